@@ -88,7 +88,7 @@ size_t naiveFillSmallHoles(BaseMesh<BaseVecT>& mesh, size_t maxSize, bool collap
 
     // First, we need to have a ClusterBiMap where each cluster describes one
     // connected part of the mesh.
-    auto subMeshes = clusterGrowing(mesh, [](FaceHandle referenceFaceH, FaceHandle currentFaceH)
+    auto subMeshes = parallelClusterGrowing(mesh, [](FaceHandle faceH, FaceHandle neighbourH)
     {
         return true;
     });
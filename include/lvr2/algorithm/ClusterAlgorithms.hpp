@@ -157,6 +157,24 @@ BoundingRectangle<typename BaseVecT::CoordType> calculateBoundingRectangle(
 template<typename BaseVecT, typename Pred>
 ClusterBiMap<FaceHandle> clusterGrowing(const BaseMesh<BaseVecT>& mesh, Pred pred);
 
+/**
+ * @brief Parallel algorithm which generates clusters from the given mesh by merging adjacent faces.
+ *
+ * Every pair of adjacent faces for which `pred` returns true ends up in the same cluster, i.e. the clusters are the
+ * connected components of the face adjacency graph after removing all edges rejected by `pred`. They are found with
+ * a concurrent union-find. Unlike `clusterGrowing()` faces are only compared with their neighbours and never with a
+ * starting face, so both functions return the same clusters if `pred` does not depend on its arguments (e.g. to find
+ * the connected parts of a mesh).
+ *
+ * The clusters are ordered by their face with the smallest index, which is the first handle of each cluster. The
+ * handles in a cluster are sorted by index.
+ *
+ * @tparam Pred a symmetric predicate which decides whether two adjacent faces belong to the same cluster. It gets
+ *         the parameters (FaceHandle faceH, FaceHandle neighbourH) and is called from multiple threads.
+ */
+template<typename BaseVecT, typename Pred>
+ClusterBiMap<FaceHandle> parallelClusterGrowing(const BaseMesh<BaseVecT>& mesh, Pred pred);
+
 /**
  * @brief Algorithm which generates plane clusters from the given mesh.
  * @param minSinAngle `1 - minSinAngle` is the allowed difference between the sin of the angle of the starting
@@ -173,6 +191,7 @@ ClusterBiMap<FaceHandle> planarClusterGrowing(
  * @brief Algorithm which generates planar clusters from the given mesh, drags points in clusters into regression
  *        planes and improves clusters iteratively.
  * @param mesh
+ * @param normals face normals of the mesh, which are updated when faces are dragged into planes
  * @param minSinAngle `1 - minSinAngle` is the allowed difference between the sin of the angle of the starting
  *                    face and all other faces in one cluster.
  * @param numIterations for cluster improvement
@@ -181,6 +200,7 @@ ClusterBiMap<FaceHandle> planarClusterGrowing(
 template<typename BaseVecT>
 ClusterBiMap<FaceHandle> iterativePlanarClusterGrowing(
     BaseMesh<BaseVecT>& mesh,
+    FaceMap<Normal<typename BaseVecT::CoordType>>& normals,
     float minSinAngle,
     int numIterations,
     int minClusterSize
@@ -195,7 +215,7 @@ Plane<BaseVecT> calcRegressionPlane(
 );
 
 /**
- * @brief Calcs regression planes for all cluster in clusters
+ * @brief Calcs regression planes for all cluster in clusters (in parallel)
  * @param minClusterSize minimum size for clusters (number of faces) for which a regression plane should be generated
  * @return map from cluster handle to its regression plane (clusterH -> Plane)
  */
@@ -216,7 +236,12 @@ void dragToRegressionPlane(
     FaceMap<Normal<typename BaseVecT::CoordType>>& normals
 );
 
-/// Drags all points from the given clusters into their regression planes
+/**
+ * @brief Drags all points from the given clusters into their regression planes
+ *
+ * Points shared by several clusters are dragged into the planes of these clusters one after another, in the order
+ * of the cluster handles. The points are processed in parallel.
+ */
 template<typename BaseVecT>
 void dragToRegressionPlanes(
     BaseMesh<BaseVecT>& mesh,
@@ -226,8 +251,8 @@ void dragToRegressionPlanes(
 );
 
 /**
- * Compares every plane with its presumabl neighours, calculates their intersection and drags all points
- * in-between to this intersection.
+ * Compares every plane with its neighbours, calculates their intersection and drags all points
+ * in-between to this intersection. Only planes of clusters which share at least one edge are compared.
  */
 template<typename BaseVecT>
 void optimizePlaneIntersections(
@@ -46,12 +46,15 @@
 #include <lvr2/io/Timestamp.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <complex>
 #include <sstream>
 #include <cmath>
 #include <limits>
+#include <unordered_map>
 #include <unordered_set>
 
+using std::unordered_map;
 using std::unordered_set;
 using std::max;
 using std::log;
@@ -63,7 +66,7 @@ template<typename BaseVecT>
 void removeDanglingCluster(BaseMesh<BaseVecT>& mesh, size_t sizeThreshold)
 {
     // Do cluster growing without a predicate, so cluster will consist of connected faces
-    auto clusterSet = clusterGrowing(mesh, [](auto referenceFaceH, auto currentFaceH)
+    auto clusterSet = parallelClusterGrowing(mesh, [](auto faceH, auto neighbourH)
     {
         return true;
     });
@@ -432,6 +435,100 @@ ClusterBiMap<FaceHandle> clusterGrowing(const BaseMesh<BaseVecT>& mesh, Pred pre
     return clusters;
 }
 
+/// Returns the root of `i` in the concurrent union-find `parents` and shortens the path to it
+inline Index findClusterRoot(vector<std::atomic<Index>>& parents, Index i)
+{
+    Index parent = parents[i].load(std::memory_order_relaxed);
+    while (parent != i)
+    {
+        // Path halving: let `i` skip its parent. Losing this race is harmless, as
+        // another thread can only have moved `i` closer to the root.
+        Index grandparent = parents[parent].load(std::memory_order_relaxed);
+        parents[i].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
+        i = parent;
+        parent = parents[i].load(std::memory_order_relaxed);
+    }
+    return i;
+}
+
+template<typename BaseVecT, typename Pred>
+ClusterBiMap<FaceHandle> parallelClusterGrowing(const BaseMesh<BaseVecT>& mesh, Pred pred)
+{
+    const Index numFaceIndices = mesh.nextFaceIndex();
+
+    // Every face starts as its own cluster
+    vector<std::atomic<Index>> parents(numFaceIndices);
+    for (Index i = 0; i < numFaceIndices; i++)
+    {
+        parents[i].store(i, std::memory_order_relaxed);
+    }
+
+    #pragma omp parallel
+    {
+        vector<FaceHandle> faceNeighbours;
+
+        #pragma omp for schedule(static)
+        for (long i = 0; i < (long)numFaceIndices; i++)
+        {
+            FaceHandle faceH(i);
+            if (!mesh.containsFace(faceH))
+            {
+                continue;
+            }
+
+            faceNeighbours.clear();
+            mesh.getNeighboursOfFace(faceH, faceNeighbours);
+            for (auto neighbourH: faceNeighbours)
+            {
+                // Look at each pair of faces only once
+                if (neighbourH.idx() < faceH.idx() || !pred(faceH, neighbourH))
+                {
+                    continue;
+                }
+
+                // Link the root with the larger index below the other one, so that the
+                // root of each cluster ends up being its face with the smallest index
+                Index a = faceH.idx();
+                Index b = neighbourH.idx();
+                while (true)
+                {
+                    a = findClusterRoot(parents, a);
+                    b = findClusterRoot(parents, b);
+                    if (a == b)
+                    {
+                        break;
+                    }
+                    if (a < b)
+                    {
+                        std::swap(a, b);
+                    }
+
+                    Index expected = a;
+                    if (parents[a].compare_exchange_strong(expected, b, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // Roots are visited before all other faces of their cluster
+    ClusterBiMap<FaceHandle> clusters;
+    DenseFaceMap<ClusterHandle> clusterOfRoot;
+    for (auto faceH: mesh.faces())
+    {
+        Index root = findClusterRoot(parents, faceH.idx());
+        if (root == faceH.idx())
+        {
+            clusterOfRoot.insert(faceH, clusters.createCluster());
+        }
+        clusters.addToCluster(clusterOfRoot[FaceHandle(root)], faceH);
+    }
+
+    return clusters;
+}
+
 template<typename BaseVecT>
 ClusterBiMap<FaceHandle> planarClusterGrowing(
     const BaseMesh<BaseVecT>& mesh,
@@ -497,18 +594,31 @@ DenseClusterMap<Plane<BaseVecT>> calcRegressionPlanes(
     size_t defaultClusterThreshold = 10 * log(mesh.numFaces());
     size_t minClusterThresholdSize = max(static_cast<size_t>(minClusterSize), defaultClusterThreshold);
 
-    // For all clusters in cluster map
+    // Collect the clusters which are large enough
+    vector<ClusterHandle> planeClusters;
     for (auto clusterH: clusters)
     {
-        // Get current cluster
-        auto cluster = clusters[clusterH];
-        if (cluster.handles.size() > minClusterThresholdSize)
+        if (clusters[clusterH].handles.size() > minClusterThresholdSize)
         {
-            // Calc regression plane for current cluster and add to cluster map: cluster -> plane
-            planes.insert(clusterH, calcRegressionPlane(mesh, cluster, normals));
+            planeClusters.push_back(clusterH);
         }
     }
 
+    // Calc regression planes for these clusters independently of each other
+    vector<Plane<BaseVecT>> regressionPlanes(planeClusters.size());
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long i = 0; i < (long)planeClusters.size(); i++)
+    {
+        regressionPlanes[i] = calcRegressionPlane(mesh, clusters[planeClusters[i]], normals);
+    }
+
+    // Add planes to cluster map: cluster -> plane
+    planes.reserve(clusters.numCluster());
+    for (size_t i = 0; i < planeClusters.size(); i++)
+    {
+        planes.insert(planeClusters[i], regressionPlanes[i]);
+    }
+
     return planes;
 }
 
@@ -605,11 +715,61 @@ void dragToRegressionPlanes(
     FaceMap<Normal<typename BaseVecT::CoordType>>& normals
 )
 {
-    // For all clusters in cluster map
+    // Drag each vertex into the planes of all faces around it. Like
+    // `dragToRegressionPlane()` for every cluster, this drags it once per face,
+    // cluster after cluster.
+    #pragma omp parallel
+    {
+        vector<FaceHandle> faces;
+        vector<ClusterHandle> clustersOfFaces;
+
+        #pragma omp for schedule(static)
+        for (long i = 0; i < (long)mesh.nextVertexIndex(); i++)
+        {
+            VertexHandle vertexH(i);
+            if (!mesh.containsVertex(vertexH))
+            {
+                continue;
+            }
+
+            faces.clear();
+            mesh.getFacesOfVertex(vertexH, faces);
+
+            clustersOfFaces.clear();
+            for (auto faceH: faces)
+            {
+                auto clusterH = clusters.getClusterOf(faceH);
+                if (clusterH && planes.containsKey(clusterH.unwrap()))
+                {
+                    clustersOfFaces.push_back(clusterH.unwrap());
+                }
+            }
+            std::sort(clustersOfFaces.begin(), clustersOfFaces.end());
+
+            auto& pos = mesh.getVertexPosition(vertexH);
+            for (auto clusterH: clustersOfFaces)
+            {
+                const auto& plane = planes[clusterH];
+                pos -= plane.normal * plane.distance(pos);
+            }
+        }
+    }
+
+    // All faces in a cluster get the normal of its plane
+    vector<ClusterHandle> planeClusters;
     for (auto clusterH: planes)
     {
-        // Drag all vertices of current cluster into regression plane
-        dragToRegressionPlane(mesh, clusters[clusterH], planes[clusterH], normals);
+        planeClusters.push_back(clusterH);
+    }
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (long i = 0; i < (long)planeClusters.size(); i++)
+    {
+        const auto& plane = planes[planeClusters[i]];
+        for (auto faceH: clusters[planeClusters[i]].handles)
+        {
+            normals[faceH] = plane.normal;
+        }
     }
 }
 
@@ -640,6 +800,59 @@ void optimizePlaneIntersections(
     const ClusterMap<Plane<BaseVecT>>& planes
 )
 {
+    auto pairKey = [](ClusterHandle clusterH, ClusterHandle neighbourClusterH)
+    {
+        return (static_cast<uint64_t>(clusterH.idx()) << 32) | neighbourClusterH.idx();
+    };
+
+    // Only neighbouring clusters have points in-between. Collect the edges between
+    // each pair of them, in the order in which `dragOntoIntersection()` visits them.
+    unordered_map<uint64_t, vector<EdgeHandle>> edgesBetween;
+    for (auto clusterH: planes)
+    {
+        for (auto faceH: clusters[clusterH].handles)
+        {
+            for (auto edgeH: mesh.getEdgesOfFace(faceH))
+            {
+                for (auto neighbourFaceH: mesh.getFacesOfEdge(edgeH))
+                {
+                    if (!neighbourFaceH || neighbourFaceH.unwrap() == faceH)
+                    {
+                        continue;
+                    }
+
+                    auto neighbourClusterH = clusters.getClusterOf(neighbourFaceH.unwrap());
+                    if (neighbourClusterH
+                        && neighbourClusterH.unwrap() != clusterH
+                        && planes.containsKey(neighbourClusterH.unwrap()))
+                    {
+                        edgesBetween[pairKey(clusterH, neighbourClusterH.unwrap())].push_back(edgeH);
+                    }
+                }
+            }
+        }
+    }
+
+    // Projects the vertices of all edges of `clusterH` next to `neighbourClusterH`
+    auto dragEdgesOntoIntersection = [&](
+        ClusterHandle clusterH,
+        ClusterHandle neighbourClusterH,
+        const Line<BaseVecT>& intersection
+    )
+    {
+        for (auto edgeH: edgesBetween[pairKey(clusterH, neighbourClusterH)])
+        {
+            auto vertices = mesh.getVerticesOfEdge(edgeH);
+
+            auto& v1 = mesh.getVertexPosition(vertices[0]);
+            auto& v2 = mesh.getVertexPosition(vertices[1]);
+
+            // project both vertices of the edge into the intersection
+            v1 = intersection.project(v1);
+            v2 = intersection.project(v2);
+        }
+    };
+
     // Status message for mesh generation
     string comment = timestamp.getElapsedTime() + "Optimizing plane intersections ";
     ProgressBar progress(planes.numValues(), comment);
@@ -656,6 +869,12 @@ void optimizePlaneIntersections(
         {
             auto clusterInnerH = *itInner;
 
+            // skip clusters which are not neighbours
+            if (!edgesBetween.count(pairKey(clusterH, clusterInnerH)))
+            {
+                continue;
+            }
+
             auto& plane1 = planes[clusterH];
             auto& plane2 = planes[clusterInnerH];
 
@@ -665,8 +884,8 @@ void optimizePlaneIntersections(
             {
                 auto intersection = plane1.intersect(plane2);
 
-                dragOntoIntersection(mesh, clusters, clusterH, clusterInnerH, intersection);
-                dragOntoIntersection(mesh, clusters, clusterInnerH, clusterH, intersection);
+                dragEdgesOntoIntersection(clusterH, clusterInnerH, intersection);
+                dragEdgesOntoIntersection(clusterInnerH, clusterH, intersection);
             }
         }
 
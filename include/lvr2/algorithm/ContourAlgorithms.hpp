@@ -32,6 +32,9 @@
 #ifndef LVR2_ALGORITHM_CONTOURALGORITHMS_H_
 #define LVR2_ALGORITHM_CONTOURALGORITHMS_H_
 
+#include <vector>
+
+using std::vector;
 
 #include <lvr2/geometry/BaseMesh.hpp>
 #include <lvr2/geometry/Handles.hpp>
@@ -49,70 +49,87 @@ namespace lvr2
 template<typename BaseVecT>
 MeshBufferPtr SimpleFinalizer<BaseVecT>::apply(const BaseMesh <BaseVecT>& mesh)
 {
-    // Create vertex and normal buffer
-    DenseVertexMap<size_t> idxMap;
-    idxMap.reserve(mesh.numVertices());
+    // Assign consecutive buffer indices to the vertices and faces in handle
+    // order. With these, the buffers below can be filled in parallel.
+    const Index vertexEnd = mesh.nextVertexIndex();
+    vector<unsigned int> idxMap(vertexEnd);
+    size_t vertexCount = 0;
+    for (Index i = 0; i < vertexEnd; i++)
+    {
+        if (mesh.containsVertex(VertexHandle(i)))
+        {
+            idxMap[i] = vertexCount++;
+        }
+    }
 
-    vector<float> vertices;
-    vertices.reserve(mesh.numVertices() * 3);
+    const Index faceEnd = mesh.nextFaceIndex();
+    vector<unsigned int> faceIdxMap(faceEnd);
+    size_t faceCount = 0;
+    for (Index i = 0; i < faceEnd; i++)
+    {
+        if (mesh.containsFace(FaceHandle(i)))
+        {
+            faceIdxMap[i] = faceCount++;
+        }
+    }
+
+    // Create vertex and normal buffer
+    vector<float> vertices(vertexCount * 3);
 
     vector<float> normals;
     if (m_normalData)
     {
-        normals.reserve(mesh.numVertices() * 3);
+        normals.resize(vertexCount * 3);
     }
 
     vector<unsigned char> colors;
     if (m_colorData)
     {
-        colors.reserve(mesh.numVertices() * 3);
+        colors.resize(vertexCount * 3);
     }
 
     // for all vertices
-    size_t vertexCount = 0;
-    for (auto vH : mesh.vertices())
+    parallelForEachVertex(mesh, [&](auto vH)
     {
+        const size_t i = idxMap[vH.idx()] * 3;
         auto point = mesh.getVertexPosition(vH);
 
         // add vertex positions to buffer
-        vertices.push_back(point.x);
-        vertices.push_back(point.y);
-        vertices.push_back(point.z);
+        vertices[i + 0] = point.x;
+        vertices[i + 1] = point.y;
+        vertices[i + 2] = point.z;
 
         if (m_normalData)
         {
             // add normal data to buffer if given
             auto normal = (*m_normalData)[vH];
-            normals.push_back(normal.getX());
-            normals.push_back(normal.getY());
-            normals.push_back(normal.getZ());
+            normals[i + 0] = normal.getX();
+            normals[i + 1] = normal.getY();
+            normals[i + 2] = normal.getZ();
         }
 
         if (m_colorData)
         {
             // add color data to buffer if given
-            colors.push_back(static_cast<unsigned char>((*m_colorData)[vH][0]));
-            colors.push_back(static_cast<unsigned char>((*m_colorData)[vH][1]));
-            colors.push_back(static_cast<unsigned char>((*m_colorData)[vH][2]));
+            auto color = (*m_colorData)[vH];
+            colors[i + 0] = static_cast<unsigned char>(color[0]);
+            colors[i + 1] = static_cast<unsigned char>(color[1]);
+            colors[i + 2] = static_cast<unsigned char>(color[2]);
         }
-
-        // Save index of vertex for face mapping
-        idxMap.insert(vH, vertexCount);
-        vertexCount++;
-    }
+    });
 
     // Create face buffer
-    vector<unsigned int> faces;
-    faces.reserve(mesh.numFaces() * 3);
-    for (auto fH : mesh.faces())
+    vector<unsigned int> faces(faceCount * 3);
+    parallelForEachFace(mesh, [&](auto fH)
     {
+        const size_t i = faceIdxMap[fH.idx()] * 3;
         auto handles = mesh.getVerticesOfFace(fH);
-        for (auto handle : handles)
+        for (size_t j = 0; j < 3; j++)
         {
             // add faces to buffer
-            faces.push_back(idxMap[handle]);
+            faces[i + j] = idxMap[handles[j].idx()];
         }
-    }
+    });
 
     // create buffer object and pass values
     MeshBufferPtr buffer( new MeshBuffer );
@@ -32,6 +32,9 @@
 #ifndef LVR2_ALGORITHM_GEOMETRYALGORITHMS_H_
 #define LVR2_ALGORITHM_GEOMETRYALGORITHMS_H_
 
+#include <cstdint>
+#include <vector>
+
 #include <lvr2/geometry/BaseMesh.hpp>
 #include <lvr2/attrmaps/AttrMaps.hpp>
 #include <lvr2/geometry/Handles.hpp>
@@ -81,6 +84,49 @@ void visitLocalVertexNeighborhood(
     VisitorF visitor
 );
 
+/**
+ * @brief Visits local vertex neighborhoods like
+ *        `visitLocalVertexNeighborhood()`, but is much faster when many
+ *        neighborhoods are visited.
+ *
+ * The adjacency and the positions of the mesh are copied into flat arrays
+ * once. The per-call data lives in a `VisitState`: instead of a set of
+ * visited vertices, each vertex is marked with the number of the last call
+ * that visited it, so forgetting the marks of the previous call is free.
+ * `visit()` can be called from several threads at once, as long as each
+ * uses its own state.
+ */
+template<typename BaseVecT>
+class LocalVertexNeighborhood
+{
+public:
+    class VisitState
+    {
+    private:
+        friend class LocalVertexNeighborhood;
+
+        /// The number of the last call that visited a vertex
+        vector<uint32_t> m_visited;
+        uint32_t m_call = 0;
+        vector<Index> m_stack;
+    };
+
+    explicit LocalVertexNeighborhood(const BaseMesh<BaseVecT>& mesh);
+
+    /**
+     * @brief Calls `visitor` for every vertex in the local neighborhood of
+     *        `vH` (not `vH` itself).
+     */
+    template<typename VisitorF>
+    void visit(VertexHandle vH, double radius, VisitState& state, VisitorF visitor) const;
+
+private:
+    /// Neighbors of vertex i are [m_offsets[i], m_offsets[i + 1])
+    vector<Index> m_offsets;
+    vector<Index> m_neighbors;
+    vector<BaseVecT> m_positions;
+};
+
 /**
  * @brief   Calculate the height difference value for each vertex of the given BaseMesh.
  *
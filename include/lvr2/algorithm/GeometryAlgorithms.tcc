@@ -114,57 +114,208 @@ void visitLocalVertexNeighborhood(
     }
 }
 
-template <typename BaseVecT>
-DenseVertexMap<float> calcVertexHeightDifferences(const BaseMesh<BaseVecT>& mesh, double radius)
+template<typename BaseVecT>
+LocalVertexNeighborhood<BaseVecT>::LocalVertexNeighborhood(const BaseMesh<BaseVecT>& mesh)
 {
-    // We create a map to store a height-diff for each vertex. We preallocate
-    // memory for all vertices. This is not only an optimization, but more
-    // importantly to avoid multithreading crashes. The parallelized loop
-    // further down inserts into this data structure; if there is no free
-    // memory left, it will reallocate which will crash horribly when multiple
-    // threads are involved.
-    DenseVertexMap<float> heightDiff;
-    heightDiff.reserve(mesh.nextVertexIndex());
+    const Index numVertices = mesh.nextVertexIndex();
+    m_offsets.assign(numVertices + 1, 0);
+    m_positions.resize(numVertices);
 
-    // Output
-    string msg = timestamp.getElapsedTime() + "Computing height differences...";
-    ProgressBar progress(mesh.numVertices(), msg);
-    ++progress;
+    // Count the neighbors of each vertex first, then fill them in
+    parallelForEachVertex(mesh, [&](VertexHandle vH)
+    {
+        m_offsets[vH.idx() + 1] = mesh.getNeighboursOfVertex(vH).size();
+        m_positions[vH.idx()] = mesh.getVertexPosition(vH);
+    });
+    for (Index i = 0; i < numVertices; i++)
+    {
+        m_offsets[i + 1] += m_offsets[i];
+    }
 
-    // Calculate height difference for each vertex
-    #pragma omp parallel for
-    for (size_t i = 0; i < mesh.nextVertexIndex(); i++)
+    m_neighbors.resize(m_offsets.back());
+    #pragma omp parallel
     {
-        auto vH = VertexHandle(i);
-        if (!mesh.containsVertex(vH))
+        vector<VertexHandle> neighbors;
+
+        #pragma omp for schedule(static)
+        for (long i = 0; i < (long)numVertices; i++)
         {
-            continue;
+            if (!mesh.containsVertex(VertexHandle(i)))
+            {
+                continue;
+            }
+
+            neighbors.clear();
+            mesh.getNeighboursOfVertex(VertexHandle(i), neighbors);
+            std::transform(neighbors.begin(), neighbors.end(), m_neighbors.begin() + m_offsets[i],
+                [](VertexHandle vH) { return vH.idx(); });
         }
+    }
+}
+
+template<typename BaseVecT>
+template<typename VisitorF>
+void LocalVertexNeighborhood<BaseVecT>::visit(
+    VertexHandle vH,
+    double radius,
+    VisitState& state,
+    VisitorF visitor
+) const
+{
+    if (state.m_visited.size() != m_positions.size())
+    {
+        state.m_visited.assign(m_positions.size(), 0);
+        state.m_call = 0;
+    }
+
+    state.m_call++;
+    if (state.m_call == 0)
+    {
+        // The counter wrapped around, so old marks could become valid again
+        std::fill(state.m_visited.begin(), state.m_visited.end(), 0);
+        state.m_call = 1;
+    }
+    const uint32_t call = state.m_call;
+
+    const auto vPos = m_positions[vH.idx()];
+    const double radiusSquared = radius * radius;
 
-        float minHeight = std::numeric_limits<float>::max();
-        float maxHeight = std::numeric_limits<float>::lowest();
+    auto& stack = state.m_stack;
+    stack.clear();
+    stack.push_back(vH.idx());
+    state.m_visited[vH.idx()] = call;
 
-        visitLocalVertexNeighborhood(mesh, vH, radius, [&](auto neighbor) {
-            auto curPos = mesh.getVertexPosition(neighbor);
+    // Same traversal as in `visitLocalVertexNeighborhood()`
+    while (!stack.empty())
+    {
+        const Index cur = stack.back();
+        stack.pop_back();
 
-            if (curPos.z < minHeight)
+        for (Index j = m_offsets[cur]; j < m_offsets[cur + 1]; j++)
+        {
+            const Index next = m_neighbors[j];
+            if (state.m_visited[next] == call)
             {
-                minHeight = curPos.z;
+                continue;
             }
-            if (curPos.z > maxHeight)
+
+            if (m_positions[next].squaredDistanceFrom(vPos) < radiusSquared)
             {
-                maxHeight = curPos.z;
+                visitor(VertexHandle(next));
+                stack.push_back(next);
+                state.m_visited[next] = call;
             }
-        });
+        }
+    }
+}
 
-        // Calculate the final height difference
-        #pragma omp critical
+/**
+ * @brief Calculates roughness and/or height difference of all vertices in
+ *        one parallel pass. A feature is skipped if its map is null. The
+ *        roughness needs the `averageAngles` of all vertices.
+ */
+template<typename BaseVecT>
+void calcLocalVertexFeatures(
+    const BaseMesh<BaseVecT>& mesh,
+    double radius,
+    const DenseVertexMap<float>* averageAngles,
+    DenseVertexMap<float>* roughness,
+    DenseVertexMap<float>* heightDiff
+)
+{
+    // Insert all keys up front, the maps must not change their size while
+    // they are written to in parallel.
+    for (auto map: {roughness, heightDiff})
+    {
+        if (map)
         {
-            heightDiff.insert(vH, maxHeight - minHeight);
+            map->clear();
+            map->reserve(mesh.nextVertexIndex());
+            for (auto vH: mesh.vertices())
+            {
+                map->insert(vH, 0);
+            }
+        }
+    }
+
+    // Output
+    string msg = timestamp.getElapsedTime();
+    if (roughness && heightDiff)
+    {
+        msg += "Computing roughness and height differences";
+    }
+    else if (roughness)
+    {
+        msg += "Computing roughness";
+    }
+    else
+    {
+        msg += "Computing height differences";
+    }
+    ProgressBar progress(mesh.numVertices(), msg);
+    ++progress;
+
+    // Calculate roughness and height difference for each vertex
+    LocalVertexNeighborhood<BaseVecT> neighborhood(mesh);
+
+    #pragma omp parallel
+    {
+        typename LocalVertexNeighborhood<BaseVecT>::VisitState state;
+
+        #pragma omp for schedule(dynamic, 64)
+        for (long i = 0; i < (long)mesh.nextVertexIndex(); i++)
+        {
+            auto vH = VertexHandle(i);
+            if (!mesh.containsVertex(vH))
+            {
+                continue;
+            }
+
+            double sum = 0.0;
+            uint32_t count = 0;
+            float minHeight = std::numeric_limits<float>::max();
+            float maxHeight = std::numeric_limits<float>::lowest();
+
+            neighborhood.visit(vH, radius, state, [&](auto neighbor) {
+                if (roughness)
+                {
+                    sum += (*averageAngles)[neighbor];
+                }
+                count += 1;
+
+                auto curPos = mesh.getVertexPosition(neighbor);
+                if (curPos.z < minHeight)
+                {
+                    minHeight = curPos.z;
+                }
+                if (curPos.z > maxHeight)
+                {
+                    maxHeight = curPos.z;
+                }
+            });
+
+            // Calculate the final roughness
+            if (roughness)
+            {
+                (*roughness)[vH] = count ? sum / count : 0;
+            }
+
+            // Calculate the final height difference
+            if (heightDiff)
+            {
+                (*heightDiff)[vH] = maxHeight - minHeight;
+            }
+
             ++progress;
         }
     }
+}
 
+template <typename BaseVecT>
+DenseVertexMap<float> calcVertexHeightDifferences(const BaseMesh<BaseVecT>& mesh, double radius)
+{
+    DenseVertexMap<float> heightDiff;
+    calcLocalVertexFeatures(mesh, radius, nullptr, nullptr, &heightDiff);
     return heightDiff;
 }
 
@@ -172,12 +323,12 @@ template<typename BaseVecT>
 DenseEdgeMap<float> calcVertexAngleEdges(const BaseMesh<BaseVecT>& mesh, const VertexMap<Normal<typename BaseVecT::CoordType>>& normals)
 {
     DenseEdgeMap<float> edgeAngle(mesh.nextEdgeIndex(), 0);
-    for (auto eH: mesh.edges())
+    parallelForEachEdge(mesh, [&](EdgeHandle eH)
     {
         auto vHVector = mesh.getVerticesOfEdge(eH);
-        edgeAngle.insert(eH, acos(normals[vHVector[0]].dot(normals[vHVector[1]])));
-        if(isnan(edgeAngle[eH])) edgeAngle[eH] = 0;
-    }
+        float angle = acos(normals[vHVector[0]].dot(normals[vHVector[1]]));
+        edgeAngle[eH] = isnan(angle) ? 0 : angle;
+    });
     return edgeAngle;
 }
 
@@ -190,7 +341,7 @@ DenseVertexMap<float> calcAverageVertexAngles(
     DenseVertexMap<float> vertexAngles(mesh.nextVertexIndex(), 0);
     auto edgeAngles = calcVertexAngleEdges(mesh, normals);
 
-    for (auto vH: mesh.vertices())
+    parallelForEachVertex(mesh, [&](VertexHandle vH)
     {
         float angleSum = 0;
         auto edgeVec = mesh.getEdgesOfVertex(vH);
@@ -199,8 +350,8 @@ DenseVertexMap<float> calcAverageVertexAngles(
         {
             angleSum += edgeAngles[eH];
         }
-        vertexAngles.insert(vH, angleSum / degree);
-    }
+        vertexAngles[vH] = angleSum / degree;
+    });
     return vertexAngles;
 }
 
@@ -212,49 +363,10 @@ DenseVertexMap<float> calcVertexRoughness(
     const VertexMap<Normal<typename BaseVecT::CoordType>>& normals
 )
 {
-    // We create a map to store the roughness for each vertex. We preallocate
-    // memory for all vertices. This is not only an optimization, but more
-    // importantly to avoid multithreading crashes. The parallelized loop
-    // further down inserts into this data structure; if there is no free
-    // memory left, it will reallocate which will crash horribly when multiple
-    // threads are involved.
     DenseVertexMap<float> roughness;
-    roughness.reserve(mesh.nextVertexIndex());
-
     auto averageAngles = calcAverageVertexAngles(mesh, normals);
-
-    // Output
-    string msg = timestamp.getElapsedTime() + "Computing roughness";
-    ProgressBar progress(mesh.numVertices(), msg);
-    ++progress;
-
-    // Calculate roughness for each vertex
-    #pragma omp parallel for
-    for (size_t i = 0; i < mesh.nextVertexIndex(); i++)
-    {
-        auto vH = VertexHandle(i);
-        if (!mesh.containsVertex(vH))
-        {
-            continue;
-        }
-
-        float sum = 0.0;
-        size_t count = 0;
-
-        visitLocalVertexNeighborhood(mesh, vH, radius, [&](auto neighbor) {
-            sum += averageAngles[neighbor];
-            count += 1;
-        });
-
-        #pragma omp critical
-        {
-            // Calculate the final roughness
-            roughness.insert(vH, count ? sum / count : 0);
-            ++progress;
-        }
-    }
+    calcLocalVertexFeatures(mesh, radius, &averageAngles, &roughness, nullptr);
     return roughness;
-
 }
 
 template<typename BaseVecT>
@@ -266,51 +378,8 @@ void calcVertexRoughnessAndHeightDifferences(
     DenseVertexMap<float>& heightDiff
 )
 {
-    // Reserving memory in those maps is important to avoid multi threading
-    // related crashes.
-    roughness.clear();
-    roughness.reserve(mesh.nextVertexIndex());
-    heightDiff.clear();
-    heightDiff.reserve(mesh.nextVertexIndex());
-
     auto averageAngles = calcAverageVertexAngles(mesh, normals);
-
-    // Calculate roughness and height difference for each vertex
-    #pragma omp parallel for
-    for (size_t i = 0; i < mesh.nextVertexIndex(); i++)
-    {
-        auto vH = VertexHandle(i);
-        if (!mesh.containsVertex(vH))
-        {
-            continue;
-        }
-
-        double sum = 0.0;
-        uint32_t count = 0;
-        float minHeight = std::numeric_limits<float>::max();
-        float maxHeight = std::numeric_limits<float>::lowest();
-
-        visitLocalVertexNeighborhood(mesh, vH, radius, [&](auto neighbor) {
-            sum += averageAngles[neighbor];
-            count += 1;
-
-            auto curPos = mesh.getVertexPosition(neighbor);
-            if (curPos.z < minHeight)
-            {
-                minHeight = curPos.z;
-            }
-            if (curPos.z > maxHeight)
-            {
-                maxHeight = curPos.z;
-            }
-        });
-
-        // Calculate the final roughness
-        roughness.insert(vH, count ? sum / count : 0);
-
-        // Calculate the final height difference
-        heightDiff.insert(vH, maxHeight - minHeight);
-    }
+    calcLocalVertexFeatures(mesh, radius, &averageAngles, &roughness, &heightDiff);
 }
 
 template<typename BaseVecT>
@@ -374,6 +443,7 @@ bool Dijkstra(
     pair<VertexHandle,float> first_pair (start, 0);
     pq.push(first_pair);
 
+    std::vector<EdgeHandle> edges;
 
     while(!pq.empty())
     {
@@ -392,14 +462,16 @@ bool Dijkstra(
         seen[current_vh] = true;
 
         // Get all edges from the current Vertex
-        std::vector<VertexHandle> neighbours;
-        mesh.getNeighboursOfVertex(current_vh, neighbours);
+        edges.clear();
+        mesh.getEdgesOfVertex(current_vh, edges);
 
-        for(auto neighbour_vh: neighbours)
+        for(auto eH: edges)
         {
+            auto edge_vertices = mesh.getVerticesOfEdge(eH);
+            auto neighbour_vh = edge_vertices[0] == current_vh ? edge_vertices[1] : edge_vertices[0];
             if(seen[neighbour_vh] || vertex_costs[neighbour_vh] >= 1) continue;
 
-            float edge_cost = edgeCosts[mesh.getEdgeBetween(current_vh, neighbour_vh).unwrap()];
+            float edge_cost = edgeCosts[eH];
 
             float tmp_neighbour_cost = distances[current_vh] + edge_cost;
             if(distances[neighbour_vh] > tmp_neighbour_cost)
@@ -58,16 +58,26 @@ template <typename BaseVecT>
 DenseFaceMap<Normal<typename BaseVecT::CoordType>> calcFaceNormals(const BaseMesh<BaseVecT>& mesh)
 {
     DenseFaceMap<Normal<typename BaseVecT::CoordType>> out;
-    out.reserve(mesh.numFaces());
+    out.reserve(mesh.nextFaceIndex());
 
-    for (auto faceH: mesh.faces())
+    // Insert all keys up front, the map must not change its size while it is
+    // written to in parallel.
+    const Index end = mesh.nextFaceIndex();
+    for (Index i = 0; i < end; i++)
     {
-        auto maybeNormal = getFaceNormal(mesh.getVertexPositionsOfFace(faceH));
-        auto normal = maybeNormal
-            ? *maybeNormal
-            : Normal<typename BaseVecT::CoordType>(0, 0, 1);
-        out.insert(faceH, normal);
+        if (mesh.containsFace(FaceHandle(i)))
+        {
+            out.insert(FaceHandle(i), Normal<typename BaseVecT::CoordType>(0, 0, 1));
+        }
     }
+
+    parallelForEachFace(mesh, [&](auto faceH)
+    {
+        if (auto maybeNormal = getFaceNormal(mesh.getVertexPositionsOfFace(faceH)))
+        {
+            out[faceH] = *maybeNormal;
+        }
+    });
     return out;
 }
 
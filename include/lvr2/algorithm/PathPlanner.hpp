@@ -0,0 +1,200 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * PathPlanner.hpp
+ */
+
+#ifndef LVR2_ALGORITHM_PATHPLANNER_H_
+#define LVR2_ALGORITHM_PATHPLANNER_H_
+
+#include <cstdint>
+#include <list>
+#include <utility>
+#include <vector>
+
+#include <lvr2/geometry/BaseMesh.hpp>
+#include <lvr2/geometry/Handles.hpp>
+#include <lvr2/attrmaps/AttrMaps.hpp>
+
+namespace lvr2
+{
+
+/**
+ * @brief Answers many shortest path queries on the vertex graph of a mesh.
+ *
+ * The graph is copied into a compressed adjacency list (CSR) with the edge
+ * costs once, so queries neither touch the mesh nor the attribute maps. All
+ * per-vertex search data lives in a `SearchState`, which is reset in
+ * constant time between queries. Thus, one state per thread is enough to
+ * answer any number of queries, and `findPaths()` answers a whole batch in
+ * parallel.
+ *
+ * Vertices with a vertex cost of 1 or more are lethal: paths never pass
+ * through them, but they may start at one. Edges with an infinite cost are
+ * never used.
+ */
+template<typename BaseVecT>
+class PathPlanner
+{
+public:
+    enum class Search
+    {
+        /// Plain Dijkstra search
+        DIJKSTRA,
+
+        /// A* with the euclidean distance to the goal as heuristic
+        ASTAR,
+
+        /// Dijkstra search from start and goal at the same time
+        BIDIRECTIONAL
+    };
+
+    /**
+     * @brief The per-query data of the searches. Create one per thread and
+     *        reuse it for all queries.
+     */
+    class SearchState
+    {
+    public:
+        /// The cost of the path found by the last successful query
+        float cost() const { return m_cost; }
+
+    private:
+        friend class PathPlanner;
+
+        /// `heapPos` of nodes that are neither in the heap nor finished
+        static constexpr uint32_t NOT_IN_HEAP = 0xFFFFFFFF;
+
+        /// `heapPos` of nodes whose distance is final
+        static constexpr uint32_t CLOSED = 0xFFFFFFFE;
+
+        struct Node
+        {
+            float dist;
+            Index pred;
+            uint32_t stamp;
+            uint32_t heapPos;
+        };
+
+        /// One search direction: the node data and a heap with decrease-key
+        struct Frontier
+        {
+            std::vector<Node> nodes;
+            std::vector<std::pair<float, Index>> heap;
+
+            Node& node(Index v, uint32_t stamp);
+            void push(Index v, float key);
+            Index pop();
+            void siftUp(uint32_t pos);
+            void siftDown(uint32_t pos);
+        };
+
+        /// Invalidates all nodes of the last query
+        void reset(size_t numVertices);
+
+        Frontier m_forward;
+        Frontier m_backward;
+        uint32_t m_stamp = 0;
+        float m_cost = 0;
+    };
+
+    /**
+     * @brief Builds the adjacency list of `mesh` with the given edge costs.
+     */
+    PathPlanner(const BaseMesh<BaseVecT>& mesh, const DenseEdgeMap<float>& edgeCosts);
+
+    /**
+     * @brief Like the other constructor, but vertices with a cost of 1 or
+     *        more in `vertexCosts` are lethal.
+     */
+    PathPlanner(
+        const BaseMesh<BaseVecT>& mesh,
+        const DenseEdgeMap<float>& edgeCosts,
+        const VertexMap<float>& vertexCosts
+    );
+
+    /**
+     * @brief Searches the cheapest path from `start` to `goal`.
+     *
+     * This method doesn't change the planner and can be called from several
+     * threads at once, as long as each uses its own `state`.
+     *
+     * @param path    The vertices of the path, including start and goal
+     * @param state   Search data, its `cost()` is the cost of the path
+     * @param search  The algorithm to use. All of them find a cheapest path.
+     *
+     * @return true if a path between start and goal exists
+     */
+    bool findPath(
+        VertexHandle start,
+        VertexHandle goal,
+        std::list<VertexHandle>& path,
+        SearchState& state,
+        Search search = Search::ASTAR
+    ) const;
+
+    /**
+     * @brief Answers all `queries` (pairs of start and goal) in parallel.
+     *
+     * @param paths  The path for each query, empty if there is none
+     *
+     * @return The cost of each path, infinity if there is none
+     */
+    std::vector<float> findPaths(
+        const std::vector<std::pair<VertexHandle, VertexHandle>>& queries,
+        std::vector<std::list<VertexHandle>>& paths,
+        Search search = Search::ASTAR
+    ) const;
+
+private:
+    void build(
+        const BaseMesh<BaseVecT>& mesh,
+        const DenseEdgeMap<float>& edgeCosts,
+        const VertexMap<float>* vertexCosts
+    );
+
+    bool unidirectional(Index start, Index goal, SearchState& state, bool useHeuristic) const;
+    bool bidirectional(Index start, Index goal, SearchState& state, Index& meet) const;
+
+    /// Arcs of vertex i are [m_offsets[i], m_offsets[i + 1])
+    std::vector<Index> m_offsets;
+    std::vector<Index> m_targets;
+    std::vector<float> m_costs;
+
+    std::vector<BaseVecT> m_positions;
+    std::vector<char> m_lethal;
+
+    /// A lower bound of cost per length of all edges, used by A*
+    float m_costPerLength;
+};
+
+} // namespace lvr2
+
+#include <lvr2/algorithm/PathPlanner.tcc>
+
+#endif /* LVR2_ALGORITHM_PATHPLANNER_H_ */
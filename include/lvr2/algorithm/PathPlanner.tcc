@@ -0,0 +1,504 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * PathPlanner.tcc
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace lvr2
+{
+
+template<typename BaseVecT>
+typename PathPlanner<BaseVecT>::SearchState::Node&
+PathPlanner<BaseVecT>::SearchState::Frontier::node(Index v, uint32_t stamp)
+{
+    Node& n = nodes[v];
+    if (n.stamp != stamp)
+    {
+        n.dist = std::numeric_limits<float>::infinity();
+        n.pred = v;
+        n.stamp = stamp;
+        n.heapPos = NOT_IN_HEAP;
+    }
+    return n;
+}
+
+template<typename BaseVecT>
+void PathPlanner<BaseVecT>::SearchState::Frontier::push(Index v, float key)
+{
+    // The node was already fetched via `node()`, so its stamp is current
+    Node& n = nodes[v];
+    if (n.heapPos == NOT_IN_HEAP)
+    {
+        n.heapPos = heap.size();
+        heap.emplace_back(key, v);
+    }
+    else
+    {
+        heap[n.heapPos].first = key;
+    }
+    siftUp(n.heapPos);
+}
+
+template<typename BaseVecT>
+Index PathPlanner<BaseVecT>::SearchState::Frontier::pop()
+{
+    const Index v = heap.front().second;
+    nodes[v].heapPos = CLOSED;
+
+    heap.front() = heap.back();
+    heap.pop_back();
+    if (!heap.empty())
+    {
+        nodes[heap.front().second].heapPos = 0;
+        siftDown(0);
+    }
+    return v;
+}
+
+template<typename BaseVecT>
+void PathPlanner<BaseVecT>::SearchState::Frontier::siftUp(uint32_t pos)
+{
+    auto entry = heap[pos];
+    while (pos > 0)
+    {
+        const uint32_t parent = (pos - 1) / 2;
+        if (heap[parent].first <= entry.first)
+        {
+            break;
+        }
+        heap[pos] = heap[parent];
+        nodes[heap[pos].second].heapPos = pos;
+        pos = parent;
+    }
+    heap[pos] = entry;
+    nodes[entry.second].heapPos = pos;
+}
+
+template<typename BaseVecT>
+void PathPlanner<BaseVecT>::SearchState::Frontier::siftDown(uint32_t pos)
+{
+    auto entry = heap[pos];
+    const uint32_t size = heap.size();
+    while (true)
+    {
+        uint32_t child = 2 * pos + 1;
+        if (child >= size)
+        {
+            break;
+        }
+        if (child + 1 < size && heap[child + 1].first < heap[child].first)
+        {
+            child++;
+        }
+        if (entry.first <= heap[child].first)
+        {
+            break;
+        }
+        heap[pos] = heap[child];
+        nodes[heap[pos].second].heapPos = pos;
+        pos = child;
+    }
+    heap[pos] = entry;
+    nodes[entry.second].heapPos = pos;
+}
+
+template<typename BaseVecT>
+void PathPlanner<BaseVecT>::SearchState::reset(size_t numVertices)
+{
+    if (m_forward.nodes.size() != numVertices)
+    {
+        // First use with this planner: nodes with stamp 0 are never valid
+        m_forward.nodes.assign(numVertices, Node{0, 0, 0, 0});
+        m_backward.nodes.assign(numVertices, Node{0, 0, 0, 0});
+        m_stamp = 0;
+    }
+
+    m_stamp++;
+    if (m_stamp == 0)
+    {
+        // The stamp wrapped around, old stamps could become valid again
+        for (auto& n: m_forward.nodes)
+        {
+            n.stamp = 0;
+        }
+        for (auto& n: m_backward.nodes)
+        {
+            n.stamp = 0;
+        }
+        m_stamp = 1;
+    }
+
+    m_forward.heap.clear();
+    m_backward.heap.clear();
+    m_cost = std::numeric_limits<float>::infinity();
+}
+
+template<typename BaseVecT>
+PathPlanner<BaseVecT>::PathPlanner(
+    const BaseMesh<BaseVecT>& mesh,
+    const DenseEdgeMap<float>& edgeCosts
+)
+{
+    build(mesh, edgeCosts, nullptr);
+}
+
+template<typename BaseVecT>
+PathPlanner<BaseVecT>::PathPlanner(
+    const BaseMesh<BaseVecT>& mesh,
+    const DenseEdgeMap<float>& edgeCosts,
+    const VertexMap<float>& vertexCosts
+)
+{
+    build(mesh, edgeCosts, &vertexCosts);
+}
+
+template<typename BaseVecT>
+void PathPlanner<BaseVecT>::build(
+    const BaseMesh<BaseVecT>& mesh,
+    const DenseEdgeMap<float>& edgeCosts,
+    const VertexMap<float>* vertexCosts
+)
+{
+    const Index numVertices = mesh.nextVertexIndex();
+
+    m_positions.assign(numVertices, BaseVecT());
+    m_lethal.assign(numVertices, 0);
+    m_offsets.assign(numVertices + 1, 0);
+
+    // Count the usable arcs of each vertex first, then fill them in
+    #pragma omp parallel
+    {
+        vector<EdgeHandle> edges;
+
+        #pragma omp for schedule(static)
+        for (long i = 0; i < (long)numVertices; i++)
+        {
+            const VertexHandle vH(i);
+            if (!mesh.containsVertex(vH))
+            {
+                continue;
+            }
+
+            m_positions[i] = mesh.getVertexPosition(vH);
+            if (vertexCosts)
+            {
+                auto cost = vertexCosts->get(vH);
+                m_lethal[i] = cost && *cost >= 1;
+            }
+
+            edges.clear();
+            mesh.getEdgesOfVertex(vH, edges);
+            Index count = 0;
+            for (auto eH: edges)
+            {
+                if (std::isfinite(edgeCosts[eH]))
+                {
+                    count++;
+                }
+            }
+            m_offsets[i + 1] = count;
+        }
+    }
+
+    for (Index i = 0; i < numVertices; i++)
+    {
+        m_offsets[i + 1] += m_offsets[i];
+    }
+
+    m_targets.resize(m_offsets.back());
+    m_costs.resize(m_offsets.back());
+
+    float costPerLength = std::numeric_limits<float>::infinity();
+
+    #pragma omp parallel
+    {
+        vector<EdgeHandle> edges;
+        float localCostPerLength = std::numeric_limits<float>::infinity();
+
+        #pragma omp for schedule(static)
+        for (long i = 0; i < (long)numVertices; i++)
+        {
+            const VertexHandle vH(i);
+            if (!mesh.containsVertex(vH))
+            {
+                continue;
+            }
+
+            edges.clear();
+            mesh.getEdgesOfVertex(vH, edges);
+            Index arc = m_offsets[i];
+            for (auto eH: edges)
+            {
+                const float cost = edgeCosts[eH];
+                if (!std::isfinite(cost))
+                {
+                    continue;
+                }
+
+                auto vertices = mesh.getVerticesOfEdge(eH);
+                auto otherH = vertices[0] == vH ? vertices[1] : vertices[0];
+                m_targets[arc] = otherH.idx();
+                m_costs[arc] = cost;
+                arc++;
+
+                const float length = mesh.getVertexPosition(vH).distance(
+                    mesh.getVertexPosition(otherH)
+                );
+                if (length > 0)
+                {
+                    localCostPerLength = std::min(localCostPerLength, cost / length);
+                }
+            }
+        }
+
+        #pragma omp critical
+        costPerLength = std::min(costPerLength, localCostPerLength);
+    }
+
+    // A* needs a heuristic that never overestimates the remaining cost.
+    // Scaling the euclidean distance by the smallest cost per length of all
+    // edges guarantees that.
+    m_costPerLength = std::isfinite(costPerLength) ? std::max(costPerLength, 0.0f) : 0.0f;
+}
+
+template<typename BaseVecT>
+bool PathPlanner<BaseVecT>::findPath(
+    VertexHandle start,
+    VertexHandle goal,
+    std::list<VertexHandle>& path,
+    SearchState& state,
+    Search search
+) const
+{
+    path.clear();
+    state.reset(m_positions.size());
+
+    const Index s = start.idx();
+    const Index g = goal.idx();
+
+    if (s == g)
+    {
+        path.push_back(start);
+        state.m_cost = 0;
+        return true;
+    }
+    if (m_lethal[g])
+    {
+        return false;
+    }
+
+    if (search == Search::BIDIRECTIONAL)
+    {
+        Index meet;
+        if (!bidirectional(s, g, state, meet))
+        {
+            return false;
+        }
+
+        // Walk from the meeting point back to the start and to the goal
+        for (Index v = meet; v != s; v = state.m_forward.nodes[v].pred)
+        {
+            path.push_front(VertexHandle(v));
+        }
+        path.push_front(start);
+        for (Index v = meet; v != g; )
+        {
+            v = state.m_backward.nodes[v].pred;
+            path.push_back(VertexHandle(v));
+        }
+        return true;
+    }
+
+    if (!unidirectional(s, g, state, search == Search::ASTAR))
+    {
+        return false;
+    }
+
+    for (Index v = g; v != s; v = state.m_forward.nodes[v].pred)
+    {
+        path.push_front(VertexHandle(v));
+    }
+    path.push_front(start);
+    return true;
+}
+
+template<typename BaseVecT>
+bool PathPlanner<BaseVecT>::unidirectional(
+    Index start,
+    Index goal,
+    SearchState& state,
+    bool useHeuristic
+) const
+{
+    auto& frontier = state.m_forward;
+    const uint32_t stamp = state.m_stamp;
+    const BaseVecT& goalPos = m_positions[goal];
+    const float scale = useHeuristic ? m_costPerLength : 0.0f;
+
+    frontier.node(start, stamp).dist = 0;
+    frontier.push(start, 0);
+
+    while (!frontier.heap.empty())
+    {
+        const Index u = frontier.pop();
+        if (u == goal)
+        {
+            state.m_cost = frontier.nodes[u].dist;
+            return true;
+        }
+
+        const float distU = frontier.nodes[u].dist;
+        for (Index arc = m_offsets[u]; arc < m_offsets[u + 1]; arc++)
+        {
+            const Index v = m_targets[arc];
+            if (m_lethal[v])
+            {
+                continue;
+            }
+
+            // The heuristic is consistent, so closed nodes are final
+            auto& n = frontier.node(v, stamp);
+            const float dist = distU + m_costs[arc];
+            if (n.heapPos == SearchState::CLOSED || dist >= n.dist)
+            {
+                continue;
+            }
+
+            n.dist = dist;
+            n.pred = u;
+            const float h = scale > 0 ? scale * m_positions[v].distance(goalPos) : 0.0f;
+            frontier.push(v, dist + h);
+        }
+    }
+    return false;
+}
+
+template<typename BaseVecT>
+bool PathPlanner<BaseVecT>::bidirectional(
+    Index start,
+    Index goal,
+    SearchState& state,
+    Index& meet
+) const
+{
+    auto& forward = state.m_forward;
+    auto& backward = state.m_backward;
+    const uint32_t stamp = state.m_stamp;
+
+    forward.node(start, stamp).dist = 0;
+    forward.push(start, 0);
+    backward.node(goal, stamp).dist = 0;
+    backward.push(goal, 0);
+
+    float best = std::numeric_limits<float>::infinity();
+
+    while (!forward.heap.empty() && !backward.heap.empty())
+    {
+        // No path through unexplored vertices can be cheaper anymore
+        if (forward.heap.front().first + backward.heap.front().first >= best)
+        {
+            break;
+        }
+
+        // Expand the smaller frontier
+        const bool isForward = forward.heap.size() <= backward.heap.size();
+        auto& self = isForward ? forward : backward;
+        auto& other = isForward ? backward : forward;
+
+        const Index u = self.pop();
+        const float distU = self.nodes[u].dist;
+        for (Index arc = m_offsets[u]; arc < m_offsets[u + 1]; arc++)
+        {
+            const Index v = m_targets[arc];
+
+            // Forward arcs must not enter lethal vertices. Backward, `v` is
+            // the vertex the arc starts at, which may only be lethal if it is
+            // the start.
+            if (m_lethal[v] && (isForward || v != start))
+            {
+                continue;
+            }
+
+            auto& n = self.node(v, stamp);
+            const float dist = distU + m_costs[arc];
+            if (n.heapPos != SearchState::CLOSED && dist < n.dist)
+            {
+                n.dist = dist;
+                n.pred = u;
+                self.push(v, dist);
+            }
+
+            auto& o = other.node(v, stamp);
+            if (n.dist + o.dist < best)
+            {
+                best = n.dist + o.dist;
+                meet = v;
+            }
+        }
+    }
+
+    if (!std::isfinite(best))
+    {
+        return false;
+    }
+    state.m_cost = best;
+    return true;
+}
+
+template<typename BaseVecT>
+std::vector<float> PathPlanner<BaseVecT>::findPaths(
+    const std::vector<std::pair<VertexHandle, VertexHandle>>& queries,
+    std::vector<std::list<VertexHandle>>& paths,
+    Search search
+) const
+{
+    std::vector<float> costs(queries.size(), std::numeric_limits<float>::infinity());
+    paths.clear();
+    paths.resize(queries.size());
+
+    #pragma omp parallel
+    {
+        SearchState state;
+
+        #pragma omp for schedule(dynamic, 1)
+        for (long i = 0; i < (long)queries.size(); i++)
+        {
+            if (findPath(queries[i].first, queries[i].second, paths[i], state, search))
+            {
+                costs[i] = state.cost();
+            }
+        }
+    }
+    return costs;
+}
+
+} // namespace lvr2
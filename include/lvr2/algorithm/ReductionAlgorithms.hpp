@@ -32,6 +32,11 @@
  *
  * Melax, Stan. "A simple, fast, and effective polygon reduction algorithm."
  * Game Developer 11 (1998): 44-49.
+ *
+ * except for `quadricMeshReduction`, which uses the error metric from:
+ *
+ * Garland, Michael, and Paul S. Heckbert. "Surface simplification using
+ * quadric error metrics." Proceedings of SIGGRAPH 97 (1997): 209-216.
  */
 
 #ifndef LVR2_ALGORITHM_REDUCTIONALGORITHMS_H_
@@ -39,6 +44,8 @@
 
 #include <boost/optional.hpp>
 
+#include <lvr2/geometry/HalfEdgeMesh.hpp>
+
 using boost::optional;
 
 namespace lvr2
@@ -88,6 +95,42 @@ size_t simpleMeshReduction(
     FaceMap<Normal<typename BaseVecT::CoordType>>& faceNormals
 );
 
+/**
+ * @brief Collapses edges of `mesh` in parallel, using the quadric error
+ *        metric, until at most `targetFaceCount` faces are left.
+ *
+ * Each vertex carries the sum of the (area weighted) plane quadrics of its
+ * faces; border edges add a heavily weighted plane perpendicular to their
+ * face, so that the outline of the mesh is preserved. Collapsing an edge
+ * moves the remaining vertex to the position minimizing the summed quadric
+ * of both end points.
+ *
+ * Instead of a global priority queue, the edges are collapsed in rounds.
+ * Every round only looks at the cheapest quarter of all edges and gives each
+ * of these candidates a pseudo random priority. An edge is collapsed if no
+ * candidate with a higher priority touches the one-rings of its vertices.
+ * These collapses can not influence each other and are carried out
+ * concurrently. Afterwards only the costs of edges around the new vertices
+ * are updated. The result does not depend on the number of threads.
+ *
+ * Collapses that would flip or degenerate a face are never performed. Thus,
+ * the algorithm also stops early if no collapsable edge is left.
+ *
+ * @param[in] targetFaceCount The number of faces the mesh should be reduced
+ *                            to.
+ * @param[in, out] faceNormals A face map storing the normals of all faces in
+ *                             the mesh. Normals of removed faces are erased,
+ *                             all others are recalculated.
+ *
+ * @return The number of edges actually collapsed.
+ */
+template<typename BaseVecT>
+size_t quadricMeshReduction(
+    HalfEdgeMesh<BaseVecT>& mesh,
+    const size_t targetFaceCount,
+    FaceMap<Normal<typename BaseVecT::CoordType>>& faceNormals
+);
+
 } // namespace lvr2
 
 #include <lvr2/algorithm/ReductionAlgorithms.tcc>
@@ -29,6 +29,12 @@
  * ReductionAlgorithms.tcc
  */
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <unordered_set>
 #include <vector>
 
@@ -56,6 +62,85 @@ struct DirEdge
     }
 };
 
+/**
+ * @brief The symmetric 4x4 matrix of a quadric error metric, stored as its
+ *        ten distinct coefficients.
+ *
+ * For the plane ax + by + cz + d = 0 those are a², ab, ac, ad, b², bc, bd,
+ * c², cd and d² (in this order). The squared distance of a point to all
+ * planes summed in the quadric is `evaluate(point)`.
+ */
+struct ErrorQuadric
+{
+    std::array<double, 10> q;
+
+    ErrorQuadric() { q.fill(0.0); }
+
+    ErrorQuadric(double a, double b, double c, double d, double weight)
+    {
+        q = {{
+            weight * a * a, weight * a * b, weight * a * c, weight * a * d,
+            weight * b * b, weight * b * c, weight * b * d,
+            weight * c * c, weight * c * d,
+            weight * d * d
+        }};
+    }
+
+    ErrorQuadric& operator+=(const ErrorQuadric& other)
+    {
+        for (int i = 0; i < 10; i++)
+        {
+            q[i] += other.q[i];
+        }
+        return *this;
+    }
+
+    ErrorQuadric operator+(const ErrorQuadric& other) const
+    {
+        ErrorQuadric out = *this;
+        out += other;
+        return out;
+    }
+
+    double evaluate(double x, double y, double z) const
+    {
+        return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x
+             + q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y
+             + q[7] * z * z + 2 * q[8] * z
+             + q[9];
+    }
+
+    /**
+     * @brief Writes the point with the smallest error to `x`, `y` and `z`.
+     *
+     * @return false, if the quadric is (close to) singular and has no unique
+     *         minimum. The output is unchanged in this case.
+     */
+    bool minimum(double& x, double& y, double& z) const
+    {
+        // Solve the 3x3 system A p = -b with Cramer's rule
+        const double c00 = q[4] * q[7] - q[5] * q[5];
+        const double c01 = q[2] * q[5] - q[1] * q[7];
+        const double c02 = q[1] * q[5] - q[2] * q[4];
+        const double det = q[0] * c00 + q[1] * c01 + q[2] * c02;
+
+        const double trace = q[0] + q[4] + q[7];
+        if (std::abs(det) <= 1e-10 * trace * trace * trace)
+        {
+            return false;
+        }
+
+        const double c11 = q[0] * q[7] - q[2] * q[2];
+        const double c12 = q[1] * q[2] - q[0] * q[5];
+        const double c22 = q[0] * q[4] - q[1] * q[1];
+
+        x = -(c00 * q[3] + c01 * q[6] + c02 * q[8]) / det;
+        y = -(c01 * q[3] + c11 * q[6] + c12 * q[8]) / det;
+        z = -(c02 * q[3] + c12 * q[6] + c22 * q[8]) / det;
+        return true;
+    }
+};
+
 } // namespace lvr2
 
 
@@ -356,4 +441,505 @@ size_t simpleMeshReduction(
     });
 }
 
+template<typename BaseVecT>
+size_t quadricMeshReduction(
+    HalfEdgeMesh<BaseVecT>& mesh,
+    const size_t targetFaceCount,
+    FaceMap<Normal<typename BaseVecT::CoordType>>& faceNormals
+)
+{
+    using CoordT = typename BaseVecT::CoordType;
+
+    // The minimal value of the dot product between the normals of a face
+    // before and after a collapse.
+    const CoordT MIN_NORMAL_DIFF = 0.5;
+
+    // Weight of the planes which keep border vertices on the border.
+    const double BORDER_WEIGHT = 1000.0;
+
+    // Costs are ordered by the (positive) float bit pattern and ties are
+    // broken by the edge index. Thus, all keys are unique and the minimum of
+    // a neighborhood is well defined.
+    const uint64_t INVALID_KEY = std::numeric_limits<uint64_t>::max();
+
+    if (mesh.numFaces() <= targetFaceCount)
+    {
+        return 0;
+    }
+
+    std::cout << timestamp << "Reduce mesh to " << targetFaceCount
+              << " faces using quadric error metrics" << std::endl;
+
+    const Index numVertexSlots = mesh.nextVertexIndex();
+    const Index numEdgeSlots = mesh.nextEdgeIndex();
+
+    // ------------------------------------------------------------------------
+    // Initial quadrics of all vertices
+    // ------------------------------------------------------------------------
+    vector<ErrorQuadric> quadrics(numVertexSlots);
+
+    #pragma omp parallel
+    {
+        vector<FaceHandle> faces;
+        vector<EdgeHandle> edges;
+
+        #pragma omp for schedule(static)
+        for (long i = 0; i < (long)numVertexSlots; i++)
+        {
+            const VertexHandle vH(i);
+            if (!mesh.containsVertex(vH))
+            {
+                continue;
+            }
+
+            ErrorQuadric& quadric = quadrics[i];
+
+            faces.clear();
+            mesh.getFacesOfVertex(vH, faces);
+            for (auto fH: faces)
+            {
+                auto pos = mesh.getVertexPositionsOfFace(fH);
+                auto normalDir = (pos[1] - pos[0]).cross(pos[2] - pos[0]);
+                const double doubleArea = normalDir.length();
+                if (doubleArea == 0)
+                {
+                    continue;
+                }
+                const double a = normalDir.x / doubleArea;
+                const double b = normalDir.y / doubleArea;
+                const double c = normalDir.z / doubleArea;
+                const double d = -(a * pos[0].x + b * pos[0].y + c * pos[0].z);
+                quadric += ErrorQuadric(a, b, c, d, doubleArea / 2);
+            }
+
+            edges.clear();
+            mesh.getEdgesOfVertex(vH, edges);
+            for (auto eH: edges)
+            {
+                if (!mesh.isBorderEdge(eH))
+                {
+                    continue;
+                }
+
+                auto faceHs = mesh.getFacesOfEdge(eH);
+                auto fH = faceHs[0] ? faceHs[0].unwrap() : faceHs[1].unwrap();
+                auto pos = mesh.getVertexPositionsOfFace(fH);
+                auto faceDir = (pos[1] - pos[0]).cross(pos[2] - pos[0]);
+
+                auto vertices = mesh.getVerticesOfEdge(eH);
+                auto p0 = mesh.getVertexPosition(vertices[0]);
+                auto edgeDir = mesh.getVertexPosition(vertices[1]) - p0;
+                auto planeDir = edgeDir.cross(faceDir);
+                const double length = planeDir.length();
+                if (length == 0)
+                {
+                    continue;
+                }
+                const double a = planeDir.x / length;
+                const double b = planeDir.y / length;
+                const double c = planeDir.z / length;
+                const double d = -(a * p0.x + b * p0.y + c * p0.z);
+                quadric += ErrorQuadric(a, b, c, d, BORDER_WEIGHT * edgeDir.length2());
+            }
+        }
+    }
+
+    // ------------------------------------------------------------------------
+    // Cost of single collapses
+    // ------------------------------------------------------------------------
+
+    // Returns the position the edge would be collapsed to, together with the
+    // error of the collapse.
+    auto collapseTarget = [&](VertexHandle aH, VertexHandle bH, const ErrorQuadric& quadric)
+    {
+        auto posA = mesh.getVertexPosition(aH);
+        auto posB = mesh.getVertexPosition(bH);
+        auto mid = (posA + posB) / 2;
+
+        double x, y, z;
+        if (quadric.minimum(x, y, z))
+        {
+            BaseVecT pos(x, y, z);
+
+            // Points far away from the edge result from nearly flat quadrics
+            // and are usually numerical noise.
+            if (pos.distance2(mid) <= posA.distance2(posB))
+            {
+                return std::make_pair(pos, quadric.evaluate(x, y, z));
+            }
+        }
+
+        // Choose the best of both end points and the midpoint
+        std::pair<BaseVecT, double> best(mid, quadric.evaluate(mid.x, mid.y, mid.z));
+        for (auto pos: { posA, posB })
+        {
+            const double error = quadric.evaluate(pos.x, pos.y, pos.z);
+            if (error < best.second)
+            {
+                best = std::make_pair(pos, error);
+            }
+        }
+        return best;
+    };
+
+    // Returns false if moving `vH` to `newPos` would flip or degenerate one of
+    // its faces which doesn't contain `otherH`.
+    auto keepsFaces = [&](
+        VertexHandle vH,
+        VertexHandle otherH,
+        const BaseVecT& newPos,
+        vector<FaceHandle>& faces
+    )
+    {
+        faces.clear();
+        mesh.getFacesOfVertex(vH, faces);
+        for (auto fH: faces)
+        {
+            auto vertices = mesh.getVerticesOfFace(fH);
+            if (vertices[0] == otherH || vertices[1] == otherH || vertices[2] == otherH)
+            {
+                continue;
+            }
+
+            auto pos = mesh.getVertexPositionsOfFace(fH);
+            auto oldNormal = getFaceNormal(pos);
+            for (int i = 0; i < 3; i++)
+            {
+                if (vertices[i] == vH)
+                {
+                    pos[i] = newPos;
+                }
+            }
+            auto newNormal = getFaceNormal(pos);
+
+            if (!newNormal || (oldNormal && newNormal->dot(*oldNormal) < MIN_NORMAL_DIFF))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // The key only depends on the quadrics and positions of both end points.
+    // Whether the collapse is valid is checked for the selected edges only,
+    // as these tests need the whole neighborhood and are comparably
+    // expensive.
+    auto calcKey = [&](EdgeHandle eH) -> uint64_t
+    {
+        auto vertices = mesh.getVerticesOfEdge(eH);
+        auto target = collapseTarget(
+            vertices[0],
+            vertices[1],
+            quadrics[vertices[0].idx()] + quadrics[vertices[1].idx()]
+        );
+
+        const float cost = static_cast<float>(std::max(target.second, 0.0));
+        uint32_t costBits;
+        std::memcpy(&costBits, &cost, sizeof(costBits));
+        return (static_cast<uint64_t>(costBits) << 32) | eH.idx();
+    };
+
+    vector<uint64_t> keys(numEdgeSlots, INVALID_KEY);
+    auto calcAllKeys = [&]()
+    {
+        #pragma omp parallel for schedule(static)
+        for (long i = 0; i < (long)numEdgeSlots; i++)
+        {
+            keys[i] = mesh.containsEdge(EdgeHandle(i))
+                ? calcKey(EdgeHandle(i))
+                : INVALID_KEY;
+        }
+    };
+    calcAllKeys();
+
+    // ------------------------------------------------------------------------
+    // Collapse rounds
+    // ------------------------------------------------------------------------
+
+    // Smallest priority of all candidates touching a vertex, and smallest
+    // priority of all candidates touching its one-ring.
+    vector<uint64_t> minIncident(numVertexSlots);
+    vector<uint64_t> minAround(numVertexSlots);
+
+    vector<uint64_t> sample;
+    vector<uint64_t> selected;
+    vector<OptionalFaceHandle> removedFaces;
+
+    size_t collapsedEdgeCount = 0;
+
+    // Rejected collapses are marked as invalid, but might have become valid
+    // by changes in their neighborhood. Before giving up, all keys are
+    // calculated again.
+    bool keysAreFresh = true;
+
+    string msg = timestamp.getElapsedTime() + "Collapsing edges ";
+    ProgressBar progress(mesh.numFaces() - targetFaceCount + 1, msg);
+    ++progress;
+
+    while (mesh.numFaces() > targetFaceCount)
+    {
+        // Estimate the cost threshold of the cheapest quarter from a sample of
+        // the valid keys.
+        sample.clear();
+        const Index stride = std::max<Index>(1, numEdgeSlots / 65536);
+        for (Index i = 0; i < numEdgeSlots; i += stride)
+        {
+            if (keys[i] != INVALID_KEY)
+            {
+                sample.push_back(keys[i]);
+            }
+        }
+        if (sample.empty())
+        {
+            // The sample might have missed the few valid edges that are left
+            for (Index i = 0; i < numEdgeSlots; i++)
+            {
+                if (keys[i] != INVALID_KEY)
+                {
+                    sample.push_back(keys[i]);
+                }
+            }
+        }
+        if (sample.empty())
+        {
+            if (keysAreFresh)
+            {
+                break;
+            }
+            calcAllKeys();
+            keysAreFresh = true;
+            continue;
+        }
+        auto quarter = sample.begin() + sample.size() / 4;
+        std::nth_element(sample.begin(), quarter, sample.end());
+        const uint64_t threshold = *quarter;
+
+        // Among the candidates, the collapses are chosen by a pseudo random
+        // priority. Choosing by cost would select only very few edges, as
+        // neighboring edges usually have similar costs.
+        const uint32_t seed = static_cast<uint32_t>(collapsedEdgeCount);
+        auto candidatePriority = [&](EdgeHandle eH) -> uint64_t
+        {
+            if (keys[eH.idx()] > threshold)
+            {
+                return INVALID_KEY;
+            }
+
+            // Finalizer of MurmurHash3
+            uint32_t h = eH.idx() ^ seed;
+            h ^= h >> 16;
+            h *= 0x85ebca6b;
+            h ^= h >> 13;
+            h *= 0xc2b2ae35;
+            h ^= h >> 16;
+            return (static_cast<uint64_t>(h) << 32) | eH.idx();
+        };
+
+        // Find the candidates with locally minimal priority. Two selected
+        // edges can not share a vertex of their one-rings: that vertex would
+        // need both priorities as its `minAround` value.
+        #pragma omp parallel
+        {
+            vector<EdgeHandle> edges;
+
+            #pragma omp for schedule(static)
+            for (long i = 0; i < (long)numVertexSlots; i++)
+            {
+                minIncident[i] = INVALID_KEY;
+                if (!mesh.containsVertex(VertexHandle(i)))
+                {
+                    continue;
+                }
+
+                edges.clear();
+                mesh.getEdgesOfVertex(VertexHandle(i), edges);
+                for (auto eH: edges)
+                {
+                    minIncident[i] = std::min(minIncident[i], candidatePriority(eH));
+                }
+            }
+        }
+
+        #pragma omp parallel
+        {
+            vector<VertexHandle> neighbours;
+
+            #pragma omp for schedule(static)
+            for (long i = 0; i < (long)numVertexSlots; i++)
+            {
+                minAround[i] = minIncident[i];
+                if (!mesh.containsVertex(VertexHandle(i)))
+                {
+                    continue;
+                }
+
+                neighbours.clear();
+                mesh.getNeighboursOfVertex(VertexHandle(i), neighbours);
+                for (auto vH: neighbours)
+                {
+                    minAround[i] = std::min(minAround[i], minIncident[vH.idx()]);
+                }
+            }
+        }
+
+        selected.clear();
+        #pragma omp parallel
+        {
+            vector<VertexHandle> neighbours;
+            vector<uint64_t> localSelected;
+
+            #pragma omp for schedule(static) nowait
+            for (long i = 0; i < (long)numVertexSlots; i++)
+            {
+                // Every edge is checked from the vertex for which it is the
+                // first candidate, which is at most one per vertex.
+                const uint64_t priority = minIncident[i];
+                if (priority == INVALID_KEY || minAround[i] != priority)
+                {
+                    continue;
+                }
+
+                auto vertices = mesh.getVerticesOfEdge(EdgeHandle(priority & 0xFFFFFFFF));
+                if (vertices[0].idx() != i && minIncident[vertices[0].idx()] == priority)
+                {
+                    // The other end point will handle this edge
+                    continue;
+                }
+
+                bool isMinimum = true;
+                for (auto vH: vertices)
+                {
+                    neighbours.clear();
+                    mesh.getNeighboursOfVertex(vH, neighbours);
+                    neighbours.push_back(vH);
+                    for (auto nH: neighbours)
+                    {
+                        if (minAround[nH.idx()] != priority)
+                        {
+                            isMinimum = false;
+                            break;
+                        }
+                    }
+                    if (!isMinimum)
+                    {
+                        break;
+                    }
+                }
+
+                if (isMinimum)
+                {
+                    localSelected.push_back(keys[priority & 0xFFFFFFFF]);
+                }
+            }
+
+            #pragma omp critical
+            selected.insert(selected.end(), localSelected.begin(), localSelected.end());
+        }
+
+        // The globally first candidate is always selected
+        if (selected.empty())
+        {
+            break;
+        }
+
+        // Don't collapse more edges than necessary. Each collapse removes at
+        // most two faces.
+        const size_t maxCollapses = (mesh.numFaces() - targetFaceCount + 1) / 2;
+        if (selected.size() > maxCollapses)
+        {
+            std::sort(selected.begin(), selected.end());
+            selected.resize(maxCollapses);
+        }
+
+        // Collapse all selected edges. They touch disjoint parts of the mesh.
+        removedFaces.assign(selected.size() * 2, OptionalFaceHandle());
+        const size_t facesBefore = mesh.numFaces();
+
+        #pragma omp parallel
+        {
+            vector<FaceHandle> faces;
+            vector<EdgeHandle> edges;
+
+            #pragma omp for schedule(static) reduction(+:collapsedEdgeCount)
+            for (long i = 0; i < (long)selected.size(); i++)
+            {
+                const EdgeHandle eH(selected[i] & 0xFFFFFFFF);
+                auto vertices = mesh.getVerticesOfEdge(eH);
+                auto quadric = quadrics[vertices[0].idx()] + quadrics[vertices[1].idx()];
+                auto target = collapseTarget(vertices[0], vertices[1], quadric);
+
+                if (!mesh.isCollapsable(eH)
+                    || !keepsFaces(vertices[0], vertices[1], target.first, faces)
+                    || !keepsFaces(vertices[1], vertices[0], target.first, faces))
+                {
+                    // The edge is ignored until one of its vertices changes
+                    keys[eH.idx()] = INVALID_KEY;
+                    continue;
+                }
+
+                auto result = mesh.collapseEdge(eH);
+                mesh.getVertexPosition(result.midPoint) = target.first;
+                quadrics[result.midPoint.idx()] = quadric;
+
+                // Removed edges must not show up in the next threshold
+                // estimation.
+                keys[eH.idx()] = INVALID_KEY;
+                for (int j = 0; j < 2; j++)
+                {
+                    if (result.neighbors[j])
+                    {
+                        removedFaces[2 * i + j] = result.neighbors[j]->removedFace;
+                        for (auto removedH: result.neighbors[j]->removedEdges)
+                        {
+                            keys[removedH.idx()] = INVALID_KEY;
+                        }
+                    }
+                }
+
+                // Only the costs of edges touching the new vertex change
+                edges.clear();
+                mesh.getEdgesOfVertex(result.midPoint, edges);
+                for (auto edgeH: edges)
+                {
+                    keys[edgeH.idx()] = calcKey(edgeH);
+                }
+                collapsedEdgeCount++;
+            }
+        }
+
+        progress += facesBefore - mesh.numFaces();
+        if (mesh.numFaces() != facesBefore)
+        {
+            keysAreFresh = false;
+        }
+
+        for (auto fH: removedFaces)
+        {
+            if (fH)
+            {
+                faceNormals.erase(fH.unwrap());
+            }
+        }
+    }
+
+    // Recalculate the normals of all remaining faces, most of them are close
+    // to a moved vertex.
+    vector<Normal<CoordT>> normals(mesh.nextFaceIndex(), Normal<CoordT>(0, 0, 1));
+    parallelForEachFace(mesh, [&](FaceHandle fH)
+    {
+        if (auto maybeNormal = getFaceNormal(mesh.getVertexPositionsOfFace(fH)))
+        {
+            normals[fH.idx()] = *maybeNormal;
+        }
+    });
+    for (auto fH: mesh.faces())
+    {
+        faceNormals.insert(fH, normals[fH.idx()]);
+    }
+
+    cout << endl << timestamp << "Collapsed " << collapsedEdgeCount << " edges..." << endl;
+
+    return collapsedEdgeCount;
+}
+
 } // namespace lvr2
@@ -43,9 +43,15 @@
 #include <lvr2/algorithm/raycasting/RaycasterBase.hpp>
 
 #define EPSILON 0.0000001
+#define DUPLICATE_HIT_EPSILON 0.00001
 #define PI 3.14159265
 #define BVH_STACK_SIZE 64
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LVR2_BVH_RAYCASTER_AVX
+#include <immintrin.h>
+#endif
+
 namespace lvr2
 {
 
@@ -53,6 +59,12 @@ namespace lvr2
 
 /**
  *  @brief BVHRaycaster: CPU version of BVH Raycasting: WIP
+ *
+ *  If the CPU supports AVX, castRays() traces packets of eight neighbouring
+ *  rays together through the BVH. A node is visited once for the whole packet
+ *  and the box and triangle tests run for all eight rays at once. Packets whose
+ *  directions don't share the same signs are too incoherent for this and are
+ *  traced ray by ray.
  */
 template<typename PointT, typename NormalT>
 class BVHRaycaster : public RaycasterBase<PointT, NormalT > {
@@ -62,6 +74,12 @@ public:
      */
     BVHRaycaster(const MeshBufferPtr mesh);
 
+    /**
+     * @brief Constructor: Loads the BVH of the mesh from the given file, or
+     *        builds it and saves it there if the file doesn't fit the mesh
+     */
+    BVHRaycaster(const MeshBufferPtr mesh, const std::string& bvhFile);
+
     bool castRay(
         const PointT& origin,
         const NormalT& direction,
@@ -82,6 +100,114 @@ public:
         std::vector<uint8_t>& hits
     );
 
+    /**
+     * @brief Casts a ray and returns the face, barycentric coordinates and distance of the closest intersection
+     *
+     * @return Whether the ray hits the mesh
+     */
+    bool castRay(
+        const PointT& origin,
+        const NormalT& direction,
+        RayHit& hit
+    );
+
+    /**
+     * @brief Casts rays from one origin and returns the closest intersection of each ray as a RayHit
+     */
+    void castRays(
+        const PointT& origin,
+        const std::vector<NormalT >& directions,
+        std::vector<RayHit>& hits,
+        std::vector<uint8_t>& hitFlags
+    );
+
+    /**
+     * @brief Casts rays from multiple origins and returns the closest intersection of each ray as a RayHit
+     */
+    void castRays(
+        const std::vector<PointT >& origins,
+        const std::vector<NormalT >& directions,
+        std::vector<RayHit>& hits,
+        std::vector<uint8_t>& hitFlags
+    );
+
+    /**
+     * @brief Checks whether the mesh blocks a ray within the given distance, e.g. for shadow rays or visibility
+     *        checks. The traversal stops at the first intersection, so this is much cheaper than castRay().
+     *
+     * @param maxDistance   Distance to the target of the ray, intersections behind it are ignored
+     * @return Whether any face intersects the ray between the origin and maxDistance
+     */
+    bool occluded(
+        const PointT& origin,
+        const NormalT& direction,
+        float maxDistance
+    );
+
+    /**
+     * @brief Checks multiple rays from one origin for occlusion, see occluded()
+     */
+    void occluded(
+        const PointT& origin,
+        const std::vector<NormalT >& directions,
+        float maxDistance,
+        std::vector<uint8_t>& occluded
+    );
+
+    /**
+     * @brief Checks multiple rays from multiple origins for occlusion, see occluded()
+     *
+     * @param maxDistances  Distance to the target of each ray
+     */
+    void occluded(
+        const std::vector<PointT >& origins,
+        const std::vector<NormalT >& directions,
+        const std::vector<float>& maxDistances,
+        std::vector<uint8_t>& occluded
+    );
+
+    /**
+     * @brief Casts a ray and returns its first intersections, e.g. to simulate multiple echoes of a laser scanner
+     *
+     * A ray through a shared edge or vertex hits all adjacent triangles at
+     * the same distance. These hits are reported only once.
+     *
+     * @param maxHits   Maximum number of intersections to return
+     * @param hits      The closest maxHits intersections, sorted by distance
+     * @return The number of intersections
+     */
+    size_t castRayMulti(
+        const PointT& origin,
+        const NormalT& direction,
+        size_t maxHits,
+        std::vector<RayHit>& hits
+    );
+
+    /**
+     * @brief Casts rays from one origin and returns their first intersections, see castRayMulti()
+     *
+     * @param hits      maxHits entries per ray, the intersections of ray i start at hits[i * maxHits]
+     * @param numHits   Number of intersections of each ray
+     */
+    void castRaysMulti(
+        const PointT& origin,
+        const std::vector<NormalT >& directions,
+        size_t maxHits,
+        std::vector<RayHit>& hits,
+        std::vector<uint32_t>& numHits
+    );
+
+    /**
+     * @brief Casts rays from multiple origins and returns their first intersections, see castRaysMulti()
+     */
+    void castRaysMulti(
+        const std::vector<PointT >& origins,
+        const std::vector<NormalT >& directions,
+        size_t maxHits,
+        std::vector<RayHit>& hits,
+        std::vector<uint32_t>& numHits
+    );
+
 
     /**
      * @struct Ray
@@ -110,6 +236,10 @@ public:
 protected:
     BVHTree<PointT> m_bvh;
 
+    // Mesh data to compute the barycentric coordinates of hits
+    floatArr m_vertices;
+    indexArray m_faces;
+
 private:
 
 
@@ -234,6 +364,94 @@ private:
         uint8_t* result_hits
     );
 
+    /**
+     * @brief Traverses the BVH front to back and passes every intersection closer than the current maximum distance
+     *        to the visitor
+     *
+     * @param ray_origin    Origin of the ray
+     * @param ray           Direction of the ray
+     * @param maxDistance   Intersections behind this distance are ignored
+     * @param visitor       Called as visitor(triangle, distance) with the index of the triangle in the intersection
+     *                      data. Returns the new maximum distance, or a negative value to stop the traversal.
+     */
+    template<typename VisitorT>
+    void traverseBVH(
+        const float* ray_origin,
+        const float* ray,
+        float maxDistance,
+        VisitorT&& visitor
+    );
+
+    /**
+     * @brief Collects the closest maxHits intersections of a ray in hits, see castRayMulti()
+     */
+    size_t castRayMulti(
+        const float* ray_origin,
+        const float* ray,
+        size_t maxHits,
+        RayHit* hits
+    );
+
+    /**
+     * @brief Fills the face and barycentric coordinates of a hit at the given distance of the ray
+     */
+    void fillHit(
+        const float* ray_origin,
+        const float* ray,
+        unsigned int triangle,
+        float distance,
+        RayHit& hit
+    );
+
+    /// Number of rays traced together by the packet traversal
+    static constexpr size_t PACKET_SIZE = 8;
+
+    /// Returns whether the packet traversal can be used on this CPU
+    static bool usePackets();
+
+    /**
+     * @brief Casts multiple rays in packets of PACKET_SIZE rays, see cast_ray_packet_avx()
+     *
+     * @param origin_stride 0 if all rays start at the first origin, 3 if each ray has its own origin
+     */
+    void cast_rays_packets(
+        const float* ray_origin,
+        size_t origin_stride,
+        const float* rays,
+        size_t num_rays,
+        const unsigned int* clBVHindicesOrTriLists,
+        const float* clBVHlimits,
+        const float* clTriangleIntersectionData,
+        const unsigned int* clTriIdxList,
+        float* result,
+        uint8_t* result_hits
+    );
+
+#ifdef LVR2_BVH_RAYCASTER_AVX
+    /**
+     * @brief Casts up to PACKET_SIZE rays through the BVH together
+     *
+     * Uses the same box and triangle tests as intersectTrianglesBVH(), but on
+     * eight rays per instruction. Missing rays of a smaller packet are filled
+     * up with copies of the last ray.
+     *
+     * @param origin_stride 0 if all rays start at the first origin, 3 if each ray has its own origin
+     */
+    __attribute__((target("avx")))
+    void cast_ray_packet_avx(
+        const float* ray_origin,
+        size_t origin_stride,
+        const float* rays,
+        size_t num_rays,
+        const unsigned int* clBVHindicesOrTriLists,
+        const float* clBVHlimits,
+        const float* clTriangleIntersectionData,
+        const unsigned int* clTriIdxList,
+        float* result,
+        uint8_t* result_hits
+    );
+#endif
+
 
 };
 
@@ -4,10 +4,22 @@ template <typename PointT, typename NormalT>
 BVHRaycaster<PointT, NormalT>::BVHRaycaster(const MeshBufferPtr mesh)
 :RaycasterBase<PointT, NormalT>(mesh)
 ,m_bvh(mesh)
+,m_vertices(mesh->getVertices())
+,m_faces(mesh->getFaceIndices())
 {
     
 }
 
+template <typename PointT, typename NormalT>
+BVHRaycaster<PointT, NormalT>::BVHRaycaster(const MeshBufferPtr mesh, const std::string& bvhFile)
+:RaycasterBase<PointT, NormalT>(mesh)
+,m_bvh(mesh, bvhFile)
+,m_vertices(mesh->getVertices())
+,m_faces(mesh->getFaceIndices())
+{
+
+}
+
 template <typename PointT, typename NormalT>
 bool BVHRaycaster<PointT, NormalT>::castRay(
     const PointT& origin,
@@ -64,6 +76,21 @@ void BVHRaycaster<PointT, NormalT>::castRays(
 
     size_t num_rays = directions.size();
 
+    if (usePackets())
+    {
+        cast_rays_packets(origin_f,
+            0,
+            direction_f,
+            num_rays,
+            clBVHindicesOrTriLists,
+            clBVHlimits,
+            clTriangleIntersectionData,
+            clTriIdxList,
+            result,
+            result_hits);
+        return;
+    }
+
     cast_rays_one_multi(origin_f, 
         direction_f, 
         num_rays,
@@ -99,6 +126,21 @@ void BVHRaycaster<PointT, NormalT>::castRays(
 
     size_t num_rays = directions.size();
 
+    if (usePackets())
+    {
+        cast_rays_packets(origin_f,
+            3,
+            direction_f,
+            num_rays,
+            clBVHindicesOrTriLists,
+            clBVHlimits,
+            clTriangleIntersectionData,
+            clTriIdxList,
+            result,
+            result_hits);
+        return;
+    }
+
     cast_rays_multi_multi(origin_f, 
         direction_f, 
         num_rays,
@@ -112,6 +154,194 @@ void BVHRaycaster<PointT, NormalT>::castRays(
 }
 
 
+template <typename PointT, typename NormalT>
+bool BVHRaycaster<PointT, NormalT>::castRay(
+    const PointT& origin,
+    const NormalT& direction,
+    RayHit& hit
+)
+{
+    const float *origin_f = reinterpret_cast<const float*>(&origin.x);
+    const float *direction_f = reinterpret_cast<const float*>(&direction.x);
+
+    bool found = false;
+    unsigned int bestTriangle = 0;
+    float bestDistance = 0;
+    traverseBVH(origin_f, direction_f, std::numeric_limits<float>::max(),
+        [&](unsigned int triangle, float distance)
+        {
+            found = true;
+            bestTriangle = triangle;
+            bestDistance = distance;
+            return distance;
+        });
+
+    if (found)
+    {
+        fillHit(origin_f, direction_f, bestTriangle, bestDistance, hit);
+    }
+
+    return found;
+}
+
+template <typename PointT, typename NormalT>
+void BVHRaycaster<PointT, NormalT>::castRays(
+    const PointT& origin,
+    const std::vector<NormalT >& directions,
+    std::vector<RayHit>& hits,
+    std::vector<uint8_t>& hitFlags
+)
+{
+    hits.resize(directions.size());
+    hitFlags.resize(directions.size());
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for(long i = 0; i < (long)directions.size(); i++)
+    {
+        hitFlags[i] = castRay(origin, directions[i], hits[i]);
+    }
+}
+
+template <typename PointT, typename NormalT>
+void BVHRaycaster<PointT, NormalT>::castRays(
+    const std::vector<PointT >& origins,
+    const std::vector<NormalT >& directions,
+    std::vector<RayHit>& hits,
+    std::vector<uint8_t>& hitFlags
+)
+{
+    hits.resize(directions.size());
+    hitFlags.resize(directions.size());
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for(long i = 0; i < (long)directions.size(); i++)
+    {
+        hitFlags[i] = castRay(origins[i], directions[i], hits[i]);
+    }
+}
+
+template <typename PointT, typename NormalT>
+bool BVHRaycaster<PointT, NormalT>::occluded(
+    const PointT& origin,
+    const NormalT& direction,
+    float maxDistance
+)
+{
+    const float *origin_f = reinterpret_cast<const float*>(&origin.x);
+    const float *direction_f = reinterpret_cast<const float*>(&direction.x);
+
+    // Any intersection will do, so stop at the first one
+    bool found = false;
+    traverseBVH(origin_f, direction_f, maxDistance,
+        [&](unsigned int, float)
+        {
+            found = true;
+            return -1.0f;
+        });
+
+    return found;
+}
+
+template <typename PointT, typename NormalT>
+void BVHRaycaster<PointT, NormalT>::occluded(
+    const PointT& origin,
+    const std::vector<NormalT >& directions,
+    float maxDistance,
+    std::vector<uint8_t>& occluded
+)
+{
+    occluded.resize(directions.size());
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for(long i = 0; i < (long)directions.size(); i++)
+    {
+        occluded[i] = this->occluded(origin, directions[i], maxDistance);
+    }
+}
+
+template <typename PointT, typename NormalT>
+void BVHRaycaster<PointT, NormalT>::occluded(
+    const std::vector<PointT >& origins,
+    const std::vector<NormalT >& directions,
+    const std::vector<float>& maxDistances,
+    std::vector<uint8_t>& occluded
+)
+{
+    occluded.resize(directions.size());
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for(long i = 0; i < (long)directions.size(); i++)
+    {
+        occluded[i] = this->occluded(origins[i], directions[i], maxDistances[i]);
+    }
+}
+
+template <typename PointT, typename NormalT>
+size_t BVHRaycaster<PointT, NormalT>::castRayMulti(
+    const PointT& origin,
+    const NormalT& direction,
+    size_t maxHits,
+    std::vector<RayHit>& hits
+)
+{
+    hits.resize(maxHits);
+    size_t numHits = castRayMulti(
+        reinterpret_cast<const float*>(&origin.x),
+        reinterpret_cast<const float*>(&direction.x),
+        maxHits,
+        hits.data());
+    hits.resize(numHits);
+
+    return numHits;
+}
+
+template <typename PointT, typename NormalT>
+void BVHRaycaster<PointT, NormalT>::castRaysMulti(
+    const PointT& origin,
+    const std::vector<NormalT >& directions,
+    size_t maxHits,
+    std::vector<RayHit>& hits,
+    std::vector<uint32_t>& numHits
+)
+{
+    hits.resize(directions.size() * maxHits);
+    numHits.resize(directions.size());
+
+    const float *origin_f = reinterpret_cast<const float*>(&origin.x);
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for(long i = 0; i < (long)directions.size(); i++)
+    {
+        numHits[i] = castRayMulti(origin_f,
+            reinterpret_cast<const float*>(&directions[i].x),
+            maxHits,
+            hits.data() + i * maxHits);
+    }
+}
+
+template <typename PointT, typename NormalT>
+void BVHRaycaster<PointT, NormalT>::castRaysMulti(
+    const std::vector<PointT >& origins,
+    const std::vector<NormalT >& directions,
+    size_t maxHits,
+    std::vector<RayHit>& hits,
+    std::vector<uint32_t>& numHits
+)
+{
+    hits.resize(directions.size() * maxHits);
+    numHits.resize(directions.size());
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for(long i = 0; i < (long)directions.size(); i++)
+    {
+        numHits[i] = castRayMulti(reinterpret_cast<const float*>(&origins[i].x),
+            reinterpret_cast<const float*>(&directions[i].x),
+            maxHits,
+            hits.data() + i * maxHits);
+    }
+}
+
+
 // PRIVATE FUNCTIONS
 template <typename PointT, typename NormalT>
 bool BVHRaycaster<PointT, NormalT>::rayIntersectsBox(
@@ -461,4 +691,502 @@ void BVHRaycaster<PointT, NormalT>::cast_rays_multi_multi(
 
 }
 
-} // namespace lvr2
\ No newline at end of file
+template <typename PointT, typename NormalT>
+template <typename VisitorT>
+void BVHRaycaster<PointT, NormalT>::traverseBVH(
+        const float* ray_origin,
+        const float* ray,
+        float maxDistance,
+        VisitorT&& visitor
+    )
+{
+    const unsigned int* clBVHindicesOrTriLists = m_bvh.getIndexesOrTrilists().data();
+    const float* clBVHlimits = m_bvh.getLimits().data();
+    const float* clTriangleIntersectionData = m_bvh.getTrianglesIntersectionData().data();
+    const unsigned int* clTriIdxList = m_bvh.getTriIndexList().data();
+
+    if (m_bvh.getIndexesOrTrilists().empty())
+    {
+        return;
+    }
+
+    int tid_scale = 4;
+    int bvh_limits_scale = 2;
+
+    float invDir[3];
+    for(int k = 0; k < 3; k++)
+    {
+        invDir[k] = 1.0f / ray[k];
+    }
+
+    unsigned int stack[BVH_STACK_SIZE];
+    int stackId = 0;
+    stack[stackId++] = 0;
+
+    // while stack is not empty
+    while (stackId)
+    {
+        unsigned int boxId = stack[--stackId];
+
+        // Slab test, which skips boxes behind maxDistance. NaNs of rays
+        // parallel to a slab fail the comparisons and are ignored.
+        const float* limits = &clBVHlimits[bvh_limits_scale * 3 * boxId];
+        float tNear = 0.0f;
+        float tFar = maxDistance;
+        for(int k = 0; k < 3; k++)
+        {
+            float t0 = (limits[2 * k] - ray_origin[k]) * invDir[k];
+            float t1 = (limits[2 * k + 1] - ray_origin[k]) * invDir[k];
+            float tMin = std::min(t0, t1);
+            float tMax = std::max(t0, t1);
+            if (tMin > tNear)
+            {
+                tNear = tMin;
+            }
+            if (tMax < tFar)
+            {
+                tFar = tMax;
+            }
+        }
+        if (tNear > tFar)
+        {
+            continue;
+        }
+
+        if (!(clBVHindicesOrTriLists[4 * boxId + 0] & 0x80000000)) // inner node
+        {
+            if (stackId + 2 > BVH_STACK_SIZE)
+            {
+                printf("BVH stack size exceeded!");
+                return;
+            }
+
+            unsigned int left = clBVHindicesOrTriLists[4 * boxId + 1];
+            unsigned int right = clBVHindicesOrTriLists[4 * boxId + 2];
+
+            // Visit the child first, which lies in the direction of the ray
+            const float* l = &clBVHlimits[bvh_limits_scale * 3 * left];
+            const float* r = &clBVHlimits[bvh_limits_scale * 3 * right];
+            float toRight = 0;
+            for(int k = 0; k < 3; k++)
+            {
+                toRight += ((r[2 * k] + r[2 * k + 1]) - (l[2 * k] + l[2 * k + 1])) * ray[k];
+            }
+
+            if (toRight > 0)
+            {
+                stack[stackId++] = right;
+                stack[stackId++] = left;
+            }
+            else
+            {
+                stack[stackId++] = left;
+                stack[stackId++] = right;
+            }
+        }
+        else // leaf node
+        {
+            unsigned int start = clBVHindicesOrTriLists[4 * boxId + 3];
+            unsigned int end = start + (clBVHindicesOrTriLists[4 * boxId + 0] & 0x7fffffff);
+            for (unsigned int i = start; i < end; i++)
+            {
+                unsigned int idx = clTriIdxList[i];
+                const float* normal = clTriangleIntersectionData + tid_scale * 4 * idx;
+
+                float k = normal[0] * ray[0] + normal[1] * ray[1] + normal[2] * ray[2];
+                if (k == 0.0f)
+                {
+                    continue; // this triangle is parallel to the ray -> ignore it
+                }
+                float s = (normal[3] - (normal[0] * ray_origin[0] + normal[1] * ray_origin[1] + normal[2] * ray_origin[2])) / k;
+                if (s <= EPSILON || s > maxDistance)
+                {
+                    continue; // behind the origin or farther than the hits so far
+                }
+
+                float hit[3];
+                for(int j = 0; j < 3; j++)
+                {
+                    hit[j] = ray_origin[j] + ray[j] * s;
+                }
+
+                // check if the intersection with the triangle's plane is inside the triangle
+                bool inside = true;
+                for(int e = 1; e <= 3 && inside; e++)
+                {
+                    const float* ee = normal + tid_scale * e;
+                    inside = ee[0] * hit[0] + ee[1] * hit[1] + ee[2] * hit[2] - ee[3] >= 0.0f;
+                }
+                if (!inside)
+                {
+                    continue;
+                }
+
+                maxDistance = visitor(idx, s);
+                if (maxDistance < 0)
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+template <typename PointT, typename NormalT>
+size_t BVHRaycaster<PointT, NormalT>::castRayMulti(
+        const float* ray_origin,
+        const float* ray,
+        size_t maxHits,
+        RayHit* hits
+    )
+{
+    if (maxHits == 0)
+    {
+        return 0;
+    }
+
+    // Keep the closest hits sorted by insertion. Once maxHits hits are found,
+    // only boxes and triangles before the last of them are searched.
+    size_t numHits = 0;
+    traverseBVH(ray_origin, ray, std::numeric_limits<float>::max(),
+        [&](unsigned int triangle, float distance)
+        {
+            // Triangles sharing the edge or vertex the ray passes through
+            // yield the same intersection
+            float tolerance = DUPLICATE_HIT_EPSILON * std::max(1.0f, distance);
+            for (size_t i = 0; i < numHits; i++)
+            {
+                if (std::abs(hits[i].distance - distance) <= tolerance)
+                {
+                    return numHits == maxHits ? hits[maxHits - 1].distance : std::numeric_limits<float>::max();
+                }
+            }
+
+            size_t pos = std::min(numHits, maxHits - 1);
+            while (pos > 0 && hits[pos - 1].distance > distance)
+            {
+                hits[pos] = hits[pos - 1];
+                pos--;
+            }
+            hits[pos].faceId = triangle;
+            hits[pos].distance = distance;
+            numHits = std::min(numHits + 1, maxHits);
+
+            return numHits == maxHits ? hits[maxHits - 1].distance : std::numeric_limits<float>::max();
+        });
+
+    // faceId holds the index of the triangle up to here
+    for(size_t i = 0; i < numHits; i++)
+    {
+        fillHit(ray_origin, ray, hits[i].faceId, hits[i].distance, hits[i]);
+    }
+
+    return numHits;
+}
+
+template <typename PointT, typename NormalT>
+void BVHRaycaster<PointT, NormalT>::fillHit(
+        const float* ray_origin,
+        const float* ray,
+        unsigned int triangle,
+        float distance,
+        RayHit& hit
+    )
+{
+    uint32_t face = m_bvh.getTriangleFaces()[triangle];
+
+    PointT p(ray_origin[0] + ray[0] * distance,
+        ray_origin[1] + ray[1] * distance,
+        ray_origin[2] + ray[2] * distance);
+    PointT v[3];
+    for(int i = 0; i < 3; i++)
+    {
+        const float* vertex = &m_vertices[m_faces[face * 3 + i] * 3];
+        v[i] = PointT(vertex[0], vertex[1], vertex[2]);
+    }
+
+    PointT v0 = v[1] - v[0];
+    PointT v1 = v[2] - v[0];
+    PointT v2 = p - v[0];
+    float d00 = v0.dot(v0);
+    float d01 = v0.dot(v1);
+    float d11 = v1.dot(v1);
+    float d20 = v2.dot(v0);
+    float d21 = v2.dot(v1);
+    float denom = d00 * d11 - d01 * d01;
+
+    hit.faceId = face;
+    hit.u = (d11 * d20 - d01 * d21) / denom;
+    hit.v = (d00 * d21 - d01 * d20) / denom;
+    hit.distance = distance;
+}
+
+template <typename PointT, typename NormalT>
+bool BVHRaycaster<PointT, NormalT>::usePackets()
+{
+#ifdef LVR2_BVH_RAYCASTER_AVX
+    static const bool avx = __builtin_cpu_supports("avx");
+    return avx;
+#else
+    return false;
+#endif
+}
+
+template <typename PointT, typename NormalT>
+void BVHRaycaster<PointT, NormalT>::cast_rays_packets(
+        const float* ray_origin,
+        size_t origin_stride,
+        const float* rays,
+        size_t num_rays,
+        const unsigned int* clBVHindicesOrTriLists,
+        const float* clBVHlimits,
+        const float* clTriangleIntersectionData,
+        const unsigned int* clTriIdxList,
+        float* result,
+        uint8_t* result_hits
+    )
+{
+    const size_t packet_size = PACKET_SIZE;
+    long num_packets = (num_rays + packet_size - 1) / packet_size;
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for(long p = 0; p < num_packets; p++)
+    {
+        size_t first = p * packet_size;
+        size_t count = std::min(packet_size, num_rays - first);
+
+        // Packets only pay off if the rays take similar paths through the BVH,
+        // so they must at least point into the same octant
+        bool coherent = true;
+        for(size_t i = first + 1; i < first + count; i++)
+        {
+            for(int k = 0; k < 3; k++)
+            {
+                coherent &= std::signbit(rays[i * 3 + k]) == std::signbit(rays[first * 3 + k]);
+            }
+        }
+
+#ifdef LVR2_BVH_RAYCASTER_AVX
+        if(coherent)
+        {
+            cast_ray_packet_avx(ray_origin + first * origin_stride,
+                origin_stride,
+                rays + first * 3,
+                count,
+                clBVHindicesOrTriLists,
+                clBVHlimits,
+                clTriangleIntersectionData,
+                clTriIdxList,
+                result + first * 3,
+                result_hits + first);
+            continue;
+        }
+
+        // Trace incoherent rays on their own. The packet kernel still beats
+        // the scalar traversal, as it visits the closer child first and skips
+        // boxes behind the closest hit.
+        for(size_t i = first; i < first + count; i++)
+        {
+            cast_ray_packet_avx(ray_origin + i * origin_stride,
+                origin_stride,
+                rays + i * 3,
+                1,
+                clBVHindicesOrTriLists,
+                clBVHlimits,
+                clTriangleIntersectionData,
+                clTriIdxList,
+                result + i * 3,
+                result_hits + i);
+        }
+        continue;
+#endif
+
+        for(size_t i = first; i < first + count; i++)
+        {
+            cast_rays_one_one(ray_origin + i * origin_stride,
+                rays + i * 3,
+                clBVHindicesOrTriLists,
+                clBVHlimits,
+                clTriangleIntersectionData,
+                clTriIdxList,
+                result + i * 3,
+                result_hits + i);
+        }
+    }
+}
+
+#ifdef LVR2_BVH_RAYCASTER_AVX
+
+/// Dot products of the vector v with each of the eight vectors p in the same order as the scalar code
+__attribute__((target("avx")))
+inline __m256 packetDot(const float* v, const __m256* p)
+{
+    __m256 sum = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(v[0]), p[0]), _mm256_mul_ps(_mm256_set1_ps(v[1]), p[1]));
+    return _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(v[2]), p[2]));
+}
+
+template <typename PointT, typename NormalT>
+__attribute__((target("avx")))
+void BVHRaycaster<PointT, NormalT>::cast_ray_packet_avx(
+        const float* ray_origin,
+        size_t origin_stride,
+        const float* rays,
+        size_t num_rays,
+        const unsigned int* clBVHindicesOrTriLists,
+        const float* clBVHlimits,
+        const float* clTriangleIntersectionData,
+        const unsigned int* clTriIdxList,
+        float* result,
+        uint8_t* result_hits
+    )
+{
+    int tid_scale = 4;
+    int bvh_limits_scale = 2;
+
+    // Convert the rays to one register per coordinate
+    alignas(32) float origins[3][PACKET_SIZE];
+    alignas(32) float dirs[3][PACKET_SIZE];
+    alignas(32) float invDirs[3][PACKET_SIZE];
+    for(size_t i = 0; i < PACKET_SIZE; i++)
+    {
+        size_t ray = std::min(i, num_rays - 1);
+        for(int k = 0; k < 3; k++)
+        {
+            origins[k][i] = ray_origin[ray * origin_stride + k];
+            dirs[k][i] = rays[ray * 3 + k];
+            invDirs[k][i] = 1.0 / rays[ray * 3 + k];
+        }
+    }
+
+    __m256 o[3], d[3], invD[3];
+    for(int k = 0; k < 3; k++)
+    {
+        o[k] = _mm256_load_ps(origins[k]);
+        d[k] = _mm256_load_ps(dirs[k]);
+        invD[k] = _mm256_load_ps(invDirs[k]);
+    }
+
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 epsilon = _mm256_set1_ps(EPSILON);
+
+    // Factor s of the closest hit along each ray
+    __m256 best = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    __m256 hit = zero;
+
+    unsigned int stack[BVH_STACK_SIZE];
+    int stackId = 0;
+    stack[stackId++] = 0;
+
+    // while stack is not empty
+    while (stackId)
+    {
+        unsigned int boxId = stack[--stackId];
+
+        // Slab test against the box for all rays which could still find a
+        // closer hit in it. Operands are ordered so that NaNs of rays parallel
+        // to a slab are ignored.
+        const float* limits = &clBVHlimits[bvh_limits_scale * 3 * boxId];
+        __m256 tNear = zero;
+        __m256 tFar = best;
+        for(int k = 0; k < 3; k++)
+        {
+            __m256 t0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(limits[2 * k]), o[k]), invD[k]);
+            __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(limits[2 * k + 1]), o[k]), invD[k]);
+            tNear = _mm256_max_ps(_mm256_min_ps(t0, t1), tNear);
+            tFar = _mm256_min_ps(_mm256_max_ps(t0, t1), tFar);
+        }
+        __m256 active = _mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ);
+        if (!_mm256_movemask_ps(active))
+        {
+            continue;
+        }
+
+        if (!(clBVHindicesOrTriLists[4 * boxId + 0] & 0x80000000)) // inner node
+        {
+            if (stackId + 2 > BVH_STACK_SIZE)
+            {
+                printf("BVH stack size exceeded!");
+                break;
+            }
+
+            unsigned int left = clBVHindicesOrTriLists[4 * boxId + 1];
+            unsigned int right = clBVHindicesOrTriLists[4 * boxId + 2];
+
+            // Visit the child first, which lies in the direction of the first ray
+            const float* l = &clBVHlimits[bvh_limits_scale * 3 * left];
+            const float* r = &clBVHlimits[bvh_limits_scale * 3 * right];
+            float toRight = 0;
+            for(int k = 0; k < 3; k++)
+            {
+                toRight += ((r[2 * k] + r[2 * k + 1]) - (l[2 * k] + l[2 * k + 1])) * dirs[k][0];
+            }
+
+            if (toRight > 0)
+            {
+                stack[stackId++] = right;
+                stack[stackId++] = left;
+            }
+            else
+            {
+                stack[stackId++] = left;
+                stack[stackId++] = right;
+            }
+        }
+        else // leaf node
+        {
+            unsigned int start = clBVHindicesOrTriLists[4 * boxId + 3];
+            unsigned int end = start + (clBVHindicesOrTriLists[4 * boxId + 0] & 0x7fffffff);
+            for (unsigned int i = start; i < end; i++)
+            {
+                const float* normal = clTriangleIntersectionData + tid_scale * 4 * clTriIdxList[i];
+
+                // distance factor of the intersection with the triangle's plane
+                __m256 k = packetDot(normal, d);
+                __m256 s = _mm256_div_ps(_mm256_sub_ps(_mm256_set1_ps(normal[3]), packetDot(normal, o)), k);
+
+                // skip parallel triangles, triangles behind the origin and all
+                // but closer hits
+                __m256 valid = _mm256_and_ps(active, _mm256_cmp_ps(k, zero, _CMP_NEQ_OQ));
+                valid = _mm256_and_ps(valid, _mm256_cmp_ps(s, epsilon, _CMP_GT_OQ));
+                valid = _mm256_and_ps(valid, _mm256_cmp_ps(s, best, _CMP_LT_OQ));
+                if (!_mm256_movemask_ps(valid))
+                {
+                    continue;
+                }
+
+                // check if the intersection with the triangle's plane is inside the triangle
+                __m256 p[3];
+                for(int c = 0; c < 3; c++)
+                {
+                    p[c] = _mm256_add_ps(_mm256_mul_ps(d[c], s), o[c]);
+                }
+                for(int e = 1; e <= 3; e++)
+                {
+                    const float* ee = normal + tid_scale * e;
+                    __m256 kt = _mm256_sub_ps(packetDot(ee, p), _mm256_set1_ps(ee[3]));
+                    valid = _mm256_and_ps(valid, _mm256_cmp_ps(kt, zero, _CMP_GE_OQ));
+                }
+
+                best = _mm256_blendv_ps(best, s, valid);
+                hit = _mm256_or_ps(hit, valid);
+            }
+        }
+    }
+
+    alignas(32) float bestS[PACKET_SIZE];
+    _mm256_store_ps(bestS, best);
+    int hits = _mm256_movemask_ps(hit);
+
+    for(size_t i = 0; i < num_rays; i++)
+    {
+        result_hits[i] = (hits >> i) & 1;
+        for(int k = 0; k < 3; k++)
+        {
+            result[i * 3 + k] = result_hits[i] ? dirs[k][i] * bestS[i] + origins[k][i] : 0;
+        }
+    }
+}
+
+#endif
+
+} // namespace lvr2
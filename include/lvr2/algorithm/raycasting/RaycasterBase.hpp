@@ -41,6 +41,23 @@
 namespace lvr2
 {
 
+/**
+ * @brief Record of the intersection of a ray with a mesh face
+ */
+struct RayHit
+{
+    /// Index of the hit face in the mesh
+    uint32_t faceId;
+
+    /// Barycentric coordinates of the intersection with respect to the second and third vertex of the face.
+    /// The coordinate of the first vertex is 1 - u - v.
+    float u;
+    float v;
+
+    /// Distance between the ray origin and the intersection
+    float distance;
+};
+
 /**
  * @brief RaycasterBase interface
  */
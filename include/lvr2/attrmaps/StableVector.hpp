@@ -35,6 +35,8 @@
 #ifndef LVR2_ATTRMAPS_STABLEVECTOR_H_
 #define LVR2_ATTRMAPS_STABLEVECTOR_H_
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <utility>
 #include <boost/optional.hpp>
@@ -61,13 +63,21 @@ template<typename HandleT, typename ElemT>
 class StableVectorIterator
 {
 private:
-    /// Reference to the deleted marker array this iterator belongs to
-    const vector<optional<ElemT>>* m_elements;
+    /// Bitmap of the used slots of the vector this iterator belongs to
+    const uint64_t* m_usedBits;
+
+    /// Number of slots (including deleted ones) of the vector
+    size_t m_size;
 
     /// Current position in the vector
     size_t m_pos;
+
+    /// Advances `m_pos` to the next used slot (or `m_size`), skipping 64
+    /// deleted slots at once.
+    void skipDeleted();
+
 public:
-    StableVectorIterator(const vector<optional<ElemT>>* deleted, bool startAtEnd = false);
+    StableVectorIterator(const uint64_t* usedBits, size_t size, bool startAtEnd = false);
 
     StableVectorIterator& operator=(const StableVectorIterator& other);
     bool operator==(const StableVectorIterator& other) const;
@@ -83,18 +93,24 @@ public:
 /**
  * @brief A vector which guarantees stable indices and features O(1) deletion.
  *
- * This is basically a wrapper for the std::vector, which marks an element as
- * deleted but does not actually delete it. This means that indices are never
+ * This is basically a vector which marks an element as deleted but does not
+ * free its slot. This means that indices are never
  * invalidated. When inserting an element, you get its index (its so called
  * "handle") back. This handle can later be used to access the element. This
  * remains true regardless of other insertions and deletions happening in
  * between.
  *
+ * The elements are stored densely without any per element overhead. Which
+ * slots hold an element is recorded in a separate bitmap, so deleted slots
+ * are skipped 64 at a time while iterating. Deleted slots are destroyed,
+ * but their memory is only reused by `compact()`.
+ *
  * USE WITH CAUTION: This NEVER frees memory of deleted values (except on its
- * own destruction and can get very large if used incorrectly! If deletions in
- * your use-case are far more numerous than insertions, this data structure is
- * probably not fitting your needs. The memory requirement of this class is
- * O(n_p) where n_p is the number of `push()` calls.
+ * own destruction or in `compact()`) and can get very large if used
+ * incorrectly! If deletions in your use-case are far more numerous than
+ * insertions, this data structure is probably not fitting your needs. The
+ * memory requirement of this class is O(n_p) where n_p is the number of
+ * `push()` calls.
  *
  * @tparam HandleT This handle type contains the actual index. It has to be
  *                 derived from `BaseHandle`!
@@ -116,7 +132,7 @@ public:
     /**
      * @brief Creates an empty StableVector.
      */
-    StableVector() : m_usedCount(0) {};
+    StableVector() : m_usedCount(0), m_size(0), m_capacity(0), m_elements(nullptr) {};
 
     /**
      * @brief Creates a StableVector with `countElements` many copies of
@@ -129,6 +145,11 @@ public:
 
     StableVector(size_t countElements, const boost::shared_array<ElementType>& sharedArray);
 
+    StableVector(const StableVector& other);
+    StableVector(StableVector&& other);
+    StableVector& operator=(StableVector other);
+    ~StableVector();
+
     /**
      * @brief Adds the given element to the vector.
      *
@@ -178,6 +199,9 @@ public:
      * trying to obtain the element with this handle later, will always result
      * in `none` (if `get()` was used). Additionally, the handle can also be
      * used with the `set()` method.
+     *
+     * Erasing different handles from multiple threads at the same time is
+     * safe, as long as no other method is called concurrently.
      */
     void erase(HandleType handle);
 
@@ -273,12 +297,46 @@ public:
      */
     void reserve(size_t newCap);
 
+    /**
+     * @brief Removes all deleted slots by moving the remaining elements to
+     *        the front, keeping their order, and releases the unused memory.
+     *
+     * This invalidates all handles! The element at slot `i` has the index
+     * `newIndices[i]` afterwards, where `newIndices` is the returned vector.
+     * Deleted slots are mapped to `std::numeric_limits<Index>::max()`.
+     */
+    vector<Index> compact();
+
 private:
     /// Count of used elements in elements vector
     size_t m_usedCount;
 
-    /// Vector for stored elements
-    vector<optional<ElementType>> m_elements;
+    /// Number of slots, including deleted ones
+    size_t m_size;
+
+    /// Number of slots `m_elements` has room for
+    size_t m_capacity;
+
+    /// Storage for the elements. Only slots marked in `m_usedBits` hold a
+    /// constructed element.
+    ElementType* m_elements;
+
+    /// Bit `i % 64` of word `i / 64` is set iff slot `i` holds an element
+    vector<uint64_t> m_usedBits;
+
+    bool isUsed(size_t i) const;
+    void markUsed(size_t i);
+    void markDeleted(size_t i);
+
+    /// Sets `m_size` to `newSize` (which must not be smaller) and grows the
+    /// bitmap and, if needed, the storage. The new slots are deleted.
+    void appendSlots(size_t newSize);
+
+    /// Moves all elements into new storage with room for `newCap` slots.
+    void reallocate(size_t newCap);
+
+    /// Destroys all elements and frees the storage.
+    void destroy();
 
     /**
      * @brief Assert that the requested handle is not deleted or throw an
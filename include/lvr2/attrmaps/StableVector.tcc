@@ -35,6 +35,9 @@
 #include <lvr2/util/Panic.hpp>
 #include <boost/shared_array.hpp>
 
+#include <algorithm>
+#include <limits>
+#include <new>
 #include <sstream>
 #include <string>
 
@@ -56,35 +59,166 @@ void StableVector<HandleT, ElemT>::checkAccess(HandleType handle) const
     }
 
     // You cannot access deleted or uninitialized elements!
-    if (!m_elements[handle.idx()])
+    if (!isUsed(handle.idx()))
     {
         panic("attempt to access a deleted value in StableVector");
     }
     #endif
 }
 
+template<typename HandleT, typename ElemT>
+bool StableVector<HandleT, ElemT>::isUsed(size_t i) const
+{
+    return (m_usedBits[i / 64] >> (i % 64)) & 1;
+}
+
+template<typename HandleT, typename ElemT>
+void StableVector<HandleT, ElemT>::markUsed(size_t i)
+{
+    m_usedBits[i / 64] |= uint64_t(1) << (i % 64);
+}
+
+template<typename HandleT, typename ElemT>
+void StableVector<HandleT, ElemT>::markDeleted(size_t i)
+{
+    const uint64_t mask = ~(uint64_t(1) << (i % 64));
+
+    // Neighbouring slots share a word, so this has to be atomic for
+    // concurrent `erase()` calls to be safe.
+    #pragma omp atomic
+    m_usedBits[i / 64] &= mask;
+}
+
+template<typename HandleT, typename ElemT>
+void StableVector<HandleT, ElemT>::appendSlots(size_t newSize)
+{
+    if (newSize > m_capacity)
+    {
+        reallocate(std::max(newSize, 2 * m_capacity));
+    }
+    m_size = newSize;
+    m_usedBits.resize((m_size + 63) / 64, 0);
+}
+
+template<typename HandleT, typename ElemT>
+void StableVector<HandleT, ElemT>::reallocate(size_t newCap)
+{
+    std::allocator<ElemT> alloc;
+    ElemT* elements = newCap > 0 ? alloc.allocate(newCap) : nullptr;
+    for (auto handle: *this)
+    {
+        auto i = handle.idx();
+        new (&elements[i]) ElemT(std::move(m_elements[i]));
+        m_elements[i].~ElemT();
+    }
+    if (m_elements)
+    {
+        alloc.deallocate(m_elements, m_capacity);
+    }
+    m_elements = elements;
+    m_capacity = newCap;
+}
+
+template<typename HandleT, typename ElemT>
+void StableVector<HandleT, ElemT>::destroy()
+{
+    for (auto handle: *this)
+    {
+        m_elements[handle.idx()].~ElemT();
+    }
+    if (m_elements)
+    {
+        std::allocator<ElemT>().deallocate(m_elements, m_capacity);
+    }
+    m_elements = nullptr;
+    m_capacity = 0;
+    m_size = 0;
+    m_usedCount = 0;
+    m_usedBits.clear();
+}
+
 template<typename HandleT, typename ElemT>
 StableVector<HandleT, ElemT>::StableVector(size_t countElements, const ElementType& defaultValue)
-    : m_elements(countElements, defaultValue),
-      m_usedCount(countElements)
-{}
+    : StableVector()
+{
+    increaseSize(HandleT(countElements), defaultValue);
+}
 
 template<typename HandleT, typename ElemT>
 StableVector<HandleT, ElemT>::StableVector(size_t countElements, const boost::shared_array<ElementType>& sharedArray)
-    : m_usedCount(countElements)
+    : StableVector()
 {
-    m_elements.reserve(countElements);
+    appendSlots(countElements);
     #pragma omp parallel for
     for(size_t i=0; i<countElements; i++)
     {
-        m_elements[i] = sharedArray[i];
+        new (&m_elements[i]) ElemT(sharedArray[i]);
     }
+    std::fill(m_usedBits.begin(), m_usedBits.end(), ~uint64_t(0));
+    if (countElements % 64 != 0)
+    {
+        m_usedBits.back() = (uint64_t(1) << (countElements % 64)) - 1;
+    }
+    m_usedCount = countElements;
+}
+
+template<typename HandleT, typename ElemT>
+StableVector<HandleT, ElemT>::StableVector(const StableVector& other)
+    : StableVector()
+{
+    reserve(other.m_size);
+    for (auto handle: other)
+    {
+        new (&m_elements[handle.idx()]) ElemT(other.m_elements[handle.idx()]);
+    }
+    m_size = other.m_size;
+    m_usedCount = other.m_usedCount;
+    m_usedBits = other.m_usedBits;
+}
+
+template<typename HandleT, typename ElemT>
+StableVector<HandleT, ElemT>::StableVector(StableVector&& other)
+    : m_usedCount(other.m_usedCount),
+      m_size(other.m_size),
+      m_capacity(other.m_capacity),
+      m_elements(other.m_elements),
+      m_usedBits(std::move(other.m_usedBits))
+{
+    other.m_elements = nullptr;
+    other.m_capacity = 0;
+    other.m_size = 0;
+    other.m_usedCount = 0;
+    other.m_usedBits.clear();
+}
+
+template<typename HandleT, typename ElemT>
+StableVector<HandleT, ElemT>& StableVector<HandleT, ElemT>::operator=(StableVector other)
+{
+    std::swap(m_usedCount, other.m_usedCount);
+    std::swap(m_size, other.m_size);
+    std::swap(m_capacity, other.m_capacity);
+    std::swap(m_elements, other.m_elements);
+    std::swap(m_usedBits, other.m_usedBits);
+    return *this;
+}
+
+template<typename HandleT, typename ElemT>
+StableVector<HandleT, ElemT>::~StableVector()
+{
+    destroy();
 }
 
 template<typename HandleT, typename ElemT>
 HandleT StableVector<HandleT, ElemT>::push(const ElementType& elem)
 {
-    m_elements.emplace_back(elem);
+    // `elem` might live in this vector, so it is copied before growing.
+    if (m_size == m_capacity)
+    {
+        return push(ElemT(elem));
+    }
+    appendSlots(m_size + 1);
+    new (&m_elements[m_size - 1]) ElemT(elem);
+    markUsed(m_size - 1);
     ++m_usedCount;
     return HandleT(size() - 1);
 }
@@ -92,7 +226,18 @@ HandleT StableVector<HandleT, ElemT>::push(const ElementType& elem)
 template<typename HandleT, typename ElemT>
 HandleT StableVector<HandleT, ElemT>::push(ElementType&& elem)
 {
-    m_elements.emplace_back(move(elem));
+    if (m_size == m_capacity)
+    {
+        ElemT tmp(move(elem));
+        appendSlots(m_size + 1);
+        new (&m_elements[m_size - 1]) ElemT(move(tmp));
+    }
+    else
+    {
+        appendSlots(m_size + 1);
+        new (&m_elements[m_size - 1]) ElemT(move(elem));
+    }
+    markUsed(m_size - 1);
     ++m_usedCount;
     return HandleT(size() - 1);
 }
@@ -105,7 +250,7 @@ void StableVector<HandleT, ElemT>::increaseSize(HandleType upTo)
         panic("call to increaseSize() with a valid handle!");
     }
 
-    m_elements.resize(upTo.idx(), boost::none);
+    appendSlots(upTo.idx());
 }
 
 template<typename HandleT, typename ElemT>
@@ -116,7 +261,16 @@ void StableVector<HandleT, ElemT>::increaseSize(HandleType upTo, const ElementTy
         panic("call to increaseSize() with a valid handle!");
     }
 
-    m_elements.resize(upTo.idx(), elem);
+    // `elem` might live in this vector
+    const ElemT value(elem);
+    const size_t oldSize = m_size;
+    appendSlots(upTo.idx());
+    for (size_t i = oldSize; i < m_size; i++)
+    {
+        new (&m_elements[i]) ElemT(value);
+        markUsed(i);
+    }
+    m_usedCount += m_size - oldSize;
 }
 
 template <typename HandleT, typename ElemT>
@@ -130,54 +284,62 @@ void StableVector<HandleT, ElemT>::erase(HandleType handle)
 {
     checkAccess(handle);
 
-    m_elements[handle.idx()] = boost::none;
-    --m_usedCount;
+    m_elements[handle.idx()].~ElemT();
+    markDeleted(handle.idx());
+    #pragma omp atomic
+    m_usedCount--;
 }
 
 template<typename HandleT, typename ElemT>
 void StableVector<HandleT, ElemT>::clear()
 {
-    m_elements.clear();
+    for (auto handle: *this)
+    {
+        m_elements[handle.idx()].~ElemT();
+    }
+    m_size = 0;
+    m_usedCount = 0;
+    m_usedBits.clear();
 }
 
 template<typename HandleT, typename ElemT>
 boost::optional<ElemT&> StableVector<HandleT, ElemT>::get(HandleType handle)
 {
-    if (handle.idx() >= size() || !m_elements[handle.idx()])
+    if (handle.idx() >= size() || !isUsed(handle.idx()))
     {
         return boost::none;
     }
-    return *m_elements[handle.idx()];
+    return m_elements[handle.idx()];
 }
 
 template<typename HandleT, typename ElemT>
 boost::optional<const ElemT&> StableVector<HandleT, ElemT>::get(HandleType handle) const
 {
-    if (handle.idx() >= size() || !m_elements[handle.idx()])
+    if (handle.idx() >= size() || !isUsed(handle.idx()))
     {
         return boost::none;
     }
-    return *m_elements[handle.idx()];
+    return m_elements[handle.idx()];
 }
 
 template<typename HandleT, typename ElemT>
 ElemT& StableVector<HandleT, ElemT>::operator[](HandleType handle)
 {
     checkAccess(handle);
-    return *m_elements[handle.idx()];
+    return m_elements[handle.idx()];
 }
 
 template<typename HandleT, typename ElemT>
 const ElemT& StableVector<HandleT, ElemT>::operator[](HandleType handle) const
 {
     checkAccess(handle);
-    return *m_elements[handle.idx()];
+    return m_elements[handle.idx()];
 }
 
 template<typename HandleT, typename ElemT>
 size_t StableVector<HandleT, ElemT>::size() const
 {
-    return m_elements.size();
+    return m_size;
 }
 
 template<typename HandleT, typename ElemT>
@@ -196,11 +358,16 @@ void StableVector<HandleT, ElemT>::set(HandleType handle, const ElementType& ele
     }
 
     // insert element
-    if (!m_elements[handle.idx()])
+    if (isUsed(handle.idx()))
+    {
+        m_elements[handle.idx()] = elem;
+    }
+    else
     {
+        new (&m_elements[handle.idx()]) ElemT(elem);
+        markUsed(handle.idx());
         ++m_usedCount;
     }
-    m_elements[handle.idx()] = elem;
 };
 
 template<typename HandleT, typename ElemT>
@@ -213,42 +380,113 @@ void StableVector<HandleT, ElemT>::set(HandleType handle, ElementType&& elem)
     }
 
     // insert element
-    if (!m_elements[handle.idx()])
+    if (isUsed(handle.idx()))
+    {
+        m_elements[handle.idx()] = move(elem);
+    }
+    else
     {
+        new (&m_elements[handle.idx()]) ElemT(move(elem));
+        markUsed(handle.idx());
         ++m_usedCount;
     }
-    m_elements[handle.idx()] = elem;
 };
 
 template<typename HandleT, typename ElemT>
 void StableVector<HandleT, ElemT>::reserve(size_t newCap)
 {
-    m_elements.reserve(newCap);
+    if (newCap > m_capacity)
+    {
+        reallocate(newCap);
+    }
+    m_usedBits.reserve((newCap + 63) / 64);
 };
 
+template<typename HandleT, typename ElemT>
+vector<Index> StableVector<HandleT, ElemT>::compact()
+{
+    vector<Index> newIndices(m_size, std::numeric_limits<Index>::max());
+
+    // Every slot below `next` is either a moved-from and destroyed one or
+    // already holds its final element, so moving into it is safe.
+    size_t next = 0;
+    for (auto handle: *this)
+    {
+        auto i = handle.idx();
+        if (i != next)
+        {
+            new (&m_elements[next]) ElemT(std::move(m_elements[i]));
+            m_elements[i].~ElemT();
+        }
+        newIndices[i] = next;
+        next++;
+    }
+
+    m_size = next;
+    m_usedBits.assign((m_size + 63) / 64, ~uint64_t(0));
+    if (m_size % 64 != 0)
+    {
+        m_usedBits.back() = (uint64_t(1) << (m_size % 64)) - 1;
+    }
+    m_usedBits.shrink_to_fit();
+    reallocate(m_size);
+
+    return newIndices;
+}
+
 template<typename HandleT, typename ElemT>
 StableVectorIterator<HandleT, ElemT> StableVector<HandleT, ElemT>::begin() const
 {
-    return StableVectorIterator<HandleT, ElemT>(&this->m_elements);
+    return StableVectorIterator<HandleT, ElemT>(m_usedBits.data(), m_size);
 }
 
 template<typename HandleT, typename ElemT>
 StableVectorIterator<HandleT, ElemT> StableVector<HandleT, ElemT>::end() const
 {
-    return StableVectorIterator<HandleT, ElemT>(&this->m_elements, true);
+    return StableVectorIterator<HandleT, ElemT>(m_usedBits.data(), m_size, true);
 }
 
 template<typename HandleT, typename ElemT>
 StableVectorIterator<HandleT, ElemT>::StableVectorIterator(
-    const vector<optional<ElemT>>* deleted,
+    const uint64_t* usedBits,
+    size_t size,
     bool startAtEnd
 )
-    : m_elements(deleted), m_pos(startAtEnd ? deleted->size() : 0)
+    : m_usedBits(usedBits), m_size(size), m_pos(startAtEnd ? size : 0)
+{
+    skipDeleted();
+}
+
+template<typename HandleT, typename ElemT>
+void StableVectorIterator<HandleT, ElemT>::skipDeleted()
 {
-    if (m_pos == 0 && !m_elements->empty() && !(*m_elements)[0])
+    if (m_pos >= m_size)
+    {
+        m_pos = m_size;
+        return;
+    }
+
+    // Most slots are used, so check the current one on its own first
+    if ((m_usedBits[m_pos / 64] >> (m_pos % 64)) & 1)
+    {
+        return;
+    }
+
+    // Look at the bits starting at `m_pos` in the current word, then skip
+    // whole words of deleted slots. Bits behind `m_size` are never set.
+    size_t word = m_pos / 64;
+    uint64_t bits = m_usedBits[word] & (~uint64_t(0) << (m_pos % 64));
+    const size_t numWords = (m_size + 63) / 64;
+    while (bits == 0)
     {
-        ++(*this);
+        if (++word == numWords)
+        {
+            m_pos = m_size;
+            return;
+        }
+        bits = m_usedBits[word];
     }
+    m_pos = word * 64 + __builtin_ctzll(bits);
 }
 
 template<typename HandleT, typename ElemT>
@@ -261,7 +499,8 @@ StableVectorIterator<HandleT, ElemT>& StableVectorIterator<HandleT, ElemT>::oper
         return *this;
     }
     m_pos = other.m_pos;
-    m_elements = other.m_elements;
+    m_size = other.m_size;
+    m_usedBits = other.m_usedBits;
 
     return *this;
 }
@@ -271,7 +510,7 @@ bool StableVectorIterator<HandleT, ElemT>::operator==(
     const StableVectorIterator<HandleT, ElemT>& other
 ) const
 {
-    return m_pos == other.m_pos && m_elements == other.m_elements;
+    return m_pos == other.m_pos && m_usedBits == other.m_usedBits;
 }
 
 template<typename HandleT, typename ElemT>
@@ -285,17 +524,11 @@ bool StableVectorIterator<HandleT, ElemT>::operator!=(
 template<typename HandleT, typename ElemT>
 StableVectorIterator<HandleT, ElemT>& StableVectorIterator<HandleT, ElemT>::operator++()
 {
-    // If not at the end, advance by one element
-    if (m_pos < m_elements->size())
-    {
-        m_pos++;
-    }
-
-    // Advance until the next element, at most 1 element behind the vector, to
-    // indicate the end of iteration.
-    while (m_pos < m_elements->size() && !(*m_elements)[m_pos])
+    // If not at the end, advance by one element and on to the next used one
+    if (m_pos < m_size)
     {
         m_pos++;
+        skipDeleted();
     }
 
     return *this;
@@ -304,7 +537,7 @@ StableVectorIterator<HandleT, ElemT>& StableVectorIterator<HandleT, ElemT>::oper
 template<typename HandleT, typename ElemT>
 bool StableVectorIterator<HandleT, ElemT>::isAtEnd() const
 {
-    return m_pos == m_elements->size();
+    return m_pos == m_size;
 }
 
 template<typename HandleT, typename ElemT>
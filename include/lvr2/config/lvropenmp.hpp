@@ -46,11 +46,17 @@ public:
 	/// Returns the number of supported threads (or 1 if OpenMP is not supported)
 	static int  getNumThreads();
 
+	/// Returns the number of the calling thread in the current parallel region (or 0)
+	static int  getThreadNum();
+
 	/// Sets the number of used threads if OpenMP is used for parallelization
 	static void setNumThreads(int n);
 
 	/// Enables the maximum number of parallel threads
 	static void setMaxNumThreads();
+
+	/// Sets the number of nested parallel regions that create threads
+	static void setMaxActiveLevels(int levels);
 };
 
 } // namespace lvr2
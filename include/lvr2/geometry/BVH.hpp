@@ -34,11 +34,15 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <string>
 #include <vector>
 #include <memory>
 
 #include "lvr2/geometry/BoundingBox.hpp"
 #include "lvr2/geometry/Normal.hpp"
+#include "lvr2/io/MeshBuffer.hpp"
 
 using std::unique_ptr;
 using std::vector;
@@ -47,13 +51,47 @@ using std::pair;
 namespace lvr2
 {
 
+/**
+ * @brief   Header of the binary BVH files written by BVHTree::serialize().
+ *
+ *          The header is followed by flat arrays that are each padded to a
+ *          multiple of 8 bytes:
+ *
+ *          - node limits (6 * numNodes floats)
+ *          - node indexes or triangle lists (4 * numNodes uint32)
+ *          - triangle index list (numTriIndices uint32)
+ *          - triangle intersection data (16 * numTriangles floats)
+ *          - mesh face of each triangle (numTriangles uint32)
+ */
+struct BVHFileHeader
+{
+    /// "LVRBVH" followed by null bytes
+    char        magic[8];
+
+    /// Version of the file format
+    uint32_t    version;
+
+    uint32_t    reserved;
+
+    /// Size of the mesh the tree was built for
+    uint64_t    numVertices;
+    uint64_t    numFaces;
+
+    /// Hash of the vertex and face arrays of the mesh
+    uint64_t    meshHash;
+
+    uint64_t    numNodes;
+    uint64_t    numTriIndices;
+    uint64_t    numTriangles;
+};
+
 /**
  * @brief Implementation of an Bounding Volume Hierarchy Tree used for ray casting
  *
  * This class generates a BVHTree from the given triangle mesh represented by vertices and faces. AABB are used as
- * bounding volumes. The Tree Contains inner nodes and leaf nodes. The leaf nodes are grouped into inner nodes using
- * the surface area heuristic. The tree is represented in two ways: the normal tree structure and the cache friendly
- * index representation.
+ * bounding volumes. The Tree Contains inner nodes and leaf nodes. Nodes are split with the binned surface area
+ * heuristic. The subtrees are built in parallel as OpenMP tasks, which write directly into the cache friendly index
+ * representation, so no pointer based tree is created.
  *
  * @tparam BaseVecT
  */
@@ -63,7 +101,7 @@ class BVHTree
 public:
 
     /**
-     * @brief Constructs the tree itself and it's cache friendly representation
+     * @brief Constructs the tree in it's cache friendly representation
      *
      * @param vertices Vertices of mesh to create tree for
      * @param faces Faces of mesh to create tree for
@@ -71,7 +109,7 @@ public:
     BVHTree(const vector<float>& vertices, const vector<uint32_t>& faces);
 
     /**
-     * @brief 
+     * @brief Constructs the tree from raw vertex and face arrays
      */
     BVHTree(
         const floatArr vertices, size_t n_vertices,
@@ -79,10 +117,29 @@ public:
     );
 
     /**
-     * @brief
+     * @brief Constructs the tree for the given mesh
      */
     BVHTree(const MeshBufferPtr mesh);
 
+    /**
+     * @brief Loads the tree for the given mesh from a file written by serialize()
+     *
+     * If the file can't be read, is corrupt or was written for a mesh with different vertices or faces, the tree is
+     * built and saved to the file instead.
+     *
+     * @param mesh Mesh to create tree for
+     * @param file BVH file, e.g. next to the mesh file
+     */
+    BVHTree(const MeshBufferPtr mesh, const std::string& file);
+
+    /**
+     * @brief Writes the tree to a binary file as described by BVHFileHeader
+     */
+    void serialize(const std::string& file) const;
+
+    /// Version of the binary BVH format written by serialize()
+    static constexpr uint32_t FILE_VERSION = 3;
+
     /**
      * @return Index list (for getTrianglesIntersectionData) of triangles in the leaf nodes
      */
@@ -121,127 +178,143 @@ public:
      */
     const vector<float>& getTrianglesIntersectionData() const;
 
-private:
+    /**
+     * @return Index of the mesh face of each triangle in getTrianglesIntersectionData. Degenerated faces are left out
+     *         of the tree, so the indices of triangles and faces differ.
+     */
+    const vector<uint32_t>& getTriangleFaces() const;
 
-    // Internal triangle representation
-    struct Triangle {
+private:
 
-        Triangle();
+    /// Number of bins per axis for the surface area heuristic
+    static constexpr int NUM_BINS = 16;
 
-        // indices in vertex array
-        // todo: not used?
-        uint32_t idx1;
-        uint32_t idx2;
-        uint32_t idx3;
+    /// Nodes with less triangles become leaf nodes
+    static constexpr uint32_t MIN_SPLIT_SIZE = 4;
 
-        BaseVecT center;
-        Normal<float> normal;
+    /// Nodes at this depth become leaf nodes, so that the traversal stack of the ray casters can't overflow
+    static constexpr uint32_t MAX_DEPTH = 48;
 
-        // intersection pre-computed cache
-        float d, d1, d2, d3;
-        Normal<float> e1, e2, e3;
+    /// Subtrees with less triangles are built in the current task
+    static constexpr uint32_t TASK_SIZE = 4096;
 
-        // todo: not used?
-        BoundingBox<BaseVecT> bb;
-    };
+    /// Triangles of larger nodes are binned in parallel chunks of this size
+    static constexpr uint32_t BINNING_CHUNK_SIZE = 1 << 16;
 
-    // Internal AABB representation
+    // Internal AABB representation, cheaper to expand than BoundingBox
     struct AABB {
-        BoundingBox<BaseVecT> bb;
+        AABB();
 
-        // Triangles corresponding to this AABB
-        vector<size_t> triangles;
-    };
+        float min[3];
+        float max[3];
 
-    // Abstract tree node
-    struct BVHNode {
-        BoundingBox<BaseVecT> bb;
-        virtual bool isLeaf() = 0;
-    };
-    using BVHNodePtr = unique_ptr<BVHNode>;
-
-    // Inner tree node
-    struct BVHInner: BVHNode {
+        void expand(const AABB& other);
+        void expand(const float point[3]);
 
-        // Left sub tree
-        BVHNodePtr left;
-
-        // Right sub tree
-        BVHNodePtr right;
-        virtual bool isLeaf() { return false; }
+        /// Half of the surface area
+        float halfArea() const;
     };
-    using BVHInnerPtr = unique_ptr<BVHInner>;
 
-    // Leaf tree node
-    struct BVHLeaf: BVHNode {
+    // Triangles and the bounds of their centroids in one bin of the surface area heuristic
+    struct Bin {
+        AABB bb;
+        AABB centroidBb;
+        uint32_t count = 0;
 
-        // Triangles corresponding to this leaf node
-        vector<size_t> triangles;
-        virtual bool isLeaf() { return true; }
+        void add(const Bin& other);
     };
-    using BVHLeafPtr = unique_ptr<BVHLeaf>;
 
-    // working variables for tree construction
-    BVHNodePtr m_root;
-    vector<Triangle> m_triangles;
+    using Bins = std::array<std::array<Bin, NUM_BINS>, 3>;
 
     // cache friendly data for the SIMD device
     vector<uint32_t> m_triIndexList;
     vector<float> m_limits;
     vector<uint32_t> m_indexesOrTrilists;
     vector<float> m_trianglesIntersectionData;
+    vector<uint32_t> m_triangleFaces;
+
+    // working variables for tree construction
+    vector<AABB> m_triangleBoxes;
+    vector<float> m_triangleCentroids;
 
     /**
-     * @brief Builds the tree without it's cache friendly representation. Utilizes the buildTreeRecursive method.
+     * @brief Builds the tree. Utilizes the buildNodeRecursive method.
      *
-     * @param vertices Vertices of mesh to create tree for
-     * @param faces Faces of mesh to create tree for
-     *
-     * @return Root node of the tree
+     * @param vertices Vertices of mesh to create tree for (3 floats per vertex)
+     * @param faces Faces of mesh to create tree for (3 indices per face)
+     * @param n_faces Number of faces
      */
-    BVHNodePtr buildTree(const vector<float>& vertices, const vector<uint32_t>& faces);
+    template<typename VertexArrT, typename FaceArrT>
+    void buildTree(const VertexArrT& vertices, const FaceArrT& faces, size_t n_faces);
 
     /**
-     * @brief Builds the tree without it's cache friendly representation. Utilizes the buildTreeRecursive method.
+     * @brief Recursive method to build the tree.
      *
-     * @param vertices Vertices of mesh to create tree for
-     * @param faces Faces of mesh to create tree for
+     * Splits the triangles m_triIndexList[begin, end) of the given node and creates its child nodes. The subtrees
+     * are built in parallel tasks.
      *
-     * @return Root node of the tree
+     * @param node Index of the node
+     * @param begin First triangle of the node in m_triIndexList
+     * @param end End of the triangles of the node in m_triIndexList
+     * @param bb Bounding box of the node's triangles
+     * @param centroidBb Bounding box of the centroids of the node's triangles
+     * @param depth The current depth of the tree
+     * @param numNodes Number of nodes created so far
      */
-    BVHNodePtr buildTree(
-        const floatArr vertices, size_t n_vertices,
-        const indexArray faces, size_t n_faces
+    void buildNodeRecursive(
+        uint32_t node,
+        uint32_t begin,
+        uint32_t end,
+        AABB bb,
+        AABB centroidBb,
+        uint32_t depth,
+        std::atomic<uint32_t>* numNodes
     );
 
+    /// Returns the bin of a centroid coordinate, `scale` is NUM_BINS divided by the extent of the centroids
+    static int binIndex(float value, float min, float scale);
+
     /**
-     * @brief Recursive method to build the tree.
-     *
-     * @param work The current work queue to generate the tree from
-     * @param depth The current depth of the tree
-     *
-     * @return Root node of the current tree
+     * @brief Sorts the triangles m_triIndexList[begin, end) into the bins of all axes
      */
-    BVHNodePtr buildTreeRecursive(vector<AABB>& work, uint32_t depth = 0);
+    void binTriangles(uint32_t begin, uint32_t end, const AABB& centroidBb, Bins& bins) const;
+
+    /// Writes the limits of the given node
+    void setLimits(uint32_t node, const AABB& bb);
+
+    /// Turns the given node into a leaf node of the triangles m_triIndexList[begin, end)
+    void setLeaf(uint32_t node, uint32_t begin, uint32_t end);
 
     /**
-     * @brief Creates the cache friendly representation of the tree. Needs the tree itself!
+     * @brief Renumbers the nodes in depth first order
+     *
+     * The tasks create nodes in an unpredictable order. In depth first order, the left child of each inner node
+     * directly follows it, which is faster to traverse and makes the layout independent of the number of threads.
      */
-    void createCFTree();
+    void sortNodes(uint32_t numNodes);
 
     /**
-     * @brief Recursive method for cache friendly tree creation.
+     * @brief Reads a tree written by serialize()
      *
-     * @param currentNode Current node to convert to it's cache friendly form
-     * @param idxBoxes Number of boxes created for the current tree. This has to be increased every time a box
-     *        is processed.
+     * @return false if the file can't be read, is corrupt or was written for another mesh
      */
-    void createCFTreeRecursive(BVHNodePtr currentNode, uint32_t& idxBoxes);
+    bool readBinary(const std::string& file, size_t n_vertices, size_t n_faces, uint64_t meshHash);
 
     /**
-     * @brief Converts the precalculated triangle intersection data to a SIMD friendly structure
+     * @brief Checks that all node, triangle and face indices of a tree read from a file are within their arrays
      */
-    void convertTrianglesIntersectionData();
+    bool isConsistent() const;
+
+    /// Returns a hash (FNV-1a) of the vertex and face arrays of a mesh
+    template<typename VertexArrT, typename FaceArrT>
+    static uint64_t hashMesh(const VertexArrT& vertices, size_t n_vertices, const FaceArrT& faces, size_t n_faces);
+
+    /// Size of the mesh the tree was built for
+    size_t m_numVertices;
+    size_t m_numFaces;
+
+    /// Hash of the mesh the tree was built for
+    uint64_t m_meshHash;
 };
 
 } /* namespace lvr2 */
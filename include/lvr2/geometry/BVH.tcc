@@ -32,6 +32,14 @@
  *  @author Johan M. von Behren <johan@vonbehren.eu>
  */
 
+#include <lvr2/io/Timestamp.hpp>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
 #include <limits>
 
 using std::make_unique;
@@ -42,27 +50,58 @@ namespace lvr2
 {
 
 template<typename BaseVecT>
-BVHTree<BaseVecT>::Triangle::Triangle()
-    : idx1(0)
-    , idx2(0)
-    , idx3(0)
-    , center(0, 0, 0)
-    , normal(0, 1, 0)
-    , d(0.0f)
-    , d1(0.0f)
-    , d2(0.0f)
-    , d3(0.0f)
-    , e1(0, 1, 0)
-    , e2(0, 1, 0)
-    , e3(0, 1, 0)
-    , bb()
-{}
+BVHTree<BaseVecT>::AABB::AABB()
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        min[axis] = std::numeric_limits<float>::max();
+        max[axis] = std::numeric_limits<float>::lowest();
+    }
+}
+
+template<typename BaseVecT>
+void BVHTree<BaseVecT>::AABB::expand(const AABB& other)
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        min[axis] = std::min(min[axis], other.min[axis]);
+        max[axis] = std::max(max[axis], other.max[axis]);
+    }
+}
+
+template<typename BaseVecT>
+void BVHTree<BaseVecT>::AABB::expand(const float point[3])
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        min[axis] = std::min(min[axis], point[axis]);
+        max[axis] = std::max(max[axis], point[axis]);
+    }
+}
+
+template<typename BaseVecT>
+float BVHTree<BaseVecT>::AABB::halfArea() const
+{
+    float x = max[0] - min[0];
+    float y = max[1] - min[1];
+    float z = max[2] - min[2];
+    return x * y + y * z + z * x;
+}
+
+template<typename BaseVecT>
+void BVHTree<BaseVecT>::Bin::add(const Bin& other)
+{
+    bb.expand(other.bb);
+    centroidBb.expand(other.centroidBb);
+    count += other.count;
+}
 
 template<typename BaseVecT>
 BVHTree<BaseVecT>::BVHTree(const vector<float>& vertices, const vector<uint32_t>& faces)
 {
-    m_root = buildTree(vertices, faces);
-    createCFTree();
+    buildTree(vertices, faces, faces.size() / 3);
+    m_numVertices = vertices.size() / 3;
+    m_meshHash = hashMesh(vertices, m_numVertices, faces, m_numFaces);
 }
 
 template<typename BaseVecT>
@@ -70,8 +109,9 @@ BVHTree<BaseVecT>::BVHTree(
     const floatArr vertices, size_t n_vertices,
     const indexArray faces, size_t n_faces)
 {
-    m_root = buildTree(vertices, n_vertices, faces, n_faces);
-    createCFTree();
+    buildTree(vertices, faces, n_faces);
+    m_numVertices = n_vertices;
+    m_meshHash = hashMesh(vertices, n_vertices, faces, n_faces);
 }
 
 template<typename BaseVecT>
@@ -85,177 +125,122 @@ BVHTree<BaseVecT>::BVHTree(const MeshBufferPtr mesh)
 }
 
 template<typename BaseVecT>
-typename BVHTree<BaseVecT>::BVHNodePtr BVHTree<BaseVecT>::buildTree(
-    const vector<float>& vertices,
-    const vector<uint32_t>& faces
-)
+BVHTree<BaseVecT>::BVHTree(const MeshBufferPtr mesh, const std::string& file)
 {
-    vector<AABB> work;
-    work.reserve(faces.size() / 3);
-    m_triangles.reserve(faces.size() / 3);
-
-    BoundingBox<BaseVecT> outerBb;
-
-    // Iterate over all faces and create an AABB for all of them
-    for (size_t i = 0; i < faces.size(); i += 3)
+    uint64_t meshHash = hashMesh(mesh->getVertices(), mesh->numVertices(), mesh->getFaceIndices(), mesh->numFaces());
+    if (readBinary(file, mesh->numVertices(), mesh->numFaces(), meshHash))
     {
-        // Convert raw float data into objects
-        BaseVecT point1;
-        point1.x = vertices[faces[i]*3];
-        point1.y = vertices[faces[i]*3+1];
-        point1.z = vertices[faces[i]*3+2];
+        return;
+    }
 
-        BaseVecT point2;
-        point2.x = vertices[faces[i+1]*3];
-        point2.y = vertices[faces[i+1]*3+1];
-        point2.z = vertices[faces[i+1]*3+2];
+    buildTree(mesh->getVertices(), mesh->getFaceIndices(), mesh->numFaces());
+    m_numVertices = mesh->numVertices();
+    m_meshHash = meshHash;
+    serialize(file);
+}
 
-        BaseVecT point3;
-        point3.x = vertices[faces[i+2]*3];
-        point3.y = vertices[faces[i+2]*3+1];
-        point3.z = vertices[faces[i+2]*3+2];
+template<typename BaseVecT>
+template<typename VertexArrT, typename FaceArrT>
+uint64_t BVHTree<BaseVecT>::hashMesh(
+    const VertexArrT& vertices, size_t n_vertices,
+    const FaceArrT& faces, size_t n_faces)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    auto add = [&](uint32_t word)
+    {
+        hash ^= word;
+        hash *= 1099511628211ULL;
+    };
 
-        // Precalculate intersection test data for faces
-        auto vc1 = point2 - point1;
-        auto vc2 = point3 - point2;
-        auto vc3 = point1 - point3;
+    for (size_t i = 0; i < n_vertices * 3; i++)
+    {
+        float value = vertices[i];
+        uint32_t word;
+        std::memcpy(&word, &value, sizeof(word));
+        add(word);
+    }
+    for (size_t i = 0; i < n_faces * 3; i++)
+    {
+        add(faces[i]);
+    }
 
-        // skip malformed faces
-        auto cross1 = vc1.cross(vc2);
-        auto cross2 = vc2.cross(vc3);
-        auto cross3 = vc3.cross(vc1);
-        if (cross1.length() == 0 || cross2.length() == 0 || cross3.length() == 0)
-        {
-            continue;
-        }
+    return hash;
+}
 
-        BoundingBox<BaseVecT> faceBb;
-        faceBb.expand(point1);
-        faceBb.expand(point2);
-        faceBb.expand(point3);
+template<typename BaseVecT>
+template<typename VertexArrT, typename FaceArrT>
+void BVHTree<BaseVecT>::buildTree(const VertexArrT& vertices, const FaceArrT& faces, size_t n_faces)
+{
+    m_numFaces = n_faces;
 
-        // Create triangles from faces for internal usage
-        Triangle triangle;
-        triangle.bb = faceBb;
-        triangle.center = BaseVecT((point1.asVector() + point2.asVector() + point3.asVector()) / 3.0f);
-        triangle.idx1 = faces[i];
-        triangle.idx2 = faces[i+1];
-        triangle.idx3 = faces[i+2];
+    // Find the faces, which are not malformed. Triangle indices are the
+    // indices of these faces in the order of the face array.
+    vector<uint8_t> valid(n_faces);
 
-        // pick best normal
-        Normal<typename BaseVecT::CoordType> normal1(cross1);
-        Normal<typename BaseVecT::CoordType> normal2(cross2);
-        Normal<typename BaseVecT::CoordType> normal3(cross3);
-        auto bestNormal = normal1;
-        if (normal2.length() > bestNormal.length())
-        {
-            bestNormal = normal2;
-        }
-        if (normal3.length() > bestNormal.length())
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < (long)n_faces; i++)
+    {
+        BaseVecT points[3];
+        for (int k = 0; k < 3; k++)
         {
-            bestNormal = normal3;
+            auto vertex = faces[i * 3 + k];
+            points[k] = BaseVecT(vertices[vertex * 3], vertices[vertex * 3 + 1], vertices[vertex * 3 + 2]);
         }
-        triangle.normal = Normal<typename BaseVecT::CoordType>(bestNormal);
-
-        triangle.d = triangle.normal.dot(point1);
-
-        // calc edge planes for intersection tests
-        triangle.e1 = Normal<typename BaseVecT::CoordType>(triangle.normal.cross(vc1));
-        triangle.d1 = triangle.e1.dot(point1);
-
-        triangle.e2 = Normal<typename BaseVecT::CoordType>(triangle.normal.cross(vc2));
-        triangle.d2 = triangle.e2.dot(point2);
-
-        triangle.e3 = Normal<typename BaseVecT::CoordType>(triangle.normal.cross(vc3));
-        triangle.d3 = triangle.e3.dot(point3);
 
-        // Create AABB and add current triangle (face) to it
-        AABB aabb;
-        aabb.bb = faceBb;
-        aabb.triangles.push_back(m_triangles.size());
-        m_triangles.push_back(triangle);
-
-        outerBb.expand(faceBb);
-        work.push_back(aabb);
+        auto vc1 = points[1] - points[0];
+        auto vc2 = points[2] - points[1];
+        auto vc3 = points[0] - points[2];
+        valid[i] = vc1.cross(vc2).length() != 0 && vc2.cross(vc3).length() != 0 && vc3.cross(vc1).length() != 0;
     }
 
-    // Create the tree recursively from the list of AABBs
-
-    BVHTree<BaseVecT>::BVHNodePtr out;
-
-    #pragma omp parallel
-    #pragma omp single nowait
-    out = buildTreeRecursive(work);
-    
-    std::cout << "end building." << std::endl;
-    out->bb = outerBb;
-
-    return out;
-}
-
+    vector<uint32_t> triangleOfFace(n_faces);
+    uint32_t numTriangles = 0;
+    for (size_t i = 0; i < n_faces; i++)
+    {
+        triangleOfFace[i] = numTriangles;
+        numTriangles += valid[i];
+    }
 
-template<typename BaseVecT>
-typename BVHTree<BaseVecT>::BVHNodePtr BVHTree<BaseVecT>::buildTree(
-    const floatArr vertices, size_t n_vertices,
-    const indexArray faces, size_t n_faces
-)
-{
-    vector<AABB> work;
-    work.reserve(n_faces);
-    m_triangles.reserve(n_faces);
+    m_triangleBoxes.resize(numTriangles);
+    m_triangleCentroids.resize(numTriangles * 3);
+    m_trianglesIntersectionData.resize(numTriangles * 16);
+    m_triangleFaces.resize(numTriangles);
 
-    BoundingBox<BaseVecT> outerBb;
-    // Iterate over all faces and create an AABB for all of them
-    for (size_t i = 0; i < n_faces*3; i += 3)
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < (long)n_faces; i++)
     {
-        // Convert raw float data into objects
-        BaseVecT point1;
-        point1.x = vertices[faces[i]*3];
-        point1.y = vertices[faces[i]*3+1];
-        point1.z = vertices[faces[i]*3+2];
+        if (!valid[i])
+        {
+            continue;
+        }
+        uint32_t triangle = triangleOfFace[i];
+        m_triangleFaces[triangle] = i;
 
-        BaseVecT point2;
-        point2.x = vertices[faces[i+1]*3];
-        point2.y = vertices[faces[i+1]*3+1];
-        point2.z = vertices[faces[i+1]*3+2];
+        // Convert raw float data into objects
+        BaseVecT point1(vertices[faces[i*3]*3], vertices[faces[i*3]*3+1], vertices[faces[i*3]*3+2]);
+        BaseVecT point2(vertices[faces[i*3+1]*3], vertices[faces[i*3+1]*3+1], vertices[faces[i*3+1]*3+2]);
+        BaseVecT point3(vertices[faces[i*3+2]*3], vertices[faces[i*3+2]*3+1], vertices[faces[i*3+2]*3+2]);
 
-        BaseVecT point3;
-        point3.x = vertices[faces[i+2]*3];
-        point3.y = vertices[faces[i+2]*3+1];
-        point3.z = vertices[faces[i+2]*3+2];
+        AABB& faceBb = m_triangleBoxes[triangle];
+        for (auto& point: {point1, point2, point3})
+        {
+            float coords[3] = {point.x, point.y, point.z};
+            faceBb.expand(coords);
+        }
+        for (int axis = 0; axis < 3; axis++)
+        {
+            m_triangleCentroids[triangle * 3 + axis] = 0.5f * (faceBb.min[axis] + faceBb.max[axis]);
+        }
 
         // Precalculate intersection test data for faces
         auto vc1 = point2 - point1;
         auto vc2 = point3 - point2;
         auto vc3 = point1 - point3;
 
-        // skip malformed faces
-        auto cross1 = vc1.cross(vc2);
-        auto cross2 = vc2.cross(vc3);
-        auto cross3 = vc3.cross(vc1);
-        if (cross1.length() == 0 || cross2.length() == 0 || cross3.length() == 0)
-        {
-            continue;
-        }
-
-        BoundingBox<BaseVecT> faceBb;
-        faceBb.expand(point1);
-        faceBb.expand(point2);
-        faceBb.expand(point3);
-
-        // Create triangles from faces for internal usage
-        Triangle triangle;
-        triangle.bb = faceBb;
-        triangle.center = (point1 + point2 + point3) / 3.0f;
-        triangle.idx1 = faces[i];
-        triangle.idx2 = faces[i+1];
-        triangle.idx3 = faces[i+2];
-
         // pick best normal
-        typename BaseVecT::CoordType test = 2.0;
-        Normal<typename BaseVecT::CoordType> normal1(cross1);
-        Normal<typename BaseVecT::CoordType> normal2(cross2);
-        Normal<typename BaseVecT::CoordType> normal3(cross3);
+        Normal<typename BaseVecT::CoordType> normal1(vc1.cross(vc2));
+        Normal<typename BaseVecT::CoordType> normal2(vc2.cross(vc3));
+        Normal<typename BaseVecT::CoordType> normal3(vc3.cross(vc1));
         auto bestNormal = normal1;
         if (normal2.length() > bestNormal.length())
         {
@@ -265,341 +250,472 @@ typename BVHTree<BaseVecT>::BVHNodePtr BVHTree<BaseVecT>::buildTree(
         {
             bestNormal = normal3;
         }
-        triangle.normal = Normal<typename BaseVecT::CoordType>(bestNormal);
-
-        triangle.d = triangle.normal.dot(point1);
+        Normal<typename BaseVecT::CoordType> normal(bestNormal);
 
         // calc edge planes for intersection tests
-        triangle.e1 = Normal<typename BaseVecT::CoordType>(triangle.normal.cross(vc1));
-        triangle.d1 = triangle.e1.dot(point1);
+        Normal<typename BaseVecT::CoordType> e1(normal.cross(vc1));
+        Normal<typename BaseVecT::CoordType> e2(normal.cross(vc2));
+        Normal<typename BaseVecT::CoordType> e3(normal.cross(vc3));
 
-        triangle.e2 = Normal<typename BaseVecT::CoordType>(triangle.normal.cross(vc2));
-        triangle.d2 = triangle.e2.dot(point2);
-
-        triangle.e3 = Normal<typename BaseVecT::CoordType>(triangle.normal.cross(vc3));
-        triangle.d3 = triangle.e3.dot(point3);
+        float* data = &m_trianglesIntersectionData[triangle * 16];
+        auto store = [&](const Normal<typename BaseVecT::CoordType>& n, float d)
+        {
+            *data++ = n.getX();
+            *data++ = n.getY();
+            *data++ = n.getZ();
+            *data++ = d;
+        };
+        store(normal, normal.dot(point1));
+        store(e1, e1.dot(point1));
+        store(e2, e2.dot(point2));
+        store(e3, e3.dot(point3));
+    }
 
-        // Create AABB and add current triangle (face) to it
-        AABB aabb;
-        aabb.bb = faceBb;
-        aabb.triangles.push_back(m_triangles.size());
-        m_triangles.push_back(triangle);
+    // Bounds of the root node
+    AABB bb;
+    AABB centroidBb;
+    for (uint32_t i = 0; i < numTriangles; i++)
+    {
+        bb.expand(m_triangleBoxes[i]);
+        centroidBb.expand(&m_triangleCentroids[i * 3]);
+    }
 
-        outerBb.expand(faceBb);
-        work.push_back(aabb);
+    m_triIndexList.resize(numTriangles);
+    for (uint32_t i = 0; i < numTriangles; i++)
+    {
+        m_triIndexList[i] = i;
     }
 
+    // A binary tree with at least one triangle per leaf has less than twice
+    // as many nodes as triangles
+    size_t maxNodes = std::max<size_t>(1, 2 * numTriangles);
+    m_limits.resize(maxNodes * 6);
+    m_indexesOrTrilists.resize(maxNodes * 4);
+
+    // Create the tree recursively, starting with the root node 0
+    std::atomic<uint32_t> numNodes(1);
 
-    // Create the tree recursively from the list of AABBs
-    BVHTree<BaseVecT>::BVHNodePtr out;
     #pragma omp parallel
     #pragma omp single nowait
-    out = buildTreeRecursive(work);
+    buildNodeRecursive(0, 0, numTriangles, bb, centroidBb, 0, &numNodes);
 
-    out->bb = outerBb;
+    sortNodes(numNodes);
 
-    return out;
+    // Free the working variables
+    vector<AABB>().swap(m_triangleBoxes);
+    vector<float>().swap(m_triangleCentroids);
 }
 
 template<typename BaseVecT>
-typename BVHTree<BaseVecT>::BVHNodePtr BVHTree<BaseVecT>::buildTreeRecursive(vector<AABB>& work, uint32_t depth)
+void BVHTree<BaseVecT>::buildNodeRecursive(
+    uint32_t node,
+    uint32_t begin,
+    uint32_t end,
+    AABB bb,
+    AABB centroidBb,
+    uint32_t depth,
+    std::atomic<uint32_t>* numNodes
+)
 {
-    // terminate recursion, if work size is small enough
-    if (work.size() < 4)
-    {
-        // Create a leaf node and add all remaining triangles into it
-        auto leaf = make_unique<BVHLeaf>();
-        for (auto aabb: work)
-        {
-            leaf->triangles.reserve(aabb.triangles.size());
-            for (auto triangle: aabb.triangles)
-            {
-                leaf->triangles.push_back(triangle);
-            }
-        }
-        return move(leaf);
-    }
+    setLimits(node, bb);
 
-    // divide node into smaller nodes
-    BoundingBox<BaseVecT> bb;
-    for (auto aabb: work)
+    // terminate recursion, if work size is small enough
+    uint32_t count = end - begin;
+    if (count < MIN_SPLIT_SIZE || depth >= MAX_DEPTH)
     {
-        bb.expand(aabb.bb);
+        setLeaf(node, begin, end);
+        return;
     }
 
-    // SAH, surface area heuristic calculation
-    float minCost =
-        work.size() * (bb.getXSize() * bb.getYSize() + bb.getYSize() * bb.getZSize() + bb.getZSize() * bb.getXSize());
+    Bins bins;
+    binTriangles(begin, end, centroidBb, bins);
 
-    auto bestSplit = numeric_limits<typename BaseVecT::CoordType>::max();
+    // SAH, surface area heuristic calculation: compare the cost of the node as
+    // leaf with the costs of all splits between two bins
+    float minCost = count * bb.halfArea();
     int bestAxis = -1;
+    int bestSplit = 0;
 
     // try all 3 axises X = 0, Y = 1, Z = 2
-    for (uint8_t j = 0; j < 3; j++)
+    for (int axis = 0; axis < 3; axis++)
     {
-        auto axis = j;
-        float start, stop, step;
-
-        if (axis == 0)
-        {
-            start = bb.getMin().x;
-            stop = bb.getMax().x;
-        }
-        else if(axis == 1)
-        {
-            start = bb.getMin().y;
-            stop = bb.getMax().y;
-        }
-        else
-        {
-            start = bb.getMin().z;
-            stop = bb.getMax().z;
-        }
-
-        if (fabs(stop - start) < 1e-4)
+        if (centroidBb.max[axis] - centroidBb.min[axis] < 1e-6)
         {
             // bb side along this axis too short, we must move to a different axis
             continue;
         }
 
-        step = (stop - start) / (1024.0f / (depth + 1.0f));
-
-        for (float testSplit = start + step; testSplit < stop - step; testSplit += step)
+        // Costs of the right sides, the split after bin i has the bins (i, NUM_BINS) on its right side
+        float rightCosts[NUM_BINS];
+        Bin right;
+        for (int i = NUM_BINS - 1; i > 0; i--)
         {
-            // create left and right bb
-            BoundingBox<BaseVecT> lBb;
-            BoundingBox<BaseVecT> rBb;
-
-            int countLeft = 0, countRight = 0;
-
-            for (size_t i = 0; i < work.size(); i++)
-            {
-                auto& v = work[i];
-
-                float value;
-                if (axis == 0)
-                {
-                    value = v.bb.getCentroid().x;
-                }
-                else if (axis == 1)
-                {
-                    value = v.bb.getCentroid().y;
-                }
-                else
-                {
-                    value = v.bb.getCentroid().z;
-                }
-
-                if (value < testSplit)
-                {
-                    lBb.expand(v.bb);
-                    countLeft++;
-                }
-                else
-                {
-                    rBb.expand(v.bb);
-                    countRight++;
-                }
-            }
+            right.add(bins[axis][i]);
+            rightCosts[i - 1] = right.count ? right.count * right.bb.halfArea() : 0;
+        }
 
-            // Skipt to small values
-            if (countLeft <= 1 || countRight <= 1)
+        Bin left;
+        for (int i = 0; i < NUM_BINS - 1; i++)
+        {
+            left.add(bins[axis][i]);
+            if (left.count == 0 || left.count == count)
             {
                 continue;
             }
 
-            // Calc surface for left and right box
-            float surfaceLeft =
-                lBb.getXSize() * lBb.getYSize() + lBb.getYSize() * lBb.getZSize() + lBb.getZSize() * lBb.getXSize();
-            float surfaceRight =
-                lBb.getXSize() * rBb.getYSize() + rBb.getYSize() * rBb.getZSize() + rBb.getZSize() * rBb.getXSize();
-
             // Check if new best split was found
-            float totalCost = surfaceLeft * countLeft + surfaceRight * countRight;
+            float totalCost = left.count * left.bb.halfArea() + rightCosts[i];
             if (totalCost < minCost)
             {
                 minCost = totalCost;
-                bestSplit = testSplit;
                 bestAxis = axis;
+                bestSplit = i;
             }
         }
     }
 
-    // If no good split was found, create a leaf node and copy all remaining triangles into it
+    // If no good split was found, create a leaf node with all remaining triangles
     if (bestAxis == -1)
     {
-        auto leaf = make_unique<BVHLeaf>();
-        for (auto aabb: work)
-        {
-            leaf->triangles.reserve(aabb.triangles.size());
-            for (auto triangle: aabb.triangles)
-            {
-                leaf->triangles.push_back(triangle);
-            }
-        }
-        return move(leaf);
+        setLeaf(node, begin, end);
+        return;
     }
 
-    vector<AABB> leftWork;
-    vector<AABB> rightWork;
-    BoundingBox<BaseVecT> lBb;
-    BoundingBox<BaseVecT> rBb;
-
     // Use the found split to split the current node into two new inner nodes
-    for (size_t i = 0; i < work.size(); i++)
+    Bin left;
+    Bin right;
+    for (int i = 0; i < NUM_BINS; i++)
     {
-        auto& v = work[i];
+        (i <= bestSplit ? left : right).add(bins[bestAxis][i]);
+    }
 
-        // Get the best axis centroid value
-        float value;
-        if (bestAxis == 0)
-        {
-            value = v.bb.getCentroid().x;
-        }
-        else if (bestAxis == 1)
+    float scale = NUM_BINS / (centroidBb.max[bestAxis] - centroidBb.min[bestAxis]);
+    float offset = centroidBb.min[bestAxis];
+    auto middle = std::partition(
+        m_triIndexList.begin() + begin,
+        m_triIndexList.begin() + end,
+        [&](uint32_t triangle)
         {
-            value = v.bb.getCentroid().y;
-        }
-        else
-        {
-            value = v.bb.getCentroid().z;
+            return binIndex(m_triangleCentroids[triangle * 3 + bestAxis], offset, scale) <= bestSplit;
         }
+    );
+    uint32_t split = middle - m_triIndexList.begin();
+
+    uint32_t leftNode = numNodes->fetch_add(2);
+    uint32_t rightNode = leftNode + 1;
 
-        // Create queues for left and right sub trees
-        if (value < bestSplit)
+    m_indexesOrTrilists[node * 4] = 0;
+    m_indexesOrTrilists[node * 4 + 1] = leftNode;
+    m_indexesOrTrilists[node * 4 + 2] = rightNode;
+    m_indexesOrTrilists[node * 4 + 3] = 0;
+
+    // Recursively split new sub trees into further inner or leaf nodes
+    #pragma omp task if(split - begin >= TASK_SIZE)
+    buildNodeRecursive(leftNode, begin, split, left.bb, left.centroidBb, depth + 1, numNodes);
+
+    buildNodeRecursive(rightNode, split, end, right.bb, right.centroidBb, depth + 1, numNodes);
+}
+
+template<typename BaseVecT>
+void BVHTree<BaseVecT>::binTriangles(uint32_t begin, uint32_t end, const AABB& centroidBb, Bins& bins) const
+{
+    // Bin large nodes in parallel chunks and merge the results
+    if (end - begin > BINNING_CHUNK_SIZE)
+    {
+        uint32_t numChunks = (end - begin + BINNING_CHUNK_SIZE - 1) / BINNING_CHUNK_SIZE;
+        vector<Bins> chunkBins(numChunks);
+        for (uint32_t chunk = 0; chunk < numChunks; chunk++)
         {
-            leftWork.push_back(v);
-            lBb.expand(v.bb);
+            #pragma omp task shared(chunkBins, centroidBb)
+            {
+                uint32_t chunkBegin = begin + chunk * BINNING_CHUNK_SIZE;
+                uint32_t chunkEnd = std::min(end, chunkBegin + BINNING_CHUNK_SIZE);
+                binTriangles(chunkBegin, chunkEnd, centroidBb, chunkBins[chunk]);
+            }
         }
-        else
+        #pragma omp taskwait
+
+        for (auto& chunk: chunkBins)
         {
-            rightWork.push_back(v);
-            rBb.expand(v.bb);
+            for (int axis = 0; axis < 3; axis++)
+            {
+                for (int i = 0; i < NUM_BINS; i++)
+                {
+                    bins[axis][i].add(chunk[axis][i]);
+                }
+            }
         }
+        return;
     }
 
-    // Recursively split new sub trees into further inner or leaf nodes
-    
-    auto inner = make_unique<BVHInner>();
-
-    // #pragma omp parallel
-    // #pragma omp single nowait
-    // {
-    #pragma omp task shared(inner)
+    float scale[3];
+    for (int axis = 0; axis < 3; axis++)
     {
-        inner->left = buildTreeRecursive(leftWork, depth + 1);
-        inner->left->bb = lBb;
+        float extent = centroidBb.max[axis] - centroidBb.min[axis];
+        scale[axis] = extent > 0 ? NUM_BINS / extent : 0;
     }
-    #pragma omp task shared(inner)
+
+    for (uint32_t i = begin; i < end; i++)
     {
-        inner->right = buildTreeRecursive(rightWork, depth + 1);
-        inner->right->bb = rBb;
+        uint32_t triangle = m_triIndexList[i];
+        const float* centroid = &m_triangleCentroids[triangle * 3];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            Bin& b = bins[axis][binIndex(centroid[axis], centroidBb.min[axis], scale[axis])];
+            b.bb.expand(m_triangleBoxes[triangle]);
+            b.centroidBb.expand(centroid);
+            b.count++;
+        }
     }
-    #pragma omp taskwait
-    // }
-    
-    return move(inner);
 }
 
 template<typename BaseVecT>
-void BVHTree<BaseVecT>::createCFTree()
+int BVHTree<BaseVecT>::binIndex(float value, float min, float scale)
 {
-    m_triIndexList.reserve(m_triangles.size());
-    uint32_t idxBoxes = 0;
-    createCFTreeRecursive(move(m_root), idxBoxes);
-    convertTrianglesIntersectionData();
+    return std::min(static_cast<int>((value - min) * scale), NUM_BINS - 1);
 }
 
 template<typename BaseVecT>
-void BVHTree<BaseVecT>::createCFTreeRecursive(BVHNodePtr currentNode, uint32_t& idxBoxes)
+void BVHTree<BaseVecT>::setLimits(uint32_t node, const AABB& bb)
 {
     // Convert bounding box limits to SIMD friendly format
-    m_limits.push_back(currentNode->bb.getMin().x);
-    m_limits.push_back(currentNode->bb.getMax().x);
+    for (int axis = 0; axis < 3; axis++)
+    {
+        m_limits[node * 6 + axis * 2] = bb.min[axis];
+        m_limits[node * 6 + axis * 2 + 1] = bb.max[axis];
+    }
+}
+
+template<typename BaseVecT>
+void BVHTree<BaseVecT>::setLeaf(uint32_t node, uint32_t begin, uint32_t end)
+{
+    // push real count
+    m_indexesOrTrilists[node * 4] = 0x80000000 | (end - begin);
 
-    m_limits.push_back(currentNode->bb.getMin().y);
-    m_limits.push_back(currentNode->bb.getMax().y);
+    // dummy box indices
+    m_indexesOrTrilists[node * 4 + 1] = 0;
+    m_indexesOrTrilists[node * 4 + 2] = 0;
 
-    m_limits.push_back(currentNode->bb.getMin().z);
-    m_limits.push_back(currentNode->bb.getMax().z);
+    // start index
+    m_indexesOrTrilists[node * 4 + 3] = begin;
+}
+
+template<typename BaseVecT>
+void BVHTree<BaseVecT>::sortNodes(uint32_t numNodes)
+{
+    vector<float> limits(numNodes * 6);
+    vector<uint32_t> indexesOrTrilists(numNodes * 4);
 
-    // If we have an inner node
-    if (!currentNode->isLeaf())
+    // Pairs of old node index and the position of the reference to it in the
+    // new index representation. The root isn't referenced by any node.
+    vector<pair<uint32_t, uint32_t>> stack;
+    stack.emplace_back(0, 0);
+
+    uint32_t idxBoxes = 0;
+    while (!stack.empty())
     {
-        BVHInnerPtr inner(dynamic_cast<BVHInner*>(currentNode.release()));
+        uint32_t node = stack.back().first;
+        uint32_t reference = stack.back().second;
+        stack.pop_back();
+
+        uint32_t newNode = idxBoxes++;
+        if (newNode != 0)
+        {
+            indexesOrTrilists[reference] = newNode;
+        }
+
+        std::copy_n(&m_limits[node * 6], 6, &limits[newNode * 6]);
+        std::copy_n(&m_indexesOrTrilists[node * 4], 4, &indexesOrTrilists[newNode * 4]);
+
+        // Inner node: visit the left child next
+        if (!(m_indexesOrTrilists[node * 4] & 0x80000000))
+        {
+            stack.emplace_back(m_indexesOrTrilists[node * 4 + 2], newNode * 4 + 2);
+            stack.emplace_back(m_indexesOrTrilists[node * 4 + 1], newNode * 4 + 1);
+        }
+    }
 
-        // push dummy count (0 -> inner node!)
-        m_indexesOrTrilists.push_back(0);
+    m_limits = move(limits);
+    m_indexesOrTrilists = move(indexesOrTrilists);
+}
 
-        // push dummy box indices (they will be fixed later)
-        size_t indexesOrTrilistsPos = m_indexesOrTrilists.size();
-        m_indexesOrTrilists.push_back(0);
-        m_indexesOrTrilists.push_back(0);
+template<typename BaseVecT>
+void BVHTree<BaseVecT>::serialize(const std::string& file) const
+{
+    std::cout << timestamp << "Saving BVH: " << file << std::endl;
+    std::ofstream out(file.c_str(), std::ios::binary);
 
-        // push dummy start index
-        m_indexesOrTrilists.push_back(0);
+    if (!out.good())
+    {
+        std::cout << timestamp << "Unable to open " << file << " for writing" << std::endl;
+        return;
+    }
 
-        // now recurse
-        uint32_t idxLeft = ++idxBoxes;
-        createCFTreeRecursive(move(inner->left), idxBoxes);
-        uint32_t idxRight = ++idxBoxes;
-        createCFTreeRecursive(move(inner->right), idxBoxes);
+    BVHFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "LVRBVH", 6);
+    header.version = FILE_VERSION;
+    header.numVertices = m_numVertices;
+    header.numFaces = m_numFaces;
+    header.meshHash = m_meshHash;
+    header.numNodes = m_indexesOrTrilists.size() / 4;
+    header.numTriIndices = m_triIndexList.size();
+    header.numTriangles = m_trianglesIntersectionData.size() / 16;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    const char zeros[8] = {0};
+    auto writeArray = [&](const auto& array)
+    {
+        size_t bytes = array.size() * sizeof(array[0]);
+        out.write(reinterpret_cast<const char*>(array.data()), bytes);
+        out.write(zeros, (8 - bytes % 8) % 8);
+    };
+    writeArray(m_limits);
+    writeArray(m_indexesOrTrilists);
+    writeArray(m_triIndexList);
+    writeArray(m_trianglesIntersectionData);
+    writeArray(m_triangleFaces);
+
+    if (!out.good())
+    {
+        std::cout << timestamp << "Unable to write " << file << std::endl;
+    }
+}
 
-        // fix box indices
-        m_indexesOrTrilists[indexesOrTrilistsPos] = idxLeft;
-        m_indexesOrTrilists[indexesOrTrilistsPos + 1] = idxRight;
+template<typename BaseVecT>
+bool BVHTree<BaseVecT>::readBinary(const std::string& file, size_t n_vertices, size_t n_faces, uint64_t meshHash)
+{
+    boost::iostreams::mapped_file_source mapped;
+    try
+    {
+        mapped.open(file);
     }
-    else
+    catch (std::exception& e)
     {
-        // If we have a leaf node
-        BVHLeafPtr leaf(dynamic_cast<BVHLeaf*>(currentNode.release()));
-        uint32_t count = static_cast<uint32_t>(leaf->triangles.size());
+        return false;
+    }
 
-        // push real count
-        m_indexesOrTrilists.push_back(0x80000000 | count);
+    const char* data = mapped.data();
+    size_t fileSize = mapped.size();
+    if (fileSize < sizeof(BVHFileHeader))
+    {
+        return false;
+    }
 
-        // push dummy box indices
-        m_indexesOrTrilists.push_back(0);
-        m_indexesOrTrilists.push_back(0);
+    BVHFileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, "LVRBVH", 6) != 0 || header.version != FILE_VERSION)
+    {
+        std::cout << timestamp << "Unsupported BVH file " << file << std::endl;
+        return false;
+    }
+    if (header.numVertices != n_vertices || header.numFaces != n_faces || header.meshHash != meshHash)
+    {
+        std::cout << timestamp << "BVH file " << file << " was created for another mesh" << std::endl;
+        return false;
+    }
 
-        // push start index
-        m_indexesOrTrilists.push_back(static_cast<uint32_t>(m_triIndexList.size()));
+    // Each element takes at least 4 bytes, larger counts can't fit into the file
+    if (header.numNodes > fileSize || header.numTriIndices > fileSize || header.numTriangles > fileSize)
+    {
+        std::cout << timestamp << "BVH file " << file << " is corrupt" << std::endl;
+        return false;
+    }
 
-        // copy triangle indices
-        for (auto idx: leaf->triangles)
+    // Locate the arrays within the file
+    size_t offset = sizeof(BVHFileHeader);
+    auto readArray = [&](auto& array, size_t size)
+    {
+        size_t bytes = size * sizeof(array[0]);
+        if (offset + bytes > fileSize)
         {
-            m_triIndexList.push_back(static_cast<uint32_t>(idx));
+            return false;
         }
+        array.resize(size);
+        std::memcpy(array.data(), data + offset, bytes);
+        offset += bytes + (8 - bytes % 8) % 8;
+        return true;
+    };
+
+    if (!readArray(m_limits, header.numNodes * 6)
+        || !readArray(m_indexesOrTrilists, header.numNodes * 4)
+        || !readArray(m_triIndexList, header.numTriIndices)
+        || !readArray(m_trianglesIntersectionData, header.numTriangles * 16)
+        || !readArray(m_triangleFaces, header.numTriangles))
+    {
+        std::cout << timestamp << "BVH file " << file << " is truncated" << std::endl;
+        return false;
+    }
+
+    m_numVertices = n_vertices;
+    m_numFaces = n_faces;
+    m_meshHash = meshHash;
+
+    if (!isConsistent())
+    {
+        std::cout << timestamp << "BVH file " << file << " is corrupt" << std::endl;
+        return false;
     }
+
+    std::cout << timestamp << "Read BVH with " << header.numNodes << " nodes from " << file << std::endl;
+
+    return true;
 }
 
 template<typename BaseVecT>
-void BVHTree<BaseVecT>::convertTrianglesIntersectionData()
+bool BVHTree<BaseVecT>::isConsistent() const
 {
-    uint32_t sizePerTriangle = 4 + 4 + 4 + 4;
-    m_trianglesIntersectionData.reserve(m_triangles.size() * sizePerTriangle);
-    for (auto const& triangle: m_triangles)
-    {
-        m_trianglesIntersectionData.push_back(triangle.normal.getX());
-        m_trianglesIntersectionData.push_back(triangle.normal.getY());
-        m_trianglesIntersectionData.push_back(triangle.normal.getZ());
-        m_trianglesIntersectionData.push_back(triangle.d);
-
-        m_trianglesIntersectionData.push_back(triangle.e1.getX());
-        m_trianglesIntersectionData.push_back(triangle.e1.getY());
-        m_trianglesIntersectionData.push_back(triangle.e1.getZ());
-        m_trianglesIntersectionData.push_back(triangle.d1);
-
-        m_trianglesIntersectionData.push_back(triangle.e2.getX());
-        m_trianglesIntersectionData.push_back(triangle.e2.getY());
-        m_trianglesIntersectionData.push_back(triangle.e2.getZ());
-        m_trianglesIntersectionData.push_back(triangle.d2);
-
-        m_trianglesIntersectionData.push_back(triangle.e3.getX());
-        m_trianglesIntersectionData.push_back(triangle.e3.getY());
-        m_trianglesIntersectionData.push_back(triangle.e3.getZ());
-        m_trianglesIntersectionData.push_back(triangle.d3);
+    size_t numNodes = m_indexesOrTrilists.size() / 4;
+    size_t numTriangles = m_triangleFaces.size();
+
+    // The ray casters start at the root
+    if (numNodes == 0 && numTriangles > 0)
+    {
+        return false;
+    }
+
+    for (size_t node = 0; node < numNodes; node++)
+    {
+        const uint32_t* entry = &m_indexesOrTrilists[node * 4];
+        if (entry[0] & 0x80000000)
+        {
+            uint64_t count = entry[0] & 0x7FFFFFFF;
+            if (entry[3] + count > m_triIndexList.size())
+            {
+                return false;
+            }
+        }
+        else
+        {
+            // Children follow their parent in depth first order, which
+            // also rules out cycles
+            for (int child = 1; child <= 2; child++)
+            {
+                if (entry[child] <= node || entry[child] >= numNodes)
+                {
+                    return false;
+                }
+            }
+        }
     }
+
+    for (uint32_t triangle : m_triIndexList)
+    {
+        if (triangle >= numTriangles)
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t face : m_triangleFaces)
+    {
+        if (face >= m_numFaces)
+        {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 template<typename BaseVecT>
@@ -626,4 +742,10 @@ const vector<float>& BVHTree<BaseVecT>::getTrianglesIntersectionData() const
     return m_trianglesIntersectionData;
 }
 
+template<typename BaseVecT>
+const vector<uint32_t>& BVHTree<BaseVecT>::getTriangleFaces() const
+{
+    return m_triangleFaces;
+}
+
 } /* namespace lvr2 */
@@ -37,6 +37,7 @@
 
 #include <cstdint>
 #include <array>
+#include <memory>
 #include <vector>
 #include <type_traits>
 #include <boost/optional.hpp>
@@ -61,6 +62,8 @@ class MeshHandleIterator
 {
     static_assert(std::is_base_of<BaseHandle<Index>, HandleT>::value, "HandleT must inherit from BaseHandle!");
 public:
+    virtual ~MeshHandleIterator() = default;
+
     /// Advances the iterator once. Using the dereference operator afterwards
     /// will yield the next handle.
     virtual MeshHandleIterator& operator++() = 0;
@@ -419,6 +422,18 @@ public:
     // Provided methods (already implemented)
     // =======================================================================
 
+    /**
+     * @brief Creates faces for all given vertex triples.
+     *
+     * The result is the same as calling `addFace()` for every triple in the
+     * given order; this default implementation does exactly that.
+     * Implementations can override it to build the connectivity of many
+     * faces at once.
+     *
+     * @return The handles of the inserted faces in the given order.
+     */
+    virtual std::vector<FaceHandle> addFaces(const std::vector<std::array<VertexHandle, 3>>& faces);
+
     /**
      * @brief Get the points of the requested face.
      *
@@ -615,6 +630,35 @@ public:
     friend BaseMesh<BaseVecT>;
 };
 
+/**
+ * @brief Calls `f(vH)` for every vertex of the mesh, distributing the calls
+ *        over all OpenMP threads.
+ *
+ * Unlike `mesh.vertices()`, this neither allocates nor uses the virtual
+ * iterator interface: the handle indices are visited directly and filtered
+ * with `containsVertex()`. If `MeshT` is a concrete mesh type like
+ * `HalfEdgeMesh`, these calls are statically dispatched.
+ *
+ * The order of the calls is unspecified and `f` is called concurrently, so
+ * it must not modify the mesh or anything shared without synchronization.
+ */
+template<typename MeshT, typename Func>
+void parallelForEachVertex(const MeshT& mesh, Func f);
+
+/**
+ * @brief Calls `f(fH)` for every face of the mesh in parallel. See
+ *        `parallelForEachVertex()`.
+ */
+template<typename MeshT, typename Func>
+void parallelForEachFace(const MeshT& mesh, Func f);
+
+/**
+ * @brief Calls `f(eH)` for every edge of the mesh in parallel. See
+ *        `parallelForEachVertex()`.
+ */
+template<typename MeshT, typename Func>
+void parallelForEachEdge(const MeshT& mesh, Func f);
+
 struct EdgeCollapseRemovedFace
 {
     /// A face adjacent to the collapsed edge which was removed
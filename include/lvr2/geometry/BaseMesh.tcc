@@ -65,6 +65,18 @@ HandleT MeshHandleIteratorPtr<HandleT>::operator*() const
     return **m_iter;
 }
 
+template<typename BaseVecT>
+std::vector<FaceHandle> BaseMesh<BaseVecT>::addFaces(const std::vector<std::array<VertexHandle, 3>>& faces)
+{
+    std::vector<FaceHandle> handles;
+    handles.reserve(faces.size());
+    for(auto& face : faces)
+    {
+        handles.push_back(addFace(face[0], face[1], face[2]));
+    }
+    return handles;
+}
+
 template <typename BaseVecT>
 FaceIteratorProxy<BaseVecT> BaseMesh<BaseVecT>::faces() const
 {
@@ -407,4 +419,52 @@ OptionalEdgeHandle BaseMesh<BaseVecT>::getEdgeBetween(VertexHandle aH, VertexHan
 }
 
 
+template<typename MeshT, typename Func>
+void parallelForEachVertex(const MeshT& mesh, Func f)
+{
+    const long end = mesh.nextVertexIndex();
+
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < end; i++)
+    {
+        VertexHandle vH(i);
+        if (mesh.containsVertex(vH))
+        {
+            f(vH);
+        }
+    }
+}
+
+template<typename MeshT, typename Func>
+void parallelForEachFace(const MeshT& mesh, Func f)
+{
+    const long end = mesh.nextFaceIndex();
+
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < end; i++)
+    {
+        FaceHandle fH(i);
+        if (mesh.containsFace(fH))
+        {
+            f(fH);
+        }
+    }
+}
+
+template<typename MeshT, typename Func>
+void parallelForEachEdge(const MeshT& mesh, Func f)
+{
+    const long end = mesh.nextEdgeIndex();
+
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < end; i++)
+    {
+        EdgeHandle eH(i);
+        if (mesh.containsEdge(eH))
+        {
+            f(eH);
+        }
+    }
+}
+
 } // namespace lvr2
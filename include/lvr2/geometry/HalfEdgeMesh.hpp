@@ -57,6 +57,10 @@ using std::min;
 namespace lvr2
 {
 
+// Forward declarations
+template<typename> class HemEdgeHandleIterator;
+template<typename> class HemHandleRange;
+
 /**
  * @brief Half-edge data structure implementing the `BaseMesh` interface.
  *
@@ -75,6 +79,11 @@ public:
     using Vertex = HalfEdgeVertex<BaseVecT>;
 
     HalfEdgeMesh();
+
+    /**
+     * @brief Creates a mesh from the vertices and faces of the given buffer.
+     *        The connectivity is built at once with `addFaces()`.
+     */
     HalfEdgeMesh(MeshBufferPtr ptr);
 
     // ========================================================================
@@ -85,6 +94,19 @@ public:
     // more likely and effective.
     VertexHandle addVertex(BaseVecT pos) final;
     FaceHandle addFace(VertexHandle v1H, VertexHandle v2H, VertexHandle v3H) final;
+
+    /**
+     * @brief Adds the given faces. If the mesh does not contain any faces
+     *        yet, all half edges are created at once: they are paired with
+     *        their twins by bucketing them at their smaller vertex and the
+     *        `next` handles of border edges are linked by walking around
+     *        the vertices. The handles are the same as the ones created by
+     *        `addFace()`. Otherwise, or if the faces do not form a mesh
+     *        this structure can represent, `addFace()` is called for every
+     *        face.
+     */
+    vector<FaceHandle> addFaces(const vector<array<VertexHandle, 3>>& faces) final;
+
     void removeFace(FaceHandle handle) final;
     EdgeCollapseResult collapseEdge(EdgeHandle edgeH) final;
     void flipEdge(EdgeHandle edgeH) final;
@@ -93,15 +115,15 @@ public:
     size_t numFaces() const final;
     size_t numEdges() const final;
 
-    bool containsVertex(VertexHandle vH) const;
-    bool containsFace(FaceHandle fH) const;
-    bool containsEdge(EdgeHandle eH) const;
+    bool containsVertex(VertexHandle vH) const final;
+    bool containsFace(FaceHandle fH) const final;
+    bool containsEdge(EdgeHandle eH) const final;
 
-    bool isBorderEdge(EdgeHandle handle) const;
+    bool isBorderEdge(EdgeHandle handle) const final;
 
-    Index nextVertexIndex() const;
-    Index nextFaceIndex() const;
-    Index nextEdgeIndex() const;
+    Index nextVertexIndex() const final;
+    Index nextFaceIndex() const final;
+    Index nextEdgeIndex() const final;
 
     BaseVecT getVertexPosition(VertexHandle handle) const final;
     BaseVecT& getVertexPosition(VertexHandle handle) final;
@@ -133,6 +155,30 @@ public:
     // = Other public methods
     // ========================================================================
 
+    /**
+     * @brief Statically dispatched alternatives to `vertices()`, `faces()` and
+     *        `edges()`.
+     *
+     * The returned ranges use plain iterators which are neither allocated
+     * on the heap nor called through virtual functions. Use these in hot
+     * loops whenever the concrete mesh type is known.
+     */
+    HemHandleRange<StableVectorIterator<VertexHandle, Vertex>> vertexHandles() const;
+    HemHandleRange<StableVectorIterator<FaceHandle, Face>> faceHandles() const;
+    HemHandleRange<HemEdgeHandleIterator<BaseVecT>> edgeHandles() const;
+
+    /**
+     * @brief Renumbers the vertices, faces and edges so that their handles
+     *        are consecutive again and frees the memory of removed ones.
+     *
+     * Removing faces or collapsing edges leaves unused handles behind, which
+     * still take up memory and have to be skipped while iterating. The order
+     * of the remaining elements is kept.
+     *
+     * This invalidates all handles and thus all attribute maps of the mesh!
+     */
+    void compact();
+
     bool debugCheckMeshIntegrity() const;
 
 private:
@@ -188,6 +234,20 @@ private:
      */
     pair<HalfEdgeHandle, HalfEdgeHandle> addEdgePair(VertexHandle v1H, VertexHandle v2H);
 
+    /**
+     * @brief Creates the edges and faces of a mesh without faces at once.
+     *
+     * @param numFaces  Number of faces to create
+     * @param vertexOf  Functor that returns the index of corner `c` of face
+     *                  `f` for `vertexOf(f, c)`
+     *
+     * @return false if the mesh already contains edges or if an edge is
+     *         shared by more than two faces or by two faces with the same
+     *         orientation. The mesh is unchanged in this case.
+     */
+    template<typename VertexOf>
+    bool buildFaces(size_t numFaces, VertexOf vertexOf);
+
 
     /**
      * @brief Circulates around the vertex `vH`, calling the `visitor` for each
@@ -240,6 +300,52 @@ private:
     // = Friends
     // ========================================================================
     template<typename> friend class HemEdgeIterator;
+    template<typename> friend class HemEdgeHandleIterator;
+};
+
+/**
+ * @brief A pair of iterators usable in range-based for-loops.
+ */
+template<typename IteratorT>
+class HemHandleRange
+{
+public:
+    HemHandleRange(IteratorT begin, IteratorT end) : m_begin(begin), m_end(end) {};
+    IteratorT begin() const { return m_begin; }
+    IteratorT end() const { return m_end; }
+
+private:
+    IteratorT m_begin;
+    IteratorT m_end;
+};
+
+/**
+ * @brief Iterator over the full edges of a HalfEdgeMesh.
+ *
+ * Only the half edge whose handle equals the full edge handle is visited,
+ * so every edge is returned once. This iterator is not virtual; it is used
+ * by `edgeHandles()` and wrapped by `HemEdgeIterator`.
+ */
+template<typename BaseVecT>
+class HemEdgeHandleIterator
+{
+public:
+    HemEdgeHandleIterator(
+        StableVectorIterator<HalfEdgeHandle, HalfEdge> iterator,
+        const HalfEdgeMesh<BaseVecT>& mesh
+    );
+
+    HemEdgeHandleIterator& operator++();
+    bool operator==(const HemEdgeHandleIterator& other) const { return m_iterator == other.m_iterator; }
+    bool operator!=(const HemEdgeHandleIterator& other) const { return m_iterator != other.m_iterator; }
+    EdgeHandle operator*() const { return EdgeHandle((*m_iterator).idx()); }
+
+private:
+    /// Advances `m_iterator` until it points to a full edge handle.
+    void skipTwins();
+
+    StableVectorIterator<HalfEdgeHandle, HalfEdge> m_iterator;
+    const HalfEdgeMesh<BaseVecT>* m_mesh;
 };
 
 /// Implementation of the MeshHandleIterator for the HalfEdgeMesh
@@ -261,10 +367,7 @@ template<typename BaseVecT>
 class HemEdgeIterator : public MeshHandleIterator<EdgeHandle>
 {
 public:
-    HemEdgeIterator(
-        StableVectorIterator<HalfEdgeHandle, HalfEdge> iterator,
-        const HalfEdgeMesh<BaseVecT>& mesh
-    ) : m_iterator(iterator), m_mesh(mesh) {};
+    HemEdgeIterator(HemEdgeHandleIterator<BaseVecT> iterator) : m_iterator(iterator) {};
 
     HemEdgeIterator& operator++();
     bool operator==(const MeshHandleIterator<EdgeHandle>& other) const;
@@ -272,8 +375,7 @@ public:
     EdgeHandle operator*() const;
 
 private:
-    StableVectorIterator<HalfEdgeHandle, HalfEdge> m_iterator;
-    const HalfEdgeMesh<BaseVecT>& m_mesh;
+    HemEdgeHandleIterator<BaseVecT> m_iterator;
 };
 
 } // namespace lvr2
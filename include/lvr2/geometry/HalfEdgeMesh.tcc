@@ -34,6 +34,7 @@
 
 #include <algorithm>
 #include <array>
+#include <limits>
 #include <utility>
 #include <iostream>
 
@@ -59,6 +60,7 @@ HalfEdgeMesh<BaseVecT>::HalfEdgeMesh(MeshBufferPtr ptr)
     floatArr vertices = ptr->getVertices();
     indexArray indices = ptr->getFaceIndices();
 
+    m_vertices.reserve(numVertices);
     for(size_t i = 0; i < numVertices; i++)
     {
         size_t pos = 3 * i;
@@ -68,13 +70,23 @@ HalfEdgeMesh<BaseVecT>::HalfEdgeMesh(MeshBufferPtr ptr)
                             vertices[pos + 2]));
     }
 
-    for(size_t i = 0; i < numFaces; i++)
+    bool built = buildFaces(numFaces, [&](size_t f, int c)
     {
-        size_t pos = 3 * i;
-        VertexHandle v1(indices[pos]);
-        VertexHandle v2(indices[pos + 1]);
-        VertexHandle v3(indices[pos + 2]);
-        this->addFace(v1, v2, v3);
+        return indices[3 * f + c];
+    });
+
+    // Fall back to inserting the faces one by one, which panics for the
+    // first face that can not be added
+    if(!built)
+    {
+        for(size_t i = 0; i < numFaces; i++)
+        {
+            size_t pos = 3 * i;
+            VertexHandle v1(indices[pos]);
+            VertexHandle v2(indices[pos + 1]);
+            VertexHandle v3(indices[pos + 2]);
+            this->addFace(v1, v2, v3);
+        }
     }
 }
 
@@ -91,6 +103,28 @@ VertexHandle HalfEdgeMesh<BaseVecT>::addVertex(BaseVecT pos)
     return m_vertices.push(v);
 }
 
+template <typename BaseVecT>
+vector<FaceHandle> HalfEdgeMesh<BaseVecT>::addFaces(const vector<array<VertexHandle, 3>>& faces)
+{
+    FaceHandle firstH = m_faces.nextHandle();
+    bool built = buildFaces(faces.size(), [&](size_t f, int c)
+    {
+        return faces[f][c].idx();
+    });
+
+    if(!built)
+    {
+        return BaseMesh<BaseVecT>::addFaces(faces);
+    }
+
+    vector<FaceHandle> handles(faces.size(), firstH);
+    for(size_t i = 0; i < faces.size(); i++)
+    {
+        handles[i] = FaceHandle(firstH.idx() + i);
+    }
+    return handles;
+}
+
 template <typename BaseVecT>
 FaceHandle HalfEdgeMesh<BaseVecT>::addFace(VertexHandle v1H, VertexHandle v2H, VertexHandle v3H)
 {
@@ -518,7 +552,10 @@ bool HalfEdgeMesh<BaseVecT>::containsFace(FaceHandle fH) const
 template <typename BaseVecT>
 bool HalfEdgeMesh<BaseVecT>::containsEdge(EdgeHandle eH) const
 {
-    return static_cast<bool>(m_edges.get(HalfEdgeHandle::oneHalfOf(eH)));
+    // Only the half with the smaller index is a valid full edge handle
+    auto halfH = HalfEdgeHandle::oneHalfOf(eH);
+    auto edge = m_edges.get(halfH);
+    return edge && edge->twin.idx() > halfH.idx();
 }
 
 template <typename BaseVecT>
@@ -1106,6 +1143,48 @@ EdgeHandle HalfEdgeMesh<BaseVecT>::halfToFullEdgeHandle(HalfEdgeHandle handle) c
 // ========================================================================
 // = Other public methods
 // ========================================================================
+template <typename BaseVecT>
+void HalfEdgeMesh<BaseVecT>::compact()
+{
+    // The order of the elements is kept, so the smaller half of each edge
+    // stays the smaller one and edge handles remain the full edge handles.
+    const auto newVertexIdx = m_vertices.compact();
+    const auto newFaceIdx = m_faces.compact();
+    const auto newEdgeIdx = m_edges.compact();
+
+    // All elements are used now, so the handles stored in them can be
+    // rewritten in parallel.
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)m_edges.size(); i++)
+    {
+        auto& edge = m_edges[HalfEdgeHandle(i)];
+        edge.target = VertexHandle(newVertexIdx[edge.target.idx()]);
+        edge.next = HalfEdgeHandle(newEdgeIdx[edge.next.idx()]);
+        edge.twin = HalfEdgeHandle(newEdgeIdx[edge.twin.idx()]);
+        if (edge.face)
+        {
+            edge.face = FaceHandle(newFaceIdx[edge.face.unwrap().idx()]);
+        }
+    }
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)m_faces.size(); i++)
+    {
+        auto& face = m_faces[FaceHandle(i)];
+        face.edge = HalfEdgeHandle(newEdgeIdx[face.edge.idx()]);
+    }
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)m_vertices.size(); i++)
+    {
+        auto& vertex = m_vertices[VertexHandle(i)];
+        if (vertex.outgoing)
+        {
+            vertex.outgoing = HalfEdgeHandle(newEdgeIdx[vertex.outgoing.unwrap().idx()]);
+        }
+    }
+}
+
 template <typename BaseVecT>
 bool HalfEdgeMesh<BaseVecT>::debugCheckMeshIntegrity() const
 {
@@ -1409,6 +1488,284 @@ OptionalHalfEdgeHandle HalfEdgeMesh<BaseVecT>::findEdgeAroundVertex(
     return out;
 }
 
+template <typename BaseVecT>
+template <typename VertexOf>
+bool HalfEdgeMesh<BaseVecT>::buildFaces(size_t numFaces, VertexOf vertexOf)
+{
+    const Index INVALID = std::numeric_limits<Index>::max();
+    size_t numVertices = m_vertices.size();
+    size_t numCorners = 3 * numFaces;
+
+    if(m_edges.size() > 0 || m_faces.size() > 0 || m_vertices.numUsed() != numVertices
+       || 2 * numCorners >= INVALID)
+    {
+        return false;
+    }
+
+    // Corner i is corner i % 3 of face i / 3. It represents the inner half
+    // edge from this corner to the next one of the face.
+    auto source = [&](size_t i) -> Index { return vertexOf(i / 3, i % 3); };
+    auto target = [&](size_t i) -> Index { return vertexOf(i / 3, (i + 1) % 3); };
+    auto nextCorner = [](size_t i) { return i - i % 3 + (i + 1) % 3; };
+    auto prevCorner = [](size_t i) { return i - i % 3 + (i + 2) % 3; };
+
+    bool valid = true;
+
+    #pragma omp parallel for schedule(static) reduction(&&:valid)
+    for(long f = 0; f < (long)numFaces; f++)
+    {
+        Index a = vertexOf(f, 0);
+        Index b = vertexOf(f, 1);
+        Index c = vertexOf(f, 2);
+        if(a >= numVertices || b >= numVertices || c >= numVertices || a == b || b == c || a == c)
+        {
+            valid = false;
+        }
+    }
+    if(!valid)
+    {
+        return false;
+    }
+
+    // Bucket the half edges at their smaller vertex. Within a bucket, the
+    // corners are sorted by index.
+    vector<Index> bucketStart(numVertices + 1, 0);
+    vector<Index> numCornersAt(numVertices, 0);
+    vector<Index> firstCorner(numVertices, INVALID);
+    for(size_t i = 0; i < numCorners; i++)
+    {
+        Index s = source(i);
+        bucketStart[std::min(s, target(i)) + 1]++;
+        if(!numCornersAt[s]++)
+        {
+            firstCorner[s] = i;
+        }
+    }
+    for(size_t v = 0; v < numVertices; v++)
+    {
+        bucketStart[v + 1] += bucketStart[v];
+    }
+
+    vector<Index> buckets(numCorners);
+    {
+        vector<Index> pos(bucketStart.begin(), bucketStart.end() - 1);
+        for(size_t i = 0; i < numCorners; i++)
+        {
+            buckets[pos[std::min(source(i), target(i))]++] = i;
+        }
+    }
+
+    // Pair every half edge with the one in the opposite direction. The first
+    // corner of an edge is the one that creates the edge in addFace().
+    vector<Index> twin(numCorners, INVALID);
+    vector<unsigned char> first(numCorners, 0);
+
+    #pragma omp parallel for schedule(dynamic, 4096) reduction(&&:valid)
+    for(long v = 0; v < (long)numVertices; v++)
+    {
+        Index* begin = buckets.data() + bucketStart[v];
+        Index* end = buckets.data() + bucketStart[v + 1];
+        auto other = [&](Index i) { return std::max(source(i), target(i)); };
+
+        // Buckets are small, so a (stable) insertion sort is sufficient
+        for(Index* it = begin + 1; it < end; it++)
+        {
+            Index corner = *it;
+            Index key = other(corner);
+            Index* pos = it;
+            while(pos > begin && other(*(pos - 1)) > key)
+            {
+                *pos = *(pos - 1);
+                pos--;
+            }
+            *pos = corner;
+        }
+
+        for(Index* it = begin; it < end;)
+        {
+            Index* groupEnd = it + 1;
+            while(groupEnd < end && other(*groupEnd) == other(*it))
+            {
+                groupEnd++;
+            }
+
+            // An edge can only be shared by two faces in opposite directions
+            if(groupEnd - it > 2 || (groupEnd - it == 2 && source(it[0]) == source(it[1])))
+            {
+                valid = false;
+            }
+            else
+            {
+                first[it[0]] = 1;
+                if(groupEnd - it == 2)
+                {
+                    twin[it[0]] = it[1];
+                    twin[it[1]] = it[0];
+                }
+            }
+            it = groupEnd;
+        }
+    }
+    if(!valid)
+    {
+        return false;
+    }
+
+    // Walk from every border edge around its target vertex to the border
+    // edge that leaves this fan of faces. The border edge of corner i ends
+    // in source(i).
+    vector<Index> fanEnd(numCorners, INVALID);
+    vector<Index> numFans(numVertices, 0);
+    vector<Index> numFanCorners(numVertices, 0);
+
+    #pragma omp parallel for schedule(dynamic, 4096) reduction(&&:valid)
+    for(long i = 0; i < (long)numCorners; i++)
+    {
+        if(twin[i] != INVALID)
+        {
+            continue;
+        }
+
+        Index v = source(i);
+        Index corner = i;
+        Index count = 1;
+        while(twin[prevCorner(corner)] != INVALID && count <= numCornersAt[v])
+        {
+            corner = twin[prevCorner(corner)];
+            count++;
+        }
+        fanEnd[i] = prevCorner(corner);
+
+        #pragma omp atomic
+        numFans[v]++;
+
+        #pragma omp atomic
+        numFanCorners[v] += count;
+    }
+
+    // All faces of a border vertex have to be part of its fans. Inner
+    // vertices need to be surrounded by one closed fan.
+    #pragma omp parallel for schedule(dynamic, 4096) reduction(&&:valid)
+    for(long v = 0; v < (long)numVertices; v++)
+    {
+        if(numFans[v] > 0)
+        {
+            if(numFanCorners[v] != numCornersAt[v])
+            {
+                valid = false;
+            }
+        }
+        else if(numCornersAt[v] > 0)
+        {
+            Index corner = firstCorner[v];
+            Index count = 0;
+            do
+            {
+                corner = twin[prevCorner(corner)];
+                count++;
+            }
+            while(corner != firstCorner[v] && count <= numCornersAt[v]);
+
+            if(count != numCornersAt[v])
+            {
+                valid = false;
+            }
+        }
+    }
+    if(!valid)
+    {
+        return false;
+    }
+
+    // Number the edges in the order of their first corner
+    vector<Index> halfEdge(numCorners);
+    Index numEdges = 0;
+    for(size_t i = 0; i < numCorners; i++)
+    {
+        if(first[i])
+        {
+            halfEdge[i] = 2 * numEdges++;
+        }
+    }
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)numCorners; i++)
+    {
+        if(!first[i])
+        {
+            halfEdge[i] = halfEdge[twin[i]] + 1;
+        }
+    }
+
+    // Create the edges and faces
+    m_edges.increaseSize(HalfEdgeHandle(2 * numEdges), Edge());
+    m_faces.increaseSize(FaceHandle(numFaces), Face(HalfEdgeHandle(0)));
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)numCorners; i++)
+    {
+        HalfEdgeHandle eH(halfEdge[i]);
+        Edge& e = m_edges[eH];
+        e.face = FaceHandle(i / 3);
+        e.target = VertexHandle(target(i));
+        e.next = HalfEdgeHandle(halfEdge[nextCorner(i)]);
+
+        if(twin[i] != INVALID)
+        {
+            e.twin = HalfEdgeHandle(halfEdge[twin[i]]);
+        }
+        else
+        {
+            HalfEdgeHandle borderH(halfEdge[i] + 1);
+            e.twin = borderH;
+
+            Edge& border = m_edges[borderH];
+            border.twin = eH;
+            border.target = VertexHandle(source(i));
+            border.next = HalfEdgeHandle(halfEdge[fanEnd[i]] + 1);
+        }
+
+        if(i % 3 == 0)
+        {
+            m_faces[FaceHandle(i / 3)].edge = eH;
+        }
+    }
+
+    #pragma omp parallel for schedule(static)
+    for(long v = 0; v < (long)numVertices; v++)
+    {
+        if(firstCorner[v] != INVALID)
+        {
+            m_vertices[VertexHandle(v)].outgoing = HalfEdgeHandle(halfEdge[firstCorner[v]]);
+        }
+    }
+
+    // Vertices with several fans: link the border edges so that circulating
+    // around the vertex visits all fans
+    vector<std::pair<Index, Index>> fans;
+    for(size_t i = 0; i < numCorners; i++)
+    {
+        if(twin[i] == INVALID && numFans[source(i)] > 1)
+        {
+            fans.push_back(std::make_pair(source(i), i));
+        }
+    }
+    std::sort(fans.begin(), fans.end());
+
+    for(size_t j = 0; j < fans.size(); j++)
+    {
+        size_t next = j + 1;
+        if(next == fans.size() || fans[next].first != fans[j].first)
+        {
+            next = j + 1 - numFans[fans[j].first];
+        }
+        m_edges[HalfEdgeHandle(halfEdge[fans[j].second] + 1)].next =
+            HalfEdgeHandle(halfEdge[fanEnd[fans[next].second]] + 1);
+    }
+
+    return true;
+}
+
 template <typename BaseVecT>
 pair<HalfEdgeHandle, HalfEdgeHandle> HalfEdgeMesh<BaseVecT>::addEdgePair(VertexHandle v1H, VertexHandle v2H)
 {
@@ -1472,17 +1829,38 @@ HandleT HemFevIterator<HandleT, ElemT>::operator*() const
 }
 
 template<typename BaseVecT>
-HemEdgeIterator<BaseVecT>& HemEdgeIterator<BaseVecT>::operator++()
+HemEdgeHandleIterator<BaseVecT>::HemEdgeHandleIterator(
+    StableVectorIterator<HalfEdgeHandle, HalfEdge> iterator,
+    const HalfEdgeMesh<BaseVecT>& mesh
+)
+    : m_iterator(iterator), m_mesh(&mesh)
+{
+    skipTwins();
+}
+
+template<typename BaseVecT>
+HemEdgeHandleIterator<BaseVecT>& HemEdgeHandleIterator<BaseVecT>::operator++()
 {
     ++m_iterator;
+    skipTwins();
+    return *this;
+}
 
-    // If not at the end, find the next half edge handle that equals the full edge handle of that edge
-    // according to the halfToFullEdgeHandle method
-    while (!m_iterator.isAtEnd() && (*m_iterator).idx() != m_mesh.halfToFullEdgeHandle(*m_iterator).idx())
+template<typename BaseVecT>
+void HemEdgeHandleIterator<BaseVecT>::skipTwins()
+{
+    // Find the next half edge handle that equals the full edge handle of that
+    // edge according to the halfToFullEdgeHandle method
+    while (!m_iterator.isAtEnd() && (*m_iterator).idx() != m_mesh->halfToFullEdgeHandle(*m_iterator).idx())
     {
         ++m_iterator;
     }
+}
 
+template<typename BaseVecT>
+HemEdgeIterator<BaseVecT>& HemEdgeIterator<BaseVecT>::operator++()
+{
+    ++m_iterator;
     return *this;
 }
 
@@ -1503,7 +1881,7 @@ bool HemEdgeIterator<BaseVecT>::operator!=(const MeshHandleIterator<EdgeHandle>&
 template<typename BaseVecT>
 EdgeHandle HemEdgeIterator<BaseVecT>::operator*() const
 {
-    return m_mesh.halfToFullEdgeHandle(*m_iterator);
+    return *m_iterator;
 }
 
 template <typename BaseVecT>
@@ -1542,7 +1920,9 @@ template <typename BaseVecT>
 MeshHandleIteratorPtr<EdgeHandle> HalfEdgeMesh<BaseVecT>::edgesBegin() const
 {
     return MeshHandleIteratorPtr<EdgeHandle>(
-        std::make_unique<HemEdgeIterator<BaseVecT>>(this->m_edges.begin(), *this)
+        std::make_unique<HemEdgeIterator<BaseVecT>>(
+            HemEdgeHandleIterator<BaseVecT>(this->m_edges.begin(), *this)
+        )
     );
 }
 
@@ -1550,7 +1930,32 @@ template <typename BaseVecT>
 MeshHandleIteratorPtr<EdgeHandle> HalfEdgeMesh<BaseVecT>::edgesEnd() const
 {
     return MeshHandleIteratorPtr<EdgeHandle>(
-        std::make_unique<HemEdgeIterator<BaseVecT>>(this->m_edges.end(), *this)
+        std::make_unique<HemEdgeIterator<BaseVecT>>(
+            HemEdgeHandleIterator<BaseVecT>(this->m_edges.end(), *this)
+        )
+    );
+}
+
+template <typename BaseVecT>
+HemHandleRange<StableVectorIterator<VertexHandle, typename HalfEdgeMesh<BaseVecT>::Vertex>>
+HalfEdgeMesh<BaseVecT>::vertexHandles() const
+{
+    return HemHandleRange<StableVectorIterator<VertexHandle, Vertex>>(m_vertices.begin(), m_vertices.end());
+}
+
+template <typename BaseVecT>
+HemHandleRange<StableVectorIterator<FaceHandle, typename HalfEdgeMesh<BaseVecT>::Face>>
+HalfEdgeMesh<BaseVecT>::faceHandles() const
+{
+    return HemHandleRange<StableVectorIterator<FaceHandle, Face>>(m_faces.begin(), m_faces.end());
+}
+
+template <typename BaseVecT>
+HemHandleRange<HemEdgeHandleIterator<BaseVecT>> HalfEdgeMesh<BaseVecT>::edgeHandles() const
+{
+    return HemHandleRange<HemEdgeHandleIterator<BaseVecT>>(
+        HemEdgeHandleIterator<BaseVecT>(m_edges.begin(), *this),
+        HemEdgeHandleIterator<BaseVecT>(m_edges.end(), *this)
     );
 }
 
@@ -80,6 +80,9 @@ class AsciiIO : public BaseIO
          *              respective parameters given to this function. Each line may
          *              consist of more attributes, but only the ones specified are
          *              parsed. Not existing attributes are indicated by -1.
+         *              Columns may be separated by whitespace or commas. The file
+         *              is memory mapped and parsed in parallel chunks, lines with
+         *              missing or malformed values in these columns are skipped.
          *
          * @param filename  The file to parse
          * @param x         The colum number containing the x-coordinate of a point
@@ -96,6 +99,27 @@ class AsciiIO : public BaseIO
                 const int& x, const int& y, const int& z,
                 const int& r = -1, const int& g = -1, const int& b = -1, const int& i = -1);
 
+        /**
+         * @brief Opens the given file for reading its points in chunks.
+         *        The attribute columns are guessed like in read().
+         *
+         * @param filename      The file to read
+         */
+        virtual PointReaderPtr openPointReader( string filename );
+
+        /**
+         * @brief Opens the given file for reading its points in chunks.
+         *        The columns are interpreted like in read(), lines with
+         *        missing or malformed values are skipped.
+         *
+         * @return A reader or an empty pointer if the file could not be
+         *         opened.
+         */
+        virtual PointReaderPtr openPointReader(
+                string filename,
+                const int& x, const int& y, const int& z,
+                const int& r = -1, const int& g = -1, const int& b = -1, const int& i = -1);
+
 
         /**
          * @todo : Implement save method for ASCII Files...
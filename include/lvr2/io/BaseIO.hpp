@@ -45,6 +45,7 @@
 #include <map>
 
 #include <lvr2/io/Model.hpp>
+#include <lvr2/io/PointReader.hpp>
 
 namespace lvr2
 {
@@ -68,6 +69,19 @@ class BaseIO
         virtual ModelPtr read(std::string filename ) = 0;
 
 
+        /**
+         * \brief Opens the given file for reading its points in chunks.
+         *        The default implementation loads the whole file with
+         *        read() and serves the points from memory. Formats that
+         *        support streaming override it.
+         *
+         * @param filename  The file to read.
+         * @return A reader or an empty pointer if the file could not be
+         *         opened.
+         */
+        virtual PointReaderPtr openPointReader(std::string filename);
+
+
         /**
          * \brief Save the loaded elements to the given file.
          *
@@ -68,6 +68,12 @@ class HDF5IO : public BaseIO, public AttributeMeshIOBase
          */
     virtual ModelPtr read(std::string filename);
 
+    /**
+     * @brief Opens the given file for reading the points of all raw scans
+     *        in chunks. The points are transformed like in readPointCloud().
+     */
+    virtual PointReaderPtr openPointReader(std::string filename);
+
     ModelPtr read(std::string filename, size_t scanNr);
 
     bool readPointCloud(ModelPtr model_ptr);
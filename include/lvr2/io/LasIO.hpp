@@ -36,12 +36,33 @@
 #define LASIO_H_
 
 #include <lvr2/io/BaseIO.hpp>
+#include <lvr2/geometry/BaseVector.hpp>
+#include <lvr2/geometry/BoundingBox.hpp>
+
+#include <memory>
+
+class LASwriter;
+class LASheader;
+class LASpoint;
 
 namespace lvr2
 {
 
 /**
- * @brief   Interface class to read laser scan data in .las-Format
+ * @brief   Interface class to read and write laser scan data in .las and
+ *          .laz format. Coordinates are scaled and offset as given in the
+ *          file header. To keep their precision in float, they are
+ *          delivered relative to the minimum of the file rounded down to
+ *          full meters, which is stored in the int atomics
+ *          'coordinate_base_x', 'coordinate_base_y' and 'coordinate_base_z'.
+ *          Besides the points the following attributes are transferred if
+ *          present:
+ *
+ *          'intensities'       float channel
+ *          'colors'            RGB, 16 bit colors are reduced to 8 bit
+ *          'classifications'   uchar channel
+ *          'gps_time'          float channel, relative to the int atomic
+ *                              'gps_time_base' to keep the precision
  */
 class LasIO : public BaseIO
 {
@@ -57,7 +78,26 @@ public:
     virtual ModelPtr read(string filename );
 
     /**
-     * @brief Save the loaded elements to the given file.
+     * @brief Loads the points of the given file within the bounding box.
+     *        If the file is indexed (.lax file next to it), only the
+     *        affected parts of the file are read.
+     *
+     * @param filename  The file to read.
+     * @param bb        The region to load, relative to the coordinate base
+     *                  like the returned points
+     */
+    ModelPtr read(string filename, const BoundingBox<BaseVector<float> >& bb);
+
+    /**
+     * @brief Opens the given file for reading its points in chunks.
+     *
+     * @param filename  The file to read.
+     */
+    virtual PointReaderPtr openPointReader(string filename);
+
+    /**
+     * @brief Save the loaded elements to the given file. The file is
+     *        compressed if its extension is .laz.
      *
      * @param filename Filename of the file to write.
      */
@@ -65,6 +105,47 @@ public:
 
 };
 
+/**
+ * @brief   Writes point buffers one after another into a single .las or
+ *          .laz file. The point format and the offset of the integer
+ *          coordinates are chosen when the first buffer is written. The
+ *          coordinate base of buffers read from LAS files is added back
+ *          and the one of the first buffer is used as offset. Coordinates
+ *          are stored with millimeter resolution.
+ */
+class LasPointWriter
+{
+public:
+    /**
+     * @brief Prepares writing to the given file. The file is created
+     *        when the first buffer is written.
+     */
+    LasPointWriter(string filename);
+
+    /// Closes the file
+    ~LasPointWriter();
+
+    /**
+     * @brief Appends the points of the given buffer to the file.
+     *
+     * @return false if the file could not be written
+     */
+    bool write(PointBufferPtr buffer);
+
+    /**
+     * @brief Updates the header and closes the file.
+     *
+     * @return The number of written points
+     */
+    size_t close();
+
+private:
+    string                      m_filename;
+    LASwriter*                  m_writer;
+    std::unique_ptr<LASheader>  m_header;
+    std::unique_ptr<LASpoint>   m_point;
+};
+
 } /* namespace lvr2 */
 
 #endif /* LASIO_H_ */
@@ -36,6 +36,7 @@
 #define IOFACTORY_H_
 
 #include "lvr2/io/Model.hpp"
+#include "lvr2/io/PointReader.hpp"
 #include "lvr2/io/IOUtils.hpp"
 #include "lvr2/io/CoordinateTransform.hpp"
 
@@ -62,10 +63,25 @@ class ModelFactory
 
         static ModelPtr readModel( std::string filename );
 
+        /**
+         * @brief Opens the given file for reading its points in chunks.
+         *        PLY, ASCII, LAS and HDF5 files are streamed, all other
+         *        formats are loaded with readModel(). The coordinate
+         *        transformation is only applied to the latter.
+         *
+         * @return A reader or an empty pointer if the file could not be
+         *         opened.
+         */
+        static PointReaderPtr openPointReader( std::string filename );
+
         static void saveModel( ModelPtr m, std::string file);
 
         static CoordinateTransform<float> m_transform;
 
+        /// Only every n-th point of each scan is read from directories
+        /// of UOS scans and scan projects
+        static int m_scanReduction;
+
 };
 
 typedef boost::shared_ptr<ModelFactory> ModelFactoryPtr;
@@ -60,6 +60,8 @@ namespace lvr2
  * The PLYIO class provides functionalities for reading and writing the Polygon
  * File Format, also known as Stanford Triangle Format. Both binary and ascii
  * modes are supported. For the actual file handling the RPly library is used.
+ * The data of binary little endian files with fixed size records is copied
+ * directly from a memory map into the buffers instead.
  * \n \n
  * The following list is a short description of all handled elements and
  * properties of ply files. In short the elements \c vertex and \c face
@@ -162,6 +164,18 @@ class PLYIO : public BaseIO
         ModelPtr read( string filename );
 
 
+        /**
+         * \brief Open specified PLY file for reading its points in chunks.
+         *
+         * Binary little endian files are streamed from a memory map if
+         * the points are stored in front of all variable sized records.
+         * Other files are loaded completely with read().
+         *
+         * \param filename        Filename of file to read.
+         **/
+        PointReaderPtr openPointReader( string filename );
+
+
     private:
 
 
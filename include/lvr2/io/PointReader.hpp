@@ -0,0 +1,171 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file       PointReader.hpp
+ * @brief      Pull based interface to read point clouds in chunks.
+ */
+
+#ifndef LVR2_IO_POINTREADER_HPP_
+#define LVR2_IO_POINTREADER_HPP_
+
+#include <lvr2/io/PointBuffer.hpp>
+#include <lvr2/geometry/BaseVector.hpp>
+#include <lvr2/geometry/BoundingBox.hpp>
+
+#include <memory>
+
+namespace lvr2
+{
+
+/**
+ * @brief Sequential reader that delivers the points of a file in chunks
+ *        of bounded size. Tools that only need to see every point once
+ *        can use it to process clouds that do not fit into memory.
+ *
+ *        Usage:
+ *
+ *          PointReaderPtr reader = ModelFactory::openPointReader(file);
+ *          PointBufferPtr chunk(new PointBuffer);
+ *          while(reader->readChunk(chunk, 1 << 20)) { ... }
+ */
+class PointReader
+{
+public:
+    PointReader() {}
+    virtual ~PointReader() {}
+
+    /**
+     * @brief Returns the number of points in the file. For formats
+     *        that contain invalid lines or records this is an upper
+     *        bound of the number of points that will be delivered.
+     */
+    virtual size_t numPoints() const = 0;
+
+    /// @brief True if the delivered chunks contain RGB colors
+    virtual bool hasColors() const { return false; }
+
+    /// @brief True if the delivered chunks contain normals
+    virtual bool hasNormals() const { return false; }
+
+    /// @brief True if the delivered chunks contain an 'intensities' channel
+    virtual bool hasIntensities() const { return false; }
+
+    /**
+     * @brief Reads the next at most \ref n points into \ref chunk. All
+     *        previous contents of the chunk are replaced. The arrays of
+     *        the chunk are reused if they are large enough, i.e. data
+     *        taken from a chunk is only valid until it is passed to
+     *        readChunk() again.
+     *
+     * @param chunk     The buffer to fill
+     * @param n         Maximum number of points to read
+     *
+     * @return The number of points in the chunk, 0 at the end of the file
+     */
+    size_t readChunk(PointBufferPtr chunk, size_t n);
+
+    /**
+     * @brief Restarts reading at the first point of the file.
+     */
+    virtual void rewind() = 0;
+
+    /**
+     * @brief Returns the bounding box of all points in the file. The
+     *        default implementation reads the whole file once and rewinds
+     *        the reader, formats that store the bounds in their header
+     *        override it.
+     */
+    virtual BoundingBox<BaseVector<float> > getBoundingBox();
+
+protected:
+
+    /**
+     * @brief Reads the next at most \ref n points into the given arrays.
+     *        The attribute arrays may be null, in that case the
+     *        attribute is skipped.
+     *
+     * @param n             Maximum number of points to read
+     * @param points        Space for 3 * n coordinates
+     * @param colors        Space for 3 * n color values or null
+     * @param normals       Space for 3 * n normal components or null
+     * @param intensities   Space for n intensities or null
+     *
+     * @return The number of points read
+     */
+    virtual size_t readPoints(
+            size_t n,
+            float* points,
+            unsigned char* colors,
+            float* normals,
+            float* intensities) = 0;
+
+    /**
+     * @brief Adds atomics that hold for all points of the file to a
+     *        freshly read chunk, e.g. the coordinate base of LAS files.
+     */
+    virtual void addAtomics(PointBuffer&) {}
+};
+
+using PointReaderPtr = std::shared_ptr<PointReader>;
+
+/**
+ * @brief Serves the points of an already loaded point buffer. Used as
+ *        fallback for formats that can't be streamed.
+ */
+class ModelPointReader : public PointReader
+{
+public:
+    ModelPointReader(PointBufferPtr buffer);
+
+    size_t numPoints() const override;
+    bool hasColors() const override;
+    bool hasNormals() const override;
+    bool hasIntensities() const override;
+    void rewind() override;
+
+protected:
+    size_t readPoints(
+            size_t n,
+            float* points,
+            unsigned char* colors,
+            float* normals,
+            float* intensities) override;
+
+private:
+    PointBufferPtr  m_buffer;
+    floatArr        m_points;
+    ucharArr        m_colors;
+    floatArr        m_normals;
+    floatArr        m_intensities;
+    size_t          m_numPoints;
+    size_t          m_position;
+};
+
+} // namespace lvr2
+
+#endif /* LVR2_IO_POINTREADER_HPP_ */
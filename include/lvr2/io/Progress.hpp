@@ -38,6 +38,8 @@
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <atomic>
+#include <memory>
 
 using std::stringstream;
 using std::cout;
@@ -52,6 +54,66 @@ using std::wcout;
 namespace lvr2
 {
 
+/**
+ * @brief   Counts the iterations of each thread in its own cache line. A
+ *          thread hands its count over to the shared counter of a progress
+ *          bar only when it may complete a percentage, so parallel loops
+ *          don't contend on the shared counter. Close to the end all counts
+ *          are handed over right away, so the bar reaches 100% inside the
+ *          loop.
+ */
+class ThreadProgress
+{
+public:
+
+    /**
+     * @brief Ctor.
+     *
+     * @param max_val   The number of performed iterations
+     */
+    ThreadProgress(size_t max_val);
+
+    /**
+     * @brief Adds \ref n iterations of the calling thread.
+     *
+     * @param n         The number of new iterations
+     * @param published The current value of the shared counter
+     *
+     * @return The iterations to add to the shared counter, 0 if they
+     *         are kept back
+     */
+    size_t add(size_t n, size_t published);
+
+    /**
+     * @brief Returns all iterations that were kept back.
+     */
+    size_t flush();
+
+private:
+
+    /// A counter padded to a cache line
+    struct Slot
+    {
+        std::atomic<size_t> count;
+        char                padding[64 - sizeof(std::atomic<size_t>)];
+    };
+
+    /// One slot per thread
+    std::unique_ptr<Slot[]> m_slots;
+
+    /// Number of slots
+    size_t                  m_numSlots;
+
+    /// Count of a slot that is handed over to the shared counter
+    size_t                  m_step;
+
+    /// Shared counter value from which on nothing is kept back
+    size_t                  m_finalVal;
+
+    /// True once the slots of all threads were handed over at the end
+    std::atomic<bool>       m_draining;
+};
+
 /**
  * @brief  	A class to manage progress information output for
  * 			process where the number of performed operations
@@ -81,7 +143,10 @@ public:
     virtual ~ProgressBar();
 
     /**
-     * @brief Increases the counter of performed iterations
+     * @brief Increases the counter of performed iterations. Each thread
+     *        counts locally and only touches the shared counter about
+     *        once per percentage, so this is cheap to call from parallel
+     *        loops.
      */
     void operator++();
 
@@ -111,16 +176,28 @@ protected:
     /// Prints the output
     void print_bar();
 
+    /// Adds \ref n to the shared counter and prints reached percentages
+    void publish(size_t n);
+
+    /// Prints all percentages reached with the counter value \ref val
+    void update(size_t val);
+
     /// The prefix string
     string 			m_prefix;
 
     /// The number of iterations
     size_t			m_maxVal;
 
-        /// The current counter
-    size_t	 		m_currentVal;
+    /// The current counter
+    std::atomic<size_t>	m_currentVal;
+
+    /// The iterations of each thread not yet added to \ref m_currentVal
+    ThreadProgress	m_threadVal;
+
+    /// The counter value that completes the next percentage
+    std::atomic<size_t>	m_nextVal;
 
-    /// A mutex object for counter increment (for parallel executions)
+    /// A mutex object for output generation (for parallel executions)
     boost::mutex 	m_mutex;
 
     /// The current progress in percent
@@ -163,8 +240,8 @@ public:
 
 protected:
 
-    /// Prints the current state
-    void print_progress();
+    /// Prints the state for counter value \ref val
+    void print_progress(size_t val);
 
     /// The prefix string
     string 			m_prefix;
@@ -173,9 +250,9 @@ protected:
     size_t			m_stepVal;
 
     /// The current counter value
-    size_t			m_currentVal;
+    std::atomic<size_t>	m_currentVal;
 
-    /// A mutex object for counter increment (for parallel executions)
+    /// A mutex object for output generation (for parallel executions)
     boost::mutex 	m_mutex;
 
     /// A string stream for output generation
@@ -239,16 +316,28 @@ protected:
 	/// Prints the output
 	void print_bar();
 
+	/// Adds \ref n to the shared counter and prints reached percentages
+	void publish(size_t n);
+
+	/// Prints all percentages reached with the counter value \ref val
+	void update(size_t val);
+
 	/// The prefix string
 	string 			m_prefix;
 
 	/// The number of iterations
 	size_t			m_maxVal;
 
-        /// The current counter
-    size_t	 		m_currentVal;
+	/// The current counter
+	std::atomic<size_t>	m_currentVal;
+
+	/// The iterations of each thread not yet added to \ref m_currentVal
+	ThreadProgress	m_threadVal;
+
+	/// The counter value that completes the next percentage
+	std::atomic<size_t>	m_nextVal;
 
-	/// A mutex object for counter increment (for parallel executions)
+	/// A mutex object for output generation (for parallel executions)
 	boost::mutex 	m_mutex;
 
 	/// The current progress in percent
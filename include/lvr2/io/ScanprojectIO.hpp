@@ -119,6 +119,13 @@ class ScanprojectIO : public BaseIO
          */
         void save(std::string dir);
 
+        /**
+         * @brief Keeps only every n-th point of each scan while reading
+         *
+         * @param n The reduction factor (1 keeps all points)
+         */
+        void setScanReduction(int n) { m_scanReduction = n > 1 ? n : 1; }
+
         /**
          * @brief Parses a directory as an UOS Scanproject
          *
@@ -149,6 +156,7 @@ class ScanprojectIO : public BaseIO
         bool exists_and_is_dir(const fs::path &dir, bool silent);
         fs::path project_dir;
         Scanproject project;
+        int m_scanReduction = 1;
         /// @endcond internal
 };
 
@@ -84,6 +84,7 @@ public:
         m_lastScan(-1),
         m_saveToDisk(false),
         m_reductionTarget(0),
+        m_scanReduction(1),
         m_numScans(0),
         m_saveRemission(false),
         m_saveRemissionColor(false){}
@@ -112,6 +113,13 @@ public:
     void setLastScan(int n) {m_lastScan = n;}
 
 
+    /**
+     * @brief Keeps only every n-th point of each scan while reading
+     * @param n         The reduction factor (1 keeps all points)
+     */
+    void setScanReduction(int n) { m_scanReduction = n > 1 ? n : 1; }
+
+
     /**
      * Reduces the given point cloud and exports all points
      * into on single file.
@@ -174,6 +182,21 @@ private:
     void readOldFormat(ModelPtr &m, string dir, int first, int last, size_t &n);
 
 
+    /**
+     * @brief Returns the transformation of the given scan in new UOS format.
+     *        The last matrix of the .frames file is used if present,
+     *        otherwise the .pose file.
+     */
+    Matrix4<Vec> readScanTransform(string dir, int scan);
+
+
+    /**
+     * @brief Writes the points of the given buffer to \ref{m_outputFile}
+     *        (reduction mode).
+     */
+    void writeReduced(PointBufferPtr buffer);
+
+
     inline std::string to_string(const int& t, int width)
     {
       stringstream ss;
@@ -235,6 +258,9 @@ private:
     /// Number of targeted points for reduction
     int     m_reductionTarget;
 
+    /// Only every n-th point of each scan is read
+    int     m_scanReduction;
+
     /// If true, remission values will be converted to color
     bool    m_saveRemissionColor;
 
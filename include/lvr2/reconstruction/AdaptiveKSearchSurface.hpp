@@ -54,6 +54,7 @@
 
 
 #include "PointsetSurface.hpp"
+#include "PlaneFitting.hpp"
 
 // #ifdef LVR2_USE_STANN
 // // SearchTreeStann
@@ -144,6 +145,13 @@ public:
     virtual pair<typename BaseVecT::CoordType, typename BaseVecT::CoordType>
         distance(BaseVecT v) const;
 
+    /// See interface documentation. Uses a single batched k-nearest
+    /// neighbour search for all grid points.
+    virtual void distance(
+        const vector<BaseVecT>& v,
+        vector<pair<typename BaseVecT::CoordType, typename BaseVecT::CoordType>>& result
+    ) const;
+
     /**
      * @brief Calculates initial point normals using a least squares fit to
      *        the \ref m_kn nearest points
@@ -228,6 +236,34 @@ private:
      */
     void init();
 
+    /**
+     * @brief Calculates the distance pair of \ref p from the tangent plane
+     *        that is averaged over the given neighbours.
+     *
+     * @param p         The grid point
+     * @param id        The indices of the nearest data points
+     * @param k         The number of neighbours, at most m_kd
+     * @param pts       The point channel of the point buffer
+     * @param normals   The normal channel of the point buffer
+     */
+    pair<typename BaseVecT::CoordType, typename BaseVecT::CoordType>
+        distanceToNeighbors(
+            const BaseVecT& p,
+            const size_t* id,
+            size_t k,
+            FloatChannel& pts,
+            FloatChannel& normals
+        ) const;
+
+    /**
+     * @brief Returns the number of neighbours in a row of kSearchBatch(),
+     *        which is less than k if the data set has fewer than k points.
+     *
+     * @param id    The k entries of the row
+     * @param k     The number of searched neighbours
+     */
+    static size_t numNeighbors(const size_t* id, size_t k);
+
     /**
      * @brief Checks if the bounding box of a point set is "well formed",
      *        i.e. no dimension is significantly larger than the other.
@@ -241,6 +277,22 @@ private:
      */
     bool boundingBoxOK(float dx, float dy, float dz);
 
+    /**
+     * @brief Returns the smallest neighbourhood size k = kmin, 2 * kmin, ...
+     *        (up to kmax) for which the bounding box of the first k
+     *        neighbours is well formed. Each neighbourhood is evaluated
+     *        as a prefix of the given one, so the neighbours have to be
+     *        the exact nearest neighbours sorted by distance.
+     *
+     * @param id    The indices of the kmax nearest neighbours
+     * @param kmin  The smallest neighbourhood size
+     * @param kmax  The largest neighbourhood size
+     * @param pts   The point channel of the point buffer
+     *
+     * @return The found size or 0 if no neighbourhood is well formed.
+     */
+    size_t wellFormedPrefix(const size_t* id, size_t kmin, size_t kmax, FloatChannel& pts);
+
     // /**
     //  * @brief Returns the mean distance of the given point set from
     //  *        the given plane
@@ -275,12 +327,13 @@ private:
      * @param queryPoint    The point for which the tangent plane is created
      * @param k             The size of the used k-neighborhood
      * @param id            The positions of the neighborhood points in \ref m_points
-     * @param ok            True, if RANSAC interpolation was succesfull
+     * @param ok            False, if the neighborhood is degenerated
      */
     Plane<BaseVecT> calcPlane(
         const BaseVecT &queryPoint,
         int k,
-        const vector<size_t> &id
+        const vector<size_t> &id,
+        bool &ok
     );
 
     Plane<BaseVecT> calcPlaneRANSAC(
@@ -296,6 +349,12 @@ private:
         const vector<size_t> &id
     );
 
+    /**
+     * @brief Computes centroid and covariance of the first k points in id
+     *        using the vectorized kernel from PlaneFitting.hpp
+     */
+    Covariance3 neighborhoodCovariance(int k, const vector<size_t> &id);
+
 
 
 
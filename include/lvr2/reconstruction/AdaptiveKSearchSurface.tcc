@@ -177,141 +177,160 @@ void AdaptiveKSearchSurface<BaseVecT>::calculateSurfaceNormals()
     string comment = timestamp.getElapsedTime() + "Estimating normals ";
     lvr2::ProgressBar progress(numPoints, comment);
 
-    #pragma omp parallel for schedule(static)
-    for(size_t i = 0; i < numPoints; i++) {
-        // We have to fit these vector to have the
-        // correct return values when performing the
-        // search on the stann kd tree. So we don't use
-        // the template parameter T for di
-        vector<size_t> id;
-        vector<float> di;
-
-        int n = 0;
-        size_t k = k_0;
-
-        while(n < 5)
+    // The points are processed in blocks. The neighbours of all points
+    // of a block are searched at once. The neighbourhood size is doubled
+    // up to four times until its bounding box is well formed. Since
+    // kSearchBatch() searches exactly and sorts the neighbours by distance,
+    // the smaller neighbourhoods are prefixes of the larger ones: the
+    // points that fail with 2 * k_0 neighbours are searched a second time
+    // with 32 * k_0 neighbours and all remaining sizes are checked on that
+    // single result.
+    const size_t blockSize = 16384;
+    const size_t kMin[2] = {2 * (size_t)k_0, 4 * (size_t)k_0};
+    const size_t kMax[2] = {2 * (size_t)k_0, 32 * (size_t)k_0};
+
+    vector<vector<size_t>> neighbors(std::min(numPoints, blockSize));
+    vector<size_t> pending;
+    vector<BaseVecT> queries;
+    vector<size_t> found;
+    vector<float> distances;
+    size_t numDegenerated = 0;
+
+    for(size_t start = 0; start < numPoints; start += blockSize)
+    {
+        size_t end = std::min(numPoints, start + blockSize);
+
+        pending.clear();
+        for(size_t i = start; i < end; i++)
         {
-            n++;
-            /**
-             *  @todo Maybe this should be done at the end of the loop
-             *        after the bounding box check
-             */
-            k = k * 2;
-
-            //T* point = this->m_points[i];
-
-            id.clear();
-            di.clear();
-
-            this->m_searchTree->kSearch(pts[i], k, id, di);
-
-            float min_x = 1e15f;
-            float min_y = 1e15f;
-            float min_z = 1e15f;
-            float max_x = - min_x;
-            float max_y = - min_y;
-            float max_z = - min_z;
-
-            float dx, dy, dz;
-            dx = dy = dz = 0;
-
-            // Calculate the bounding box of found point set
-            /**
-             * @todo Use the bounding box object from the old model3d
-             *       library for bounding box calculation...
-             */
-            for(size_t j = 0; j < k; j++) {
-                min_x = std::min(min_x, pts[id[j]][0]);
-                min_y = std::min(min_y, pts[id[j]][1]);
-                min_z = std::min(min_z, pts[id[j]][2]);
-
-                max_x = std::max(max_x, pts[id[j]][0]);
-                max_y = std::max(max_y, pts[id[j]][1]);
-                max_z = std::max(max_z, pts[id[j]][2]);
-
-                dx = max_x - min_x;
-                dy = max_y - min_y;
-                dz = max_z - min_z;
+            pending.push_back(i);
+        }
+
+        for(int round = 0; round < 2 && !pending.empty(); round++)
+        {
+            size_t k = kMax[round];
+
+            queries.resize(pending.size());
+            for(size_t j = 0; j < pending.size(); j++)
+            {
+                queries[j] = pts[pending[j]];
             }
 
-            if(boundingBoxOK(dx, dy, dz))
+            this->m_searchTree->kSearchBatch(queries, k, found, distances);
+
+            #pragma omp parallel for schedule(static)
+            for(long j = 0; j < (long)pending.size(); j++)
             {
-                break;
+                const size_t* id = &found[j * k];
+                size_t numFound = numNeighbors(id, k);
+                size_t n = wellFormedPrefix(id, kMin[round], numFound, pts);
+
+                // Use the largest neighbourhood if none is well formed
+                if(n == 0 && (round == 1 || numFound < k))
+                {
+                    n = numFound;
+                }
+
+                if(n > 0)
+                {
+                    neighbors[pending[j] - start].assign(id, id + n);
+                    pending[j] = numPoints;
+                }
             }
+
+            pending.erase(std::remove(pending.begin(), pending.end(), numPoints), pending.end());
         }
 
-        // Create a query point for the current point
-        auto queryPoint = pts[i];
+        #pragma omp parallel for schedule(static) reduction(+:numDegenerated)
+        for(long i = start; i < (long)end; i++) {
+            const vector<size_t>& id = neighbors[i - start];
+            int numNeighbors = id.size();
 
-        // Interpolate a plane based on the k-neighborhood
-        Plane<BaseVecT> p;
-        bool ransac_ok;
+            // Create a query point for the current point
+            auto queryPoint = pts[i];
 
-        if(m_calcMethod == 1)
-        {
-            p = calcPlaneRANSAC(queryPoint, k, id, ransac_ok);
-            // Fallback if RANSAC failed
-            if(!ransac_ok)
+            // Interpolate a plane based on the k-neighborhood
+            Plane<BaseVecT> p;
+            bool ransac_ok;
+            bool plane_ok = true;
+
+            if(m_calcMethod == 1)
             {
-                // compare speed
-                p = calcPlane(queryPoint, k, id);
+                p = calcPlaneRANSAC(queryPoint, numNeighbors, id, ransac_ok);
+                // Fallback if RANSAC failed
+                if(!ransac_ok)
+                {
+                    // compare speed
+                    p = calcPlane(queryPoint, numNeighbors, id, plane_ok);
+                }
+            }
+            else if(m_calcMethod == 2)
+            {
+                p = calcPlaneIterative(queryPoint, numNeighbors, id);
+            }
+            else
+            {
+                p = calcPlane(queryPoint, numNeighbors, id, plane_ok);
             }
-        }
-        else if(m_calcMethod == 2)
-        {
-            p = calcPlaneIterative(queryPoint, k, id);
-        }
-        else
-        {
-            p = calcPlane(queryPoint, k, id);
-        }
-        // Get the mean distance to the tangent plane
-        //mean_distance = meanDistance(p, id, k);
-        Normal<typename BaseVecT::CoordType> normal(0, 0, 1);
-        normal = p.normal;
 
-        // Flip normals towards the center of the scene or nearest scan pose
-        if(m_poseTree)
-        {
-            vector<size_t> nearestPoseIds;
-            m_poseTree->kSearch(queryPoint, 1, nearestPoseIds);
-            if(nearestPoseIds.size() == 1)
+            if(!plane_ok)
             {
-                BaseVecT nearest = pts[nearestPoseIds[0]];
-                Normal<typename BaseVecT::CoordType> dir(queryPoint - nearest);
-                if(normal.dot(dir) > 0)
+                numDegenerated++;
+            }
+            // Get the mean distance to the tangent plane
+            //mean_distance = meanDistance(p, id, k);
+            Normal<typename BaseVecT::CoordType> normal(0, 0, 1);
+            normal = p.normal;
+
+            // Flip normals towards the center of the scene or nearest scan pose
+            if(m_poseTree)
+            {
+                vector<size_t> nearestPoseIds;
+                m_poseTree->kSearch(queryPoint, 1, nearestPoseIds);
+                if(nearestPoseIds.size() == 1)
                 {
-                    normal = -normal;
+                    BaseVecT nearest = pts[nearestPoseIds[0]];
+                    Normal<typename BaseVecT::CoordType> dir(queryPoint - nearest);
+                    if(normal.dot(dir) > 0)
+                    {
+                        normal = -normal;
+                    }
+                }
+                else
+                {
+                    cout << timestamp.getElapsedTime() << "Could not get nearest scan pose. Defaulting to centroid." << endl;
+                    Normal<typename BaseVecT::CoordType> dir(queryPoint - m_centroid);
+                    if(normal.dot(dir) > 0)
+                    {
+                        normal = -normal;
+                    }
                 }
             }
             else
             {
-                cout << timestamp.getElapsedTime() << "Could not get nearest scan pose. Defaulting to centroid." << endl;
                 Normal<typename BaseVecT::CoordType> dir(queryPoint - m_centroid);
                 if(normal.dot(dir) > 0)
                 {
                     normal = -normal;
                 }
             }
-        }
-        else
-        {
-            Normal<typename BaseVecT::CoordType> dir(queryPoint - m_centroid);
-            if(normal.dot(dir) > 0)
-            {
-                normal = -normal;
-            }
-        }
 
-        // Save result in normal array
-        normals[i*3 + 0] = normal.x;
-        normals[i*3 + 1] = normal.y;
-        normals[i*3 + 2] = normal.z;
+            // Save result in normal array
+            normals[i*3 + 0] = normal.x;
+            normals[i*3 + 1] = normal.y;
+            normals[i*3 + 2] = normal.z;
 
-        ++progress;
+            ++progress;
+        }
     }
     cout << endl;
 
+    if(numDegenerated > 0)
+    {
+        cout << timestamp << "Warning: " << numDegenerated
+             << " degenerated neighborhoods in plane fit." << endl;
+    }
+
     if(this->m_ki)
     {
         interpolateSurfaceNormals();
@@ -335,40 +354,57 @@ void AdaptiveKSearchSurface<BaseVecT>::interpolateSurfaceNormals()
     string comment = timestamp.getElapsedTime() + "Interpolating normals ";
     lvr2::ProgressBar progress(numPoints, comment);
 
-    // Interpolate normals
-    #pragma omp parallel for schedule(static)
-    for( int i = 0; i < (int)numPoints; i++){
-
-        vector<size_t> id;
-        vector<float> di;
+    // Interpolate normals. The neighbours are searched blockwise.
+    const size_t blockSize = 16384;
+    int k = this->m_ki;
+    vector<BaseVecT> queries;
+    vector<size_t> found;
+    vector<float> distances;
 
-        this->m_searchTree->kSearch(pts[i], this->m_ki, id, di);
-
-        BaseVecT mean;
+    for(size_t start = 0; start < numPoints; start += blockSize)
+    {
+        size_t end = std::min(numPoints, start + blockSize);
 
-        for(int j = 0; j < this->m_ki; j++)
+        queries.resize(end - start);
+        for(size_t i = start; i < end; i++)
         {
-            mean += normals[id[j]];
+            queries[i - start] = pts[i];
         }
-        auto mean_normal = mean.normalized();
 
-        tmp[i] = mean_normal;
+        this->m_searchTree->kSearchBatch(queries, k, found, distances);
 
-        ///todo Try to remove this code. Should improve the results at all.
-        for(int j = 0; j < this->m_ki; j++)
-        {
-            Normal<typename BaseVecT::CoordType> n = normals[id[j]];
+        #pragma omp parallel for schedule(static)
+        for(long i = start; i < (long)end; i++){
+
+            const size_t* id = &found[(i - start) * k];
+            size_t numFound = numNeighbors(id, k);
+
+            BaseVecT mean;
+
+            for(size_t j = 0; j < numFound; j++)
+            {
+                mean += normals[id[j]];
+            }
+            auto mean_normal = mean.normalized();
 
-            // Only override existing normals if the interpolated
-            // normals is significantly different from the initial
-            // estimation. This helps to avoid a too smooth normal
-            // field
-            if(fabs(n.dot(mean_normal)) > 0.2 )
+            tmp[i] = mean_normal;
+
+            ///todo Try to remove this code. Should improve the results at all.
+            for(size_t j = 0; j < numFound; j++)
             {
-                normals[id[j]] = mean_normal;
+                Normal<typename BaseVecT::CoordType> n = normals[id[j]];
+
+                // Only override existing normals if the interpolated
+                // normals is significantly different from the initial
+                // estimation. This helps to avoid a too smooth normal
+                // field
+                if(fabs(n.dot(mean_normal)) > 0.2 )
+                {
+                    normals[id[j]] = mean_normal;
+                }
             }
+            ++progress;
         }
-        ++progress;
     }
     cout << endl;
     cout << timestamp.getElapsedTime() << "Copying normals..." << endl;
@@ -378,6 +414,58 @@ void AdaptiveKSearchSurface<BaseVecT>::interpolateSurfaceNormals()
     }
 }
 
+template<typename BaseVecT>
+size_t AdaptiveKSearchSurface<BaseVecT>::numNeighbors(const size_t* id, size_t k)
+{
+    // The missing neighbours are at the end of the sorted result
+    while(k > 0 && id[k - 1] == SearchTree<BaseVecT>::INVALID_INDEX)
+    {
+        k--;
+    }
+    return k;
+}
+
+template<typename BaseVecT>
+size_t AdaptiveKSearchSurface<BaseVecT>::wellFormedPrefix(
+    const size_t* id,
+    size_t kmin,
+    size_t kmax,
+    FloatChannel& pts
+)
+{
+    float min_x = 1e15f;
+    float min_y = 1e15f;
+    float min_z = 1e15f;
+    float max_x = - min_x;
+    float max_y = - min_y;
+    float max_z = - min_z;
+
+    // Grow the bounding box point by point and check it whenever
+    // the next neighbourhood size is reached
+    size_t k = kmin;
+    for(size_t j = 0; j < kmax; j++)
+    {
+        min_x = std::min(min_x, pts[id[j]][0]);
+        min_y = std::min(min_y, pts[id[j]][1]);
+        min_z = std::min(min_z, pts[id[j]][2]);
+
+        max_x = std::max(max_x, pts[id[j]][0]);
+        max_y = std::max(max_y, pts[id[j]][1]);
+        max_z = std::max(max_z, pts[id[j]][2]);
+
+        if(j + 1 == k)
+        {
+            if(boundingBoxOK(max_x - min_x, max_y - min_y, max_z - min_z))
+            {
+                return k;
+            }
+            k *= 2;
+        }
+    }
+
+    return 0;
+}
+
 template<typename BaseVecT>
 bool AdaptiveKSearchSurface<BaseVecT>::boundingBoxOK(float dx, float dy, float dz)
 {
@@ -463,22 +551,56 @@ pair<typename BaseVecT::CoordType, typename BaseVecT::CoordType>
 
     FloatChannel pts     = *(this->m_pointBuffer->getFloatChannel("points"));
     FloatChannel normals = *(this->m_pointBuffer->getFloatChannel("normals"));
-    size_t numPoints     = pts.numElements();
     int k = this->m_kd;
 
     vector<size_t> id;
     vector<float> di;
 
-    //Allocate ANN point
+    // Find nearest tangent plane
+    this->m_searchTree->kSearch( p, k, id, di );
+
+    return distanceToNeighbors(p, id.data(), id.size(), pts, normals);
+}
+
+template<typename BaseVecT>
+void AdaptiveKSearchSurface<BaseVecT>::distance(
+    const vector<BaseVecT>& v,
+    vector<pair<typename BaseVecT::CoordType, typename BaseVecT::CoordType>>& result
+) const
+{
+    FloatChannel pts     = *(this->m_pointBuffer->getFloatChannel("points"));
+    FloatChannel normals = *(this->m_pointBuffer->getFloatChannel("normals"));
+    int k = this->m_kd;
+
+    vector<size_t> id;
+    vector<float> di;
+
+    // Find the nearest tangent planes of all grid points at once
+    this->m_searchTree->kSearchBatch(v, k, id, di);
+
+    result.resize(v.size());
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)v.size(); i++)
     {
-        // Find nearest tangent plane
-        this->m_searchTree->kSearch( p, k, id, di );
+        result[i] = distanceToNeighbors(v[i], &id[i * k], numNeighbors(&id[i * k], k), pts, normals);
     }
+}
 
+template<typename BaseVecT>
+pair<typename BaseVecT::CoordType, typename BaseVecT::CoordType>
+    AdaptiveKSearchSurface<BaseVecT>::distanceToNeighbors(
+        const BaseVecT& p,
+        const size_t* id,
+        size_t k,
+        FloatChannel& pts,
+        FloatChannel& normals
+    ) const
+{
     BaseVecT nearest;
     BaseVecT avg_normal;
 
-    for ( int i = 0; i < k; i++ )
+    for ( size_t i = 0; i < k; i++ )
     {
         //Get nearest tangent plane
         auto vq = pts[id[i]];
@@ -511,56 +633,51 @@ pair<typename BaseVecT::CoordType, typename BaseVecT::CoordType>
 // }
 
 template<typename BaseVecT>
-Plane<BaseVecT> AdaptiveKSearchSurface<BaseVecT>::calcPlane(
-    const BaseVecT &queryPoint,
+Covariance3 AdaptiveKSearchSurface<BaseVecT>::neighborhoodCovariance(
     int k,
     const vector<size_t> &id
 )
 {
-    FloatChannel pts     = *(this->m_pointBuffer->getFloatChannel("points"));
-    size_t numPoints     = pts.numElements();
-
-    /**
-     * @todo Think of a better way to code this magic number.
-     */
-    const float epsilon = 100.0;
+    FloatChannel pts = *(this->m_pointBuffer->getFloatChannel("points"));
 
-    // Calculate a least sqaures fit to the given points
-    Eigen::Vector3f C;
-    Eigen::VectorXf F(k);
-    Eigen::MatrixXf B(k, 3);
+    // Gather the neighborhood into per-thread coordinate arrays so that
+    // the covariance kernel can process them with vector instructions
+    thread_local vector<float> x;
+    thread_local vector<float> y;
+    thread_local vector<float> z;
+    x.resize(k);
+    y.resize(k);
+    z.resize(k);
 
-    for(int j = 0; j < k; j++) {
+    for(int j = 0; j < k; j++)
+    {
         BaseVecT p = pts[id[j]];
-        F(j)    = p.y;
-        B(j, 0) = 1.0f;
-        B(j, 1) = p.x;
-        B(j, 2) = p.z;
+        x[j] = p.x;
+        y[j] = p.y;
+        z[j] = p.z;
     }
 
-    C = B.jacobiSvd(Eigen::ComputeThinU | Eigen::ComputeThinV).solve(F);
-
-    // Calculate to vectors in the fitted plane
-    auto z1 = C(0) + C(1) * (queryPoint.x + epsilon) + C(2) * queryPoint.z;
-    auto z2 = C(0) + C(1) * queryPoint.x + C(2) * (queryPoint.z + epsilon);
-
-    // Calculcate the plane's normal via the cross product
-    auto diff1 = BaseVecT(queryPoint.x + epsilon, z1, queryPoint.z) - queryPoint;
-    auto diff2 = BaseVecT(queryPoint.x, z2, queryPoint.z + epsilon) - queryPoint;
+    return computeCovariance(x.data(), y.data(), z.data(), k);
+}
 
-    auto normal = diff1.cross(diff2).normalized();
+template<typename BaseVecT>
+Plane<BaseVecT> AdaptiveKSearchSurface<BaseVecT>::calcPlane(
+    const BaseVecT &queryPoint,
+    int k,
+    const vector<size_t> &id,
+    bool &ok
+)
+{
+    // The plane normal is the eigenvector of the smallest eigenvalue
+    // of the neighborhood's covariance matrix
+    Covariance3 c = neighborhoodCovariance(k, id);
 
-    if(isnan(normal.getX()) || isnan(normal.getY()) || isnan(normal.getZ()))
-    {
-        cout << "Warning: Nan-coordinate in plane normal." << endl;
-    }
+    float n[3];
+    ok = smallestEigenvector(c.cov, n);
 
     // Create a plane representation and return the result
     Plane<BaseVecT> p;
-    // p.a = C(0);
-    // p.b = C(1);
-    // p.c = C(2);
-    p.normal = normal;
+    p.normal = Normal<typename BaseVecT::CoordType>(n[0], n[1], n[2]);
     p.pos = queryPoint;
 
     return p;
@@ -573,40 +690,26 @@ Plane<BaseVecT> AdaptiveKSearchSurface<BaseVecT>::calcPlaneIterative(
     const vector<size_t> &id
 )
 {
-
-    FloatChannel pts     = *(this->m_pointBuffer->getFloatChannel("points"));
-    FloatChannel normals = *(this->m_pointBuffer->getFloatChannel("normals"));
-    size_t numPoints     = pts.numElements();
-
     Plane<BaseVecT> p;
     BaseVecT normal;
 
+    // Second moments about the query point: cov + d * d^T with d = mean - q
+    Covariance3 c = neighborhoodCovariance(k, id);
+    float dx = c.mean[0] - queryPoint.x;
+    float dy = c.mean[1] - queryPoint.y;
+    float dz = c.mean[2] - queryPoint.z;
 
     //x
-    float xx = 0.0;
-    float xy = 0.0;
-    float xz = 0.0;
+    float xx = c.cov[0] + dx * dx;
+    float xy = c.cov[1] + dx * dy;
+    float xz = c.cov[2] + dx * dz;
 
     //y
-    float yy = 0.0;
-    float yz = 0.0;
+    float yy = c.cov[3] + dy * dy;
+    float yz = c.cov[4] + dy * dz;
 
     //z
-    float zz = 0.0;
-
-    for(int j = 0; j < k; j++) {
-        auto p = pts[id[j]];
-
-        auto r = p - queryPoint;
-
-        xx += r.x * r.x;
-        xy += r.x * r.y;
-        xz += r.x * r.z;
-        yy += r.y * r.y;
-        yz += r.y * r.z;
-        zz += r.z * r.z;
-
-    }
+    float zz = c.cov[5] + dz * dz;
 
     //determinante
     float det_x = yy * zz - yz * yz;
@@ -73,6 +73,20 @@ public:
         float comparePrecision
     );
 
+    /**
+     * @brief Unlike FastBox, extruded boxes create triangles, too.
+     *        See FastBox::getSurfaceIndex().
+     */
+    virtual int getSurfaceIndex(
+        vector<QueryPoint<BaseVecT>>& query_points,
+        BaseVecT positions[12]
+    );
+
+    /**
+     * @brief Remembers the face for optimizePlanarFaces().
+     */
+    virtual void addSurfaceFace(FaceHandle face);
+
     void optimizePlanarFaces(BaseMesh<BaseVecT>& mesh, size_t kc);
 
     // the point set surface
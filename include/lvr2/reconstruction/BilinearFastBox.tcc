@@ -124,6 +124,20 @@ void BilinearFastBox<BaseVecT>::getSurface(
      }
 }
 
+template<typename BaseVecT>
+int BilinearFastBox<BaseVecT>::getSurfaceIndex(
+        vector<QueryPoint<BaseVecT>>& qp,
+        BaseVecT positions[12])
+{
+    return this->getValidIndex(qp, positions);
+}
+
+template<typename BaseVecT>
+void BilinearFastBox<BaseVecT>::addSurfaceFace(FaceHandle face)
+{
+    m_faces.push_back(face);
+}
+
  template<typename BaseVecT>
  void BilinearFastBox<BaseVecT>::optimizePlanarFaces(BaseMesh<BaseVecT>& mesh, size_t kc)
  {
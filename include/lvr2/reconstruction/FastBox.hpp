@@ -137,6 +137,30 @@ public:
         float comparePrecision
     );
 
+    /**
+     * @brief Determines the local marching cubes configuration without
+     *        modifying a mesh. This is used by the parallel surface
+     *        extraction in FastReconstruction, which creates the vertices
+     *        and faces afterwards.
+     *
+     * @param query_points  A vector containing the query points of the
+     *                      reconstruction grid
+     * @param positions     The interpolated intersections on the twelve
+     *                      box edges
+     * @return              The index into the MC table or -1 if the box
+     *                      does not create any triangles.
+     */
+    virtual int getSurfaceIndex(
+        vector<QueryPoint<BaseVecT>>& query_points,
+        BaseVecT positions[12]
+    );
+
+    /**
+     * @brief Called for every face the parallel surface extraction
+     *        creates from the triangles of this box.
+     */
+    virtual void addSurfaceFace(FaceHandle) {}
+
     /// The voxelsize of the reconstruction grid
     static float             m_voxelsize;
 
@@ -165,6 +189,12 @@ protected:
             return false;
     }
 
+    /**
+     * @brief Calculates the MC table index and the edge intersections
+     *        of this box. Returns -1 if a corner is invalid.
+     */
+    int getValidIndex(vector<QueryPoint<BaseVecT>>& query_points, BaseVecT positions[12]);
+
     /**
      * @brief Calculated the index for the MC table
      */
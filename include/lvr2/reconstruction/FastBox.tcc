@@ -125,6 +125,13 @@ int  FastBox<BaseVecT>::getIndex(vector<QueryPoint<BaseVecT> > &qp)
 template<typename BaseVecT>
 float FastBox<BaseVecT>::calcIntersection(float x1, float x2, float d1, float d2)
 {
+    // The tetraeder decomposition also interpolates along axes the
+    // edge does not extend in. Don't shift these coordinates, otherwise
+    // vertices on the faces of a cell leave the grid planes.
+    if(x1 == x2)
+    {
+        return x1;
+    }
 
     // Calculate the surface intersection using linear interpolation
     // and check for different signs of the given distance values.
@@ -194,6 +201,39 @@ void FastBox<BaseVecT>::getIntersections(BaseVecT* corners,
 }
 
 
+template<typename BaseVecT>
+int FastBox<BaseVecT>::getValidIndex(vector<QueryPoint<BaseVecT>>& qp, BaseVecT positions[12])
+{
+    BaseVecT corners[8];
+    float distances[8];
+
+    getCorners(corners, qp);
+    getDistances(distances, qp);
+    getIntersections(corners, distances, positions);
+
+    // Do not create triangles for invalid boxes
+    for (int i = 0; i < 8; i++)
+    {
+        if (qp[m_vertices[i]].m_invalid)
+        {
+            return -1;
+        }
+    }
+
+    return getIndex(qp);
+}
+
+template<typename BaseVecT>
+int FastBox<BaseVecT>::getSurfaceIndex(vector<QueryPoint<BaseVecT>>& qp, BaseVecT positions[12])
+{
+    if (this->m_extruded)
+    {
+        return -1;
+    }
+
+    return getValidIndex(qp, positions);
+}
+
 template<typename BaseVecT>
 void FastBox<BaseVecT>::getSurface(
     BaseMesh<BaseVecT>& mesh,
@@ -50,6 +50,7 @@
 
 #include <unordered_map>
 #include <memory>
+#include <cstdint>
 
 using std::shared_ptr;
 using std::unordered_map;
@@ -89,9 +90,14 @@ public:
     /**
      * @brief Constructor.
      *
-     * @param grid  A HashGrid instance on which the reconstruction is performed.
+     * @param grid      A HashGrid instance on which the reconstruction is performed.
+     * @param parallel  Extract the surface with all available threads. The
+     *                  resulting mesh is the same as with the serial
+     *                  extraction. Only supported for FastBox and
+     *                  BilinearFastBox, other box types are processed
+     *                  serially.
      */
-    FastReconstruction(shared_ptr<HashGrid<BaseVecT, BoxT>> grid);
+    FastReconstruction(shared_ptr<HashGrid<BaseVecT, BoxT>> grid, bool parallel = false);
 
 
     /**
@@ -106,6 +112,21 @@ public:
      */
     virtual void getMesh(BaseMesh<BaseVecT> &mesh);
 
+    /**
+     * @brief Returns the surface reconstruction of the part of the grid
+     *        that lies inside the given bounding box. Used to reconstruct
+     *        a point set in several partitions.
+     *
+     * @param mesh              The resulting mesh
+     * @param bb                Only cells whose center lies in this box
+     *                          (including the min and excluding the max
+     *                          faces) are triangulated
+     * @param duplicates        The indices of all vertices closer than
+     *                          comparePrecision to a face of bb are
+     *                          appended. Adjacent partitions create the
+     *                          same vertices at these positions.
+     * @param comparePrecision  Maximum distance of duplicates to bb
+     */
     virtual void getMesh(
         BaseMesh<BaseVecT>& mesh,
         BoundingBox<BaseVecT>& bb,
@@ -115,7 +136,31 @@ public:
 
 private:
 
+    /**
+     * @brief Performs the edge flipping of the sharp feature boxes and
+     *        the contour optimization of the planar marching cubes boxes
+     *        after the triangles were created.
+     */
+    void refineSurface(BaseMesh<BaseVecT>& mesh);
+
+    /**
+     * @brief Creates the marching cubes triangles of all cells in parallel.
+     *        Vertices on shared grid edges are merged afterwards and the
+     *        mesh is filled in the order of the serial extraction.
+     */
+    void getMeshParallel(BaseMesh<BaseVecT>& mesh);
+
+    /**
+     * @brief Returns a unique key for the grid edge that corresponds to
+     *        the given edge of the box, built from the indices of its
+     *        two query points.
+     */
+    static uint64_t edgeKey(BoxT* box, int edge);
+
     shared_ptr<HashGrid<BaseVecT, BoxT>> m_grid;
+
+    /// Whether to use the parallel surface extraction
+    bool m_parallel;
 };
 
 
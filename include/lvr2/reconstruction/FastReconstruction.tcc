@@ -34,40 +34,73 @@
 #include <lvr2/geometry/BaseMesh.hpp>
 #include <lvr2/reconstruction/FastReconstructionTables.hpp>
 #include <lvr2/io/Progress.hpp>
+#include <lvr2/util/ParallelSort.hpp>
+
+#include <algorithm>
+#include <type_traits>
 
 namespace lvr2
 {
 
 template<typename BaseVecT, typename BoxT>
-FastReconstruction<BaseVecT, BoxT>::FastReconstruction(shared_ptr<HashGrid<BaseVecT, BoxT>> grid)
+FastReconstruction<BaseVecT, BoxT>::FastReconstruction(shared_ptr<HashGrid<BaseVecT, BoxT>> grid, bool parallel)
 {
     m_grid = grid;
+    m_parallel = parallel;
+}
+
+template<typename BaseVecT, typename BoxT>
+uint64_t FastReconstruction<BaseVecT, BoxT>::edgeKey(BoxT* box, int edge)
+{
+    uint64_t a = box->getVertex(vertex_edge_table[edge][0]);
+    uint64_t b = box->getVertex(vertex_edge_table[edge][1]);
+    return a < b ? (a << 32) | b : (b << 32) | a;
 }
 
 template<typename BaseVecT, typename BoxT>
 void FastReconstruction<BaseVecT, BoxT>::getMesh(BaseMesh<BaseVecT> &mesh)
 {
-    // Status message for mesh generation
-    string comment = timestamp.getElapsedTime() + "Creating mesh ";
-    ProgressBar progress(m_grid->getNumberOfCells(), comment);
+    typename HashGrid<BaseVecT, BoxT>::box_map_it it;
 
-    // Some pointers
-    BoxT* b;
-    unsigned int global_index = mesh.numVertices();
+    // Only plain marching cubes boxes can be processed in parallel. The
+    // other box types modify their neighbors while creating triangles.
+    bool parallelBox = std::is_same<BoxT, FastBox<BaseVecT>>::value
+                    || std::is_same<BoxT, BilinearFastBox<BaseVecT>>::value;
 
-    // Iterate through cells and calculate local approximations
-    typename HashGrid<BaseVecT, BoxT>::box_map_it it;
-    for(it = m_grid->firstCell(); it != m_grid->lastCell(); it++)
+    if(m_parallel && parallelBox)
     {
-        b = it->second;
-        b->getSurface(mesh, m_grid->getQueryPoints(), global_index);
+        getMeshParallel(mesh);
+    }
+    else
+    {
+        // Status message for mesh generation
+        string comment = timestamp.getElapsedTime() + "Creating mesh ";
+        ProgressBar progress(m_grid->getNumberOfCells(), comment);
+
+        // Some pointers
+        BoxT* b;
+        unsigned int global_index = mesh.numVertices();
+
+        // Iterate through cells and calculate local approximations
+        for(it = m_grid->firstCell(); it != m_grid->lastCell(); it++)
+        {
+            b = it->second;
+            b->getSurface(mesh, m_grid->getQueryPoints(), global_index);
+            if(!timestamp.isQuiet())
+                ++progress;
+        }
+
         if(!timestamp.isQuiet())
-            ++progress;
+            cout << endl;
     }
 
-    if(!timestamp.isQuiet())
-        cout << endl;
+    refineSurface(mesh);
+}
 
+template<typename BaseVecT, typename BoxT>
+void FastReconstruction<BaseVecT, BoxT>::refineSurface(BaseMesh<BaseVecT>& mesh)
+{
+    typename HashGrid<BaseVecT, BoxT>::box_map_it it;
     BoxTraits<BoxT> traits;
 
     if(traits.type == "SharpBox")  // Perform edge flipping for extended marching cubes
@@ -177,6 +210,167 @@ void FastReconstruction<BaseVecT, BoxT>::getMesh(BaseMesh<BaseVecT> &mesh)
 
 }
 
+template<typename BaseVecT, typename BoxT>
+void FastReconstruction<BaseVecT, BoxT>::getMeshParallel(BaseMesh<BaseVecT>& mesh)
+{
+    vector<QueryPoint<BaseVecT>>& qp = m_grid->getQueryPoints();
+
+    // The mesh is filled in the iteration order of the grid, so the
+    // result is the same as the one of the serial extraction
+    vector<BoxT*> boxes;
+    boxes.reserve(m_grid->getNumberOfCells());
+    typename HashGrid<BaseVecT, BoxT>::box_map_it it;
+    for(it = m_grid->firstCell(); it != m_grid->lastCell(); it++)
+    {
+        boxes.push_back(it->second);
+    }
+
+    // A triangle corner, identified by the grid edge it lies on
+    struct Corner
+    {
+        uint64_t edge;
+        BaseVecT position;
+    };
+
+    // Create the triangles of consecutive cell blocks in parallel
+    const size_t blockSize = 4096;
+    size_t numBlocks = (boxes.size() + blockSize - 1) / blockSize;
+    vector<vector<Corner>> blockCorners(numBlocks);
+    vector<unsigned char> numTriangles(boxes.size(), 0);
+
+    string comment = timestamp.getElapsedTime() + "Creating mesh ";
+    ProgressBar progress(numBlocks, comment);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(size_t block = 0; block < numBlocks; block++)
+    {
+        vector<Corner>& corners = blockCorners[block];
+        size_t end = std::min(boxes.size(), (block + 1) * blockSize);
+        for(size_t i = block * blockSize; i < end; i++)
+        {
+            BaseVecT positions[12];
+            int index = boxes[i]->getSurfaceIndex(qp, positions);
+            if(index < 0)
+            {
+                continue;
+            }
+
+            for(int a = 0; MCTable[index][a] != -1; a += 3)
+            {
+                for(int b = 0; b < 3; b++)
+                {
+                    int edge = MCTable[index][a + b];
+                    corners.push_back({edgeKey(boxes[i], edge), positions[edge]});
+                }
+                numTriangles[i]++;
+            }
+        }
+
+        if(!timestamp.isQuiet())
+            ++progress;
+    }
+
+    if(!timestamp.isQuiet())
+        cout << endl;
+
+    // Global position of each block's first corner
+    vector<size_t> offsets(numBlocks + 1, 0);
+    for(size_t block = 0; block < numBlocks; block++)
+    {
+        offsets[block + 1] = offsets[block] + blockCorners[block].size();
+    }
+    size_t numCorners = offsets[numBlocks];
+
+    // Sort the corners by their grid edge. Corners on the same edge are
+    // ordered by their position, so the first one is the corner that
+    // creates the vertex in the serial extraction.
+    vector<std::pair<uint64_t, size_t>> edges(numCorners);
+
+    #pragma omp parallel for schedule(static)
+    for(size_t block = 0; block < numBlocks; block++)
+    {
+        for(size_t j = 0; j < blockCorners[block].size(); j++)
+        {
+            edges[offsets[block] + j] = std::make_pair(blockCorners[block][j].edge, offsets[block] + j);
+        }
+    }
+    parallel_sort(edges.begin(), edges.end());
+
+    // Assign every corner to the first corner on its edge
+    vector<size_t> owner(numCorners);
+
+    #pragma omp parallel for schedule(static)
+    for(size_t i = 0; i < numCorners; i++)
+    {
+        if(i == 0 || edges[i].first != edges[i - 1].first)
+        {
+            for(size_t j = i; j < numCorners && edges[j].first == edges[i].first; j++)
+            {
+                owner[edges[j].second] = edges[i].second;
+            }
+        }
+    }
+
+    cout << timestamp << "Inserting " << numCorners / 3 << " triangles" << endl;
+
+    // Fill the mesh. Vertices and faces are created in the same order as
+    // in the serial extraction, so all handles are identical.
+    vector<OptionalVertexHandle> handles(numCorners);
+    vector<std::array<VertexHandle, 3>> triangles(numCorners / 3, {{VertexHandle(0), VertexHandle(0), VertexHandle(0)}});
+    size_t corner = 0;
+    for(size_t i = 0; i < boxes.size(); i++)
+    {
+        const vector<Corner>& corners = blockCorners[i / blockSize];
+        size_t first = offsets[i / blockSize];
+
+        for(unsigned char t = 0; t < numTriangles[i]; t++)
+        {
+            for(int b = 0; b < 3; b++, corner++)
+            {
+                if(owner[corner] == corner)
+                {
+                    handles[corner] = mesh.addVertex(corners[corner - first].position);
+                }
+                triangles[corner / 3][b] = handles[owner[corner]].unwrap();
+            }
+        }
+    }
+
+    // Connect all triangles at once and hand them to their boxes
+    vector<FaceHandle> faces = mesh.addFaces(triangles);
+    size_t face = 0;
+    for(size_t i = 0; i < boxes.size(); i++)
+    {
+        for(unsigned char t = 0; t < numTriangles[i]; t++, face++)
+        {
+            boxes[i]->addSurfaceFace(faces[face]);
+        }
+    }
+
+    // Store the vertices on the box edges for the following optimizations
+    #pragma omp parallel for schedule(static)
+    for(size_t i = 0; i < boxes.size(); i++)
+    {
+        FastBox<BaseVecT>* box = boxes[i];
+        for(int edge = 0; edge < 12; edge++)
+        {
+            bool in0 = qp[box->getVertex(vertex_edge_table[edge][0])].m_distance > 0;
+            bool in1 = qp[box->getVertex(vertex_edge_table[edge][1])].m_distance > 0;
+            if(in0 == in1)
+            {
+                continue;
+            }
+
+            auto key = std::make_pair(edgeKey(boxes[i], edge), size_t(0));
+            auto found = std::lower_bound(edges.begin(), edges.end(), key);
+            if(found != edges.end() && found->first == key.first)
+            {
+                box->m_intersections[edge] = handles[found->second];
+            }
+        }
+    }
+}
+
 template<typename BaseVecT, typename BoxT>
 void FastReconstruction<BaseVecT, BoxT>::getMesh(
     BaseMesh<BaseVecT>& mesh,
@@ -185,26 +379,67 @@ void FastReconstruction<BaseVecT, BoxT>::getMesh(
     float comparePrecision
 )
 {
-//    // Status message for mesh generation
-//    string comment = timestamp.getElapsedTime() + "Creating Mesh ";
-//    ProgressBar progress(m_grid->getNumberOfCells(), comment);
-
-//    // Some pointers
-//    BoxT* b;
-//    unsigned int global_index = mesh.numVertices();
-
-//    // Iterate through cells and calculate local approximations
-//    typename HashGrid<BaseVecT, BoxT>::box_map_it it;
-//    for(it = m_grid->firstCell(); it != m_grid->lastCell(); it++)
-//    {
-//        b = it->second;
-//        b->getSurface(mesh, m_grid->getQueryPoints(), global_index, bb, duplicates, comparePrecision);
-//        if(!timestamp.isQuiet())
-//            ++progress;
-//    }
-
-//    if(!timestamp.isQuiet())
-//        cout << endl;
+    // Status message for mesh generation
+    string comment = timestamp.getElapsedTime() + "Creating mesh ";
+    ProgressBar progress(m_grid->getNumberOfCells(), comment);
+
+    // Some pointers
+    BoxT* b;
+    unsigned int global_index = mesh.numVertices();
+
+    auto bbMin = bb.getMin();
+    auto bbMax = bb.getMax();
+
+    // Only triangulate cells whose center lies inside the bounding box. The
+    // intervals are half open, so each cell belongs to exactly one of
+    // several adjacent bounding boxes.
+    typename HashGrid<BaseVecT, BoxT>::box_map_it it;
+    for(it = m_grid->firstCell(); it != m_grid->lastCell(); it++)
+    {
+        b = it->second;
+        BaseVecT center = b->getCenter();
+        if(center.x >= bbMin.x && center.y >= bbMin.y && center.z >= bbMin.z &&
+           center.x <  bbMax.x && center.y <  bbMax.y && center.z <  bbMax.z)
+        {
+            b->getSurface(mesh, m_grid->getQueryPoints(), global_index);
+        }
+        if(!timestamp.isQuiet())
+            ++progress;
+    }
+
+    if(!timestamp.isQuiet())
+        cout << endl;
+
+    // Vertices on the faces of the bounding box are also created by the
+    // reconstruction of the adjacent partition. The caller may pass a
+    // non-empty list, so only the entries appended here are restored.
+    size_t firstDuplicate = duplicates.size();
+    vector<BaseVecT> positions;
+    for(auto vH : mesh.vertices())
+    {
+        BaseVecT v = mesh.getVertexPosition(vH);
+        float dist = std::min({
+            fabs(v.x - bbMin.x), fabs(v.x - bbMax.x),
+            fabs(v.y - bbMin.y), fabs(v.y - bbMax.y),
+            fabs(v.z - bbMin.z), fabs(v.z - bbMax.z)
+        });
+
+        if(dist < comparePrecision)
+        {
+            duplicates.push_back(vH.idx());
+            positions.push_back(v);
+        }
+    }
+
+    refineSurface(mesh);
+
+    // The contour optimization moves border vertices. Restore the
+    // duplicates, otherwise they can not be matched with their
+    // counterparts in the adjacent partitions.
+    for(size_t i = 0; i < positions.size(); i++)
+    {
+        mesh.getVertexPosition(VertexHandle(duplicates[firstDuplicate + i])) = positions[i];
+    }
 }
 
 } // namespace lvr2
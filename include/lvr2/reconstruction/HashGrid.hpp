@@ -38,11 +38,15 @@
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include <array>
+#include <cstdint>
 
 #include "QueryPoint.hpp"
 
 #include <lvr2/geometry/BoundingBox.hpp>
 #include <lvr2/reconstruction/QueryPoint.hpp>
+#include <lvr2/util/FlatHashMap.hpp>
+#include <lvr2/util/ObjectPool.hpp>
 
 using std::string;
 using std::vector;
@@ -51,6 +55,50 @@ using std::unordered_map;
 namespace lvr2
 {
 
+/**
+ * @brief   Header of the binary grid files written by HashGrid::serialize().
+ *
+ *          The header is followed by flat arrays that are each padded to a
+ *          multiple of 8 bytes:
+ *
+ *          - query point positions (3 * numQueryPoints floats)
+ *          - query point distances (numQueryPoints floats)
+ *          - query point invalid flags (numQueryPoints bytes)
+ *          - cell hash values (numCells uint64)
+ *          - cell centers (3 * numCells floats)
+ *          - query point indices of the cell corners (8 * numCells uint32)
+ *          - cell indices of the 27 neighbors of each cell, or
+ *            0xFFFFFFFF if a neighbor does not exist (27 * numCells uint32)
+ *          - cell flags, bit 0 is set for extruded and bit 1 for
+ *            duplicate cells (numCells bytes)
+ */
+struct HashGridFileHeader
+{
+    /// "LVRGRID" followed by a null byte
+    char        magic[8];
+
+    /// Version of the file format
+    uint32_t    version;
+
+    /// Whether the grid was extruded
+    uint32_t    extrude;
+
+    /// Min and max corner of the grid's bounding box
+    float       boundingBox[6];
+
+    /// Min and max corner of the bounding box of all query points
+    float       queryPointBoundingBox[6];
+
+    /// The voxelsize of the grid
+    float       voxelsize;
+
+    uint32_t    padding;
+
+    uint64_t    numQueryPoints;
+
+    uint64_t    numCells;
+};
+
 class GridBase
 {
 public:
@@ -98,12 +146,12 @@ public:
     BoundingBox<BaseVecT> qp_bb;
 
     /// Typedef to alias box map
-    typedef unordered_map<size_t, BoxT*> box_map;
+    typedef FlatHashMap<BoxT*> box_map;
 
-    typedef unordered_map<size_t, size_t> qp_map;
+    typedef FlatHashMap<size_t> qp_map;
 
     /// Typedef to alias iterators for box maps
-    typedef typename unordered_map<size_t, BoxT*>::iterator  box_map_it;
+    typedef typename box_map::iterator  box_map_it;
 
     /// Typedef to alias iterators to query points
     typedef typename vector<QueryPoint<BaseVecT>>::iterator query_point_it;
@@ -126,7 +174,10 @@ public:
     /***
      * @brief   Constructor
      *
-     * Construcs a HashGrid from a file
+     * Construcs a HashGrid from a file. Binary grid files (see
+     * HashGrid::serialize(string file)) are memory mapped and the cells,
+     * corners and neighbor links are created from the stored arrays.
+     * Grids in the former text format are parsed.
      *
      * @param   file        File representing the HashGrid (See HashGrid::serialize(string file) )
      */
@@ -142,6 +193,21 @@ public:
      */
     virtual void addLatticePoint(int i, int j, int k, float distance = 0.0);
 
+    /**
+     * @brief   Adds all given lattice points to an empty grid at once.
+     *
+     *          Generates the same cells, query points (with the same
+     *          indices) and neighbor links as calling addLatticePoint()
+     *          for every entry in the given order. Instead of querying
+     *          the cell map per point, the cell keys are sorted in Morton
+     *          order and deduplicated, and the cells, their corners and
+     *          neighbor links are created in parallel passes. If the grid
+     *          already contains cells, the points are added serially.
+     *
+     * @param indices   Discrete (x, y, z) positions within the grid.
+     */
+    void addLatticePoints(const vector<std::array<int, 3>>& indices);
+
     /**
      * @brief   Saves a representation of the grid to the given file
      *
@@ -149,8 +215,18 @@ public:
      */
     virtual void saveGrid(string file);
 
+    /**
+     * @brief   Saves the grid to the given file in the binary format
+     *          described by HashGridFileHeader. The file can be loaded
+     *          with HashGrid(string file).
+     *
+     * @param file      Output file name.
+     */
     virtual void serialize(string file);
 
+    /// Version of the binary grid format written by serialize()
+    static constexpr uint32_t FILE_VERSION = 1;
+
     /***
      * @brief   Returns the number of generated cells.
      */
@@ -235,6 +311,26 @@ protected:
      */
     void calcIndices();
 
+    /**
+     * @brief   Reads a grid in the binary format written by serialize()
+     *
+     * @return  false if the file is not a valid binary grid file
+     */
+    bool readBinaryGrid(string file);
+
+    /**
+     * @brief   Reads a grid in the former text format
+     */
+    void readTextGrid(string file);
+
+    /**
+     * @brief   Returns the size of a section in a binary grid file
+     */
+    static inline size_t paddedSize(size_t bytes)
+    {
+        return (bytes + 7) & ~size_t(7);
+    }
+
 
 
     inline int calcIndex(float f)
@@ -242,9 +338,35 @@ protected:
         return f < 0 ? f - .5 : f + .5;
     }
 
+    /**
+     * @brief   Interleaves the lower 21 bits of the given indices to a
+     *          Morton code, i.e., a key that preserves spatial locality.
+     */
+    inline uint64_t mortonCode(int i, int j, int k) const
+    {
+        return spreadBits(i) | (spreadBits(j) << 1) | (spreadBits(k) << 2);
+    }
+
+    /**
+     * @brief   Inserts two zero bits between each of the lower 21 bits of v.
+     */
+    static inline uint64_t spreadBits(int v)
+    {
+        uint64_t x = static_cast<uint32_t>(v) & 0x1fffff;
+        x = (x | x << 32) & 0x1f00000000ffff;
+        x = (x | x << 16) & 0x1f0000ff0000ff;
+        x = (x | x << 8)  & 0x100f00f00f00f00f;
+        x = (x | x << 4)  & 0x10c30c30c30c30c3;
+        x = (x | x << 2)  & 0x1249249249249249;
+        return x;
+    }
+
     /// Map to handle the boxes in the grid
     box_map         m_cells;
 
+    /// Storage of the boxes referenced in m_cells
+    ObjectPool<BoxT> m_boxes;
+
     qp_map          m_qpIndices;
 
     /// The voxelsize used for reconstruction
@@ -37,7 +37,12 @@
 #include <lvr2/reconstruction/FastReconstructionTables.hpp>
 #include <lvr2/io/Progress.hpp>
 #include <lvr2/io/Timestamp.hpp>
+#include <lvr2/util/ParallelSort.hpp>
 
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 
@@ -105,6 +110,188 @@ HashGrid<BaseVecT, BoxT>::HashGrid(
 
 template<typename BaseVecT, typename BoxT>
 HashGrid<BaseVecT, BoxT>::HashGrid(string file)
+{
+    m_globalIndex = 0;
+    m_coordinateScales.x = 1.0;
+    m_coordinateScales.y = 1.0;
+    m_coordinateScales.z = 1.0;
+
+    // Binary grid files start with a magic number
+    char magic[8] = {0};
+    {
+        ifstream ifs(file.c_str(), std::ios::binary);
+        ifs.read(magic, sizeof(magic));
+    }
+
+    if(std::memcmp(magic, "LVRGRID", 8) == 0)
+    {
+        if(!readBinaryGrid(file))
+        {
+            cout << timestamp << "Unable to read grid file " << file << endl;
+        }
+    }
+    else
+    {
+        readTextGrid(file);
+    }
+}
+
+template<typename BaseVecT, typename BoxT>
+bool HashGrid<BaseVecT, BoxT>::readBinaryGrid(string file)
+{
+    boost::iostreams::mapped_file_source mapped;
+    try
+    {
+        mapped.open(file);
+    }
+    catch(std::exception& e)
+    {
+        cout << timestamp << "Unable to map grid file: " << e.what() << endl;
+        return false;
+    }
+
+    const char* data = mapped.data();
+    size_t fileSize = mapped.size();
+    if(fileSize < sizeof(HashGridFileHeader))
+    {
+        return false;
+    }
+
+    HashGridFileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if(header.version != FILE_VERSION)
+    {
+        cout << timestamp << "Unsupported grid file version " << header.version << endl;
+        return false;
+    }
+
+    size_t numQueryPoints = header.numQueryPoints;
+    size_t numCells = header.numCells;
+
+    // Every query point and cell takes at least one byte of the file. This
+    // also keeps the section sizes below from overflowing.
+    if(numQueryPoints > fileSize || numCells > fileSize)
+    {
+        cout << timestamp << "Grid file " << file << " is corrupt" << endl;
+        return false;
+    }
+
+    // Locate the arrays within the file
+    size_t offset = sizeof(HashGridFileHeader);
+    auto section = [&](size_t bytes)
+    {
+        const char* begin = data + offset;
+        offset += paddedSize(bytes);
+        return begin;
+    };
+
+    auto positions  = reinterpret_cast<const float*>(section(3 * numQueryPoints * sizeof(float)));
+    auto distances  = reinterpret_cast<const float*>(section(numQueryPoints * sizeof(float)));
+    auto invalid    = reinterpret_cast<const uint8_t*>(section(numQueryPoints));
+    auto keys       = reinterpret_cast<const uint64_t*>(section(numCells * sizeof(uint64_t)));
+    auto centers    = reinterpret_cast<const float*>(section(3 * numCells * sizeof(float)));
+    auto vertices   = reinterpret_cast<const uint32_t*>(section(8 * numCells * sizeof(uint32_t)));
+    auto neighbors  = reinterpret_cast<const uint32_t*>(section(27 * numCells * sizeof(uint32_t)));
+    auto flags      = reinterpret_cast<const uint8_t*>(section(numCells));
+
+    if(offset > fileSize)
+    {
+        cout << timestamp << "Grid file " << file << " is truncated" << endl;
+        return false;
+    }
+
+    // Validate all indices before anything is built from them. Neighbors
+    // that don't exist are stored as 0xFFFFFFFF.
+    bool valid = true;
+
+    #pragma omp parallel for schedule(static) reduction(&&:valid)
+    for(long i = 0; i < (long)numCells; i++)
+    {
+        for(int k = 0; k < 8; k++)
+        {
+            valid = valid && vertices[8 * i + k] < numQueryPoints;
+        }
+        for(int n = 0; n < 27; n++)
+        {
+            uint32_t neighbor = neighbors[27 * i + n];
+            valid = valid && (neighbor < numCells || neighbor == 0xFFFFFFFF);
+        }
+    }
+
+    if(!valid)
+    {
+        cout << timestamp << "Grid file " << file << " is corrupt" << endl;
+        return false;
+    }
+
+    m_extrude = header.extrude;
+    m_boundingBox = BoundingBox<BaseVecT>(
+        BaseVecT(header.boundingBox[0], header.boundingBox[1], header.boundingBox[2]),
+        BaseVecT(header.boundingBox[3], header.boundingBox[4], header.boundingBox[5]));
+    qp_bb = BoundingBox<BaseVecT>(
+        BaseVecT(header.queryPointBoundingBox[0], header.queryPointBoundingBox[1], header.queryPointBoundingBox[2]),
+        BaseVecT(header.queryPointBoundingBox[3], header.queryPointBoundingBox[4], header.queryPointBoundingBox[5]));
+    m_voxelsize = header.voxelsize;
+    BoxT::m_voxelsize = m_voxelsize;
+    calcIndices();
+
+    m_queryPoints.resize(numQueryPoints);
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)numQueryPoints; i++)
+    {
+        QueryPoint<BaseVecT>& qp = m_queryPoints[i];
+        qp.m_position = BaseVecT(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+        qp.m_distance = distances[i];
+        qp.m_invalid = invalid[i];
+    }
+    m_globalIndex = numQueryPoints;
+
+    // Create the boxes, then link the neighbors once all boxes exist
+    vector<BoxT*> boxes(numCells);
+    size_t firstBox = m_boxes.grow(numCells);
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)numCells; i++)
+    {
+        BaseVecT center(centers[3 * i], centers[3 * i + 1], centers[3 * i + 2]);
+        BoxT* box = m_boxes.construct(firstBox + i, center);
+        for(int k = 0; k < 8; k++)
+        {
+            box->setVertex(k, vertices[8 * i + k]);
+        }
+        box->m_extruded = flags[i] & 1;
+        box->m_duplicate = flags[i] & 2;
+        boxes[i] = box;
+    }
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)numCells; i++)
+    {
+        for(int n = 0; n < 27; n++)
+        {
+            uint32_t neighbor = neighbors[27 * i + n];
+            if(neighbor < numCells)
+            {
+                boxes[i]->setNeighbor(n, boxes[neighbor]);
+            }
+        }
+    }
+
+    m_cells.reserve(numCells);
+    for(size_t i = 0; i < numCells; i++)
+    {
+        m_cells[keys[i]] = boxes[i];
+    }
+
+    cout << timestamp << "Read grid with " << numCells << " cells and "
+         << numQueryPoints << " query points" << endl;
+
+    return true;
+}
+
+template<typename BaseVecT, typename BoxT>
+void HashGrid<BaseVecT, BoxT>::readTextGrid(string file)
 {
     ifstream ifs(file.c_str());
     float minx, miny, minz, maxx, maxy, maxz, vsize;
@@ -115,10 +302,6 @@ HashGrid<BaseVecT, BoxT>::HashGrid(string file)
     ifs >> minx >> miny >> minz >> maxx >> maxy >> maxz >> qsize >> vsize >> csize;
 
     m_boundingBox = BoundingBox<BaseVecT>(BaseVecT(minx, miny, minz), BaseVecT(maxx, maxy, maxz));
-    m_globalIndex = 0;
-    m_coordinateScales.x = 1.0;
-    m_coordinateScales.y = 1.0;
-    m_coordinateScales.z = 1.0;
     m_voxelsize = vsize;
     BoxT::m_voxelsize = m_voxelsize;
     calcIndices();
@@ -139,6 +322,7 @@ HashGrid<BaseVecT, BoxT>::HashGrid(string file)
 
     }
     //cout << timestamp << "read qpoints.. csize: " << csize << endl;
+    m_cells.reserve(csize);
     size_t h;
     unsigned int cell[8];
     BaseVecT cell_center;
@@ -148,7 +332,7 @@ HashGrid<BaseVecT, BoxT>::HashGrid(string file)
         //cout << "i: " << k << endl;
         ifs >> h >> cell[0] >> cell[1] >> cell[2] >> cell[3] >> cell[4] >> cell[5] >> cell[6] >> cell[7]
                  >> cell_center.x >> cell_center.y >> cell_center.z >> fusion;
-        BoxT* box = new BoxT(cell_center);
+        BoxT* box = m_boxes.emplace(cell_center);
         box->m_extruded = fusion;
         for(int j=0 ; j<8 ; j++)
         {
@@ -258,7 +442,7 @@ void HashGrid<BaseVecT, BoxT>::addLatticePoint(int index_x, int index_y, int ind
                     }
 
                     //Create new box
-                    BoxT* box = new BoxT(box_center);
+                    BoxT* box = m_boxes.emplace(box_center);
                     if(
                         box_center[0] <= m_boundingBox.getMin().x + m_voxelsize*5  ||
                         box_center[1] <= m_boundingBox.getMin().y + m_voxelsize*5  ||
@@ -335,6 +519,378 @@ void HashGrid<BaseVecT, BoxT>::addLatticePoint(int index_x, int index_y, int ind
     }
 }
 
+template<typename BaseVecT, typename BoxT>
+void HashGrid<BaseVecT, BoxT>::addLatticePoints(const vector<std::array<int, 3>>& indices)
+{
+    // The creation order of addLatticePoint() can only be reproduced
+    // for an empty grid
+    if(!m_cells.empty())
+    {
+        for(auto& index : indices)
+        {
+            addLatticePoint(index[0], index[1], index[2]);
+        }
+        return;
+    }
+
+    // A cell (or cell candidate) identified by its hash value. The rank
+    // encodes when addLatticePoint() would have created it: the index of
+    // the first lattice point that touches the cell times the number of
+    // neighbor offsets plus the offset. A query point is owned by the
+    // cell corner with the lowest rank * 8 + corner.
+    struct RankedCell
+    {
+        size_t key;
+        size_t rank;
+    };
+
+    struct MortonCell
+    {
+        uint64_t morton;
+        size_t key;
+        size_t rank;
+    };
+
+    auto rankedLess = [](const RankedCell& a, const RankedCell& b)
+    {
+        return a.key < b.key || (a.key == b.key && a.rank < b.rank);
+    };
+    auto rankedEqual = [](const RankedCell& a, const RankedCell& b)
+    {
+        return a.key == b.key;
+    };
+    auto mortonLess = [](const MortonCell& a, const MortonCell& b)
+    {
+        return a.morton < b.morton
+            || (a.morton == b.morton && (a.key < b.key || (a.key == b.key && a.rank < b.rank)));
+    };
+    auto mortonEqual = [](const MortonCell& a, const MortonCell& b)
+    {
+        return a.key == b.key;
+    };
+
+    const int limit = this->m_extrude ? 1 : 0;
+    const int width = 2 * limit + 1;
+    const size_t numOffsets = width * width * width;
+    const size_t blockSize = 1 << 14;
+
+    float vsh = 0.5 * this->m_voxelsize;
+    auto v_min = this->m_boundingBox.getMin();
+    auto v_max = this->m_boundingBox.getMax();
+
+    // Recovers the discrete cell position from a creation rank
+    auto cellIndex = [&](size_t rank, int& x, int& y, int& z)
+    {
+        auto& index = indices[rank / numOffsets];
+        int offset = rank % numOffsets;
+        x = index[0] + offset / (width * width) - limit;
+        y = index[1] + (offset / width) % width - limit;
+        z = index[2] + offset % width - limit;
+    };
+
+    auto cellCenter = [&](int x, int y, int z)
+    {
+        return BaseVecT(
+            x * this->m_voxelsize + v_min.x,
+            y * this->m_voxelsize + v_min.y,
+            z * this->m_voxelsize + v_min.z);
+    };
+
+    cout << timestamp << "Sorting lattice points" << endl;
+
+    // Deduplicate the cells that contain the lattice points. Points are
+    // first deduplicated in blocks, since consecutive points usually
+    // share a cell.
+    vector<MortonCell> pointCells;
+    {
+        size_t numBlocks = (indices.size() + blockSize - 1) / blockSize;
+        vector<vector<MortonCell>> blocks(numBlocks);
+
+        #pragma omp parallel for schedule(dynamic)
+        for(long b = 0; b < (long)numBlocks; b++)
+        {
+            size_t end = std::min(indices.size(), (b + 1) * blockSize);
+            auto& block = blocks[b];
+            block.reserve(end - b * blockSize);
+            for(size_t p = b * blockSize; p < end; p++)
+            {
+                auto& index = indices[p];
+                block.push_back({
+                    mortonCode(index[0], index[1], index[2]),
+                    hashValue(index[0], index[1], index[2]),
+                    p
+                });
+            }
+            std::sort(block.begin(), block.end(), mortonLess);
+            block.erase(std::unique(block.begin(), block.end(), mortonEqual), block.end());
+        }
+
+        for(auto& block : blocks)
+        {
+            pointCells.insert(pointCells.end(), block.begin(), block.end());
+            vector<MortonCell>().swap(block);
+        }
+        parallel_sort(pointCells.begin(), pointCells.end(), mortonLess);
+        pointCells.erase(std::unique(pointCells.begin(), pointCells.end(), mortonEqual), pointCells.end());
+    }
+
+    // Generate all (extruded) cells. Blocks of Morton ordered point
+    // cells are spatially compact, so most shared neighbors are already
+    // removed within a block.
+    vector<RankedCell> cells;
+    {
+        size_t cellBlockSize = blockSize / numOffsets;
+        size_t numBlocks = (pointCells.size() + cellBlockSize - 1) / cellBlockSize;
+        vector<vector<RankedCell>> blocks(numBlocks);
+
+        #pragma omp parallel for schedule(dynamic)
+        for(long b = 0; b < (long)numBlocks; b++)
+        {
+            size_t end = std::min(pointCells.size(), (b + 1) * cellBlockSize);
+            auto& block = blocks[b];
+            for(size_t c = b * cellBlockSize; c < end; c++)
+            {
+                for(size_t offset = 0; offset < numOffsets; offset++)
+                {
+                    size_t rank = pointCells[c].rank * numOffsets + offset;
+                    int x, y, z;
+                    cellIndex(rank, x, y, z);
+
+                    BaseVecT box_center = cellCenter(x, y, z);
+                    if(
+                        box_center[0] <= v_min.x  ||
+                        box_center[1] <= v_min.y  ||
+                        box_center[2] <= v_min.z ||
+                        box_center[0] >= v_max.x + m_voxelsize  ||
+                        box_center[1] >= v_max.y + m_voxelsize  ||
+                        box_center[2] >= v_max.z + m_voxelsize
+                    )
+                    {
+                        continue;
+                    }
+
+                    block.push_back({hashValue(x, y, z), rank});
+                }
+            }
+            std::sort(block.begin(), block.end(), rankedLess);
+            block.erase(std::unique(block.begin(), block.end(), rankedEqual), block.end());
+        }
+        vector<MortonCell>().swap(pointCells);
+
+        for(auto& block : blocks)
+        {
+            cells.insert(cells.end(), block.begin(), block.end());
+            vector<RankedCell>().swap(block);
+        }
+        parallel_sort(cells.begin(), cells.end(), rankedLess);
+        cells.erase(std::unique(cells.begin(), cells.end(), rankedEqual), cells.end());
+    }
+
+    cout << timestamp << "Creating " << cells.size() << " cells" << endl;
+
+    // Collects the positions of all 27 neighbors (including the cell
+    // itself at index 13) in the order used by setNeighbor() or -1 if
+    // a neighbor does not exist. Neighbors along the z axis have
+    // consecutive keys, so one search per (x, y) column is sufficient.
+    auto findNeighbors = [&](int x, int y, int z, long* neighbors)
+    {
+        int neighbor_index = 0;
+        for(int a = -1; a < 2; a++)
+        {
+            for(int b = -1; b < 2; b++)
+            {
+                size_t key = hashValue(x + a, y + b, z - 1);
+                auto it = std::lower_bound(
+                    cells.begin(),
+                    cells.end(),
+                    key,
+                    [](const RankedCell& cell, size_t k) { return cell.key < k; }
+                );
+                for(int c = -1; c < 2; c++, key++)
+                {
+                    if(it != cells.end() && it->key == key)
+                    {
+                        neighbors[neighbor_index++] = it - cells.begin();
+                        ++it;
+                    }
+                    else
+                    {
+                        neighbors[neighbor_index++] = -1;
+                    }
+                }
+            }
+        }
+    };
+
+    // Determines the cell and corner that created the query point of
+    // the given corner, i.e., the sharing corner with the lowest rank
+    auto findOwner = [&](long cell, int corner, const long* neighbors, long& ownerCell, int& ownerCorner)
+    {
+        ownerCell = cell;
+        ownerCorner = corner;
+        size_t best = cells[cell].rank * 8 + corner;
+        for(int i = 0; i < 7; i++)
+        {
+            const int* shared = shared_vertex_table[corner] + i * 4;
+            long n = neighbors[(shared[0] + 1) * 9 + (shared[1] + 1) * 3 + shared[2] + 1];
+            if(n >= 0 && cells[n].rank * 8 + shared[3] < best)
+            {
+                best = cells[n].rank * 8 + shared[3];
+                ownerCell = n;
+                ownerCorner = shared[3];
+            }
+        }
+    };
+
+    // Create boxes and find the query points each box is responsible for
+    vector<BoxT*> boxes(cells.size());
+    vector<unsigned char> ownedCorners(cells.size());
+    size_t firstBox = m_boxes.grow(cells.size());
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(long i = 0; i < (long)cells.size(); i++)
+    {
+        int x, y, z;
+        cellIndex(cells[i].rank, x, y, z);
+        BaseVecT box_center = cellCenter(x, y, z);
+
+        BoxT* box = m_boxes.construct(firstBox + i, box_center);
+        if(
+            box_center[0] <= v_min.x + m_voxelsize*5  ||
+            box_center[1] <= v_min.y + m_voxelsize*5  ||
+            box_center[2] <= v_min.z + m_voxelsize*5)
+        {
+            box->m_duplicate = true;
+        }
+        else if( box_center[0] >= v_max.x - m_voxelsize*5  ||
+                 box_center[1] >= v_max.y - m_voxelsize*5  ||
+                 box_center[2] >= v_max.z - m_voxelsize*5)
+        {
+            box->m_duplicate = true;
+        }
+        boxes[i] = box;
+
+        long neighbors[27];
+        findNeighbors(x, y, z, neighbors);
+
+        unsigned char owned = 0;
+        for(int k = 0; k < 8; k++)
+        {
+            long ownerCell;
+            int ownerCorner;
+            findOwner(i, k, neighbors, ownerCell, ownerCorner);
+            if(ownerCell == i)
+            {
+                owned |= 1 << k;
+            }
+        }
+        ownedCorners[i] = owned;
+    }
+
+    // Query point indices follow the creation order, i.e., the rank of
+    // their owning corner
+    vector<size_t> ownerRanks;
+    {
+        vector<size_t> offsets(cells.size() + 1, 0);
+        for(size_t i = 0; i < cells.size(); i++)
+        {
+            offsets[i + 1] = offsets[i] + __builtin_popcount(ownedCorners[i]);
+        }
+
+        ownerRanks.resize(offsets.back());
+        #pragma omp parallel for schedule(static)
+        for(long i = 0; i < (long)cells.size(); i++)
+        {
+            size_t pos = offsets[i];
+            for(int k = 0; k < 8; k++)
+            {
+                if(ownedCorners[i] & (1 << k))
+                {
+                    ownerRanks[pos++] = cells[i].rank * 8 + k;
+                }
+            }
+        }
+        parallel_sort(ownerRanks.begin(), ownerRanks.end());
+    }
+
+    cout << timestamp << "Creating " << ownerRanks.size() << " query points" << endl;
+
+    // Link neighbors, assign query points to the box corners and
+    // create the query points
+    this->m_queryPoints.resize(ownerRanks.size());
+
+    #pragma omp parallel
+    {
+        BoundingBox<BaseVecT> local_bb;
+        bool expanded = false;
+
+        #pragma omp for schedule(dynamic, 1024)
+        for(long i = 0; i < (long)cells.size(); i++)
+        {
+            int x, y, z;
+            cellIndex(cells[i].rank, x, y, z);
+
+            long neighbors[27];
+            findNeighbors(x, y, z, neighbors);
+
+            BoxT* box = boxes[i];
+            for(int n = 0; n < 27; n++)
+            {
+                // The box itself is never registered as its own neighbor
+                if(n != 13 && neighbors[n] >= 0)
+                {
+                    box->setNeighbor(n, boxes[neighbors[n]]);
+                }
+            }
+
+            for(int k = 0; k < 8; k++)
+            {
+                long ownerCell;
+                int ownerCorner;
+                findOwner(i, k, neighbors, ownerCell, ownerCorner);
+
+                size_t ownerRank = cells[ownerCell].rank * 8 + ownerCorner;
+                unsigned int index = std::lower_bound(
+                    ownerRanks.begin(),
+                    ownerRanks.end(),
+                    ownerRank
+                ) - ownerRanks.begin();
+                box->setVertex(k, index);
+
+                if(ownerCell == i)
+                {
+                    BaseVecT box_center = box->getCenter();
+                    BaseVecT position(box_center.x + box_creation_table[k][0] * vsh,
+                                      box_center.y + box_creation_table[k][1] * vsh,
+                                      box_center.z + box_creation_table[k][2] * vsh);
+
+                    local_bb.expand(position);
+                    expanded = true;
+
+                    this->m_queryPoints[index] = QueryPoint<BaseVecT>(position, 0.0);
+                }
+            }
+        }
+
+        #pragma omp critical
+        {
+            if(expanded)
+            {
+                qp_bb.expand(local_bb);
+            }
+        }
+    }
+
+    this->m_globalIndex = ownerRanks.size();
+
+    // Register the boxes in the cell map
+    this->m_cells.reserve(cells.size());
+    for(size_t i = 0; i < cells.size(); i++)
+    {
+        this->m_cells[cells[i].key] = boxes[i];
+    }
+}
+
 template<typename BaseVecT, typename BoxT>
 void HashGrid<BaseVecT, BoxT>::setCoordinateScaling(float x, float y, float z)
 {
@@ -346,16 +902,7 @@ void HashGrid<BaseVecT, BoxT>::setCoordinateScaling(float x, float y, float z)
 template<typename BaseVecT, typename BoxT>
 HashGrid<BaseVecT, BoxT>::~HashGrid()
 {
-    box_map_it iter;
-    for(iter = m_cells.begin(); iter != m_cells.end(); iter++)
-    {
-        if(iter->second != NULL)
-        {
-            delete (iter->second);
-            iter->second = NULL;
-        }
-    }
-
+    // The boxes are released by m_boxes
     m_cells.clear();
 }
 
@@ -443,7 +990,7 @@ void HashGrid<BaseVecT, BoxT>::saveGrid(string filename)
         }
 
         // Write box definitions
-        typename unordered_map<size_t, BoxT* >::iterator it;
+        box_map_it it;
         BoxT* box;
         for(it = m_cells.begin(); it != m_cells.end(); it++)
         {
@@ -462,52 +1009,128 @@ template<typename BaseVecT, typename BoxT>
 void HashGrid<BaseVecT, BoxT>::serialize(string file)
 {
     std::cout << timestamp << "saving grid: " << file << std::endl;
-    std::ofstream out(file.c_str());
+    std::ofstream out(file.c_str(), std::ios::binary);
 
-    // Write data
-    if(out.good())
+    if(!out.good())
     {
-        out << m_extrude << std::endl;
-        out <<    m_boundingBox.getMin().x << " " << m_boundingBox.getMin().y
-        << " " << m_boundingBox.getMin().z << " " << m_boundingBox.getMax().x
-        << " " << m_boundingBox.getMax().y << " " << m_boundingBox.getMax().z << std::endl;
+        std::cout << timestamp << "Unable to open " << file << " for writing" << std::endl;
+        return;
+    }
 
+    size_t numQueryPoints = m_queryPoints.size();
+    size_t numCells = m_cells.size();
 
-        out << m_queryPoints.size() << " " << m_voxelsize << " " << m_cells.size() << endl;
+    HashGridFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "LVRGRID", 8);
+    header.version = FILE_VERSION;
+    header.extrude = m_extrude;
+    for(int i = 0; i < 3; i++)
+    {
+        header.boundingBox[i] = m_boundingBox.getMin()[i];
+        header.boundingBox[i + 3] = m_boundingBox.getMax()[i];
+        header.queryPointBoundingBox[i] = qp_bb.getMin()[i];
+        header.queryPointBoundingBox[i + 3] = qp_bb.getMax()[i];
+    }
+    header.voxelsize = m_voxelsize;
+    header.numQueryPoints = numQueryPoints;
+    header.numCells = numCells;
 
-        // Write query points and distances
-        for(size_t i = 0; i < m_queryPoints.size(); i++)
-        {
-            out << m_queryPoints[i].m_position.x << " "
-            << m_queryPoints[i].m_position.y << " "
-            << m_queryPoints[i].m_position.z << " ";
+    // Flatten the query points
+    vector<float> positions(3 * numQueryPoints);
+    vector<float> distances(numQueryPoints);
+    vector<uint8_t> invalid(numQueryPoints);
 
-            if(!isnan(m_queryPoints[i].m_distance))
-            {
-                out << m_queryPoints[i].m_distance << std::endl;
-            }
-            else
-            {
-                out << 0 << endl;
-            }
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)numQueryPoints; i++)
+    {
+        const QueryPoint<BaseVecT>& qp = m_queryPoints[i];
+        positions[3 * i] = qp.m_position.x;
+        positions[3 * i + 1] = qp.m_position.y;
+        positions[3 * i + 2] = qp.m_position.z;
+        distances[i] = qp.m_distance;
+        invalid[i] = qp.m_invalid;
+    }
+
+    // Number the cells in the order of the cell map. Neighbor pointers are
+    // translated to these numbers by searching the boxes sorted by address.
+    vector<uint64_t> keys;
+    vector<BoxT*> boxes;
+    keys.reserve(numCells);
+    boxes.reserve(numCells);
+    for(auto it = m_cells.begin(); it != m_cells.end(); it++)
+    {
+        keys.push_back(it->first);
+        boxes.push_back(it->second);
+    }
+
+    using NeighborPtr = decltype(boxes[0]->getNeighbor(0));
+    vector<std::pair<NeighborPtr, uint32_t>> cellIndices(numCells);
+    for(size_t i = 0; i < numCells; i++)
+    {
+        cellIndices[i] = std::make_pair(boxes[i], i);
+    }
+    std::sort(cellIndices.begin(), cellIndices.end());
 
+    vector<float> centers(3 * numCells);
+    vector<uint32_t> vertices(8 * numCells);
+    vector<uint32_t> neighbors(27 * numCells);
+    vector<uint8_t> flags(numCells);
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)numCells; i++)
+    {
+        BoxT* box = boxes[i];
+        BaseVecT center = box->getCenter();
+        centers[3 * i] = center.x;
+        centers[3 * i + 1] = center.y;
+        centers[3 * i + 2] = center.z;
+
+        for(int k = 0; k < 8; k++)
+        {
+            vertices[8 * i + k] = box->getVertex(k);
         }
 
-        // Write box definitions
-        typename unordered_map<size_t, BoxT* >::iterator it;
-        BoxT* box;
-        for(it = m_cells.begin(); it != m_cells.end(); it++)
+        for(int n = 0; n < 27; n++)
         {
-            box = it->second;
-            out << it->first << " ";
-            for(int i = 0; i < 8; i++)
+            NeighborPtr neighbor = box->getNeighbor(n);
+            uint32_t index = 0xFFFFFFFF;
+            if(neighbor)
             {
-                out << box->getVertex(i) << " ";
+                auto it = std::lower_bound(
+                    cellIndices.begin(),
+                    cellIndices.end(),
+                    std::make_pair(neighbor, uint32_t(0))
+                );
+                if(it != cellIndices.end() && it->first == neighbor)
+                {
+                    index = it->second;
+                }
             }
-            out << box->getCenter().x << " " << box->getCenter().y << " " << box->getCenter().z
-                << " " << box->m_extruded << endl;
+            neighbors[27 * i + n] = index;
         }
+
+        flags[i] = (box->m_extruded ? 1 : 0) | (box->m_duplicate ? 2 : 0);
     }
+
+    // Write the header and the padded arrays
+    auto writeSection = [&](const void* data, size_t bytes)
+    {
+        static const char zeros[8] = {0};
+        out.write(reinterpret_cast<const char*>(data), bytes);
+        out.write(zeros, paddedSize(bytes) - bytes);
+    };
+
+    writeSection(&header, sizeof(header));
+    writeSection(positions.data(), positions.size() * sizeof(float));
+    writeSection(distances.data(), distances.size() * sizeof(float));
+    writeSection(invalid.data(), invalid.size());
+    writeSection(keys.data(), keys.size() * sizeof(uint64_t));
+    writeSection(centers.data(), centers.size() * sizeof(float));
+    writeSection(vertices.data(), vertices.size() * sizeof(uint32_t));
+    writeSection(neighbors.data(), neighbors.size() * sizeof(uint32_t));
+    writeSection(flags.data(), flags.size());
+
     out.close();
     std::cout << timestamp << "finished saving grid: " << file << std::endl;
 }
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * PlaneFitting.hpp
+ */
+
+#ifndef LVR2_RECONSTRUCTION_PLANEFITTING_HPP_
+#define LVR2_RECONSTRUCTION_PLANEFITTING_HPP_
+
+#include <cstddef>
+
+namespace lvr2
+{
+
+/**
+ * @brief Centroid and covariance matrix of a set of 3D points. Only the
+ *        upper triangle of the symmetric covariance matrix is stored, in
+ *        the order xx, xy, xz, yy, yz, zz.
+ */
+struct Covariance3
+{
+    float mean[3];
+    float cov[6];
+};
+
+/**
+ * @brief Computes centroid and covariance of n points that are given as
+ *        separate coordinate arrays. All sums are accumulated in a single
+ *        pass relative to the first point. The AVX2 kernel is used if the
+ *        CPU supports it.
+ *
+ * @param x, y, z   The point coordinates
+ * @param n         The number of points
+ */
+Covariance3 computeCovariance(const float* x, const float* y, const float* z, size_t n);
+
+/**
+ * @brief Computes the unit eigenvector of the smallest eigenvalue of a
+ *        symmetric 3x3 matrix in closed form. For a covariance matrix this
+ *        is the normal of the least squares plane through the points.
+ *
+ * @param cov       The upper triangle of the matrix, see Covariance3
+ * @param normal    The resulting unit vector
+ *
+ * @return false if the matrix does not define a direction, i.e. all
+ *         points are equal. The normal is set to (0, 0, 1) in this case.
+ */
+bool smallestEigenvector(const float cov[6], float normal[3]);
+
+/**
+ * @brief Returns true if computeCovariance() uses the AVX2 kernel on this
+ *        machine.
+ */
+bool covarianceUsesAVX2();
+
+} // namespace lvr2
+
+#endif /* LVR2_RECONSTRUCTION_PLANEFITTING_HPP_ */
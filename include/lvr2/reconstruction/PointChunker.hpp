@@ -0,0 +1,203 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * PointChunker.hpp
+ */
+
+#ifndef LVR2_RECONSTRUCTION_POINTCHUNKER_HPP_
+#define LVR2_RECONSTRUCTION_POINTCHUNKER_HPP_
+
+#include <lvr2/io/PointBuffer.hpp>
+#include <lvr2/geometry/BaseVector.hpp>
+#include <lvr2/geometry/BoundingBox.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <array>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace lvr2
+{
+
+/**
+ * @brief Partitions a point cloud into cubic chunks that are stored in
+ *        temporary files, so that they can be processed one after
+ *        another with bounded memory usage.
+ *
+ *        The chunk with index (i, j, k) covers the cube from
+ *        (i, j, k) * chunkSize to (i + 1, j + 1, k + 1) * chunkSize. Each
+ *        chunk additionally contains all points within the overlap
+ *        distance of this cube, so points near the borders are stored in
+ *        up to eight chunks. Points are buffered in memory and appended
+ *        to the chunk files whenever the buffers get too large.
+ */
+class PointChunker
+{
+public:
+
+    using ChunkIndex = std::array<int, 3>;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param chunkSize     Edge length of the chunks
+     * @param overlap       Distance by which the chunks are extended on
+     *                      each side. Has to be smaller than chunkSize.
+     * @param directory     Directory for the chunk files. If empty, a new
+     *                      directory in the system's temporary path is
+     *                      used.
+     */
+    PointChunker(float chunkSize, float overlap, const std::string& directory = "");
+
+    /**
+     * @brief Destructor. Removes all chunk files and the directory if
+     *        it was created by this object.
+     */
+    ~PointChunker();
+
+    PointChunker(const PointChunker&) = delete;
+    PointChunker& operator=(const PointChunker&) = delete;
+
+    /**
+     * @brief Adds points to the chunks.
+     *
+     * @param points    Array of n * 3 coordinates
+     * @param normals   Array of n * 3 normal coordinates or nullptr. Whether
+     *                  normals are given is determined by the first call,
+     *                  later calls that do not match are ignored.
+     * @param n         Number of points
+     */
+    void addPoints(const float* points, const float* normals, size_t n);
+
+    /**
+     * @brief Adds all points of the given file. The file is streamed
+     *        in fixed-size batches through ModelFactory::openPointReader(),
+     *        so formats with a streaming reader (ASCII, PLY, LAS, HDF5)
+     *        are never loaded completely.
+     *
+     * @return false if the file could not be read
+     */
+    bool addFile(const std::string& filename);
+
+    /**
+     * @brief Writes all buffered points to the chunk files. Has to be
+     *        called before the chunks are loaded.
+     */
+    void finish();
+
+    /**
+     * @brief Returns the indices of all chunks that contain points
+     */
+    std::vector<ChunkIndex> chunks() const;
+
+    /**
+     * @brief Returns the number of points in the given chunk, including
+     *        the points in its overlap
+     */
+    size_t numPoints(const ChunkIndex& chunk) const;
+
+    /**
+     * @brief Returns the number of added points
+     */
+    size_t numPoints() const { return m_numPoints; }
+
+    /**
+     * @brief Returns the overlap of the chunks
+     */
+    float getOverlap() const { return m_overlap; }
+
+    /**
+     * @brief Returns true if the added points have normals
+     */
+    bool hasNormals() const { return m_hasNormals; }
+
+    /**
+     * @brief Returns the bounding box of all added points
+     */
+    BoundingBox<BaseVector<float>> getBoundingBox() const { return m_boundingBox; }
+
+    /**
+     * @brief Returns the cube covered by the given chunk without overlap
+     */
+    BoundingBox<BaseVector<float>> chunkBoundingBox(const ChunkIndex& chunk) const;
+
+    /**
+     * @brief Loads the points (and normals) of the given chunk
+     */
+    PointBufferPtr loadChunk(const ChunkIndex& chunk) const;
+
+private:
+
+    struct Chunk
+    {
+        /// Buffered point data that is not written to the file yet
+        std::vector<float> buffer;
+
+        /// Number of points in the chunk
+        size_t numPoints = 0;
+    };
+
+    /// Returns the file name of the given chunk
+    boost::filesystem::path chunkFile(const ChunkIndex& chunk) const;
+
+    /// Appends the buffers of all chunks to their files
+    void flush();
+
+    /// Edge length of the chunks
+    float m_chunkSize;
+
+    /// Overlap of the chunks
+    float m_overlap;
+
+    /// Directory of the chunk files
+    boost::filesystem::path m_directory;
+
+    /// Whether m_directory was created by this object
+    bool m_ownsDirectory;
+
+    /// All chunks that contain points
+    std::map<ChunkIndex, Chunk> m_chunks;
+
+    /// Number of floats in all buffers
+    size_t m_bufferedFloats;
+
+    /// Number of added points
+    size_t m_numPoints;
+
+    /// Whether normals are stored with the points
+    bool m_hasNormals;
+
+    /// Bounding box of all added points
+    BoundingBox<BaseVector<float>> m_boundingBox;
+};
+
+} // namespace lvr2
+
+#endif /* LVR2_RECONSTRUCTION_POINTCHUNKER_HPP_ */
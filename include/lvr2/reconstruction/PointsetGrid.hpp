@@ -47,12 +47,25 @@ template<typename BaseVecT, typename BoxT>
 class PointsetGrid: public HashGrid<BaseVecT, BoxT>
 {
 public:
+    /**
+     * @brief   Creates a grid for the points of the given surface
+     *
+     * @param cellSize          Voxel size or number of intersections, see HashGrid
+     * @param surface           The point set surface to reconstruct
+     * @param bb                Bounding box of the covered volume
+     * @param isVoxelsize       Whether to interpret cellSize as voxelsize or intersections
+     * @param extrude           Whether to add neighbor cells to fill holes
+     * @param parallelBuild     If true, the grid is built with
+     *                          HashGrid::addLatticePoints(). The
+     *                          resulting grid is the same.
+     */
     PointsetGrid(
         float cellSize,
         PointsetSurfacePtr<BaseVecT> surface,
         BoundingBox<BaseVecT> bb,
         bool isVoxelsize = true,
-        bool extrude = true
+        bool extrude = true,
+        bool parallelBuild = false
     );
 
     virtual ~PointsetGrid() {}
@@ -41,7 +41,8 @@ PointsetGrid<BaseVecT, BoxT>::PointsetGrid(
     PointsetSurfacePtr<BaseVecT> surface,
     BoundingBox<BaseVecT> bb,
     bool isVoxelsize,
-    bool extrude
+    bool extrude,
+    bool parallelBuild
 ) :
     HashGrid<BaseVecT, BoxT>(cellSize, bb, isVoxelsize, extrude),
     m_surface(surface)
@@ -56,12 +57,29 @@ PointsetGrid<BaseVecT, BoxT>::PointsetGrid(
 
     FloatChannel pts = *(m_surface->pointBuffer()->getFloatChannel("points"));
 
-    // Iterator over all points, calc lattice indices and add lattice points to the grid
-    for(size_t i = 0; i < numPoint; i++)
+    if(parallelBuild)
     {
-        BaseVecT pt = pts[i];
-        auto index = (pt - v_min) / this->m_voxelsize;
-        this->addLatticePoint(calcIndex(index.x), calcIndex(index.y), calcIndex(index.z));
+        // Calc all lattice indices and create the cells at once
+        vector<std::array<int, 3>> indices(numPoint);
+
+        #pragma omp parallel for schedule(static)
+        for(long i = 0; i < (long)numPoint; i++)
+        {
+            BaseVecT pt = pts[i];
+            auto index = (pt - v_min) / this->m_voxelsize;
+            indices[i] = {{ calcIndex(index.x), calcIndex(index.y), calcIndex(index.z) }};
+        }
+        this->addLatticePoints(indices);
+    }
+    else
+    {
+        // Iterator over all points, calc lattice indices and add lattice points to the grid
+        for(size_t i = 0; i < numPoint; i++)
+        {
+            BaseVecT pt = pts[i];
+            auto index = (pt - v_min) / this->m_voxelsize;
+            this->addLatticePoint(calcIndex(index.x), calcIndex(index.y), calcIndex(index.z));
+        }
     }
 }
 
@@ -69,30 +87,84 @@ PointsetGrid<BaseVecT, BoxT>::PointsetGrid(
 template<typename BaseVecT, typename BoxT>
 void PointsetGrid<BaseVecT, BoxT>::calcDistanceValues()
 {
+    Timestamp ts;
+
+    size_t numQueryPoints = this->m_queryPoints.size();
+
+    // The query points are created in the order of the point cloud, so
+    // consecutive points are usually far apart. Process them in Morton
+    // order instead. Neighbouring queries then traverse the same parts of
+    // the search tree, and each block of queries covers a compact region.
+    vector<std::pair<uint64_t, unsigned int>> order(numQueryPoints);
+    auto v_min = this->m_boundingBox.getMin();
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)numQueryPoints; i++)
+    {
+        // Query points lie on the cell corners at half-integer indices
+        auto index = (this->m_queryPoints[i].m_position - v_min) / this->m_voxelsize;
+        order[i] = std::make_pair(
+            this->mortonCode(
+                std::floor(index.x + 1.0f),
+                std::floor(index.y + 1.0f),
+                std::floor(index.z + 1.0f)),
+            (unsigned int)i
+        );
+    }
+    parallel_sort(order.begin(), order.end());
+
+    double sortTime = ts.getElapsedTimeInS();
+    cout << timestamp << "Sorted " << numQueryPoints << " query points in "
+         << sortTime << " s" << endl;
+
     // Status message output
     string comment = timestamp.getElapsedTime() + "Calculating distance values ";
-    ProgressBar progress(this->m_queryPoints.size(), comment);
+    ProgressBar progress(numQueryPoints, comment);
 
-    Timestamp ts;
+    // Calculate a distance value for each query point. The query points
+    // are passed to the surface in blocks to use batched neighbour searches.
+    const size_t blockSize = 16384;
+    vector<BaseVecT> positions;
+    vector<pair<typename BaseVecT::CoordType, typename BaseVecT::CoordType>> distances;
 
-    // Calculate a distance value for each query point
-    #pragma omp parallel for
-    for( int i = 0; i < (int)this->m_queryPoints.size(); i++){
-        float projectedDistance;
-        float euklideanDistance;
+    for(size_t start = 0; start < numQueryPoints; start += blockSize)
+    {
+        size_t end = std::min(numQueryPoints, start + blockSize);
 
-        //cout << euklideanDistance << " " << projectedDistance << endl;
+        positions.resize(end - start);
 
-        std::tie(projectedDistance, euklideanDistance) =
-            this->m_surface->distance(this->m_queryPoints[i].m_position);
-        if (euklideanDistance > 1.7320 * this->m_voxelsize)
+        #pragma omp parallel for schedule(static)
+        for(long i = start; i < (long)end; i++)
         {
-            this->m_queryPoints[i].m_invalid = true;
+            positions[i - start] = this->m_queryPoints[order[i].second].m_position;
         }
-        this->m_queryPoints[i].m_distance = projectedDistance;
-        ++progress;
+
+        this->m_surface->distance(positions, distances);
+
+        #pragma omp parallel for schedule(static)
+        for(long i = start; i < (long)end; i++)
+        {
+            QueryPoint<BaseVecT>& qp = this->m_queryPoints[order[i].second];
+
+            float projectedDistance;
+            float euklideanDistance;
+
+            std::tie(projectedDistance, euklideanDistance) = distances[i - start];
+            if (euklideanDistance > 1.7320 * this->m_voxelsize)
+            {
+                qp.m_invalid = true;
+            }
+            qp.m_distance = projectedDistance;
+        }
+
+        progress += end - start;
     }
     cout << endl;
+
+    double distanceTime = ts.getElapsedTimeInS() - sortTime;
+    cout << timestamp << "Calculated " << numQueryPoints << " distance values in "
+         << distanceTime << " s (" << (size_t)(numQueryPoints / std::max(distanceTime, 1e-6))
+         << " per second)" << endl;
     cout << timestamp << "Elapsed time: " << ts << endl;
 }
 
@@ -73,6 +73,21 @@ public:
      */
     virtual pair<typename BaseVecT::CoordType, typename BaseVecT::CoordType>
         distance(BaseVecT v) const = 0;
+
+    /**
+     * @brief Returns the distances of several grid points at once. The
+     *        default implementation calls the single point version for
+     *        every grid point.
+     *
+     * @param v       The grid points
+     * @param result  Receives the distance pair (see above) of every
+     *                grid point
+     */
+    virtual void distance(
+        const vector<BaseVecT>& v,
+        vector<pair<typename BaseVecT::CoordType, typename BaseVecT::CoordType>>& result
+    ) const;
+
     /**
      * @brief   Calculates surface normals for each data point in the given
      *          PointBuffeer. If the buffer alreay contains normal information
@@ -50,6 +50,21 @@ PointsetSurface<BaseVecT>::PointsetSurface(PointBufferPtr pointBuffer)
     }
 }
 
+template<typename BaseVecT>
+void PointsetSurface<BaseVecT>::distance(
+    const vector<BaseVecT>& v,
+    vector<pair<typename BaseVecT::CoordType, typename BaseVecT::CoordType>>& result
+) const
+{
+    result.resize(v.size());
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)v.size(); i++)
+    {
+        result[i] = this->distance(v[i]);
+    }
+}
+
 template<typename BaseVecT>
 Normal<float> PointsetSurface<BaseVecT>::getInterpolatedNormal(const BaseVecT& position) const
 {
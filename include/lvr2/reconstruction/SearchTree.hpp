@@ -35,6 +35,7 @@
 #ifndef LVR2_RECONSTRUCTION_SEARCHTREE_H_
 #define LVR2_RECONSTRUCTION_SEARCHTREE_H_
 
+#include <limits>
 #include <vector>
 
 namespace lvr2
@@ -51,6 +52,9 @@ class SearchTree
 {
 public:
 
+    /// Index of the entries of kSearchBatch() for which no neighbour exists
+    static constexpr size_t INVALID_INDEX = std::numeric_limits<size_t>::max();
+
     /**
      * @brief This function performs a k-next-neighbor search on the
               data that was given in the constructor.
@@ -90,6 +94,32 @@ public:
         vector<size_t>& indices
     ) const;
 
+    /**
+     * @brief Performs a k-next-neighbor search for a batch of query points.
+     *        The results are stored row-wise in flat arrays, i.e. the
+     *        neighbours of `qps[i]` are `indices[i * k]` to
+     *        `indices[i * k + k - 1]`, sorted by increasing distance.
+     *        The search is exact, so the first k' < k entries are the k'
+     *        nearest neighbours. Implementations that override this with
+     *        an approximate search have to keep that property.
+     *        If fewer than k points exist, the remaining entries of a row
+     *        are INVALID_INDEX with the largest representable distance.
+     *        The output vectors are resized to
+     *        `qps.size() * k` entries, so they can be reused between calls.
+     *
+     * @param qps         The query points.
+     * @param k           The number of neighbours that should be searched
+     *                    for every query point.
+     * @param indices     The indices of the neighbours within the dataset.
+     * @param distances   The distances of the neighbours.
+     */
+    virtual void kSearchBatch(
+        const vector<BaseVecT>& qps,
+        int k,
+        vector<size_t>& indices,
+        vector<typename BaseVecT::CoordType>& distances
+    ) const;
+
     // /**
     //  * @brief Set the number of neighbours used to estimate and interpolate normals.
     //  */
@@ -35,12 +35,16 @@
 
 #include <lvr2/io/Timestamp.hpp>
 
+#include <algorithm>
 #include <iostream>
 using std::cout;
 using std::endl;
 
 namespace lvr2 {
 
+template<typename BaseVecT>
+constexpr size_t SearchTree<BaseVecT>::INVALID_INDEX;
+
 
 template<typename BaseVecT>
 void SearchTree<BaseVecT>::kSearch(
@@ -53,6 +57,41 @@ void SearchTree<BaseVecT>::kSearch(
     this->kSearch(qp, neighbours, indices, distances);
 }
 
+template<typename BaseVecT>
+void SearchTree<BaseVecT>::kSearchBatch(
+    const vector<BaseVecT>& qps,
+    int k,
+    vector<size_t>& indices,
+    vector<typename BaseVecT::CoordType>& distances
+) const
+{
+    indices.resize(qps.size() * k);
+    distances.resize(qps.size() * k);
+
+    // Fallback for trees without a native batch query
+    #pragma omp parallel
+    {
+        vector<size_t> id;
+        vector<typename BaseVecT::CoordType> di;
+
+        #pragma omp for schedule(dynamic, 64)
+        for(long i = 0; i < (long)qps.size(); i++)
+        {
+            id.clear();
+            di.clear();
+            this->kSearch(qps[i], k, id, di);
+
+            // kSearch() finds less than k neighbours in small data sets
+            size_t found = std::min(id.size(), (size_t)k);
+            std::copy(id.begin(), id.begin() + found, indices.begin() + i * k);
+            std::copy(di.begin(), di.begin() + found, distances.begin() + i * k);
+            std::fill(indices.begin() + i * k + found, indices.begin() + (i + 1) * k, INVALID_INDEX);
+            std::fill(distances.begin() + i * k + found, distances.begin() + (i + 1) * k,
+                      std::numeric_limits<typename BaseVecT::CoordType>::max());
+        }
+    }
+}
+
 // template<typename BaseVecT>
 // void SearchTree<BaseVecT>::setKi(int ki)
 // {
@@ -83,6 +83,15 @@ public:
         vector<CoordT>& distances
     ) const;
 
+    /// See interface documentation. All query points are passed to FLANN
+    /// at once, which distributes them over all available cores.
+    virtual void kSearchBatch(
+        const vector<BaseVecT>& qps,
+        int k,
+        vector<size_t>& indices,
+        vector<CoordT>& distances
+    ) const;
+
     /// See interface documentation.
     virtual void radiusSearch(
         const BaseVecT& qp,
@@ -38,6 +38,8 @@
 
 #include <lvr2/util/Panic.hpp>
 
+#include <algorithm>
+
 using std::make_unique;
 
 namespace lvr2
@@ -74,10 +76,8 @@ void SearchTreeFlann<BaseVecT>::kSearch(
     vector<CoordT>& distances
 ) const
 {
-    flann::Matrix<float> query_point(new float[3], 1, 3);
-    query_point[0][0] = qp.x;
-    query_point[0][1] = qp.y;
-    query_point[0][2] = qp.z;
+    float query[3] = {qp.x, qp.y, qp.z};
+    flann::Matrix<float> query_point(query, 1, 3);
 
     vector<int> flann_indices(k);
     vector<CoordT> flann_distances(k);
@@ -85,15 +85,57 @@ void SearchTreeFlann<BaseVecT>::kSearch(
     flann::Matrix<int> ind(flann_indices.data(), 1, k);
     flann::Matrix<CoordT> dist(flann_distances.data(), 1, k);
 
-    m_tree->knnSearch(query_point, ind, dist, k, flann::SearchParams());
+    // Fewer than k neighbours are found in small data sets
+    int found = m_tree->knnSearch(query_point, ind, dist, k, flann::SearchParams());
 
-    for (int i = 0; i < k; i++)
+    for (int i = 0; i < std::min(found, k); i++)
     {
         indices.push_back(static_cast<size_t>(flann_indices[i]));
         distances.push_back(CoordT(flann_distances[i]));
     }
 }
 
+template<typename BaseVecT>
+void SearchTreeFlann<BaseVecT>::kSearchBatch(
+    const vector<BaseVecT>& qps,
+    int k,
+    vector<size_t>& indices,
+    vector<CoordT>& distances
+) const
+{
+    size_t n = qps.size();
+
+    // FLANN leaves the entries untouched for which no neighbour exists
+    indices.assign(n * k, this->INVALID_INDEX);
+    distances.assign(n * k, std::numeric_limits<CoordT>::max());
+    if(n == 0)
+    {
+        return;
+    }
+
+    vector<float> queries(3 * n);
+    for(size_t i = 0; i < n; i++)
+    {
+        queries[3 * i + 0] = qps[i].x;
+        queries[3 * i + 1] = qps[i].y;
+        queries[3 * i + 2] = qps[i].z;
+    }
+
+    // FLANN writes the results directly into the output arrays
+    flann::Matrix<float> query_points(queries.data(), n, 3);
+    flann::Matrix<size_t> ind(indices.data(), n, k);
+    flann::Matrix<CoordT> dist(distances.data(), n, k);
+
+    // Search exactly: callers may use the first k' < k results as the
+    // k' nearest neighbours, which approximate results don't guarantee
+    flann::SearchParams params;
+    params.checks = flann::FLANN_CHECKS_UNLIMITED;
+    params.eps = 0.0f;
+    params.sorted = true;
+    params.cores = 0; // Use all available cores
+    m_tree->knnSearch(query_points, ind, dist, k, params);
+}
+
 template<typename BaseVecT>
 void SearchTreeFlann<BaseVecT>::radiusSearch(
     const BaseVecT& qp,
@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * SearchTreeNanoflann.hpp
+ */
+
+#ifndef LVR2_RECONSTRUCTION_SEARCHTREENANOFLANN_HPP_
+#define LVR2_RECONSTRUCTION_SEARCHTREENANOFLANN_HPP_
+
+#include <vector>
+#include <memory>
+
+#include <nanoflann.hpp>
+
+#include <lvr2/reconstruction/SearchTree.hpp>
+#include <lvr2/io/PointBuffer.hpp>
+
+using std::vector;
+using std::unique_ptr;
+
+namespace lvr2
+{
+
+/**
+ * @brief SearchClass for point data.
+ *
+ *      This class uses the header only nanoflann library that is shipped
+ *      in ext/nanoflann to implement a nearest neighbour search for
+ *      point-data.
+ */
+template<typename BaseVecT>
+class SearchTreeNanoflann : public SearchTree<BaseVecT>
+{
+private:
+    using CoordT = typename BaseVecT::CoordType;
+
+public:
+
+    /**
+     *  @brief Takes the point-data and initializes the underlying searchtree.
+     *
+     *  @param buffer  A PointBuffer point that holds the data.
+     */
+    SearchTreeNanoflann(PointBufferPtr buffer);
+
+    /// See interface documentation.
+    virtual void kSearch(
+        const BaseVecT& qp,
+        int k,
+        vector<size_t>& indices,
+        vector<CoordT>& distances
+    ) const;
+
+    /// See interface documentation. The query points are distributed
+    /// over all available threads.
+    virtual void kSearchBatch(
+        const vector<BaseVecT>& qps,
+        int k,
+        vector<size_t>& indices,
+        vector<CoordT>& distances
+    ) const;
+
+    /// See interface documentation.
+    virtual void radiusSearch(
+        const BaseVecT& qp,
+        CoordT r,
+        vector<size_t>& indices
+    ) const;
+
+    /// Dataset interface required by nanoflann
+    size_t kdtree_get_point_count() const { return m_points.size() / 3; }
+
+    /// Dataset interface required by nanoflann
+    CoordT kdtree_distance(const CoordT* p1, const size_t idx_p2, size_t size) const;
+
+    /// Dataset interface required by nanoflann
+    CoordT kdtree_get_pt(const size_t idx, int dim) const { return m_points[idx * 3 + dim]; }
+
+    /// Dataset interface required by nanoflann. Returning false lets
+    /// nanoflann compute the bounding box itself.
+    template<typename BBOX>
+    bool kdtree_get_bbox(BBOX&) const { return false; }
+
+protected:
+
+    using KDTree = nanoflann::KDTreeSingleIndexAdaptor<
+        nanoflann::L2_Simple_Adaptor<CoordT, SearchTreeNanoflann<BaseVecT>>,
+        SearchTreeNanoflann<BaseVecT>,
+        3
+    >;
+
+    /// Collects the indices of all points within a (squared) radius.
+    /// Replaces nanoflann's RadiusResultSet, which does not compile with
+    /// C++11 in the shipped version.
+    struct RadiusIndexSet
+    {
+        CoordT radius;
+        vector<size_t>& indices;
+
+        RadiusIndexSet(CoordT r, vector<size_t>& out) : radius(r), indices(out) {}
+        size_t size() const { return indices.size(); }
+        bool full() const { return true; }
+        CoordT worstDist() const { return radius; }
+        void addPoint(CoordT dist, size_t index)
+        {
+            if(dist < radius)
+            {
+                indices.push_back(index);
+            }
+        }
+    };
+
+    /// The point coordinates, three values per point
+    vector<CoordT> m_points;
+
+    /// The nanoflann search tree structure.
+    unique_ptr<KDTree> m_tree;
+};
+
+} // namespace lvr2
+
+#include <lvr2/reconstruction/SearchTreeNanoflann.tcc>
+
+#endif /* LVR2_RECONSTRUCTION_SEARCHTREENANOFLANN_HPP_ */
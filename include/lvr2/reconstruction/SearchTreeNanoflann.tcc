@@ -0,0 +1,143 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * SearchTreeNanoflann.tcc
+ */
+
+#include <lvr2/util/Panic.hpp>
+
+using std::make_unique;
+
+namespace lvr2
+{
+
+template<typename BaseVecT>
+SearchTreeNanoflann<BaseVecT>::SearchTreeNanoflann(PointBufferPtr buffer)
+{
+    auto n = buffer->numPoints();
+    FloatChannelOptional pts_optional = buffer->getFloatChannel("points");
+    FloatChannel pts_channel = *pts_optional;
+
+    m_points.resize(3 * n);
+    for(size_t i = 0; i < n; i++)
+    {
+        BaseVecT p = pts_channel[i];
+        m_points[3 * i + 0] = p.x;
+        m_points[3 * i + 1] = p.y;
+        m_points[3 * i + 2] = p.z;
+    }
+
+    m_tree = make_unique<KDTree>(3, *this, nanoflann::KDTreeSingleIndexAdaptorParams(10));
+    m_tree->buildIndex();
+}
+
+template<typename BaseVecT>
+typename BaseVecT::CoordType SearchTreeNanoflann<BaseVecT>::kdtree_distance(
+    const CoordT* p1,
+    const size_t idx_p2,
+    size_t
+) const
+{
+    const CoordT* p2 = &m_points[idx_p2 * 3];
+    CoordT d0 = p1[0] - p2[0];
+    CoordT d1 = p1[1] - p2[1];
+    CoordT d2 = p1[2] - p2[2];
+    return d0 * d0 + d1 * d1 + d2 * d2;
+}
+
+template<typename BaseVecT>
+void SearchTreeNanoflann<BaseVecT>::kSearch(
+    const BaseVecT& qp,
+    int k,
+    vector<size_t>& indices,
+    vector<CoordT>& distances
+) const
+{
+    CoordT query[3] = {qp.x, qp.y, qp.z};
+
+    size_t first = indices.size();
+    indices.resize(first + k);
+    distances.resize(first + k);
+
+    // The result may hold fewer than k neighbours if the tree has less
+    // than k points
+    nanoflann::KNNResultSet<CoordT, size_t> result(k);
+    result.init(&indices[first], &distances[first]);
+    m_tree->findNeighbors(result, query, nanoflann::SearchParams());
+
+    indices.resize(first + result.size());
+    distances.resize(first + result.size());
+}
+
+template<typename BaseVecT>
+void SearchTreeNanoflann<BaseVecT>::kSearchBatch(
+    const vector<BaseVecT>& qps,
+    int k,
+    vector<size_t>& indices,
+    vector<CoordT>& distances
+) const
+{
+    indices.resize(qps.size() * k);
+    distances.resize(qps.size() * k);
+
+    // The cost of a query varies with the local point density. Small
+    // dynamic chunks balance the load and keep consecutive (usually
+    // spatially coherent) queries on the same thread.
+    #pragma omp parallel for schedule(dynamic, 64)
+    for(long i = 0; i < (long)qps.size(); i++)
+    {
+        CoordT query[3] = {qps[i].x, qps[i].y, qps[i].z};
+        nanoflann::KNNResultSet<CoordT, size_t> result(k);
+        result.init(&indices[i * k], &distances[i * k]);
+        m_tree->findNeighbors(result, query, nanoflann::SearchParams());
+
+        // Mark the entries without a neighbour in small data sets
+        for(size_t j = result.size(); j < (size_t)k; j++)
+        {
+            indices[i * k + j] = this->INVALID_INDEX;
+            distances[i * k + j] = std::numeric_limits<CoordT>::max();
+        }
+    }
+}
+
+template<typename BaseVecT>
+void SearchTreeNanoflann<BaseVecT>::radiusSearch(
+    const BaseVecT& qp,
+    CoordT r,
+    vector<size_t>& indices
+) const
+{
+    CoordT query[3] = {qp.x, qp.y, qp.z};
+
+    // The L2 metric of nanoflann works with squared distances
+    indices.clear();
+    RadiusIndexSet result(r * r, indices);
+    m_tree->findNeighbors(result, query, nanoflann::SearchParams());
+}
+
+} // namespace lvr2
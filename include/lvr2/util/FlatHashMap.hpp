@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * FlatHashMap.hpp
+ */
+
+#ifndef LVR2_UTIL_FLATHASHMAP_H_
+#define LVR2_UTIL_FLATHASHMAP_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace lvr2
+{
+
+/**
+ * @brief An insert-only open addressing hash map for integer keys.
+ *
+ * The key-value pairs are stored densely in insertion order, so iterating
+ * the map walks a single contiguous array. Lookups use a power of two
+ * sized table of 32 bit indices into that array with linear probing. The
+ * keys are scrambled with a multiplicative hash, so packed grid indices,
+ * which are mostly consecutive, are distributed evenly.
+ *
+ * Compared to std::unordered_map there is no allocation per element and
+ * no pointer chasing during lookups. Elements can not be erased and
+ * iterators and references are invalidated by insertions.
+ *
+ * @tparam ValueT Type of the stored values
+ */
+template<typename ValueT>
+class FlatHashMap
+{
+public:
+    using value_type = std::pair<size_t, ValueT>;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    /**
+     * @brief Creates an empty map.
+     */
+    FlatHashMap();
+
+    /**
+     * @brief Returns an iterator to the element with the given key or end().
+     */
+    iterator find(size_t key);
+
+    /// See other overload.
+    const_iterator find(size_t key) const;
+
+    /**
+     * @brief Inserts the given pair if its key is not present yet.
+     *
+     * @return An iterator to the element with the given key and true if
+     *         the element was inserted.
+     */
+    std::pair<iterator, bool> insert(const value_type& value);
+
+    /**
+     * @brief Returns the value of the given key. Inserts a default
+     *        constructed value if the key is not present.
+     */
+    ValueT& operator[](size_t key);
+
+    /**
+     * @brief Allocates space for at least `n` elements.
+     */
+    void reserve(size_t n);
+
+    /**
+     * @brief Removes all elements.
+     */
+    void clear();
+
+    size_t size() const { return m_values.size(); }
+
+    bool empty() const { return m_values.empty(); }
+
+    iterator begin() { return m_values.begin(); }
+
+    iterator end() { return m_values.end(); }
+
+    const_iterator begin() const { return m_values.begin(); }
+
+    const_iterator end() const { return m_values.end(); }
+
+private:
+
+    /// Marks an unused slot of the lookup table
+    static const uint32_t EMPTY = 0xffffffff;
+
+    /// Returns the first slot to probe for the given key
+    inline size_t slot(size_t key) const
+    {
+        return (key * 0x9e3779b97f4a7c15ull) >> m_shift;
+    }
+
+    /// Returns the slot containing the key or the empty slot to insert it
+    size_t probe(size_t key) const;
+
+    /// Resizes the lookup table to 2^bits slots and reinserts all elements
+    void rehash(unsigned bits);
+
+    /// The elements in insertion order
+    std::vector<value_type> m_values;
+
+    /// Indices into m_values
+    std::vector<uint32_t> m_slots;
+
+    /// 64 - log2(m_slots.size())
+    unsigned m_shift;
+};
+
+} // namespace lvr2
+
+#include <lvr2/util/FlatHashMap.tcc>
+
+#endif // LVR2_UTIL_FLATHASHMAP_H_
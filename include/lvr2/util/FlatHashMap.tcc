@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * FlatHashMap.tcc
+ */
+
+namespace lvr2
+{
+
+template<typename ValueT>
+const uint32_t FlatHashMap<ValueT>::EMPTY;
+
+template<typename ValueT>
+FlatHashMap<ValueT>::FlatHashMap()
+{
+    rehash(4);
+}
+
+template<typename ValueT>
+size_t FlatHashMap<ValueT>::probe(size_t key) const
+{
+    size_t mask = m_slots.size() - 1;
+    size_t s = slot(key);
+    while (m_slots[s] != EMPTY && m_values[m_slots[s]].first != key)
+    {
+        s = (s + 1) & mask;
+    }
+    return s;
+}
+
+template<typename ValueT>
+typename FlatHashMap<ValueT>::iterator FlatHashMap<ValueT>::find(size_t key)
+{
+    size_t s = probe(key);
+    return m_slots[s] == EMPTY ? m_values.end() : m_values.begin() + m_slots[s];
+}
+
+template<typename ValueT>
+typename FlatHashMap<ValueT>::const_iterator FlatHashMap<ValueT>::find(size_t key) const
+{
+    size_t s = probe(key);
+    return m_slots[s] == EMPTY ? m_values.end() : m_values.begin() + m_slots[s];
+}
+
+template<typename ValueT>
+std::pair<typename FlatHashMap<ValueT>::iterator, bool> FlatHashMap<ValueT>::insert(const value_type& value)
+{
+    size_t s = probe(value.first);
+    if (m_slots[s] != EMPTY)
+    {
+        return std::make_pair(m_values.begin() + m_slots[s], false);
+    }
+
+    // Keep the load factor below 1/2, so unsuccessful lookups
+    // (which are common for neighbor searches) stay short
+    if (2 * (m_values.size() + 1) > m_slots.size())
+    {
+        rehash(65 - m_shift);
+        s = probe(value.first);
+    }
+
+    m_slots[s] = m_values.size();
+    m_values.push_back(value);
+    return std::make_pair(m_values.end() - 1, true);
+}
+
+template<typename ValueT>
+ValueT& FlatHashMap<ValueT>::operator[](size_t key)
+{
+    return insert(value_type(key, ValueT())).first->second;
+}
+
+template<typename ValueT>
+void FlatHashMap<ValueT>::reserve(size_t n)
+{
+    m_values.reserve(n);
+
+    unsigned bits = 64 - m_shift;
+    while ((size_t(1) << bits) < 2 * n)
+    {
+        bits++;
+    }
+    if (bits != 64 - m_shift)
+    {
+        rehash(bits);
+    }
+}
+
+template<typename ValueT>
+void FlatHashMap<ValueT>::clear()
+{
+    std::vector<value_type>().swap(m_values);
+    rehash(4);
+}
+
+template<typename ValueT>
+void FlatHashMap<ValueT>::rehash(unsigned bits)
+{
+    m_shift = 64 - bits;
+    m_slots.assign(size_t(1) << bits, EMPTY);
+
+    size_t mask = m_slots.size() - 1;
+    for (size_t i = 0; i < m_values.size(); i++)
+    {
+        size_t s = slot(m_values[i].first);
+        while (m_slots[s] != EMPTY)
+        {
+            s = (s + 1) & mask;
+        }
+        m_slots[s] = i;
+    }
+}
+
+} // namespace lvr2
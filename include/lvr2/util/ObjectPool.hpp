@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * ObjectPool.hpp
+ */
+
+#ifndef LVR2_UTIL_OBJECTPOOL_H_
+#define LVR2_UTIL_OBJECTPOOL_H_
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace lvr2
+{
+
+/**
+ * @brief A chunked arena that owns objects of a single type.
+ *
+ * Objects are constructed in place in large chunks of memory instead of
+ * being allocated one by one. Their addresses stay valid until the pool
+ * is cleared or destroyed and consecutively created objects are adjacent
+ * in memory. Objects can not be removed individually.
+ *
+ * Besides emplace(), slots can be reserved with grow() and constructed
+ * later with construct(). Constructing distinct slots is thread safe.
+ * Every reserved slot has to be constructed before the pool is cleared
+ * or destroyed.
+ *
+ * @tparam T Type of the stored objects
+ */
+template<typename T>
+class ObjectPool
+{
+public:
+
+    /**
+     * @brief Creates an empty pool.
+     *
+     * @param chunkSize Number of objects allocated at once
+     */
+    explicit ObjectPool(size_t chunkSize = 4096);
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    /**
+     * @brief Destroys all objects.
+     */
+    ~ObjectPool();
+
+    /**
+     * @brief Constructs a new object with the given arguments.
+     *
+     * @return A pointer to the new object.
+     */
+    template<typename... Args>
+    T* emplace(Args&&... args);
+
+    /**
+     * @brief Reserves `n` uninitialized slots.
+     *
+     * @return The index of the first reserved slot.
+     */
+    size_t grow(size_t n);
+
+    /**
+     * @brief Constructs an object in the reserved slot `i`.
+     *
+     * @return A pointer to the new object.
+     */
+    template<typename... Args>
+    T* construct(size_t i, Args&&... args);
+
+    /**
+     * @brief Destroys all objects and releases the memory.
+     */
+    void clear();
+
+    /// Returns the number of slots
+    size_t size() const { return m_size; }
+
+    /// Returns the object in slot `i`
+    T& operator[](size_t i) { return *slot(i); }
+
+private:
+    using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    inline T* slot(size_t i)
+    {
+        return reinterpret_cast<T*>(&m_chunks[i / m_chunkSize][i % m_chunkSize]);
+    }
+
+    /// Number of objects per chunk
+    size_t m_chunkSize;
+
+    /// Number of used slots
+    size_t m_size;
+
+    /// The allocated chunks
+    std::vector<std::unique_ptr<Storage[]>> m_chunks;
+};
+
+} // namespace lvr2
+
+#include <lvr2/util/ObjectPool.tcc>
+
+#endif // LVR2_UTIL_OBJECTPOOL_H_
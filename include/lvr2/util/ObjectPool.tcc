@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * ObjectPool.tcc
+ */
+
+#include <utility>
+
+namespace lvr2
+{
+
+template<typename T>
+ObjectPool<T>::ObjectPool(size_t chunkSize)
+    : m_chunkSize(chunkSize), m_size(0)
+{
+}
+
+template<typename T>
+ObjectPool<T>::~ObjectPool()
+{
+    clear();
+}
+
+template<typename T>
+template<typename... Args>
+T* ObjectPool<T>::emplace(Args&&... args)
+{
+    return construct(grow(1), std::forward<Args>(args)...);
+}
+
+template<typename T>
+size_t ObjectPool<T>::grow(size_t n)
+{
+    size_t first = m_size;
+    m_size += n;
+    while (m_chunks.size() * m_chunkSize < m_size)
+    {
+        m_chunks.emplace_back(new Storage[m_chunkSize]);
+    }
+    return first;
+}
+
+template<typename T>
+template<typename... Args>
+T* ObjectPool<T>::construct(size_t i, Args&&... args)
+{
+    return new (slot(i)) T(std::forward<Args>(args)...);
+}
+
+template<typename T>
+void ObjectPool<T>::clear()
+{
+    for (size_t i = 0; i < m_size; i++)
+    {
+        slot(i)->~T();
+    }
+    m_size = 0;
+    m_chunks.clear();
+}
+
+} // namespace lvr2
@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * ParallelSort.hpp
+ */
+
+#ifndef LVR2_UTIL_PARALLELSORT_H_
+#define LVR2_UTIL_PARALLELSORT_H_
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+namespace lvr2
+{
+
+/**
+ * @brief Sorts the range [first, last) using all available OpenMP threads.
+ *
+ * The range is split into one block per thread, the blocks are sorted
+ * concurrently and then merged pairwise. Small ranges and builds without
+ * OpenMP fall back to std::sort. Like std::sort the result is not stable.
+ *
+ * @tparam Iter     Random access iterator type
+ * @tparam Compare  Strict weak ordering on the iterator's value type
+ *
+ * @param first     Start of the range to sort
+ * @param last      End of the range to sort
+ * @param comp      Comparison function object
+ */
+template<typename Iter, typename Compare>
+void parallel_sort(Iter first, Iter last, Compare comp);
+
+/**
+ * @brief Like the other overload, but sorts using operator<.
+ */
+template<typename Iter>
+void parallel_sort(Iter first, Iter last);
+
+} // namespace lvr2
+
+#include <lvr2/util/ParallelSort.tcc>
+
+#endif // LVR2_UTIL_PARALLELSORT_H_
@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * ParallelSort.tcc
+ */
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+#ifdef LVR2_USE_OPEN_MP
+#include <omp.h>
+#endif
+
+namespace lvr2
+{
+
+template<typename Iter, typename Compare>
+void parallel_sort(Iter first, Iter last, Compare comp)
+{
+#ifdef LVR2_USE_OPEN_MP
+    auto n = std::distance(first, last);
+
+    // Below this size the thread overhead outweighs the gain
+    const decltype(n) minParallelSize = 1 << 16;
+
+    int numBlocks = omp_get_max_threads();
+    if (numBlocks > 1 && n >= minParallelSize)
+    {
+        // Block boundaries, block b is [bounds[b], bounds[b + 1])
+        std::vector<decltype(n)> bounds(numBlocks + 1);
+        for (int b = 0; b <= numBlocks; b++)
+        {
+            bounds[b] = n / numBlocks * b + std::min<decltype(n)>(b, n % numBlocks);
+        }
+
+        #pragma omp parallel for schedule(static, 1)
+        for (int b = 0; b < numBlocks; b++)
+        {
+            std::sort(first + bounds[b], first + bounds[b + 1], comp);
+        }
+
+        // Merge neighboring blocks until one sorted range is left
+        for (int width = 1; width < numBlocks; width *= 2)
+        {
+            #pragma omp parallel for schedule(dynamic, 1)
+            for (int b = 0; b < numBlocks - width; b += 2 * width)
+            {
+                int end = std::min(b + 2 * width, numBlocks);
+                std::inplace_merge(
+                    first + bounds[b],
+                    first + bounds[b + width],
+                    first + bounds[end],
+                    comp
+                );
+            }
+        }
+        return;
+    }
+#endif
+
+    std::sort(first, last, comp);
+}
+
+template<typename Iter>
+void parallel_sort(Iter first, Iter last)
+{
+    parallel_sort(first, last, std::less<typename std::iterator_traits<Iter>::value_type>());
+}
+
+} // namespace lvr2
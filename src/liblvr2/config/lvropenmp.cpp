@@ -67,6 +67,13 @@ void OpenMPConfig::setMaxNumThreads()
 #endif
 }
 
+void OpenMPConfig::setMaxActiveLevels(int levels)
+{
+#ifdef LVR2_USE_OPEN_MP
+	omp_set_max_active_levels(levels);
+#endif
+}
+
 int OpenMPConfig::getNumThreads()
 {
 #ifdef LVR2_USE_OPEN_MP
@@ -76,6 +83,15 @@ int OpenMPConfig::getNumThreads()
 #endif
 }
 
+int OpenMPConfig::getThreadNum()
+{
+#ifdef LVR2_USE_OPEN_MP
+	return omp_get_thread_num();
+#else
+	return 0;
+#endif
+}
+
 } // namespace lvr2
 
 
@@ -35,192 +35,616 @@
 #include <fstream>
 #include <string.h>
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
 
 using std::ifstream;
 
 #include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 
 #include <lvr2/io/AsciiIO.hpp>
 #include <lvr2/io/Progress.hpp>
 #include <lvr2/io/Timestamp.hpp>
+#include <lvr2/config/lvropenmp.hpp>
 
 namespace lvr2
 {
 
+namespace
+{
 
-ModelPtr AsciiIO::read(
-        string filename,
-        const int &xPos, const int& yPos, const int& zPos,
-        const int &rPos, const int& gPos, const int& bPos, const int &iPos)
+/// Files are parsed in chunks of about this size, which are split at line breaks
+const size_t MAX_CHUNK_SIZE = 16 << 20;
+const size_t MIN_CHUNK_SIZE = 1 << 20;
+
+/// Column targets within a parsed line
+enum AsciiColumn { COL_X, COL_Y, COL_Z, COL_R, COL_G, COL_B, COL_I, COL_SKIP };
+
+inline bool isSeparator(char c)
 {
-    // Check extension
-    boost::filesystem::path selectedFile(filename);
-    string extension(selectedFile.extension().string());
+    return c == ' ' || c == '\t' || c == ',' || c == '\r';
+}
 
-    if ( extension != ".pts" && extension != ".3d" && extension != ".xyz" && extension != ".txt" )
+/// Returns the start of the first line which begins at or after pos
+const char* nextLineStart(const char* begin, const char* end, const char* pos)
+{
+    if (pos <= begin)
     {
-        cout << "»" << extension << "« is not a valid file extension." << endl;
-        return ModelPtr();
+        return begin;
     }
-    // Count lines in file to estimate the number of present points
-    size_t lines_in_file = countLines(filename);
-    cout << lines_in_file << endl;
+    const char* newline = static_cast<const char*>(memchr(pos - 1, '\n', end - pos + 1));
+    return newline ? newline + 1 : end;
+}
 
-    if ( lines_in_file < 2 )
+/**
+ * @brief Parses a floating point number in [p, end) without copying it.
+ *
+ * Numbers with up to 15 significant digits and small exponents are converted
+ * with a single rounding, so the result is the same as with strtof. Anything
+ * else falls back to strtof.
+ *
+ * @return Pointer behind the number or nullptr if it is malformed
+ */
+const char* parseFloat(const char* p, const char* end, float& value)
+{
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
     {
-        cout << timestamp << "AsciiIO: Too few lines in file (has to be > 2)." << endl;
-        return ModelPtr();
+        negative = *p == '-';
+        p++;
     }
 
-    // Open file
-    ifstream in;
-    in.open(filename.c_str());
+    uint64_t mantissa = 0;
+    int significant = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+    {
+        anyDigit = true;
+        if (mantissa || *p != '0')
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            significant++;
+        }
+    }
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++)
+        {
+            anyDigit = true;
+            if (mantissa || *p != '0')
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                significant++;
+            }
+            exponent--;
+        }
+    }
+    if (anyDigit && p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* q = p + 1;
+        bool negativeExp = false;
+        if (q < end && (*q == '-' || *q == '+'))
+        {
+            negativeExp = *q == '-';
+            q++;
+        }
+        int exp = 0;
+        const char* digits = q;
+        for (; q < end && *q >= '0' && *q <= '9' && exp < 10000; q++)
+        {
+            exp = exp * 10 + (*q - '0');
+        }
+        if (q > digits)
+        {
+            exponent += negativeExp ? -exp : exp;
+            p = q;
+        }
+    }
 
-    // Read first to lines, ignore the first one
-    char buffer[2048];
-    in.getline(buffer, 2048);
-    in.getline(buffer, 2048);
+    if (anyDigit && (p == end || isSeparator(*p) || *p == '\n')
+        && significant <= 15 && exponent >= -22 && exponent <= 22)
+    {
+        // Exact operands and one rounding to double
+        double d = exponent < 0 ? mantissa / powers[-exponent] : mantissa * powers[exponent];
+
+        // Converting to float rounds a second time, which is only wrong if
+        // d lies exactly between two floats
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof(bits));
+        if ((bits & 0x1fffffff) != 0x10000000)
+        {
+            value = negative ? -(float)d : (float)d;
+            return p;
+        }
+    }
 
-    // Get number of entries in test line and analize
-    int num_columns  = AsciiIO::getEntriesInLine(filename);
+    // Slow path for long, special or malformed numbers
+    char buffer[128];
+    const char* tokenEnd = start;
+    while (tokenEnd < end && !isSeparator(*tokenEnd) && *tokenEnd != '\n')
+    {
+        tokenEnd++;
+    }
+    size_t length = std::min<size_t>(tokenEnd - start, sizeof(buffer) - 1);
+    memcpy(buffer, start, length);
+    buffer[length] = 0;
 
-    // Reopen file and read data
-    in.close();
-    in.open(filename.c_str());
+    char* parsedEnd;
+    value = strtof(buffer, &parsedEnd);
+    if (parsedEnd == buffer || parsedEnd != buffer + length)
+    {
+        return nullptr;
+    }
+    return tokenEnd;
+}
 
-    // Again skip first line
-    in.getline(buffer, 2048);
+/// Points of one chunk of the file
+struct AsciiChunk
+{
+    std::vector<float> points;
+    std::vector<unsigned char> colors;
+    std::vector<float> intensities;
+};
 
-    // Buffer related variables
-    size_t numPoints = 0;
+/**
+ * @brief Parses the requested columns of the line [p, lineEnd).
+ *
+ * @param columns   Target of each column up to the last requested one
+ * @param values    Receives the values, indexed by AsciiColumn
+ *
+ * @return False if a value is missing or malformed
+ */
+bool parseAsciiLine(const char* p, const char* lineEnd, const std::vector<AsciiColumn>& columns, float* values)
+{
+    for (size_t col = 0; col < columns.size(); col++)
+    {
+        while (p < lineEnd && isSeparator(*p))
+        {
+            p++;
+        }
+        if (p == lineEnd)
+        {
+            return false;
+        }
+        else if (columns[col] == COL_SKIP)
+        {
+            while (p < lineEnd && !isSeparator(*p))
+            {
+                p++;
+            }
+        }
+        else
+        {
+            p = parseFloat(p, lineEnd, values[columns[col]]);
+            if (!p)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
 
-    floatArr points;
-    ucharArr pointColors;
-    floatArr pointIntensities;
+inline unsigned char toColor(float value)
+{
+    return (unsigned char)std::min(std::max(value, 0.0f), 255.0f);
+}
 
-    // Alloc memory for points
-    numPoints = lines_in_file - 1;
-    points = floatArr( new float[ numPoints * 3 ] );
-    ModelPtr model(new Model);
-    model->m_pointCloud = PointBufferPtr( new PointBuffer);
+/**
+ * @brief Parses all lines in [p, end). Lines with missing or malformed
+ *        values in the requested columns are skipped.
+ *
+ * @param columns   Target of each column up to the last requested one
+ */
+void parseAsciiChunk(const char* p, const char* end, const std::vector<AsciiColumn>& columns, AsciiChunk& chunk)
+{
+    bool has_color = std::find(columns.begin(), columns.end(), COL_R) != columns.end();
+    bool has_intensity = std::find(columns.begin(), columns.end(), COL_I) != columns.end();
 
-    // (Some) sanity checks for given paramters
-    if(rPos > num_columns || gPos > num_columns || bPos > num_columns || iPos > num_columns)
+    while (p < end)
     {
-        cout << timestamp << "Error: At least one attribute index is larger than the number of columns" << endl;
-        // Retrun empty model
-        return ModelPtr();
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!lineEnd)
+        {
+            lineEnd = end;
+        }
+
+        float values[COL_SKIP];
+        if (parseAsciiLine(p, lineEnd, columns, values))
+        {
+            chunk.points.insert(chunk.points.end(), values, values + 3);
+            if (has_color)
+            {
+                for (int c = COL_R; c <= COL_B; c++)
+                {
+                    chunk.colors.push_back(toColor(values[c]));
+                }
+            }
+            if (has_intensity)
+            {
+                chunk.intensities.push_back(values[COL_I]);
+            }
+        }
+
+        p = lineEnd < end ? lineEnd + 1 : end;
     }
+}
 
-    // Check for color and intensity
-    bool has_color = (rPos > -1 && gPos > -1 && bPos > -1);
-    bool has_intensity = (iPos > -1);
+/**
+ * @brief Maps the columns of each line to the attributes. Columns behind
+ *        the last requested one are not parsed at all.
+ */
+std::vector<AsciiColumn> mapColumns(int xPos, int yPos, int zPos, int rPos, int gPos, int bPos, int iPos)
+{
+    std::vector<AsciiColumn> columns;
+    auto setColumn = [&](int pos, AsciiColumn target)
+    {
+        if (pos >= (int)columns.size())
+        {
+            columns.resize(pos + 1, COL_SKIP);
+        }
+        columns[pos] = target;
+    };
+    setColumn(xPos, COL_X);
+    setColumn(yPos, COL_Y);
+    setColumn(zPos, COL_Z);
+    if (rPos > -1 && gPos > -1 && bPos > -1)
+    {
+        setColumn(rPos, COL_R);
+        setColumn(gPos, COL_G);
+        setColumn(bPos, COL_B);
+    }
+    if (iPos > -1)
+    {
+        setColumn(iPos, COL_I);
+    }
+    return columns;
+}
 
-    // Alloc buffer memory for additional attributes
-    if ( has_color )
+/// Returns the number of columns in the line starting at p
+int countColumns(const char* p, const char* end)
+{
+    const char* lineEnd = nextLineStart(p, end, p + 1);
+    int num_columns = 0;
+    while (p < lineEnd && *p != '\n')
     {
-        pointColors = ucharArr( new uint8_t[ numPoints * 3 ] );
+        while (p < lineEnd && isSeparator(*p))
+        {
+            p++;
+        }
+        if (p < lineEnd && *p != '\n')
+        {
+            num_columns++;
+        }
+        while (p < lineEnd && *p != '\n' && !isSeparator(*p))
+        {
+            p++;
+        }
     }
+    return num_columns;
+}
 
-    if ( has_intensity )
+/**
+ * @brief Guesses the attribute columns from the number of columns: If 4
+ *        values per point are given, the 4th value usually is a
+ *        reflectence information. Six entries suggest RGB information,
+ *        seven entries intensity and RGB.
+ */
+void detectColumns(int num_columns, int& rPos, int& gPos, int& bPos, int& iPos)
+{
+    int num_attributes  = num_columns - 3;
+    bool has_color      = (num_attributes == 3) || (num_attributes == 4);
+    bool has_intensity  = (num_attributes == 1) || (num_attributes == 4);
+
+    rPos = gPos = bPos = iPos = -1;
+    if (has_color)
+    {
+        rPos = 3;
+        gPos = 4;
+        bPos = 5;
+    }
+    if (has_intensity)
     {
-        pointIntensities = floatArr( new float[ numPoints ] );
+        iPos = num_attributes == 1 ? 3 : 6;
     }
+}
 
-    // Read data form file
-    size_t c = 0;
-    while (in.good() && c < numPoints)
+/**
+ * @brief Reads the lines of a memory mapped ASCII file in chunks. The
+ *        lines of each chunk are parsed in parallel.
+ */
+class AsciiPointReader : public PointReader
+{
+public:
+    AsciiPointReader(const std::vector<AsciiColumn>& columns)
+        : m_columns(columns), m_numPoints(0)
     {
+        m_hasColor = std::find(columns.begin(), columns.end(), COL_R) != columns.end();
+        m_hasIntensity = std::find(columns.begin(), columns.end(), COL_I) != columns.end();
+    }
 
-        float x, y, z, intensity, dummy;
-        unsigned int r, g, b;
+    /// Maps the file and skips the first line, which may be a header
+    bool open(const string& filename)
+    {
+        try
+        {
+            m_file.open(filename);
+        }
+        catch (std::exception& e)
+        {
+            return false;
+        }
+        m_end = m_file.data() + m_file.size();
+        m_dataBegin = nextLineStart(m_file.data(), m_end, m_file.data() + 1);
+        m_pos = m_dataBegin;
+        return true;
+    }
 
-        for(int i = 0; i < num_columns; i++)
+    size_t numPoints() const override
+    {
+        // Counting the lines touches the whole file, so it is only done
+        // on demand
+        if (!m_numPoints && m_dataBegin < m_end)
         {
-            if(i == xPos)
-            {
-                in >> x;
-            }
-            else if(i == yPos)
-            {
-                in >> y;
-            }
-            else if(i == zPos)
-            {
-                in >> z;
-            }
-            else if(i == rPos)
-            {
-                in >> r;
-            }
-            else if(i == gPos)
+            long size = m_end - m_dataBegin;
+            size_t c = m_end[-1] == '\n' ? 0 : 1;
+
+            #pragma omp parallel for schedule(static) reduction(+:c)
+            for (long i = 0; i < size; i += MAX_CHUNK_SIZE)
             {
-                in >> g;
+                const char* p = m_dataBegin + i;
+                const char* end = m_dataBegin + std::min(size, (long)(i + MAX_CHUNK_SIZE));
+                while ((p = static_cast<const char*>(memchr(p, '\n', end - p))))
+                {
+                    c++;
+                    p++;
+                }
             }
-            else if(i == bPos)
+            m_numPoints = c;
+        }
+        return m_numPoints;
+    }
+
+    bool hasColors() const override { return m_hasColor; }
+    bool hasIntensities() const override { return m_hasIntensity; }
+
+    void rewind() override
+    {
+        m_pos = m_dataBegin;
+    }
+
+protected:
+    size_t readPoints(size_t n, float* points, unsigned char* colors, float*, float* intensities) override
+    {
+        size_t numRead = 0;
+        std::vector<const char*> lines;
+        std::vector<char> valid;
+
+        // Lines with invalid values are dropped, so repeat until the
+        // chunk is full or the file ends
+        while (numRead < n && m_pos < m_end)
+        {
+            lines.clear();
+            while (lines.size() < n - numRead && m_pos < m_end)
             {
-                in >> b;
+                lines.push_back(m_pos);
+                const char* newline = static_cast<const char*>(memchr(m_pos, '\n', m_end - m_pos));
+                m_pos = newline ? newline + 1 : m_end;
             }
-            else if(i == iPos)
+            lines.push_back(m_pos);
+
+            long numLines = lines.size() - 1;
+            valid.assign(numLines, 0);
+
+            #pragma omp parallel for schedule(static)
+            for (long i = 0; i < numLines; i++)
             {
-                in >> intensity;
+                float values[COL_SKIP];
+                const char* lineEnd = lines[i + 1];
+                if (lineEnd > lines[i] && lineEnd[-1] == '\n')
+                {
+                    lineEnd--;
+                }
+                valid[i] = parseAsciiLine(lines[i], lineEnd, m_columns, values);
+                if (valid[i])
+                {
+                    size_t k = numRead + i;
+                    std::copy(values, values + 3, points + 3 * k);
+                    if (colors && m_hasColor)
+                    {
+                        for (int c = 0; c < 3; c++)
+                        {
+                            colors[3 * k + c] = toColor(values[COL_R + c]);
+                        }
+                    }
+                    if (intensities && m_hasIntensity)
+                    {
+                        intensities[k] = values[COL_I];
+                    }
+                }
             }
-            else
+
+            // Close the gaps left by invalid lines
+            size_t first = numRead;
+            for (long i = 0; i < numLines; i++)
             {
-                in >> dummy;
+                if (valid[i])
+                {
+                    size_t from = first + i;
+                    size_t to = numRead++;
+                    if (from != to)
+                    {
+                        std::copy(points + 3 * from, points + 3 * from + 3, points + 3 * to);
+                        if (colors && m_hasColor)
+                        {
+                            std::copy(colors + 3 * from, colors + 3 * from + 3, colors + 3 * to);
+                        }
+                        if (intensities && m_hasIntensity)
+                        {
+                            intensities[to] = intensities[from];
+                        }
+                    }
+                }
             }
-
         }
 
-        // Read according to determined format
-        if(has_color)
-        {
-            pointColors[ c * 3     ] = (unsigned char) r;
-            pointColors[ c * 3 + 1 ] = (unsigned char) g;
-            pointColors[ c * 3 + 2 ] = (unsigned char) b;
+        return numRead;
+    }
 
-        }
+private:
+    boost::iostreams::mapped_file_source    m_file;
+    std::vector<AsciiColumn>                m_columns;
+    const char*                             m_dataBegin;
+    const char*                             m_end;
+    const char*                             m_pos;
+    bool                                    m_hasColor;
+    bool                                    m_hasIntensity;
+    mutable size_t                          m_numPoints;
+};
 
-        if (has_intensity)
-        {
-            pointIntensities[c] = intensity;
+} // namespace
 
-        }
 
-        points[ c * 3     ] = x;
-        points[ c * 3 + 1 ] = y;
-        points[ c * 3 + 2 ] = z;
-        c++;
+ModelPtr AsciiIO::read(
+        string filename,
+        const int &xPos, const int& yPos, const int& zPos,
+        const int &rPos, const int& gPos, const int& bPos, const int &iPos)
+{
+    // Check extension
+    boost::filesystem::path selectedFile(filename);
+    string extension(selectedFile.extension().string());
+
+    if ( extension != ".pts" && extension != ".3d" && extension != ".xyz" && extension != ".txt" )
+    {
+        cout << "»" << extension << "« is not a valid file extension." << endl;
+        return ModelPtr();
     }
 
-    // Sanity check
-    if(c != numPoints)
+    auto start = std::chrono::steady_clock::now();
+
+    boost::iostreams::mapped_file_source mapped;
+    try
     {
-        cout << timestamp << "Warning: Point count / line count mismatch: "
-             << numPoints << " / " << c << endl;
+        mapped.open(filename);
+    }
+    catch (std::exception& e)
+    {
+        cout << timestamp << "AsciiIO: Unable to open " << filename << endl;
+        return ModelPtr();
     }
 
-    // Assign buffers
-    size_t numColors = 0;
-    size_t numIntensities = 0;
+    const char* fileBegin = mapped.data();
+    const char* fileEnd = fileBegin + mapped.size();
 
-    if(has_color)
+    // Skip the first line, which may be a header
+    const char* dataBegin = nextLineStart(fileBegin, fileEnd, fileBegin + 1);
+    if (dataBegin == fileEnd)
     {
-        numColors = numPoints;
-        model->m_pointCloud->setColorArray(pointColors, numColors);
+        cout << timestamp << "AsciiIO: Too few lines in file (has to be > 2)." << endl;
+        return ModelPtr();
+    }
 
+    // Get number of entries in the first data line
+    int num_columns = countColumns(dataBegin, fileEnd);
+
+    // (Some) sanity checks for given paramters
+    if(rPos > num_columns || gPos > num_columns || bPos > num_columns || iPos > num_columns)
+    {
+        cout << timestamp << "Error: At least one attribute index is larger than the number of columns" << endl;
+        // Retrun empty model
+        return ModelPtr();
     }
 
-    if(has_intensity)
+    // Check for color and intensity
+    bool has_color = (rPos > -1 && gPos > -1 && bPos > -1);
+    bool has_intensity = (iPos > -1);
+
+    std::vector<AsciiColumn> columns = mapColumns(xPos, yPos, zPos, rPos, gPos, bPos, iPos);
+
+    // Split the data into chunks at line breaks and parse them in parallel
+    size_t dataSize = fileEnd - dataBegin;
+    size_t chunkSize = std::max(MIN_CHUNK_SIZE, std::min(MAX_CHUNK_SIZE, dataSize / (4 * OpenMPConfig::getNumThreads())));
+    long numChunks = (dataSize + chunkSize - 1) / chunkSize;
+    std::vector<AsciiChunk> chunks(numChunks);
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long i = 0; i < numChunks; i++)
     {
-        numIntensities = numPoints;
-        model->m_pointCloud->addFloatChannel(pointIntensities, "intensities", numIntensities, 1);
+        const char* chunkBegin = nextLineStart(dataBegin, fileEnd, dataBegin + i * chunkSize);
+        const char* chunkEnd = nextLineStart(dataBegin, fileEnd, dataBegin + std::min(dataSize, (i + 1) * chunkSize));
+        parseAsciiChunk(chunkBegin, chunkEnd, columns, chunks[i]);
+    }
 
+    // Copy the chunks into the buffers
+    std::vector<size_t> offsets(numChunks + 1, 0);
+    for (long i = 0; i < numChunks; i++)
+    {
+        offsets[i + 1] = offsets[i] + chunks[i].points.size() / 3;
     }
+    size_t numPoints = offsets[numChunks];
 
+    if (numPoints == 0)
+    {
+        cout << timestamp << "AsciiIO: No points found in " << filename << endl;
+        return ModelPtr();
+    }
+
+    floatArr points(new float[numPoints * 3]);
+    ucharArr pointColors;
+    floatArr pointIntensities;
+    if (has_color)
+    {
+        pointColors = ucharArr(new uint8_t[numPoints * 3]);
+    }
+    if (has_intensity)
+    {
+        pointIntensities = floatArr(new float[numPoints]);
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long i = 0; i < numChunks; i++)
+    {
+        AsciiChunk& chunk = chunks[i];
+        std::copy(chunk.points.begin(), chunk.points.end(), points.get() + offsets[i] * 3);
+        if (has_color)
+        {
+            std::copy(chunk.colors.begin(), chunk.colors.end(), pointColors.get() + offsets[i] * 3);
+        }
+        if (has_intensity)
+        {
+            std::copy(chunk.intensities.begin(), chunk.intensities.end(), pointIntensities.get() + offsets[i]);
+        }
+        chunk = AsciiChunk();
+    }
+
+    ModelPtr model(new Model);
+    model->m_pointCloud = PointBufferPtr( new PointBuffer);
+
+    if(has_color)
+    {
+        model->m_pointCloud->setColorArray(pointColors, numPoints);
+    }
+
+    if(has_intensity)
+    {
+        model->m_pointCloud->addFloatChannel(pointIntensities, "intensities", numPoints, 1);
+    }
 
     model->m_pointCloud->setPointArray(points, numPoints);
 
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cout << timestamp << "AsciiIO: Read " << numPoints << " points from " << filename << " ("
+         << mapped.size() / seconds / (1 << 20) << " MB/s)" << endl;
+
     this->m_model = model;
     return model;
 }
@@ -237,64 +661,44 @@ ModelPtr AsciiIO::read(string filename)
         cout << "»" << extension << "« is not a valid file extension." << endl;
         return ModelPtr();
     }
-    // Count lines in file to estimate the number of present points
-    int lines_in_file = countLines(filename);
-
-    if ( lines_in_file < 2 )
-    {
-        cout << timestamp << "AsciiIO: Too few lines in file (has to be > 2)." << endl;
-        return ModelPtr();
-    }
     // Open the given file. Skip the first line (as it may
     // contain meta data in some formats). Then try to guess
-    // the additional data using some heuristics that apply for
-    // most data formats: If 4 values per point are, given
-    // the 4th value usually is a reflectence information.
-    // Six entries suggest RGB information, seven entries
-    // intensity and RGB.
-
-    // Open file
-    ifstream in;
-    in.open(filename.c_str());
-
-    // Read first to lines, ignore the first one
-    char buffer[2048];
-    in.getline(buffer, 2048);
-    in.getline(buffer, 2048);
-
-    // Get number of entries in test line and analize
-    int num_attributes  = AsciiIO::getEntriesInLine(filename) - 3;
-    bool has_color      = (num_attributes == 3) || (num_attributes == 4);
-    bool has_intensity  = (num_attributes == 1) || (num_attributes == 4);
+    // the additional data from the number of columns.
+    int rPos, gPos, bPos, iPos;
+    detectColumns(AsciiIO::getEntriesInLine(filename), rPos, gPos, bPos, iPos);
 
-    if(has_color || has_intensity)
+    if(rPos > -1 || iPos > -1)
     {
         cout << timestamp << "Autodetected the following attributes" << endl;
-        cout << timestamp << "Color:     " << has_color << endl;
-        cout << timestamp << "Intensity: " << has_intensity << endl;
-
-        if(has_color && has_intensity)
-        {
-            return read(filename, 0, 1, 2, 3, 4, 5, 6);
-        }
-        else if(has_color)
-        {
-            return read(filename, 0, 1, 2, 3, 4, 5);
-        }
-        else if(has_intensity)
-        {
-            if(num_attributes == 1)
-            {
-                return read(filename, 0, 1, 2, -1, -1, -1, 3);
-            }
-            else
-            {
-                return read(filename, 0, 1, 2, -1, -1, -1, 6);
-            }
-        }
+        cout << timestamp << "Color:     " << (rPos > -1) << endl;
+        cout << timestamp << "Intensity: " << (iPos > -1) << endl;
     }
-    return read(filename, 0, 1, 2);
+    return read(filename, 0, 1, 2, rPos, gPos, bPos, iPos);
+}
+
+
+PointReaderPtr AsciiIO::openPointReader(string filename)
+{
+    int rPos, gPos, bPos, iPos;
+    detectColumns(AsciiIO::getEntriesInLine(filename), rPos, gPos, bPos, iPos);
+    return openPointReader(filename, 0, 1, 2, rPos, gPos, bPos, iPos);
+}
+
+
+PointReaderPtr AsciiIO::openPointReader(
+        string filename,
+        const int &xPos, const int& yPos, const int& zPos,
+        const int &rPos, const int& gPos, const int& bPos, const int &iPos)
+{
+    std::shared_ptr<AsciiPointReader> reader(
+            new AsciiPointReader(mapColumns(xPos, yPos, zPos, rPos, gPos, bPos, iPos)));
 
+    if (!reader->open(filename))
+    {
+        cout << timestamp << "AsciiIO: Unable to open " << filename << endl;
+        return PointReaderPtr();
+    }
+    return reader;
 }
 
 
@@ -374,18 +778,34 @@ void AsciiIO::save( std::string filename )
 
 size_t AsciiIO::countLines(string filename)
 {
-    // Open file for reading
-    ifstream in(filename.c_str());
+    boost::iostreams::mapped_file_source mapped;
+    try
+    {
+        mapped.open(filename);
+    }
+    catch (std::exception& e)
+    {
+        return 1;
+    }
 
-    // Count lines in file
-    size_t c = 0;
-    char line[2048];
-    while(in.good())
+    // Count line breaks in parallel. Like reading the file with getline,
+    // this includes an empty last line.
+    const char* data = mapped.data();
+    long size = mapped.size();
+    size_t c = 1;
+
+    #pragma omp parallel for schedule(static) reduction(+:c)
+    for (long i = 0; i < size; i += MAX_CHUNK_SIZE)
     {
-        in.getline(line, 1024);
-        c++;
+        const char* p = data + i;
+        const char* end = data + std::min(size, (long)(i + MAX_CHUNK_SIZE));
+        while ((p = static_cast<const char*>(memchr(p, '\n', end - p))))
+        {
+            c++;
+            p++;
+        }
     }
-    in.close();
+
     return c;
 }
 
@@ -63,4 +63,15 @@ ModelPtr BaseIO::getModel()
     return m_model;
 }
 
+
+PointReaderPtr BaseIO::openPointReader(std::string filename)
+{
+    ModelPtr model = read(filename);
+    if(model && model->m_pointCloud)
+    {
+        return PointReaderPtr(new ModelPointReader(model->m_pointCloud));
+    }
+    return PointReaderPtr();
+}
+
 } // namespace lvr2
@@ -32,6 +32,8 @@
 #include <chrono>
 #include <ctime>
 #include <algorithm>
+#include <cstdio>
+#include <memory>
 
 namespace lvr2
 {
@@ -40,6 +42,135 @@ const std::string HDF5IO::vertices_name = "vertices";
 const std::string HDF5IO::indices_name = "indices";
 const std::string HDF5IO::meshes_group = "meshes";
 
+namespace
+{
+
+/**
+ * @brief Reads the points of all raw scans in chunks. Like in
+ *        HDF5IO::readPointCloud(), the points are transformed by the
+ *        initial pose of their scan position.
+ */
+class HDF5PointReader : public PointReader
+{
+public:
+    HDF5PointReader() : m_numPoints(0), m_scan(0), m_position(0) {}
+
+    bool open(const std::string& filename)
+    {
+        try
+        {
+            m_file.reset(new HighFive::File(filename, HighFive::File::ReadOnly));
+            if (!m_file->exist("raw") || !m_file->getGroup("raw").exist("scans"))
+            {
+                return false;
+            }
+
+            HighFive::Group scans = m_file->getGroup("raw").getGroup("scans");
+            for (size_t i = 0; i < scans.getNumberObjects(); i++)
+            {
+                int pos_num;
+                std::string name = scans.getObjectName(i);
+                if (!std::sscanf(name.c_str(), "position_%5d", &pos_num))
+                {
+                    continue;
+                }
+
+                HighFive::Group group = scans.getGroup(name);
+                if (!group.exist("points"))
+                {
+                    continue;
+                }
+
+                Scan scan{group.getDataSet("points"), Matrix4<BaseVector<float> >(), 0};
+                std::vector<size_t> dim = scan.points.getSpace().getDimensions();
+                scan.numPoints = 1;
+                for (size_t d: dim)
+                {
+                    scan.numPoints *= d;
+                }
+                scan.numPoints /= 3;
+
+                if (group.exist("initialPose"))
+                {
+                    float pose[16];
+                    group.getDataSet("initialPose").read(pose);
+                    scan.transform = Matrix4<BaseVector<float> >(pose);
+                }
+                scan.transform.transpose();
+
+                m_numPoints += scan.numPoints;
+                m_scans.push_back(scan);
+            }
+        }
+        catch (HighFive::Exception& e)
+        {
+            return false;
+        }
+        return !m_scans.empty();
+    }
+
+    size_t numPoints() const override { return m_numPoints; }
+
+    void rewind() override
+    {
+        m_scan = 0;
+        m_position = 0;
+    }
+
+protected:
+    size_t readPoints(size_t n, float* points, unsigned char*, float*, float*) override
+    {
+        size_t numRead = 0;
+        while (numRead < n && m_scan < m_scans.size())
+        {
+            Scan& scan = m_scans[m_scan];
+            size_t num = std::min(n - numRead, scan.numPoints - m_position);
+            float* dst = points + 3 * numRead;
+
+            // Points are stored as flat array or as n x 3 matrix
+            if (scan.points.getSpace().getDimensions().size() == 1)
+            {
+                scan.points.select({3 * m_position}, {3 * num}).read(dst);
+            }
+            else
+            {
+                scan.points.select({m_position, 0}, {num, 3}).read(dst);
+            }
+
+            BaseVector<float>* it = reinterpret_cast<BaseVector<float>*>(dst);
+            for (size_t i = 0; i < num; i++, it++)
+            {
+                *it = scan.transform * *it;
+            }
+
+            numRead += num;
+            m_position += num;
+            if (m_position == scan.numPoints)
+            {
+                m_scan++;
+                m_position = 0;
+            }
+        }
+        return numRead;
+    }
+
+private:
+    struct Scan
+    {
+        HighFive::DataSet           points;
+        Matrix4<BaseVector<float> > transform;
+        size_t                      numPoints;
+    };
+
+    std::unique_ptr<HighFive::File> m_file;
+    std::vector<Scan>               m_scans;
+    size_t                          m_numPoints;
+    size_t                          m_scan;
+    size_t                          m_position;
+};
+
+} // namespace
+
 HDF5IO::HDF5IO(const std::string filename, const std::string part_name, int open_flag) :
     m_hdf5_file(nullptr),
     m_compress(true),
@@ -137,6 +268,17 @@ ModelPtr HDF5IO::read(std::string filename)
     return model_ptr;
 }
 
+PointReaderPtr HDF5IO::openPointReader(std::string filename)
+{
+    std::shared_ptr<HDF5PointReader> reader(new HDF5PointReader);
+    if(!reader->open(filename))
+    {
+        std::cout << timestamp << "HDF5IO: No raw scans in " << filename << std::endl;
+        return PointReaderPtr();
+    }
+    return reader;
+}
+
 bool HDF5IO::readPointCloud(ModelPtr model_ptr)
 {
     std::vector<ScanData> scans = getRawScanData(true);
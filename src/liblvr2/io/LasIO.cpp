@@ -36,6 +36,11 @@
 using std::cout;
 using std::endl;
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
 #include <lvr2/io/LasIO.hpp>
 #include <lvr2/io/Timestamp.hpp>
 
@@ -45,69 +50,466 @@ using std::endl;
 namespace lvr2
 {
 
-ModelPtr LasIO::read(string filename )
+namespace
 {
 
-    // Create Lasreader object
+/// Number of points that are inspected to detect the range of the colors
+const size_t LAS_COLOR_SAMPLES = 1000;
+
+/// Resolution of the written coordinates
+const double LAS_SCALE = 0.001;
+
+/// Int atomics that hold the integer part of the coordinates
+const char* const COORDINATE_BASE[3] = {"coordinate_base_x", "coordinate_base_y", "coordinate_base_z"};
+
+LASreader* openLas(const string& filename)
+{
     LASreadOpener lasreadopener;
     lasreadopener.set_file_name(filename.c_str());
+    return lasreadopener.active() ? lasreadopener.open() : 0;
+}
 
-    if(lasreadopener.active())
+/**
+ * @brief LAS colors should use the full 16 bit range, but many writers
+ *        store 8 bit values. Returns true if the first points contain 16
+ *        bit values. The reader is rewound afterwards.
+ */
+bool hasWideColors(LASreader* reader)
+{
+    bool wide = false;
+    for(size_t i = 0; i < LAS_COLOR_SAMPLES && !wide && reader->read_point(); i++)
     {
-        LASreader* lasreader = lasreadopener.open();
+        const U16* rgb = reader->point.rgb;
+        wide = rgb[0] > 255 || rgb[1] > 255 || rgb[2] > 255;
+    }
+    reader->seek(0);
+    return wide;
+}
 
-        // Get number of points in file
-        size_t num_points = lasreader->npoints;
+inline unsigned char toColor(U16 value, bool wide)
+{
+    return wide ? value >> 8 : std::min<U16>(value, 255);
+}
 
-        // Alloc coordinate array
-        floatArr points ( new float[3 * num_points]);
-        floatArr intensities ( new float[num_points]);
-        ucharArr colors (new unsigned char[3 * num_points]);
+/**
+ * @brief Georeferenced coordinates are too large for a float, so they are
+ *        delivered relative to the minimum of the file, rounded down to
+ *        full meters.
+ */
+void coordinateBase(LASreader* reader, double base[3])
+{
+    base[0] = std::floor(reader->get_min_x());
+    base[1] = std::floor(reader->get_min_y());
+    base[2] = std::floor(reader->get_min_z());
+}
 
-        // Read point data
-        for(size_t i = 0; i < num_points; i++)
+void addCoordinateBase(PointBuffer& buffer, const double base[3])
+{
+    for(int c = 0; c < 3; c++)
+    {
+        buffer.addIntAtomic((int)base[c], COORDINATE_BASE[c]);
+    }
+}
+
+/**
+ * @brief Reads the points of a LAS file in chunks. The attributes are the
+ *        same as delivered by LasIO::read().
+ */
+class LasPointReader : public PointReader
+{
+public:
+    LasPointReader(LASreader* reader) : m_reader(reader)
+    {
+        m_wideColors = m_reader->point.have_rgb && hasWideColors(m_reader);
+        coordinateBase(m_reader, m_base);
+    }
+
+    ~LasPointReader()
+    {
+        delete m_reader;
+    }
+
+    size_t numPoints() const override { return m_reader->npoints; }
+    bool hasColors() const override { return m_reader->point.have_rgb; }
+    bool hasIntensities() const override { return true; }
+
+    void rewind() override
+    {
+        m_reader->seek(0);
+    }
+
+    BoundingBox<BaseVector<float> > getBoundingBox() override
+    {
+        return BoundingBox<BaseVector<float> >(
+                BaseVector<float>(
+                        m_reader->get_min_x() - m_base[0],
+                        m_reader->get_min_y() - m_base[1],
+                        m_reader->get_min_z() - m_base[2]),
+                BaseVector<float>(
+                        m_reader->get_max_x() - m_base[0],
+                        m_reader->get_max_y() - m_base[1],
+                        m_reader->get_max_z() - m_base[2]));
+    }
+
+protected:
+    void addAtomics(PointBuffer& chunk) override
+    {
+        addCoordinateBase(chunk, m_base);
+    }
+
+    size_t readPoints(size_t n, float* points, unsigned char* colors, float*, float* intensities) override
+    {
+        const LASpoint& point = m_reader->point;
+
+        size_t i = 0;
+        for(; i < n && m_reader->read_point(); i++)
         {
-            size_t buf_pos = 3 * i;
-            lasreader->read_point();
-            points[buf_pos]     = lasreader->point.x;
-            points[buf_pos + 1] = lasreader->point.y;
-            points[buf_pos + 2] = lasreader->point.z;
+            points[3 * i]     = point.get_x() - m_base[0];
+            points[3 * i + 1] = point.get_y() - m_base[1];
+            points[3 * i + 2] = point.get_z() - m_base[2];
+
+            if(colors)
+            {
+                for(int c = 0; c < 3; c++)
+                {
+                    colors[3 * i + c] = toColor(point.rgb[c], m_wideColors);
+                }
+            }
+            if(intensities)
+            {
+                intensities[i] = point.intensity;
+            }
+        }
+        return i;
+    }
+
+private:
+    LASreader*  m_reader;
+    bool        m_wideColors;
+    double      m_base[3];
+};
+
+/**
+ * @brief Reads all points of the reader, optionally restricted to the
+ *        given bounding box.
+ */
+ModelPtr readLas(LASreader* lasreader, const BoundingBox<BaseVector<float> >* bb)
+{
+    const LASpoint& point = lasreader->point;
+    bool has_color = point.have_rgb;
+    bool has_gps_time = point.have_gps_time;
+    bool wide_colors = has_color && hasWideColors(lasreader);
 
-            // Create fake colors from intensities
-            /// TODO: Check for color attributes if possible...
-            colors[buf_pos] = lasreader->point.intensity;
-            colors[buf_pos + 1] = lasreader->point.intensity;
-            colors[buf_pos + 2] = lasreader->point.intensity;
+    double base[3];
+    coordinateBase(lasreader, base);
+
+    double min_z = 0.0;
+    double max_z = 0.0;
+    if(bb)
+    {
+        // Uses the spatial index of the file if there is one
+        BaseVector<float> min = bb->getMin();
+        BaseVector<float> max = bb->getMax();
+        lasreader->inside_rectangle(min.x + base[0], min.y + base[1], max.x + base[0], max.y + base[1]);
+        min_z = min.z + base[2];
+        max_z = max.z + base[2];
+    }
 
-            intensities[i] = lasreader->point.intensity;
+    // The number of points is only known for unfiltered reads
+    size_t capacity = bb ? 0 : lasreader->npoints;
+    std::vector<float> points;
+    std::vector<float> intensities;
+    std::vector<unsigned char> colors;
+    std::vector<unsigned char> classifications;
+    std::vector<double> gps_times;
+    points.reserve(3 * capacity);
+    intensities.reserve(capacity);
+    classifications.reserve(capacity);
+    if(has_color)
+    {
+        colors.reserve(3 * capacity);
+    }
+    if(has_gps_time)
+    {
+        gps_times.reserve(capacity);
+    }
 
+    while(lasreader->read_point())
+    {
+        double z = point.get_z();
+        if(bb && (z < min_z || z > max_z))
+        {
+            continue;
+        }
+
+        points.push_back(point.get_x() - base[0]);
+        points.push_back(point.get_y() - base[1]);
+        points.push_back(z - base[2]);
+        intensities.push_back(point.intensity);
+        classifications.push_back(point.classification & 31);
+
+        if(has_color)
+        {
+            for(int c = 0; c < 3; c++)
+            {
+                colors.push_back(toColor(point.rgb[c], wide_colors));
+            }
+        }
+        if(has_gps_time)
+        {
+            gps_times.push_back(point.gps_time);
         }
+    }
+
+    size_t num_points = intensities.size();
 
-        // Create point buffer and model
-        PointBufferPtr p_buffer( new PointBuffer);
-        p_buffer->setPointArray(points, num_points);
-        p_buffer->addFloatChannel(intensities, "intensities", num_points, 1);
-        p_buffer->setColorArray(colors, num_points);
+    // Create point buffer and model
+    PointBufferPtr p_buffer( new PointBuffer);
+
+    floatArr point_arr(new float[3 * num_points]);
+    std::copy(points.begin(), points.end(), point_arr.get());
+    p_buffer->setPointArray(point_arr, num_points);
+    addCoordinateBase(*p_buffer, base);
+
+    floatArr intensity_arr(new float[num_points]);
+    std::copy(intensities.begin(), intensities.end(), intensity_arr.get());
+    p_buffer->addFloatChannel(intensity_arr, "intensities", num_points, 1);
+
+    ucharArr class_arr(new unsigned char[num_points]);
+    std::copy(classifications.begin(), classifications.end(), class_arr.get());
+    p_buffer->addUCharChannel(class_arr, "classifications", num_points, 1);
+
+    if(has_color)
+    {
+        ucharArr color_arr(new unsigned char[3 * num_points]);
+        std::copy(colors.begin(), colors.end(), color_arr.get());
+        p_buffer->setColorArray(color_arr, num_points);
+    }
+
+    if(has_gps_time && num_points)
+    {
+        // A float can't hold absolute GPS times, so store them relative
+        // to the first full second
+        double base = std::floor(*std::min_element(gps_times.begin(), gps_times.end()));
+        floatArr time_arr(new float[num_points]);
+        for(size_t i = 0; i < num_points; i++)
+        {
+            time_arr[i] = gps_times[i] - base;
+        }
+        p_buffer->addFloatChannel(time_arr, "gps_time", num_points, 1);
+        p_buffer->addIntAtomic((int)base, "gps_time_base");
+    }
 
-        ModelPtr m_ptr( new Model(p_buffer));
-        m_model = m_ptr;
+    return ModelPtr( new Model(p_buffer));
+}
 
-        delete lasreader;
+} // namespace
 
-        return m_ptr;
+PointReaderPtr LasIO::openPointReader(string filename)
+{
+    LASreader* lasreader = openLas(filename);
+    if(!lasreader)
+    {
+        cout << timestamp << "LasIO::openPointReader(): Unable to open file " << filename << endl;
+        return PointReaderPtr();
     }
-    else
+    return PointReaderPtr(new LasPointReader(lasreader));
+}
+
+ModelPtr LasIO::read(string filename )
+{
+    LASreader* lasreader = openLas(filename);
+    if(!lasreader)
     {
         cout << timestamp << "LasIO::read(): Unable to open file " << filename << endl;
         return ModelPtr();
     }
+
+    m_model = readLas(lasreader, 0);
+    delete lasreader;
+
+    return m_model;
 }
 
+ModelPtr LasIO::read(string filename, const BoundingBox<BaseVector<float> >& bb)
+{
+    LASreader* lasreader = openLas(filename);
+    if(!lasreader)
+    {
+        cout << timestamp << "LasIO::read(): Unable to open file " << filename << endl;
+        return ModelPtr();
+    }
+
+    m_model = readLas(lasreader, &bb);
+    delete lasreader;
+
+    return m_model;
+}
 
 void LasIO::save( string filename )
 {
-    /// TODO: Implement LAS output
-    std::cerr << "LASIO: Saving not yet implemented." << endl;
+    if(!m_model || !m_model->m_pointCloud)
+    {
+        cout << timestamp << "LasIO::save(): No point cloud to save." << endl;
+        return;
+    }
+
+    LasPointWriter writer(filename);
+    if(writer.write(m_model->m_pointCloud))
+    {
+        cout << timestamp << "LasIO: Wrote " << writer.close() << " points to " << filename << endl;
+    }
+}
+
+LasPointWriter::LasPointWriter(string filename)
+    : m_filename(filename), m_writer(0)
+{
+}
+
+LasPointWriter::~LasPointWriter()
+{
+    close();
+}
+
+bool LasPointWriter::write(PointBufferPtr buffer)
+{
+    size_t n = buffer->numPoints();
+    floatArr points = buffer->getPointArray();
+    if(!n || !points)
+    {
+        return true;
+    }
+
+    unsigned w_color = 0;
+    ucharArr colors = buffer->getColorArray(w_color);
+    if(w_color < 3)
+    {
+        colors.reset();
+    }
+
+    size_t n_channel;
+    unsigned w_channel;
+    floatArr intensities = buffer->getFloatArray("intensities", n_channel, w_channel);
+    if(n_channel != n || w_channel != 1)
+    {
+        intensities.reset();
+    }
+    ucharArr classifications = buffer->getUCharArray("classifications", n_channel, w_channel);
+    if(n_channel != n || w_channel != 1)
+    {
+        classifications.reset();
+    }
+    floatArr gps_times = buffer->getFloatArray("gps_time", n_channel, w_channel);
+    if(n_channel != n || w_channel != 1)
+    {
+        gps_times.reset();
+    }
+    intOptional gps_time_base = buffer->getIntAtomic("gps_time_base");
+    double base = gps_time_base ? *gps_time_base : 0.0;
+
+    // Buffers read from LAS files hold coordinates relative to a base
+    double coordinate_base[3] = {0.0, 0.0, 0.0};
+    bool has_coordinate_base = true;
+    for(int c = 0; c < 3; c++)
+    {
+        intOptional value = buffer->getIntAtomic(COORDINATE_BASE[c]);
+        has_coordinate_base = has_coordinate_base && value;
+        coordinate_base[c] = value ? *value : 0.0;
+    }
+
+    if(!m_writer)
+    {
+        // Point formats 0 to 3 of LAS 1.2, with optional GPS time and RGB
+        static const U16 record_lengths[] = {20, 28, 26, 34};
+        U8 format = (gps_times ? 1 : 0) + (colors ? 2 : 0);
+
+        m_header.reset(new LASheader);
+        m_header->point_data_format = format;
+        m_header->point_data_record_length = record_lengths[format];
+
+        // Keep the integer coordinates small. The coordinate base of
+        // buffers from LAS files is the natural offset, otherwise the
+        // minimum of the first buffer is used.
+        double offset[3] = {coordinate_base[0], coordinate_base[1], coordinate_base[2]};
+        if(!has_coordinate_base)
+        {
+            float min[3] = {std::numeric_limits<float>::max(),
+                            std::numeric_limits<float>::max(),
+                            std::numeric_limits<float>::max()};
+            for(size_t i = 0; i < n; i++)
+            {
+                for(int c = 0; c < 3; c++)
+                {
+                    min[c] = std::min(min[c], points[3 * i + c]);
+                }
+            }
+            for(int c = 0; c < 3; c++)
+            {
+                offset[c] = std::floor(min[c]);
+            }
+        }
+        m_header->x_scale_factor = m_header->y_scale_factor = m_header->z_scale_factor = LAS_SCALE;
+        m_header->x_offset = offset[0];
+        m_header->y_offset = offset[1];
+        m_header->z_offset = offset[2];
+
+        m_point.reset(new LASpoint);
+        if(!m_point->init(m_header.get(), format, record_lengths[format]))
+        {
+            return false;
+        }
+
+        LASwriteOpener laswriteopener;
+        laswriteopener.set_file_name(m_filename.c_str());
+        m_writer = laswriteopener.open(m_header.get());
+        if(!m_writer)
+        {
+            cout << timestamp << "LasPointWriter: Unable to open file " << m_filename << endl;
+            return false;
+        }
+    }
+
+    LASpoint& point = *m_point;
+    for(size_t i = 0; i < n; i++)
+    {
+        point.set_x(coordinate_base[0] + points[3 * i]);
+        point.set_y(coordinate_base[1] + points[3 * i + 1]);
+        point.set_z(coordinate_base[2] + points[3 * i + 2]);
+        point.intensity = intensities ? (U16)std::min(std::max(intensities[i], 0.0f), 65535.0f) : 0;
+        point.classification = classifications ? classifications[i] : 0;
+
+        if(point.have_rgb)
+        {
+            for(int c = 0; c < 3; c++)
+            {
+                point.rgb[c] = colors ? colors[w_color * i + c] * 257 : 0;
+            }
+        }
+        if(point.have_gps_time)
+        {
+            point.gps_time = gps_times ? base + gps_times[i] : 0.0;
+        }
+
+        m_writer->write_point(&point);
+        m_writer->update_inventory(&point);
+    }
+
+    return true;
+}
+
+size_t LasPointWriter::close()
+{
+    if(!m_writer)
+    {
+        return 0;
+    }
+
+    m_writer->update_header(m_header.get(), TRUE);
+    I64 n = m_writer->close();
+    delete m_writer;
+    m_writer = 0;
+
+    return n;
 }
 
 } /* namespace lvr2 */
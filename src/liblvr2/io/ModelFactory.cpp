@@ -63,6 +63,7 @@ namespace lvr2
 {
 
 CoordinateTransform<float> ModelFactory::m_transform;
+int ModelFactory::m_scanReduction = 1;
 
 ModelPtr ModelFactory::readModel( std::string filename )
 {
@@ -93,7 +94,7 @@ ModelPtr ModelFactory::readModel( std::string filename )
     {
         io = new ObjIO;
     }
-    else if (extension == ".las")
+    else if (extension == ".las" || extension == ".laz")
     {
         io = new LasIO;
     }
@@ -113,7 +114,9 @@ ModelPtr ModelFactory::readModel( std::string filename )
 #endif /* LVR2_USE_PCL */
     else if (extension == "" && ScanprojectIO().parse_project(selectedFile.string(), true))
     {
-        io = new ScanprojectIO;
+        ScanprojectIO* projectIO = new ScanprojectIO;
+        projectIO->setScanReduction(m_scanReduction);
+        io = projectIO;
     }
     else if (extension == "")
     {
@@ -155,7 +158,9 @@ ModelPtr ModelFactory::readModel( std::string filename )
         // Check and create io
         if(!found_boctree && found_3d)
         {
-            io = new UosIO;
+            UosIO* uosIO = new UosIO;
+            uosIO->setScanReduction(m_scanReduction);
+            io = uosIO;
         }
         else if(found_boctree && found_3d)
         {
@@ -228,6 +233,44 @@ ModelPtr ModelFactory::readModel( std::string filename )
 
 }
 
+PointReaderPtr ModelFactory::openPointReader( std::string filename )
+{
+    // Check extension
+    boost::filesystem::path selectedFile( filename );
+    std::string extension = selectedFile.extension().string();
+
+    // Formats that support streaming
+    std::unique_ptr<BaseIO> io;
+    if(extension == ".ply")
+    {
+        io.reset(new PLYIO);
+    }
+    else if(extension == ".pts" || extension == ".3d" || extension == ".xyz" || extension == ".txt")
+    {
+        io.reset(new AsciiIO);
+    }
+    else if (extension == ".las" || extension == ".laz")
+    {
+        io.reset(new LasIO);
+    }
+    else if (extension == ".h5")
+    {
+        io.reset(new HDF5IO);
+    }
+
+    if(io)
+    {
+        return io->openPointReader( filename );
+    }
+
+    ModelPtr m = readModel( filename );
+    if(m && m->m_pointCloud)
+    {
+        return PointReaderPtr(new ModelPointReader(m->m_pointCloud));
+    }
+    return PointReaderPtr();
+}
+
 void ModelFactory::saveModel( ModelPtr m, std::string filename)
 {
     // Get file exptension
@@ -253,6 +296,10 @@ void ModelFactory::saveModel( ModelPtr m, std::string filename)
     {
         io = new STLIO;
     }
+    else if (extension == ".las" || extension == ".laz")
+    {
+        io = new LasIO;
+    }
     else if (extension == ".h5")
     {
         io = new HDF5IO;
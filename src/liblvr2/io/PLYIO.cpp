@@ -48,11 +48,512 @@
 #include <fstream>
 
 #include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <opencv2/opencv.hpp>
 
 namespace lvr2
 {
 
+namespace
+{
+
+/// Records of binary files are converted in blocks of this many elements
+const size_t PLY_BLOCK_SIZE = 1 << 16;
+
+/**
+ * @brief Destination of a PLY property for the binary fast path
+ */
+struct PlyTarget
+{
+    const char* element;
+    const char* property;
+
+    /// Destination of the first value of the first element
+    void*       data;
+
+    /// Type of the destination: PLY_FLOAT, PLY_UCHAR, PLY_SHORT or PLY_UINT
+    e_ply_type  type;
+
+    /// Number of values per element in data
+    int         stride;
+
+    /// Number of values of the property, 3 for triangle lists
+    int         count;
+};
+
+size_t plyTypeSize(e_ply_type type)
+{
+    switch (type)
+    {
+        case PLY_INT8: case PLY_UINT8: case PLY_CHAR: case PLY_UCHAR:
+            return 1;
+        case PLY_INT16: case PLY_UINT16: case PLY_SHORT: case PLY_USHORT:
+            return 2;
+        case PLY_INT32: case PLY_UIN32: case PLY_INT: case PLY_UINT:
+        case PLY_FLOAT32: case PLY_FLOAT:
+            return 4;
+        case PLY_FLOAT64: case PLY_DOUBLE:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+/// Copies a property of n records to dst, converting through double like the rply callbacks
+template<typename DstT, typename SrcT>
+void copyPlyValues(const char* src, size_t recordSize, size_t n, int count, DstT* dst, int stride)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        for (int c = 0; c < count; c++)
+        {
+            SrcT value;
+            memcpy(&value, src + i * recordSize + c * sizeof(SrcT), sizeof(SrcT));
+            dst[i * stride + c] = (DstT)(double)value;
+        }
+    }
+}
+
+template<typename DstT>
+void copyPlyValues(const char* src, e_ply_type type, size_t recordSize, size_t n, int count, DstT* dst, int stride)
+{
+    switch (type)
+    {
+        case PLY_INT8: case PLY_CHAR:
+            copyPlyValues<DstT, int8_t>(src, recordSize, n, count, dst, stride); break;
+        case PLY_UINT8: case PLY_UCHAR:
+            copyPlyValues<DstT, uint8_t>(src, recordSize, n, count, dst, stride); break;
+        case PLY_INT16: case PLY_SHORT:
+            copyPlyValues<DstT, int16_t>(src, recordSize, n, count, dst, stride); break;
+        case PLY_UINT16: case PLY_USHORT:
+            copyPlyValues<DstT, uint16_t>(src, recordSize, n, count, dst, stride); break;
+        case PLY_INT32: case PLY_INT:
+            copyPlyValues<DstT, int32_t>(src, recordSize, n, count, dst, stride); break;
+        case PLY_UIN32: case PLY_UINT:
+            copyPlyValues<DstT, uint32_t>(src, recordSize, n, count, dst, stride); break;
+        case PLY_FLOAT32: case PLY_FLOAT:
+            copyPlyValues<DstT, float>(src, recordSize, n, count, dst, stride); break;
+        case PLY_FLOAT64: case PLY_DOUBLE:
+            copyPlyValues<DstT, double>(src, recordSize, n, count, dst, stride); break;
+        default:
+            break;
+    }
+}
+
+bool isLittleEndianHost()
+{
+    const uint16_t endianTest = 1;
+    return *reinterpret_cast<const uint8_t*>(&endianTest) == 1;
+}
+
+/**
+ * @brief Returns the start of the data behind the header of the mapped
+ *        PLY file, or nullptr if it is not a binary little endian file.
+ */
+const char* findBinaryPlyData(const char* data, size_t size)
+{
+    const char* headerEnd = nullptr;
+    const char* format = nullptr;
+    for (const char* line = data; line < data + size; )
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', data + size - line));
+        if (!lineEnd)
+        {
+            return nullptr;
+        }
+        if (lineEnd - line >= 7 && !strncmp(line, "format ", 7))
+        {
+            format = line + 7;
+        }
+        if (lineEnd - line >= 10 && !strncmp(line, "end_header", 10))
+        {
+            headerEnd = lineEnd + 1;
+            break;
+        }
+        line = lineEnd + 1;
+    }
+    if (!headerEnd || !format || strncmp(format, "binary_little_endian", 20))
+    {
+        return nullptr;
+    }
+    return headerEnd;
+}
+
+/**
+ * @brief Reads the data of a binary little endian PLY file directly from a
+ *        memory map into the targets, instead of calling an rply callback
+ *        for every value.
+ *
+ * This only works if all records have a fixed size, i.e. the only list
+ * properties are triangle lists of the targets or are located in the last
+ * element, which contains no targets.
+ *
+ * @param ply       File opened with rply, after reading the header
+ * @param targets   Destinations of the properties to read
+ * @return false if the file has to be read with rply
+ */
+bool readBinaryPly(p_ply ply, const string& filename, const std::vector<PlyTarget>& targets)
+{
+    if (!isLittleEndianHost())
+    {
+        return false;
+    }
+
+    boost::iostreams::mapped_file_source mapped;
+    try
+    {
+        mapped.open(filename);
+    }
+    catch (std::exception& e)
+    {
+        return false;
+    }
+    const char* data = mapped.data();
+    size_t size = mapped.size();
+
+    const char* headerEnd = findBinaryPlyData(data, size);
+    if (!headerEnd)
+    {
+        return false;
+    }
+
+    // Property of a record, which is copied to a target
+    struct Field
+    {
+        size_t offset;
+        e_ply_type type;
+        const PlyTarget* target;
+    };
+
+    size_t offset = headerEnd - data;
+    p_ply_element elem = NULL;
+    while ((elem = ply_get_next_element(ply, elem)))
+    {
+        const char* elementName;
+        long numElements;
+        ply_get_element_info(elem, &elementName, &numElements);
+
+        size_t recordSize = 0;
+        std::vector<Field> fields;
+        std::vector<Field> listLengths;
+        bool variableSize = false;
+
+        p_ply_property prop = NULL;
+        while ((prop = ply_get_next_property(elem, prop)))
+        {
+            const char* propertyName;
+            e_ply_type type, lengthType, valueType;
+            ply_get_property_info(prop, &propertyName, &type, &lengthType, &valueType);
+
+            const PlyTarget* target = nullptr;
+            for (const PlyTarget& t: targets)
+            {
+                if (!strcmp(t.element, elementName) && !strcmp(t.property, propertyName))
+                {
+                    target = &t;
+                }
+            }
+
+            if (type == PLY_LIST)
+            {
+                // Lists of targets must have target->count entries
+                if (!target)
+                {
+                    variableSize = true;
+                    break;
+                }
+                listLengths.push_back({recordSize, lengthType, target});
+                recordSize += plyTypeSize(lengthType);
+                fields.push_back({recordSize, valueType, target});
+                recordSize += target->count * plyTypeSize(valueType);
+            }
+            else
+            {
+                if (target)
+                {
+                    fields.push_back({recordSize, type, target});
+                }
+                recordSize += plyTypeSize(type);
+            }
+        }
+
+        if (variableSize)
+        {
+            // Unknown lists are fine if nothing has to be read from here on
+            for (const PlyTarget& t: targets)
+            {
+                for (p_ply_element e = elem; e; e = ply_get_next_element(ply, e))
+                {
+                    const char* name;
+                    ply_get_element_info(e, &name, NULL);
+                    if (!strcmp(t.element, name))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        if (offset + recordSize * numElements > size)
+        {
+            return false;
+        }
+
+        const char* records = data + offset;
+        long numBlocks = (numElements + PLY_BLOCK_SIZE - 1) / PLY_BLOCK_SIZE;
+        bool fixedLists = true;
+
+        #pragma omp parallel for schedule(dynamic) reduction(&&:fixedLists)
+        for (long b = 0; b < numBlocks; b++)
+        {
+            size_t first = b * PLY_BLOCK_SIZE;
+            size_t n = std::min<size_t>(PLY_BLOCK_SIZE, numElements - first);
+            const char* block = records + first * recordSize;
+
+            for (const Field& list: listLengths)
+            {
+                std::vector<unsigned int> lengths(n);
+                copyPlyValues(block + list.offset, list.type, recordSize, n, 1, lengths.data(), 1);
+                for (unsigned int length: lengths)
+                {
+                    fixedLists = fixedLists && length == (unsigned int)list.target->count;
+                }
+            }
+
+            for (const Field& field: fields)
+            {
+                const PlyTarget& t = *field.target;
+                const char* src = block + field.offset;
+                switch (t.type)
+                {
+                    case PLY_FLOAT:
+                        copyPlyValues(src, field.type, recordSize, n, t.count,
+                                static_cast<float*>(t.data) + first * t.stride, t.stride);
+                        break;
+                    case PLY_UCHAR:
+                        copyPlyValues(src, field.type, recordSize, n, t.count,
+                                static_cast<unsigned char*>(t.data) + first * t.stride, t.stride);
+                        break;
+                    case PLY_SHORT:
+                        copyPlyValues(src, field.type, recordSize, n, t.count,
+                                static_cast<short*>(t.data) + first * t.stride, t.stride);
+                        break;
+                    case PLY_UINT:
+                        copyPlyValues(src, field.type, recordSize, n, t.count,
+                                static_cast<unsigned int*>(t.data) + first * t.stride, t.stride);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+
+        if (!fixedLists)
+        {
+            // e.g. polygons, which rply reports as an error
+            return false;
+        }
+
+        offset += recordSize * numElements;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Reads the points of a memory mapped binary little endian PLY
+ *        file in chunks. The points are taken from the 'point' element
+ *        or, like in PLYIO::read(), from the 'vertex' element if the
+ *        file contains neither points nor faces.
+ */
+class PlyPointReader : public PointReader
+{
+public:
+    PlyPointReader() : m_records(nullptr), m_offset(0), m_recordSize(0), m_numPoints(0), m_position(0) {}
+
+    /// @return false if the file can't be streamed
+    bool open(const string& filename)
+    {
+        if (!isLittleEndianHost())
+        {
+            return false;
+        }
+
+        p_ply ply = ply_open(filename.c_str(), NULL, 0, NULL);
+        if (!ply)
+        {
+            return false;
+        }
+        bool ok = ply_read_header(ply) && parseHeader(ply);
+        ply_close(ply);
+        if (!ok)
+        {
+            return false;
+        }
+
+        try
+        {
+            m_file.open(filename);
+        }
+        catch (std::exception& e)
+        {
+            return false;
+        }
+
+        const char* data = findBinaryPlyData(m_file.data(), m_file.size());
+        if (!data)
+        {
+            return false;
+        }
+        m_records = data + m_offset;
+        return m_records + m_recordSize * m_numPoints <= m_file.data() + m_file.size();
+    }
+
+    size_t numPoints() const override { return m_numPoints; }
+    bool hasColors() const override { return m_fields[RED].valid && m_fields[GREEN].valid && m_fields[BLUE].valid; }
+    bool hasNormals() const override { return m_fields[NX].valid && m_fields[NY].valid && m_fields[NZ].valid; }
+    bool hasIntensities() const override { return m_fields[INTENSITY].valid; }
+
+    void rewind() override
+    {
+        m_position = 0;
+    }
+
+protected:
+    size_t readPoints(size_t n, float* points, unsigned char* colors, float* normals, float* intensities) override
+    {
+        n = std::min(n, m_numPoints - m_position);
+        const char* records = m_records + m_position * m_recordSize;
+        long numBlocks = (n + PLY_BLOCK_SIZE - 1) / PLY_BLOCK_SIZE;
+
+        #pragma omp parallel for schedule(dynamic)
+        for (long b = 0; b < numBlocks; b++)
+        {
+            size_t first = b * PLY_BLOCK_SIZE;
+            size_t num = std::min<size_t>(PLY_BLOCK_SIZE, n - first);
+            const char* block = records + first * m_recordSize;
+
+            for (int c = 0; c < 3; c++)
+            {
+                copy(block, X + c, num, points + 3 * first + c, 3);
+                if (colors && hasColors())
+                {
+                    copy(block, RED + c, num, colors + 3 * first + c, 3);
+                }
+                if (normals && hasNormals())
+                {
+                    copy(block, NX + c, num, normals + 3 * first + c, 3);
+                }
+            }
+            if (intensities && hasIntensities())
+            {
+                copy(block, INTENSITY, num, intensities + first, 1);
+            }
+        }
+
+        m_position += n;
+        return n;
+    }
+
+private:
+    enum Property { X, Y, Z, RED, GREEN, BLUE, NX, NY, NZ, INTENSITY, NUM_PROPERTIES };
+
+    struct Field
+    {
+        Field() : offset(0), type(PLY_FLOAT), valid(false) {}
+        size_t      offset;
+        e_ply_type  type;
+        bool        valid;
+    };
+
+    template<typename DstT>
+    void copy(const char* block, int property, size_t n, DstT* dst, int stride)
+    {
+        const Field& field = m_fields[property];
+        copyPlyValues(block + field.offset, field.type, m_recordSize, n, 1, dst, stride);
+    }
+
+    /// Locates the point records. All records in front of them must have a fixed size.
+    bool parseHeader(p_ply ply)
+    {
+        static const char* names[NUM_PROPERTIES] = {
+            "x", "y", "z", "red", "green", "blue", "nx", "ny", "nz", "intensity"
+        };
+
+        bool hasPoints = false;
+        bool hasFaces = false;
+        p_ply_element elem = NULL;
+        while ((elem = ply_get_next_element(ply, elem)))
+        {
+            const char* name;
+            ply_get_element_info(elem, &name, NULL);
+            hasPoints = hasPoints || !strcmp(name, "point");
+            hasFaces = hasFaces || !strcmp(name, "face");
+        }
+        if (!hasPoints && hasFaces)
+        {
+            return false;
+        }
+        const char* pointElement = hasPoints ? "point" : "vertex";
+
+        m_offset = 0;
+        elem = NULL;
+        while ((elem = ply_get_next_element(ply, elem)))
+        {
+            const char* elementName;
+            long numElements;
+            ply_get_element_info(elem, &elementName, &numElements);
+            bool isPoint = !strcmp(elementName, pointElement);
+
+            size_t recordSize = 0;
+            p_ply_property prop = NULL;
+            while ((prop = ply_get_next_property(elem, prop)))
+            {
+                const char* propertyName;
+                e_ply_type type;
+                ply_get_property_info(prop, &propertyName, &type, NULL, NULL);
+                if (type == PLY_LIST)
+                {
+                    return false;
+                }
+                if (isPoint)
+                {
+                    for (int i = 0; i < NUM_PROPERTIES; i++)
+                    {
+                        if (!strcmp(propertyName, names[i]))
+                        {
+                            m_fields[i].offset = recordSize;
+                            m_fields[i].type = type;
+                            m_fields[i].valid = true;
+                        }
+                    }
+                }
+                recordSize += plyTypeSize(type);
+            }
+
+            if (isPoint)
+            {
+                m_recordSize = recordSize;
+                m_numPoints = numElements;
+                return m_fields[X].valid && m_fields[Y].valid && m_fields[Z].valid;
+            }
+            m_offset += recordSize * numElements;
+        }
+        return false;
+    }
+
+    boost::iostreams::mapped_file_source    m_file;
+    const char*                             m_records;
+    size_t                                  m_offset;
+    size_t                                  m_recordSize;
+    size_t                                  m_numPoints;
+    size_t                                  m_position;
+    Field                                   m_fields[NUM_PROPERTIES];
+};
+
+} // namespace
+
 
 void PLYIO::save( string filename )
 {
@@ -402,6 +903,17 @@ void PLYIO::save( string filename )
 }
 
 
+PointReaderPtr PLYIO::openPointReader( string filename )
+{
+    std::shared_ptr<PlyPointReader> reader( new PlyPointReader );
+    if ( reader->open( filename ) )
+    {
+        return reader;
+    }
+    return BaseIO::openPointReader( filename );
+}
+
+
 ModelPtr PLYIO::read( string filename )
 {
    return read( filename, true );
@@ -636,82 +1148,155 @@ ModelPtr PLYIO::read( string filename, bool readColor, bool readConfidence,
     short*          point_panorama_coords    = pointPanoramaCoords.get();
 
 
-    /* Set callbacks. */
+    /* Binary little endian files are copied directly into the buffers */
+    std::vector<PlyTarget> targets;
     if ( vertex )
     {
-        ply_set_read_cb( ply, "vertex", "x", readVertexCb, &vertex, 0 );
-        ply_set_read_cb( ply, "vertex", "y", readVertexCb, &vertex, 0 );
-        ply_set_read_cb( ply, "vertex", "z", readVertexCb, &vertex, 1 );
+        targets.push_back( { "vertex", "x", vertex,     PLY_FLOAT, 3, 1 } );
+        targets.push_back( { "vertex", "y", vertex + 1, PLY_FLOAT, 3, 1 } );
+        targets.push_back( { "vertex", "z", vertex + 2, PLY_FLOAT, 3, 1 } );
     }
     if ( vertex_color )
     {
-        ply_set_read_cb( ply, "vertex", "red",   readColorCb,  &vertex_color,  0 );
-        ply_set_read_cb( ply, "vertex", "green", readColorCb,  &vertex_color,  0 );
-        ply_set_read_cb( ply, "vertex", "blue",  readColorCb,  &vertex_color,  1 );
+        targets.push_back( { "vertex", "red",   vertex_color,     PLY_UCHAR, 3, 1 } );
+        targets.push_back( { "vertex", "green", vertex_color + 1, PLY_UCHAR, 3, 1 } );
+        targets.push_back( { "vertex", "blue",  vertex_color + 2, PLY_UCHAR, 3, 1 } );
     }
     if ( vertex_confidence )
     {
-        ply_set_read_cb( ply, "vertex", "confidence", readVertexCb, &vertex_confidence, 1 );
+        targets.push_back( { "vertex", "confidence", vertex_confidence, PLY_FLOAT, 1, 1 } );
     }
     if ( vertex_intensity )
     {
-        ply_set_read_cb( ply, "vertex", "intensity", readVertexCb, &vertex_intensity, 1 );
+        targets.push_back( { "vertex", "intensity", vertex_intensity, PLY_FLOAT, 1, 1 } );
     }
     if ( vertex_normal )
     {
-        ply_set_read_cb( ply, "vertex", "nx", readVertexCb, &vertex_normal, 0 );
-        ply_set_read_cb( ply, "vertex", "ny", readVertexCb, &vertex_normal, 0 );
-        ply_set_read_cb( ply, "vertex", "nz", readVertexCb, &vertex_normal, 1 );
+        targets.push_back( { "vertex", "nx", vertex_normal,     PLY_FLOAT, 3, 1 } );
+        targets.push_back( { "vertex", "ny", vertex_normal + 1, PLY_FLOAT, 3, 1 } );
+        targets.push_back( { "vertex", "nz", vertex_normal + 2, PLY_FLOAT, 3, 1 } );
     }
     if ( vertex_panorama_coords )
     {
-        ply_set_read_cb( ply, "vertex", "x_coords", readPanoramaCoordCB, &vertex_panorama_coords, 0 );
-        ply_set_read_cb( ply, "vertex", "y_coords", readPanoramaCoordCB, &vertex_panorama_coords, 1 );
+        targets.push_back( { "vertex", "x_coords", vertex_panorama_coords,     PLY_SHORT, 2, 1 } );
+        targets.push_back( { "vertex", "y_coords", vertex_panorama_coords + 1, PLY_SHORT, 2, 1 } );
     }
-
     if ( face )
     {
-        ply_set_read_cb( ply, "face", "vertex_indices", readFaceCb, &face, 0 );
-        ply_set_read_cb( ply, "face", "vertex_index", readFaceCb, &face, 0 );
+        targets.push_back( { "face", "vertex_indices", face, PLY_UINT, 3, 3 } );
+        targets.push_back( { "face", "vertex_index",   face, PLY_UINT, 3, 3 } );
     }
-
     if ( point )
     {
-        ply_set_read_cb( ply, "point", "x", readVertexCb, &point, 0 );
-        ply_set_read_cb( ply, "point", "y", readVertexCb, &point, 0 );
-        ply_set_read_cb( ply, "point", "z", readVertexCb, &point, 1 );
+        targets.push_back( { "point", "x", point,     PLY_FLOAT, 3, 1 } );
+        targets.push_back( { "point", "y", point + 1, PLY_FLOAT, 3, 1 } );
+        targets.push_back( { "point", "z", point + 2, PLY_FLOAT, 3, 1 } );
     }
     if ( point_color )
     {
-        ply_set_read_cb( ply, "point", "red",   readColorCb,  &point_color,  0 );
-        ply_set_read_cb( ply, "point", "green", readColorCb,  &point_color,  0 );
-        ply_set_read_cb( ply, "point", "blue",  readColorCb,  &point_color,  1 );
+        targets.push_back( { "point", "red",   point_color,     PLY_UCHAR, 3, 1 } );
+        targets.push_back( { "point", "green", point_color + 1, PLY_UCHAR, 3, 1 } );
+        targets.push_back( { "point", "blue",  point_color + 2, PLY_UCHAR, 3, 1 } );
     }
     if ( point_confidence )
     {
-        ply_set_read_cb( ply, "point", "confidence", readVertexCb, &point_confidence, 1 );
+        targets.push_back( { "point", "confidence", point_confidence, PLY_FLOAT, 1, 1 } );
     }
     if ( point_intensity )
     {
-        ply_set_read_cb( ply, "point", "intensity", readVertexCb, &point_intensity, 1 );
+        targets.push_back( { "point", "intensity", point_intensity, PLY_FLOAT, 1, 1 } );
     }
     if ( point_normal )
     {
-        ply_set_read_cb( ply, "point", "nx", readVertexCb, &point_normal, 0 );
-        ply_set_read_cb( ply, "point", "ny", readVertexCb, &point_normal, 0 );
-        ply_set_read_cb( ply, "point", "nz", readVertexCb, &point_normal, 1 );
+        targets.push_back( { "point", "nx", point_normal,     PLY_FLOAT, 3, 1 } );
+        targets.push_back( { "point", "ny", point_normal + 1, PLY_FLOAT, 3, 1 } );
+        targets.push_back( { "point", "nz", point_normal + 2, PLY_FLOAT, 3, 1 } );
     }
     if ( point_panorama_coords )
     {
-        ply_set_read_cb( ply, "point", "x_coords", readPanoramaCoordCB, &point_panorama_coords, 0 );
-        ply_set_read_cb( ply, "point", "y_coords", readPanoramaCoordCB, &point_panorama_coords, 1 );
+        targets.push_back( { "point", "x_coords", point_panorama_coords,     PLY_SHORT, 2, 1 } );
+        targets.push_back( { "point", "y_coords", point_panorama_coords + 1, PLY_SHORT, 2, 1 } );
     }
 
-    /* Read ply file. */
-    if ( !ply_read( ply ) )
+    if ( !readBinaryPly( ply, filename, targets ) )
     {
-        std::cerr << timestamp << "Could not read »" << filename << "«."
-            << std::endl;
+        /* Set callbacks. */
+        if ( vertex )
+        {
+            ply_set_read_cb( ply, "vertex", "x", readVertexCb, &vertex, 0 );
+            ply_set_read_cb( ply, "vertex", "y", readVertexCb, &vertex, 0 );
+            ply_set_read_cb( ply, "vertex", "z", readVertexCb, &vertex, 1 );
+        }
+        if ( vertex_color )
+        {
+            ply_set_read_cb( ply, "vertex", "red",   readColorCb,  &vertex_color,  0 );
+            ply_set_read_cb( ply, "vertex", "green", readColorCb,  &vertex_color,  0 );
+            ply_set_read_cb( ply, "vertex", "blue",  readColorCb,  &vertex_color,  1 );
+        }
+        if ( vertex_confidence )
+        {
+            ply_set_read_cb( ply, "vertex", "confidence", readVertexCb, &vertex_confidence, 1 );
+        }
+        if ( vertex_intensity )
+        {
+            ply_set_read_cb( ply, "vertex", "intensity", readVertexCb, &vertex_intensity, 1 );
+        }
+        if ( vertex_normal )
+        {
+            ply_set_read_cb( ply, "vertex", "nx", readVertexCb, &vertex_normal, 0 );
+            ply_set_read_cb( ply, "vertex", "ny", readVertexCb, &vertex_normal, 0 );
+            ply_set_read_cb( ply, "vertex", "nz", readVertexCb, &vertex_normal, 1 );
+        }
+        if ( vertex_panorama_coords )
+        {
+            ply_set_read_cb( ply, "vertex", "x_coords", readPanoramaCoordCB, &vertex_panorama_coords, 0 );
+            ply_set_read_cb( ply, "vertex", "y_coords", readPanoramaCoordCB, &vertex_panorama_coords, 1 );
+        }
+
+        if ( face )
+        {
+            ply_set_read_cb( ply, "face", "vertex_indices", readFaceCb, &face, 0 );
+            ply_set_read_cb( ply, "face", "vertex_index", readFaceCb, &face, 0 );
+        }
+
+        if ( point )
+        {
+            ply_set_read_cb( ply, "point", "x", readVertexCb, &point, 0 );
+            ply_set_read_cb( ply, "point", "y", readVertexCb, &point, 0 );
+            ply_set_read_cb( ply, "point", "z", readVertexCb, &point, 1 );
+        }
+        if ( point_color )
+        {
+            ply_set_read_cb( ply, "point", "red",   readColorCb,  &point_color,  0 );
+            ply_set_read_cb( ply, "point", "green", readColorCb,  &point_color,  0 );
+            ply_set_read_cb( ply, "point", "blue",  readColorCb,  &point_color,  1 );
+        }
+        if ( point_confidence )
+        {
+            ply_set_read_cb( ply, "point", "confidence", readVertexCb, &point_confidence, 1 );
+        }
+        if ( point_intensity )
+        {
+            ply_set_read_cb( ply, "point", "intensity", readVertexCb, &point_intensity, 1 );
+        }
+        if ( point_normal )
+        {
+            ply_set_read_cb( ply, "point", "nx", readVertexCb, &point_normal, 0 );
+            ply_set_read_cb( ply, "point", "ny", readVertexCb, &point_normal, 0 );
+            ply_set_read_cb( ply, "point", "nz", readVertexCb, &point_normal, 1 );
+        }
+        if ( point_panorama_coords )
+        {
+            ply_set_read_cb( ply, "point", "x_coords", readPanoramaCoordCB, &point_panorama_coords, 0 );
+            ply_set_read_cb( ply, "point", "y_coords", readPanoramaCoordCB, &point_panorama_coords, 1 );
+        }
+
+        /* Read ply file. */
+        if ( !ply_read( ply ) )
+        {
+            std::cerr << timestamp << "Could not read »" << filename << "«."
+                << std::endl;
+        }
     }
 
     /* Check if we got only vertices and neither points nor faces. If that is
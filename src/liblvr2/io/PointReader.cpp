@@ -0,0 +1,223 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file       PointReader.cpp
+ * @brief      Pull based interface to read point clouds in chunks.
+ */
+
+#include <lvr2/io/PointReader.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace lvr2
+{
+
+size_t PointReader::readChunk(PointBufferPtr chunk, size_t n)
+{
+    // Reuse the arrays of the previous chunk if they are large enough
+    floatArr points;
+    ucharArr colors;
+    floatArr normals;
+    floatArr intensities;
+
+    if(chunk->numPoints() >= n)
+    {
+        unsigned w = 0;
+        size_t numIntensities = 0;
+        points = chunk->getPointArray();
+        colors = chunk->getColorArray(w);
+        if(w != 3)
+        {
+            colors.reset();
+        }
+        normals = chunk->getNormalArray();
+        intensities = chunk->getFloatArray("intensities", numIntensities, w);
+        if(numIntensities < n || w != 1)
+        {
+            intensities.reset();
+        }
+    }
+
+    if(!points)
+    {
+        points = floatArr(new float[3 * n]);
+    }
+    if(hasColors() && !colors)
+    {
+        colors = ucharArr(new unsigned char[3 * n]);
+    }
+    if(hasNormals() && !normals)
+    {
+        normals = floatArr(new float[3 * n]);
+    }
+    if(hasIntensities() && !intensities)
+    {
+        intensities = floatArr(new float[n]);
+    }
+
+    // Channels can't be replaced, so start over with an empty buffer
+    *chunk = PointBuffer();
+
+    size_t numRead = readPoints(
+            n,
+            points.get(),
+            hasColors() ? colors.get() : 0,
+            hasNormals() ? normals.get() : 0,
+            hasIntensities() ? intensities.get() : 0);
+
+    if(numRead == 0)
+    {
+        return 0;
+    }
+
+    chunk->setPointArray(points, numRead);
+    if(hasColors())
+    {
+        chunk->setColorArray(colors, numRead);
+    }
+    if(hasNormals())
+    {
+        chunk->setNormalArray(normals, numRead);
+    }
+    if(hasIntensities())
+    {
+        chunk->addFloatChannel(intensities, "intensities", numRead, 1);
+    }
+    addAtomics(*chunk);
+
+    return numRead;
+}
+
+BoundingBox<BaseVector<float> > PointReader::getBoundingBox()
+{
+    BoundingBox<BaseVector<float> > bb;
+
+    const size_t blockSize = 1 << 20;
+    std::vector<float> points(3 * blockSize);
+
+    rewind();
+    size_t n;
+    while((n = readPoints(blockSize, points.data(), 0, 0, 0)) > 0)
+    {
+        for(size_t i = 0; i < n; i++)
+        {
+            bb.expand(BaseVector<float>(points[3 * i], points[3 * i + 1], points[3 * i + 2]));
+        }
+    }
+    rewind();
+
+    return bb;
+}
+
+ModelPointReader::ModelPointReader(PointBufferPtr buffer)
+    : m_buffer(buffer), m_numPoints(0), m_position(0)
+{
+    if(m_buffer)
+    {
+        unsigned w = 0;
+        size_t n = 0;
+        m_numPoints = m_buffer->numPoints();
+        m_points = m_buffer->getPointArray();
+        m_colors = m_buffer->getColorArray(w);
+        if(w != 3)
+        {
+            m_colors.reset();
+        }
+        if(m_buffer->hasNormals())
+        {
+            m_normals = m_buffer->getNormalArray();
+        }
+        m_intensities = m_buffer->getFloatArray("intensities", n, w);
+        if(n != m_numPoints || w != 1)
+        {
+            m_intensities.reset();
+        }
+    }
+}
+
+size_t ModelPointReader::numPoints() const
+{
+    return m_numPoints;
+}
+
+bool ModelPointReader::hasColors() const
+{
+    return (bool)m_colors;
+}
+
+bool ModelPointReader::hasNormals() const
+{
+    return (bool)m_normals;
+}
+
+bool ModelPointReader::hasIntensities() const
+{
+    return (bool)m_intensities;
+}
+
+void ModelPointReader::rewind()
+{
+    m_position = 0;
+}
+
+size_t ModelPointReader::readPoints(
+        size_t n,
+        float* points,
+        unsigned char* colors,
+        float* normals,
+        float* intensities)
+{
+    if(!m_points)
+    {
+        return 0;
+    }
+
+    size_t num = std::min(n, m_numPoints - m_position);
+    size_t first = m_position;
+
+    memcpy(points, m_points.get() + 3 * first, 3 * num * sizeof(float));
+    if(colors && m_colors)
+    {
+        memcpy(colors, m_colors.get() + 3 * first, 3 * num);
+    }
+    if(normals && m_normals)
+    {
+        memcpy(normals, m_normals.get() + 3 * first, 3 * num * sizeof(float));
+    }
+    if(intensities && m_intensities)
+    {
+        memcpy(intensities, m_intensities.get() + first, num * sizeof(float));
+    }
+
+    m_position += num;
+    return num;
+}
+
+} // namespace lvr2
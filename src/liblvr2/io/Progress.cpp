@@ -34,9 +34,11 @@
 
 
 #include <lvr2/io/Progress.hpp>
+#include <lvr2/config/lvropenmp.hpp>
 
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 
 using std::stringstream;
 using std::cout;
@@ -46,15 +48,83 @@ using std::flush;
 namespace lvr2
 {
 
+namespace
+{
+
+/// Returns the smallest counter value for which val * 100 / max >= percent
+size_t valueForPercent(size_t max, int percent)
+{
+    if(max == 0)
+    {
+        return 1;
+    }
+    return (percent * max + 99) / 100;
+}
+
+} // anonymous namespace
+
+ThreadProgress::ThreadProgress(size_t max_val)
+{
+    m_numSlots = std::max(OpenMPConfig::getNumThreads(), 1);
+    m_slots.reset(new Slot[m_numSlots]);
+    for(size_t i = 0; i < m_numSlots; i++)
+    {
+        m_slots[i].count = 0;
+    }
+
+    // All slots together keep back less than one percent
+    m_step = std::max<size_t>(max_val / (100 * m_numSlots), 1);
+    m_finalVal = max_val - std::min(max_val, m_numSlots * m_step);
+    m_draining = false;
+}
+
+size_t ThreadProgress::add(size_t n, size_t published)
+{
+    // Threads outside of OpenMP regions may share a slot, so the count
+    // is taken with an exchange
+    Slot& slot = m_slots[OpenMPConfig::getThreadNum() % m_numSlots];
+    size_t count = slot.count.fetch_add(n, std::memory_order_relaxed) + n;
+
+    if(published >= m_finalVal)
+    {
+        // The kept back iterations may complete the last percentage. Hand
+        // over the slots of threads that are already done once, and every
+        // further iteration right away.
+        if(!m_draining.exchange(true))
+        {
+            return flush();
+        }
+        return slot.count.exchange(0, std::memory_order_relaxed);
+    }
+
+    if(count < m_step)
+    {
+        return 0;
+    }
+    return slot.count.exchange(0, std::memory_order_relaxed);
+}
+
+size_t ThreadProgress::flush()
+{
+    size_t n = 0;
+    for(size_t i = 0; i < m_numSlots; i++)
+    {
+        n += m_slots[i].count.exchange(0, std::memory_order_relaxed);
+    }
+    return n;
+}
+
 ProgressCallbackPtr ProgressBar::m_progressCallback = 0;
 ProgressTitleCallbackPtr ProgressBar::m_titleCallback = 0;
 
 ProgressBar::ProgressBar(size_t max_val, string prefix)
+    : m_threadVal(max_val)
 {
 	m_prefix = prefix;
 	m_maxVal = max_val;
     m_currentVal = 0;
 	m_percent = 0;
+    m_nextVal = valueForPercent(m_maxVal, 1);
 
 	if(m_titleCallback)
 	{
@@ -67,7 +137,9 @@ ProgressBar::ProgressBar(size_t max_val, string prefix)
 
 ProgressBar::~ProgressBar()
 {
-
+    // Only prints if iterations were kept back until now, which happens
+    // if the loop ended before max_val iterations
+    publish(m_threadVal.flush());
 }
 
 void ProgressBar::setProgressCallback(ProgressCallbackPtr ptr)
@@ -82,44 +154,37 @@ void ProgressBar::setProgressTitleCallback(ProgressTitleCallbackPtr ptr)
 
 void ProgressBar::operator++()
 {
-    boost::mutex::scoped_lock lock(m_mutex);
+    publish(m_threadVal.add(1, m_currentVal.load(std::memory_order_relaxed)));
+}
+
+void ProgressBar::operator+=(size_t n)
+{
+    publish(m_threadVal.add(n, m_currentVal.load(std::memory_order_relaxed)));
+}
 
-    m_currentVal++;
-    short difference = (short)((float)m_currentVal/m_maxVal * 100 - m_percent);
-    if (difference < 1)
+void ProgressBar::publish(size_t n)
+{
+    if(n == 0)
     {
         return;
     }
 
-    while (difference >= 1)
+    size_t val = m_currentVal.fetch_add(n, std::memory_order_relaxed) + n;
+    if(val >= m_nextVal.load(std::memory_order_relaxed))
     {
-        m_percent++;
-        difference--;
-        print_bar();
-
-        if(m_progressCallback)
-        {
-        	m_progressCallback(m_percent);
-        }
+        update(val);
     }
-
 }
 
-void ProgressBar::operator+=(size_t n)
+void ProgressBar::update(size_t val)
 {
     boost::mutex::scoped_lock lock(m_mutex);
 
-    m_currentVal+= n;
-    short difference = (short)((float)m_currentVal/m_maxVal * 100 - m_percent);
-    if (difference < 1)
-    {
-        return;
-    }
-
-    while (difference >= 1)
+    // Another thread may already have printed a larger value
+    int percent = m_maxVal ? (int)(val * 100 / m_maxVal) : 100;
+    while (m_percent < percent)
     {
         m_percent++;
-        difference--;
         print_bar();
 
         if(m_progressCallback)
@@ -128,6 +193,7 @@ void ProgressBar::operator+=(size_t n)
         }
     }
 
+    m_nextVal.store(std::max(valueForPercent(m_maxVal, m_percent + 1), val + 1), std::memory_order_relaxed);
 }
 
 void ProgressBar::print_bar()
@@ -144,17 +210,17 @@ ProgressCounter::ProgressCounter(int stepVal, string prefix)
 
 void ProgressCounter::operator++()
 {
-	boost::mutex::scoped_lock lock(m_mutex);
-	m_currentVal++;
-	if(m_currentVal % m_stepVal == 0)
+	size_t val = m_currentVal.fetch_add(1, std::memory_order_relaxed) + 1;
+	if(val % m_stepVal == 0)
 	{
-		print_progress();
+		boost::mutex::scoped_lock lock(m_mutex);
+		print_progress(val);
 	}
 }
 
-void ProgressCounter::print_progress()
+void ProgressCounter::print_progress(size_t val)
 {
-	cout << "\r" << m_prefix << " " << m_currentVal << flush;
+	cout << "\r" << m_prefix << " " << val << flush;
 }
 
 PacmanProgressCallbackPtr PacmanProgressBar::m_progressCallback = 0;
@@ -163,11 +229,13 @@ PacmanProgressTitleCallbackPtr PacmanProgressBar::m_titleCallback = 0;
 PacmanProgressBar::PacmanProgressBar(size_t max_val, string prefix, size_t bar_length)
 :
 	m_prefix(prefix)
+	,m_threadVal(max_val)
 	,m_bar_length(bar_length)
 {
 	m_maxVal = max_val;
     m_currentVal = 0;
 	m_percent = 0;
+    m_nextVal = valueForPercent(m_maxVal, 1);
 
 	if(m_titleCallback)
 	{
@@ -180,7 +248,8 @@ PacmanProgressBar::PacmanProgressBar(size_t max_val, string prefix, size_t bar_l
 
 PacmanProgressBar::~PacmanProgressBar()
 {
-
+    // Only prints if iterations were kept back until now
+    publish(m_threadVal.flush());
 }
 
 void PacmanProgressBar::setProgressCallback(ProgressCallbackPtr ptr)
@@ -195,20 +264,32 @@ void PacmanProgressBar::setProgressTitleCallback(ProgressTitleCallbackPtr ptr)
 
 void PacmanProgressBar::operator++()
 {
-    boost::mutex::scoped_lock lock(m_mutex);
-
-    m_currentVal++;
-    short difference = (short)((float)m_currentVal/m_maxVal * 100 - m_percent);
+    publish(m_threadVal.add(1, m_currentVal.load(std::memory_order_relaxed)));
+}
 
-	if (difference < 1)
+void PacmanProgressBar::publish(size_t n)
+{
+    if(n == 0)
     {
         return;
     }
 
-    while (difference >= 1)
+    size_t val = m_currentVal.fetch_add(n, std::memory_order_relaxed) + n;
+    if(val >= m_nextVal.load(std::memory_order_relaxed))
+    {
+        update(val);
+    }
+}
+
+void PacmanProgressBar::update(size_t val)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    // Another thread may already have printed a larger value
+    int percent = m_maxVal ? (int)(val * 100 / m_maxVal) : 100;
+    while (m_percent < percent)
     {
         m_percent++;
-        difference--;
         print_bar();
 
         if(m_progressCallback)
@@ -217,6 +298,7 @@ void PacmanProgressBar::operator++()
         }
     }
 
+    m_nextVal.store(std::max(valueForPercent(m_maxVal, m_percent + 1), val + 1), std::memory_order_relaxed);
 }
 
 void PacmanProgressBar::print_bar()
@@ -265,7 +265,9 @@ ModelPtr ScanprojectIO::read(std::string dir)
         return ModelPtr();
     }
 
-    return UosIO().read(project.scans_dir.string());
+    UosIO uosIO;
+    uosIO.setScanReduction(m_scanReduction);
+    return uosIO.read(project.scans_dir.string());
 }
 
 void ScanprojectIO::save(std::string dir)
@@ -43,6 +43,8 @@
 #include <cmath>
 #include <fstream>
 #include <sstream>
+#include <cstring>
+#include <algorithm>
 
 using std::list;
 using std::vector;
@@ -55,6 +57,8 @@ using std::stringstream;
 
 #include <lvr2/io/Progress.hpp>
 #include <lvr2/io/Timestamp.hpp>
+#include <lvr2/io/PointReader.hpp>
+#include <lvr2/config/lvropenmp.hpp>
 
 namespace lvr2
 {
@@ -202,330 +206,381 @@ void UosIO::reduce(string dir, string target, int reduction)
 }
 
 
-void UosIO::readNewFormat(ModelPtr &model, string dir, int first, int last, size_t &n)
+namespace
 {
-    list<Vec > allPoints;
-    list<BaseVector<int> > allColors;
-
-    size_t point_counter = 0;
 
-    vector<indexPair> sub_clouds;
+/// A scan in new UOS format and the slice of the result buffers it is read into
+struct UosScan
+{
+    string          filename;
+    int             number;
+    int             rPos;
+    int             iPos;
+    size_t          numLines;
+    size_t          offset;
+    size_t          numPoints;
+};
+
+} // anonymous namespace
+
+Matrix4<Vec> UosIO::readScanTransform(string dir, int scan)
+{
+    // Try to get transformation from .frames file
+    boost::filesystem::path frame_path(
+            boost::filesystem::path(dir) /
+            boost::filesystem::path( "scan" + to_string( scan, 3 ) + ".frames" ) );
 
-    // Count points in all given files
-    size_t numPointsTotal = 0;
-    for(int fileCounter = first; fileCounter <= last; fileCounter++)
+    ifstream frame_in(frame_path.string().c_str());
+    if(frame_in.good())
     {
-        // Create scan file name
-        boost::filesystem::path scan_path(
-                boost::filesystem::path(dir) /
-                boost::filesystem::path( "scan" + to_string( fileCounter, 3 ) + ".3d" ) );
-        string scanFileName = "/" + scan_path.relative_path().string();
-
-        // Count lines in scan
-        numPointsTotal += AsciiIO::countLines(scanFileName);
+        return parseFrameFile(frame_in);
     }
 
-    // Calculate the number of points to skip when writing to disk
-    size_t skipPoints = 1;
+    // Try to parse .pose file
+    boost::filesystem::path pose_path(
+            boost::filesystem::path(dir) /
+            boost::filesystem::path( "scan" + to_string( scan, 3 ) + ".pose" ) );
 
-    if(m_reductionTarget > 1)
+    ifstream pose_in(pose_path.string().c_str());
+    if(pose_in.good())
     {
-        skipPoints = (int)numPointsTotal / m_reductionTarget;
-    }
+        float euler[6];
+        for(int i = 0; i < 6; i++) pose_in >> euler[i];
 
-    if(m_saveToDisk)
-    {
-        cout << timestamp << "Reduction mode. Writing every " << skipPoints << "th point." << endl;
+        euler[3] *= 0.017453293;
+        euler[4] *= 0.017453293;
+        euler[5] *= 0.017453293;
+
+        Vec position(euler[0], euler[1], euler[2]);
+        Vec angle(euler[3], euler[4], euler[5]);
+
+        return Matrix4<Vec>(position, angle);
     }
 
+    // Called for all scans in parallel
+    #pragma omp critical
+    cout << timestamp << "UOS Reader: Warning: No position information found for scan "
+         << scan << "." << endl;
+    return Matrix4<Vec>();
+}
+
+void UosIO::readNewFormat(ModelPtr &model, string dir, int first, int last, size_t &n)
+{
+    vector<UosScan> scans;
     for(int fileCounter = first; fileCounter <= last; fileCounter++)
     {
-        // New (unit) transformation matrix
-        Matrix4<Vec> tf;
-
-        // Input file streams for scan data, poses and frames
-        ifstream scan_in, pose_in, frame_in;
-
         // Create scan file name
         boost::filesystem::path scan_path(
                 boost::filesystem::path(dir) /
                 boost::filesystem::path( "scan" + to_string( fileCounter, 3 ) + ".3d" ) );
-        string scanFileName = scan_path.string();
 
-        // Count lines in scan
-        size_t points_in_file = AsciiIO::countLines(scanFileName);
+        if(!boost::filesystem::exists(scan_path))
+        {
+            // Continue with next file if the expected file couldn't be read
+            cout << timestamp << "UOS Reader: Unable to read scan " << scan_path.string() << endl;
+            continue;
+        }
+
+        UosScan scan;
+        scan.filename = scan_path.string();
+        scan.number = fileCounter;
+        scan.numLines = 0;
+        scan.offset = 0;
+        scan.numPoints = 0;
+        scans.push_back(scan);
+    }
+
+    // Scans are handled one after another if there are too few of them
+    // to keep all threads busy. The reader of each scan then parses in
+    // parallel itself.
+    bool parallelScans = scans.size() >= (size_t)OpenMPConfig::getNumThreads();
+
+    // Detect the attributes and count the lines of all scans. Colors and
+    // intensities are only kept if every scan provides them.
+    bool hasColors = true;
+    bool hasIntensities = true;
+
+    #pragma omp parallel for schedule(dynamic) reduction(&&:hasColors,hasIntensities) if(parallelScans)
+    for(long i = 0; i < (long)scans.size(); i++)
+    {
+        UosScan& scan = scans[i];
 
-        int num_attributes = AsciiIO::getEntriesInLine(scanFileName) - 3;
+        // Attributes are stored as "x y z [rem] [r g b]"
+        int num_attributes = AsciiIO::getEntriesInLine(scan.filename) - 3;
         bool has_color = (num_attributes == 3) || (num_attributes == 4);
         bool has_intensity = (num_attributes == 1) || (num_attributes == 4);
 
-        if(has_color)
-        {
-            cout << timestamp << "Reading color information." << endl;
-        }
+        scan.iPos = has_intensity ? 3 : -1;
+        scan.rPos = has_color ? (has_intensity ? 4 : 3) : -1;
 
-        if(has_intensity)
+        hasColors = hasColors && has_color;
+        hasIntensities = hasIntensities && has_intensity;
+
+        AsciiIO io;
+        PointReaderPtr reader = io.openPointReader(scan.filename, 0, 1, 2);
+        if(reader)
         {
-            cout << timestamp << "Reading intensity information." << endl;
+            scan.numLines = reader->numPoints();
         }
+    }
 
-        // Read scan data
-        scan_in.open(scanFileName.c_str());
-        if(!scan_in.good())
+    size_t numPointsTotal = 0;
+    for(size_t i = 0; i < scans.size(); i++)
+    {
+        numPointsTotal += scans[i].numLines;
+    }
+
+    size_t reduction = m_scanReduction;
+
+    // Calculate the number of points to skip when writing to disk
+    if(m_saveToDisk)
+    {
+        size_t skipPoints = 1;
+        if(m_reductionTarget > 1 && numPointsTotal / m_reductionTarget > 1)
         {
-            // Continue with next file if the expected file couldn't be read
-            cout << timestamp << "UOS Reader: Unable to read scan " << scanFileName << endl;
-            scan_in.close();
-            scan_in.clear();
-            continue;
+            skipPoints = numPointsTotal / m_reductionTarget;
         }
-        else
-        {
-            // Tmp list of read points
-            list<Vec > tmp_points;
+        reduction = skipPoints;
 
+        cout << timestamp << "Reduction mode. Writing every " << skipPoints << "th point." << endl;
+    }
+    else if(reduction > 1)
+    {
+        cout << timestamp << "UOS Reader: Reading every " << reduction << "th point." << endl;
+    }
 
-            // Try to get fransformation from .frames file
-            boost::filesystem::path frame_path(
-                    boost::filesystem::path(dir) /
-                    boost::filesystem::path( "scan" + to_string( fileCounter, 3 ) + ".frames" ) );
-            string frameFileName = frame_path.string();
+    // Reserve a slice of the result buffers for each scan
+    size_t maxPoints = 0;
+    for(size_t i = 0; i < scans.size(); i++)
+    {
+        scans[i].offset = maxPoints;
+        maxPoints += (scans[i].numLines + reduction - 1) / reduction;
+    }
 
-            frame_in.open(frameFileName.c_str());
-            if(!frame_in.good())
-            {
-                // Try to parse .pose file
-                boost::filesystem::path pose_path(
-                        boost::filesystem::path(dir) /
-                        boost::filesystem::path( "scan" + to_string( fileCounter, 3 ) + ".pose" ) );
-                string poseFileName = pose_path.string();
-
-                pose_in.open(poseFileName.c_str());
-                if(pose_in.good())
-                {
-                    float euler[6];
-                    for(int i = 0; i < 6; i++) pose_in >> euler[i];
+    if(maxPoints == 0)
+    {
+        return;
+    }
 
-                    euler[3] *= 0.017453293;
-                    euler[4] *= 0.017453293;
-                    euler[5] *= 0.017453293;
+    if(hasColors)
+    {
+        cout << timestamp << "Reading color information." << endl;
+    }
 
-                    Vec position(euler[0], euler[1], euler[2]);
-                    Vec angle(euler[3], euler[4], euler[5]);
+    if(hasIntensities)
+    {
+        cout << timestamp << "Reading intensity information." << endl;
+    }
 
-                    tf = Matrix4<Vec>(position, angle);
-                }
-                else
-                {
-                    cout << timestamp << "UOS Reader: Warning: No position information found." << endl;
-                    tf = Matrix4<Vec>();
-                }
+    floatArr points(new float[3 * maxPoints]);
+    ucharArr pointColors;
+    floatArr pointIntensities;
 
-            }
-            else
-            {
-                // Use transformation from .frame files
-                tf = parseFrameFile(frame_in);
+    if(hasColors)
+    {
+        pointColors = ucharArr(new unsigned char[3 * maxPoints]);
+    }
 
-            }
+    if(hasIntensities)
+    {
+        pointIntensities = floatArr(new float[maxPoints]);
+    }
 
-            // Print pose information
-            float euler[6];
-            tf.toPostionAngle(euler);
+    // Parse and transform all scans into their slices
+    string comment = timestamp.getElapsedTime() + "Reading scans in " + dir;
+    ProgressBar progress(scans.size(), comment);
 
-            cout << timestamp << "Processing " << scanFileName << " @ "
-                << euler[0] << " " << euler[1] << " " << euler[2] << " "
-                << euler[3] << " " << euler[4] << " " << euler[5] << endl;
+    #pragma omp parallel for schedule(dynamic) if(parallelScans)
+    for(long i = 0; i < (long)scans.size(); i++)
+    {
+        UosScan& scan = scans[i];
+        if(scan.numLines == 0)
+        {
+            ++progress;
+            continue;
+        }
 
-            // Skip first line in scan file (maybe metadata)
-            char dummy[1024];
-            scan_in.getline(dummy, 1024);
+        Matrix4<Vec> tf = readScanTransform(dir, scan.number);
 
-            // Setup info output
-            string comment = timestamp.getElapsedTime() + "Reading file " + scanFileName;
-            ProgressBar progress(points_in_file, comment);
+        AsciiIO io;
+        PointReaderPtr reader = io.openPointReader(
+                scan.filename, 0, 1, 2,
+                hasColors ? scan.rPos : -1,
+                hasColors ? scan.rPos + 1 : -1,
+                hasColors ? scan.rPos + 2 : -1,
+                hasIntensities ? scan.iPos : -1);
 
-            // Read all points
-            while(scan_in.good())
-            {
-                float x, y, z, rem, dummy;
-                int r, g, b;
+        float* scanPoints = points.get() + 3 * scan.offset;
+        unsigned char* scanColors = hasColors ? pointColors.get() + 3 * scan.offset : 0;
+        float* scanIntensities = hasIntensities ? pointIntensities.get() + scan.offset : 0;
 
-                point_counter ++;
+        // Index of the next point in the scan, used for reduction
+        size_t index = 0;
 
-                if(has_intensity && !has_color)
-                {
-                    scan_in >> x >> y >> z >> rem;
-                }
-                else if(has_intensity && has_color)
-                {
-                    scan_in >> x >> y >> z >> rem >> r >> g >> b;
-                    allColors.push_back(BaseVector<int> (r, g, b));
-                }
-                else if(has_color && !has_intensity)
-                {
-                    scan_in >> x >> y >> z >> r >> g >> b;
-                    allColors.push_back(BaseVector<int> (r, g, b));
-                }
-                else
+        PointBufferPtr chunk(new PointBuffer);
+        size_t numRead;
+        while(reader && (numRead = reader->readChunk(chunk, 1 << 20)) > 0)
+        {
+            unsigned w;
+            size_t numIntensities;
+            floatArr chunkPoints = chunk->getPointArray();
+            ucharArr chunkColors = chunk->getColorArray(w);
+            floatArr chunkIntensities = chunk->getFloatArray("intensities", numIntensities, w);
+
+            for(size_t j = 0; j < numRead; j++, index++)
+            {
+                if(index % reduction)
                 {
-                    scan_in >> x >> y >> z;
-                    for(int n_dummys = 0; n_dummys < num_attributes; n_dummys++) scan_in >> dummy;
+                    continue;
                 }
 
-                BaseVector<float> point(x, y, z);
-                BaseVector<unsigned char> color;
+                Vec v(chunkPoints[3 * j], chunkPoints[3 * j + 1], chunkPoints[3 * j + 2]);
+                v = tf * v;
+
+                size_t k = scan.numPoints++;
+                scanPoints[3 * k    ] = v[0];
+                scanPoints[3 * k + 1] = v[1];
+                scanPoints[3 * k + 2] = v[2];
 
-                // Code branching for point converter!
-                if(!m_saveToDisk)
+                if(scanColors)
                 {
-                    tmp_points.push_back(point);
+                    scanColors[3 * k    ] = chunkColors[3 * j    ];
+                    scanColors[3 * k + 1] = chunkColors[3 * j + 1];
+                    scanColors[3 * k + 2] = chunkColors[3 * j + 2];
                 }
-                else
+
+                if(scanIntensities)
                 {
-                    if(m_outputFile.good())
-                    {
-                        if(point_counter % skipPoints == 0)
-                        {
-                            point = tf * point;
-                            m_outputFile << point[0] << " " << point[1] << " " << point[2] << " ";
-
-                            // Save remission values if present
-                            if(has_intensity && m_saveRemission)
-                            {
-                                m_outputFile << rem << " ";
-                            }
-
-                            // Save color values if present
-                            if(has_color)
-                            {
-                                m_outputFile << r << " " << g << " " << b;
-                            }
-                            else if(m_saveRemissionColor)
-                            {
-                                r = g = b = rem;
-                                m_outputFile << r << " " << g << " " << b;
-                            }
-                            m_outputFile << endl;
-                        }
-                    }
+                    scanIntensities[k] = chunkIntensities[j];
                 }
-                ++progress;
             }
+        }
+        ++progress;
+    }
+    cout << endl;
 
-            // Save index of first point of new scan
-            size_t firstIndex;
-            if(allPoints.size() > 0)
+    // Close the gaps left by skipped lines and save the index range of
+    // each scan
+    vector<indexPair> sub_clouds;
+    size_t numPoints = 0;
+    for(size_t i = 0; i < scans.size(); i++)
+    {
+        const UosScan& scan = scans[i];
+        if(scan.numPoints == 0)
+        {
+            continue;
+        }
+
+        if(scan.offset != numPoints)
+        {
+            memmove(points.get() + 3 * numPoints, points.get() + 3 * scan.offset,
+                    3 * scan.numPoints * sizeof(float));
+            if(hasColors)
             {
-                firstIndex = allPoints.size();
+                memmove(pointColors.get() + 3 * numPoints, pointColors.get() + 3 * scan.offset,
+                        3 * scan.numPoints);
             }
-            else
+            if(hasIntensities)
             {
-                firstIndex = 0;
+                memmove(pointIntensities.get() + numPoints, pointIntensities.get() + scan.offset,
+                        scan.numPoints * sizeof(float));
             }
+        }
 
-            // Transform scan point with current matrix
-            list<Vec >::iterator it, it1;
-            for(it = tmp_points.begin(); it != tmp_points.end(); it++)
-            {
-                Vec v = *it;
-                v = tf * v;
-                allPoints.push_back(v);
-            }
+        sub_clouds.push_back(make_pair(numPoints, numPoints + scan.numPoints - 1));
+        numPoints += scan.numPoints;
+        m_numScans++;
+    }
 
-            // Save last index
-            size_t lastIndex;
-            if(allPoints.size() > 0)
-            {
-                lastIndex = allPoints.size() - 1;
-            }
-            else
-            {
-                lastIndex = 0;
-            }
+    if(numPoints == 0)
+    {
+        return;
+    }
 
-            // Save index pair for current scan
-            sub_clouds.push_back(make_pair(firstIndex, lastIndex));
-            m_numScans++;
-        }
-        cout << endl;
+    cout << timestamp << "UOS Reader: Read " << numPoints << " points from "
+         << sub_clouds.size() << " scans." << endl;
+
+    // Create point cloud in model
+    n = numPoints;
+    model = ModelPtr( new Model );
+    model->m_pointCloud = PointBufferPtr( new PointBuffer );
+    model->m_pointCloud->setPointArray( points, numPoints );
+
+    if(hasColors)
+    {
+        model->m_pointCloud->setColorArray(pointColors, numPoints);
     }
 
-    // Convert into array
-    if ( allPoints.size() )
+    if(hasIntensities)
     {
-        cout << timestamp << "UOS Reader: Read " << allPoints.size() << " points." << endl;
+        model->m_pointCloud->addFloatChannel(pointIntensities, "intensities", numPoints, 1);
+    }
 
-        // Save position information
+    // Add sub cloud information
+    indexArray sub_clouds_array = indexArray( new unsigned int[sub_clouds.size() * 2] );
+    for(size_t i = 0; i < sub_clouds.size(); i++)
+    {
+        sub_clouds_array[i*2 + 0] = sub_clouds[i].first;
+        sub_clouds_array[i*2 + 1] = sub_clouds[i].second;
+    }
+    model->m_pointCloud->addIndexChannel(sub_clouds_array, "sub_clouds", sub_clouds.size(), 2);
+
+    if(m_saveToDisk)
+    {
+        writeReduced(model->m_pointCloud);
+    }
+}
 
-        size_t numPoints(0);
-        floatArr points;
-        ucharArr pointColors;
+void UosIO::writeReduced(PointBufferPtr buffer)
+{
+    if(!m_outputFile.good())
+    {
+        return;
+    }
 
+    size_t n = buffer->numPoints();
+    unsigned w;
+    size_t numIntensities = 0;
+    floatArr points = buffer->getPointArray();
+    ucharArr colors = buffer->getColorArray(w);
+    floatArr intensities = buffer->getFloatArray("intensities", numIntensities, w);
 
-        numPoints = allPoints.size();
-        points = floatArr( new float[3 * allPoints.size()] );
-        list<Vec >::iterator p_it;
-        size_t i(0);
-        for( p_it = allPoints.begin(); p_it != allPoints.end(); p_it++ )
-        {
-            Vec v = *p_it;
-            points[i    ] = v[0];
-            points[i + 1] = v[1];
-            points[i + 2] = v[2];
-            i += 3;
-        }
+    for(size_t i = 0; i < n; i++)
+    {
+        m_outputFile << points[3 * i] << " " << points[3 * i + 1] << " " << points[3 * i + 2] << " ";
 
-        // Save color information
-        if ( allColors.size() )
+        // Save remission values if present
+        if(intensities && m_saveRemission)
         {
-            pointColors = ucharArr( new unsigned char[ 3 * numPoints ] );
-            i = 0;
-            list<BaseVector<int>>::iterator c_it;
-            for(c_it = allColors.begin(); c_it != allColors.end(); c_it++)
-            {
-                BaseVector<int> v = *c_it;
-                pointColors[i    ] = (unsigned char) v[0];
-                pointColors[i + 1] = (unsigned char) v[1];
-                pointColors[i + 2] = (unsigned char) v[2];
-                i += 3;
-            }
+            m_outputFile << intensities[i] << " ";
         }
 
-        // Create point cloud in model
-        model = ModelPtr( new Model );
-        model->m_pointCloud = PointBufferPtr( new PointBuffer );
-        model->m_pointCloud->setPointArray( points, numPoints );
-
-        if (allColors.size())
+        // Save color values if present
+        if(colors)
         {
-            model->m_pointCloud->setColorArray(pointColors, numPoints);
+            m_outputFile << (int)colors[3 * i] << " " << (int)colors[3 * i + 1] << " " << (int)colors[3 * i + 2];
         }
-
-        // Add sub cloud information
-        if (sub_clouds.size())
+        else if(intensities && m_saveRemissionColor)
         {
-            indexArray sub_clouds_array = indexArray( new unsigned int[sub_clouds.size() * 2] );
-            for(size_t i = 0; i < sub_clouds.size(); i++)
-            {
-                sub_clouds_array[i*2 + 0] = sub_clouds[i].first;
-                sub_clouds_array[i*2 + 1] = sub_clouds[i].second;
-            }
-
-            model->m_pointCloud->addIndexChannel(sub_clouds_array, "sub_clouds", numPoints, 2);
+            int r = intensities[i];
+            m_outputFile << r << " " << r << " " << r;
         }
+        m_outputFile << endl;
     }
-
 }
 
 void UosIO::readOldFormat(ModelPtr &model, string dir, int first, int last, size_t &n)
 {
-    Matrix4<Vec> m_tf;
+    // Transformed points of each scan position, read in parallel
+    vector<vector<float> > scanPoints(last - first + 1);
 
-    list<Vec > ptss;
-    list<Vec > allPoints;
-    for(int fileCounter = first; fileCounter <= last; fileCounter++)
+    #pragma omp parallel for schedule(dynamic)
+    for(long s = 0; s < (long)scanPoints.size(); s++)
     {
+        int fileCounter = first + s;
+        vector<float>& ptss = scanPoints[s];
+
+        Matrix4<Vec> m_tf;
         float euler[6];
         ifstream scan_in, pose_in, frame_in;
 
@@ -539,15 +594,15 @@ void UosIO::readOldFormat(ModelPtr &model, string dir, int first, int last, size
                 boost::filesystem::path( to_string( fileCounter, 3 ) ) /
                 boost::filesystem::path( "position.dat" ) );
 
-        // Get file name (if some knows a more elegant way to
-        // extract the pull path let me know
-        poseFileName = "/" + p.relative_path().string();
+        poseFileName = p.string();
 
         // Try to open file
         pose_in.open(poseFileName.c_str());
 
         // Abort if opening failed and try with next die
         if (!pose_in.good()) continue;
+
+        #pragma omp critical
         cout << timestamp << "Processing Scan " << dir << "/" << to_string(fileCounter, 3) << endl;
 
         // Extract pose information
@@ -563,6 +618,9 @@ void UosIO::readOldFormat(ModelPtr &model, string dir, int first, int last, size
             euler[i] = rad(euler[i]);
         }
 
+        // Index of the next point of this position, used for reduction
+        size_t index = 0;
+
         // Read and convert scan
         for (int i = 1; ; i++) {
             //scanFileName = dir + to_string(fileCounter, 3) + "/scan" + to_string(i,3) + ".dat";
@@ -571,7 +629,7 @@ void UosIO::readOldFormat(ModelPtr &model, string dir, int first, int last, size
                     boost::filesystem::path(dir) /
                     boost::filesystem::path( to_string( fileCounter, 3 ) ) /
                     boost::filesystem::path( "scan" + to_string(i) + ".dat" ) );
-            scanFileName = "/" + sfile.relative_path().string();
+            scanFileName = sfile.string();
 
             scan_in.open(scanFileName.c_str());
             if (!scan_in.good()) {
@@ -609,7 +667,6 @@ void UosIO::readOldFormat(ModelPtr &model, string dir, int first, int last, size
                 cAngle[6] = firstLine[41];
                 cAngle[7] = 0;
                 current_angle = atof(cAngle);
-                cout << current_angle << endl;
             } else {
                 intensity_flag = 0;
                 char cAngle[8];
@@ -627,7 +684,7 @@ void UosIO::readOldFormat(ModelPtr &model, string dir, int first, int last, size
             double cos_currentAngle = cos(rad(current_angle));
             double sin_currentAngle = sin(rad(current_angle));
 
-            for (int j = 0; j < Nr; j++) {
+            for (int j = 0; j < Nr; j++, index++) {
                 if (!intensity_flag) {
                     scan_in >> X >> Z >> D >> I;
                 } else {
@@ -635,13 +692,12 @@ void UosIO::readOldFormat(ModelPtr &model, string dir, int first, int last, size
                     I = 1.0;
                 }
 
-                // calculate 3D coordinates (local coordinates)
-                Vec p;
-                p[0] = X;
-                p[1] = Z * sin_currentAngle;
-                p[2] = Z * cos_currentAngle;
+                if (index % m_scanReduction) continue;
 
-                ptss.push_back(p);
+                // calculate 3D coordinates (local coordinates)
+                ptss.push_back(X);
+                ptss.push_back(Z * sin_currentAngle);
+                ptss.push_back(Z * cos_currentAngle);
             }
             scan_in.close();
             scan_in.clear();
@@ -654,7 +710,7 @@ void UosIO::readOldFormat(ModelPtr &model, string dir, int first, int last, size
         boost::filesystem::path framePath(
                 boost::filesystem::path(dir) / 
                 boost::filesystem::path("scan" + to_string( fileCounter, 3 ) + ".frames" ) );
-        string frameFileName = "/" + framePath.relative_path().string();
+        string frameFileName = framePath.string();
 
         // Try to open frame file
         frame_in.open(frameFileName.c_str());
@@ -671,35 +727,36 @@ void UosIO::readOldFormat(ModelPtr &model, string dir, int first, int last, size
             m_tf = Matrix4<Vec>(position, angle);
         }
 
-        // Transform points and insert in to global vector
-        list<Vec >::iterator it;
-        for(it = ptss.begin(); it != ptss.end(); it++)
+        // Transform points in place
+        for(size_t i = 0; i < ptss.size(); i += 3)
         {
-            Vec v = *it;
+            Vec v(ptss[i], ptss[i + 1], ptss[i + 2]);
             v = m_tf * v;
-            allPoints.push_back(v);
+            ptss[i    ] = v[0];
+            ptss[i + 1] = v[1];
+            ptss[i + 2] = v[2];
         }
+    }
 
-        // Clear scan
-        ptss.clear();
+    // Compute the slice of each scan position in the result
+    vector<size_t> offsets(scanPoints.size() + 1, 0);
+    for(size_t s = 0; s < scanPoints.size(); s++)
+    {
+        offsets[s + 1] = offsets[s] + scanPoints[s].size() / 3;
     }
 
     // Convert into indexed array
-    if(allPoints.size() > 0)
+    if(offsets.back() > 0)
     {
-        cout << timestamp << "UOS Reader: Read " << allPoints.size() << " points." << endl;
-        n = allPoints.size();
-        floatArr points( new float[3 * allPoints.size()] );
-        list<Vec >::iterator p_it;
-        int i(0);
-        for( p_it = allPoints.begin(); p_it != allPoints.end(); p_it++ )
+        n = offsets.back();
+        cout << timestamp << "UOS Reader: Read " << n << " points." << endl;
+        floatArr points( new float[3 * n] );
+
+        #pragma omp parallel for schedule(dynamic)
+        for(long s = 0; s < (long)scanPoints.size(); s++)
         {
-            int t_index = 3 * i;
-            Vec v = *p_it;
-            points[t_index    ] = v[0];
-            points[t_index + 1] = v[1];
-            points[t_index + 2] = v[2];
-            i++;
+            std::copy(scanPoints[s].begin(), scanPoints[s].end(), points.get() + 3 * offsets[s]);
+            vector<float>().swap(scanPoints[s]);
         }
 
         // Alloc model
@@ -0,0 +1,233 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * PlaneFitting.cpp
+ */
+
+#include <lvr2/reconstruction/PlaneFitting.hpp>
+
+#include <Eigen/Dense>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LVR2_PLANE_FITTING_AVX2
+#include <immintrin.h>
+#endif
+
+namespace lvr2
+{
+
+namespace
+{
+
+/// Number of accumulated sums: x, y, z, xx, xy, xz, yy, yz, zz
+const int NUM_SUMS = 9;
+
+void accumulateScalar(
+    const float* x, const float* y, const float* z,
+    size_t begin, size_t end,
+    float ox, float oy, float oz,
+    double sums[NUM_SUMS])
+{
+    float s[NUM_SUMS] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    for(size_t i = begin; i < end; i++)
+    {
+        float dx = x[i] - ox;
+        float dy = y[i] - oy;
+        float dz = z[i] - oz;
+        s[0] += dx;
+        s[1] += dy;
+        s[2] += dz;
+        s[3] += dx * dx;
+        s[4] += dx * dy;
+        s[5] += dx * dz;
+        s[6] += dy * dy;
+        s[7] += dy * dz;
+        s[8] += dz * dz;
+    }
+
+    for(int j = 0; j < NUM_SUMS; j++)
+    {
+        sums[j] += s[j];
+    }
+}
+
+#ifdef LVR2_PLANE_FITTING_AVX2
+
+/// Horizontal sum of all eight lanes
+__attribute__((target("avx2,fma")))
+inline double reduce(__m256 v)
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+/// Returns the number of processed points, the rest is left for the scalar code
+__attribute__((target("avx2,fma")))
+size_t accumulateAVX2(
+    const float* x, const float* y, const float* z,
+    size_t n,
+    float ox, float oy, float oz,
+    double sums[NUM_SUMS])
+{
+    const __m256 ox8 = _mm256_set1_ps(ox);
+    const __m256 oy8 = _mm256_set1_ps(oy);
+    const __m256 oz8 = _mm256_set1_ps(oz);
+
+    __m256 sx  = _mm256_setzero_ps();
+    __m256 sy  = _mm256_setzero_ps();
+    __m256 sz  = _mm256_setzero_ps();
+    __m256 sxx = _mm256_setzero_ps();
+    __m256 sxy = _mm256_setzero_ps();
+    __m256 sxz = _mm256_setzero_ps();
+    __m256 syy = _mm256_setzero_ps();
+    __m256 syz = _mm256_setzero_ps();
+    __m256 szz = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), ox8);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), oy8);
+        __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(z + i), oz8);
+
+        sx  = _mm256_add_ps(sx, dx);
+        sy  = _mm256_add_ps(sy, dy);
+        sz  = _mm256_add_ps(sz, dz);
+        sxx = _mm256_fmadd_ps(dx, dx, sxx);
+        sxy = _mm256_fmadd_ps(dx, dy, sxy);
+        sxz = _mm256_fmadd_ps(dx, dz, sxz);
+        syy = _mm256_fmadd_ps(dy, dy, syy);
+        syz = _mm256_fmadd_ps(dy, dz, syz);
+        szz = _mm256_fmadd_ps(dz, dz, szz);
+    }
+
+    sums[0] += reduce(sx);
+    sums[1] += reduce(sy);
+    sums[2] += reduce(sz);
+    sums[3] += reduce(sxx);
+    sums[4] += reduce(sxy);
+    sums[5] += reduce(sxz);
+    sums[6] += reduce(syy);
+    sums[7] += reduce(syz);
+    sums[8] += reduce(szz);
+
+    return i;
+}
+
+bool hasAVX2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return avx2;
+}
+
+#endif
+
+} // anonymous namespace
+
+bool covarianceUsesAVX2()
+{
+#ifdef LVR2_PLANE_FITTING_AVX2
+    return hasAVX2();
+#else
+    return false;
+#endif
+}
+
+Covariance3 computeCovariance(const float* x, const float* y, const float* z, size_t n)
+{
+    Covariance3 result = {{0, 0, 0}, {0, 0, 0, 0, 0, 0}};
+    if(n == 0)
+    {
+        return result;
+    }
+
+    // Sums relative to the first point to avoid cancellation
+    float ox = x[0];
+    float oy = y[0];
+    float oz = z[0];
+    double s[NUM_SUMS] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    size_t done = 0;
+#ifdef LVR2_PLANE_FITTING_AVX2
+    if(hasAVX2())
+    {
+        done = accumulateAVX2(x, y, z, n, ox, oy, oz, s);
+    }
+#endif
+    accumulateScalar(x, y, z, done, n, ox, oy, oz, s);
+
+    double mx = s[0] / n;
+    double my = s[1] / n;
+    double mz = s[2] / n;
+
+    result.mean[0] = ox + mx;
+    result.mean[1] = oy + my;
+    result.mean[2] = oz + mz;
+
+    result.cov[0] = s[3] / n - mx * mx;
+    result.cov[1] = s[4] / n - mx * my;
+    result.cov[2] = s[5] / n - mx * mz;
+    result.cov[3] = s[6] / n - my * my;
+    result.cov[4] = s[7] / n - my * mz;
+    result.cov[5] = s[8] / n - mz * mz;
+
+    return result;
+}
+
+bool smallestEigenvector(const float cov[6], float normal[3])
+{
+    Eigen::Matrix3d m;
+    m << cov[0], cov[1], cov[2],
+         cov[1], cov[3], cov[4],
+         cov[2], cov[4], cov[5];
+
+    // Normalize to avoid under- and overflows in the closed form solution
+    double scale = m.cwiseAbs().maxCoeff();
+    if(!(scale > 0))
+    {
+        normal[0] = 0;
+        normal[1] = 0;
+        normal[2] = 1;
+        return false;
+    }
+    m /= scale;
+
+    // Analytic solver for 3x3 matrices, eigenvalues in increasing order
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver;
+    solver.computeDirect(m, Eigen::ComputeEigenvectors);
+    Eigen::Vector3d n = solver.eigenvectors().col(0);
+
+    normal[0] = n.x();
+    normal[1] = n.y();
+    normal[2] = n.z();
+    return true;
+}
+
+} // namespace lvr2
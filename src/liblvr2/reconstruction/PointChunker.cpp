@@ -0,0 +1,286 @@
+/**
+ * Copyright (c) 2018, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * PointChunker.cpp
+ */
+
+#include <lvr2/reconstruction/PointChunker.hpp>
+#include <lvr2/io/ModelFactory.hpp>
+#include <lvr2/io/PointReader.hpp>
+#include <lvr2/io/Timestamp.hpp>
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+using std::cout;
+using std::endl;
+
+namespace lvr2
+{
+
+namespace
+{
+
+/// Maximum number of buffered floats before the buffers are written (128 MB)
+const size_t MAX_BUFFERED_FLOATS = 32 * 1024 * 1024;
+
+/// Number of points read from the input files at once
+const size_t READ_BATCH_SIZE = 1024 * 1024;
+
+} // anonymous namespace
+
+PointChunker::PointChunker(float chunkSize, float overlap, const std::string& directory)
+    : m_chunkSize(chunkSize),
+      m_overlap(std::min(overlap, 0.5f * chunkSize)),
+      m_ownsDirectory(false),
+      m_bufferedFloats(0),
+      m_numPoints(0),
+      m_hasNormals(false)
+{
+    if(overlap != m_overlap)
+    {
+        cout << timestamp << "Chunk overlap reduced to " << m_overlap << "." << endl;
+    }
+
+    if(directory.empty())
+    {
+        m_directory = boost::filesystem::temp_directory_path()
+                    / boost::filesystem::unique_path("lvr2_chunks_%%%%-%%%%-%%%%");
+    }
+    else
+    {
+        m_directory = directory;
+    }
+
+    if(!boost::filesystem::exists(m_directory))
+    {
+        boost::filesystem::create_directories(m_directory);
+        m_ownsDirectory = true;
+    }
+}
+
+PointChunker::~PointChunker()
+{
+    boost::system::error_code ec;
+    if(m_ownsDirectory)
+    {
+        boost::filesystem::remove_all(m_directory, ec);
+    }
+    else
+    {
+        for(auto& chunk : m_chunks)
+        {
+            boost::filesystem::remove(chunkFile(chunk.first), ec);
+        }
+    }
+}
+
+boost::filesystem::path PointChunker::chunkFile(const ChunkIndex& chunk) const
+{
+    return m_directory / ("chunk_" + std::to_string(chunk[0]) + "_"
+                                   + std::to_string(chunk[1]) + "_"
+                                   + std::to_string(chunk[2]) + ".bin");
+}
+
+void PointChunker::addPoints(const float* points, const float* normals, size_t n)
+{
+    if(n == 0)
+    {
+        return;
+    }
+
+    // The first points decide whether normals are stored
+    if(m_numPoints == 0)
+    {
+        m_hasNormals = (normals != nullptr);
+    }
+    else if(m_hasNormals != (normals != nullptr))
+    {
+        cout << timestamp << "Warning: Ignoring " << n << " points "
+             << (m_hasNormals ? "without" : "with") << " normals." << endl;
+        return;
+    }
+
+    for(size_t i = 0; i < n; i++)
+    {
+        const float* p = points + 3 * i;
+        m_boundingBox.expand(BaseVector<float>(p[0], p[1], p[2]));
+
+        // Range of chunks whose extended cube contains the point
+        int first[3];
+        int last[3];
+        for(int a = 0; a < 3; a++)
+        {
+            first[a] = (int)std::floor((p[a] - m_overlap) / m_chunkSize);
+            last[a]  = (int)std::floor((p[a] + m_overlap) / m_chunkSize);
+        }
+
+        for(int x = first[0]; x <= last[0]; x++)
+        {
+            for(int y = first[1]; y <= last[1]; y++)
+            {
+                for(int z = first[2]; z <= last[2]; z++)
+                {
+                    Chunk& chunk = m_chunks[{{x, y, z}}];
+                    chunk.buffer.insert(chunk.buffer.end(), p, p + 3);
+                    if(m_hasNormals)
+                    {
+                        chunk.buffer.insert(chunk.buffer.end(), normals + 3 * i, normals + 3 * i + 3);
+                    }
+                    chunk.numPoints++;
+                    m_bufferedFloats += m_hasNormals ? 6 : 3;
+                }
+            }
+        }
+
+        if(m_bufferedFloats > MAX_BUFFERED_FLOATS)
+        {
+            flush();
+        }
+    }
+
+    m_numPoints += n;
+}
+
+bool PointChunker::addFile(const std::string& filename)
+{
+    PointReaderPtr reader = ModelFactory::openPointReader(filename);
+    if(!reader)
+    {
+        cout << timestamp << "Unable to open " << filename << "." << endl;
+        return false;
+    }
+
+    PointBufferPtr chunk(new PointBuffer);
+    size_t n;
+    while((n = reader->readChunk(chunk, READ_BATCH_SIZE)) > 0)
+    {
+        floatArr points = chunk->getPointArray();
+        floatArr normals = chunk->getNormalArray();
+        addPoints(points.get(), chunk->hasNormals() ? normals.get() : nullptr, n);
+    }
+
+    cout << timestamp << "Added " << m_numPoints << " points to " << m_chunks.size() << " chunks." << endl;
+    return true;
+}
+
+void PointChunker::flush()
+{
+    for(auto& chunk : m_chunks)
+    {
+        std::vector<float>& buffer = chunk.second.buffer;
+        if(buffer.empty())
+        {
+            continue;
+        }
+
+        std::ofstream out(chunkFile(chunk.first).string(), std::ios::binary | std::ios::app);
+        out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(float));
+
+        // Release the memory, most chunks will not get new points soon
+        std::vector<float>().swap(buffer);
+    }
+    m_bufferedFloats = 0;
+}
+
+void PointChunker::finish()
+{
+    flush();
+}
+
+std::vector<PointChunker::ChunkIndex> PointChunker::chunks() const
+{
+    std::vector<ChunkIndex> indices;
+    indices.reserve(m_chunks.size());
+    for(auto& chunk : m_chunks)
+    {
+        indices.push_back(chunk.first);
+    }
+    return indices;
+}
+
+size_t PointChunker::numPoints(const ChunkIndex& chunk) const
+{
+    auto it = m_chunks.find(chunk);
+    return it == m_chunks.end() ? 0 : it->second.numPoints;
+}
+
+BoundingBox<BaseVector<float>> PointChunker::chunkBoundingBox(const ChunkIndex& chunk) const
+{
+    BaseVector<float> min(chunk[0] * m_chunkSize, chunk[1] * m_chunkSize, chunk[2] * m_chunkSize);
+    BaseVector<float> max = min + BaseVector<float>(m_chunkSize, m_chunkSize, m_chunkSize);
+    return BoundingBox<BaseVector<float>>(min, max);
+}
+
+PointBufferPtr PointChunker::loadChunk(const ChunkIndex& chunk) const
+{
+    PointBufferPtr buffer(new PointBuffer);
+
+    size_t n = numPoints(chunk);
+    if(n == 0)
+    {
+        return buffer;
+    }
+
+    int width = m_hasNormals ? 6 : 3;
+    std::vector<float> data(n * width);
+
+    std::ifstream in(chunkFile(chunk).string(), std::ios::binary);
+    in.read(reinterpret_cast<char*>(data.data()), data.size() * sizeof(float));
+    if(!in.good())
+    {
+        cout << timestamp << "Warning: Unable to read chunk file " << chunkFile(chunk) << endl;
+        return buffer;
+    }
+
+    floatArr points(new float[3 * n]);
+    floatArr normals(m_hasNormals ? new float[3 * n] : nullptr);
+    for(size_t i = 0; i < n; i++)
+    {
+        const float* record = &data[i * width];
+        points[3 * i]     = record[0];
+        points[3 * i + 1] = record[1];
+        points[3 * i + 2] = record[2];
+        if(m_hasNormals)
+        {
+            normals[3 * i]     = record[3];
+            normals[3 * i + 1] = record[4];
+            normals[3 * i + 2] = record[5];
+        }
+    }
+
+    buffer->setPointArray(points, n);
+    if(m_hasNormals)
+    {
+        buffer->setNormalArray(normals, n);
+    }
+    return buffer;
+}
+
+} // namespace lvr2
@@ -57,16 +57,6 @@ int main(int argc, char** argv)
     string inputFile = options.inputFile();
     string outputFile = options.outputFile();
 
-    // Count entries
-    int numEntries = AsciiIO::getEntriesInLine(inputFile);
-    int numLines = AsciiIO::countLines(inputFile);
-    int numPoints = numLines - 1;
-
-    if(numPoints <= 0)
-    {
-        std::cout << timestamp << "File contains no points. Exiting." << std::endl;
-    }
-
     // Check color and intensity options
     bool readColor = true;
     if( (options.r() < 0) || (options.g() < 0) || (options.b() < 0) )
@@ -82,89 +72,65 @@ int main(int argc, char** argv)
     std::cout << timestamp << "Read intensities\t\t: " << readIntensity << std::endl;
     std::cout << timestamp << "Convert intensities\t: " << convert << std::endl;
 
-    // Alloc buffers
-    floatArr points(new float[3 * numPoints]);
-    ucharArr colors;
-    floatArr intensities;
-
-    if(readColor || (readIntensity && convert))
+    // Parse the requested columns
+    AsciiIO io;
+    ModelPtr model;
+    if (readColor)
     {
-        colors = ucharArr(new unsigned char[3 * numPoints]);
+        model = io.read(inputFile, options.x(), options.y(), options.z(),
+                        options.r(), options.g(), options.b(), options.i());
+    }
+    else
+    {
+        model = io.read(inputFile, options.x(), options.y(), options.z(),
+                        -1, -1, -1, options.i());
     }
 
-    if(readIntensity)
+    if(!model)
     {
-        intensities = floatArr(new float[numPoints]);
+        std::cout << timestamp << "File contains no points. Exiting." << std::endl;
+        return 0;
     }
 
-    // Open input file and skip first line
+    PointBufferPtr pointBuffer = model->m_pointCloud;
+    size_t numPoints = pointBuffer->numPoints();
+    floatArr points = pointBuffer->getPointArray();
 
-    string comment = timestamp.getElapsedTime() + "Reading file " + inputFile;
-    ProgressBar progress(numPoints, comment);
+    size_t n;
+    unsigned w;
+    floatArr intensities = pointBuffer->getFloatArray("intensities", n, w);
+    ucharArr colors;
+    if(convert && intensities)
+    {
+        colors = ucharArr(new unsigned char[3 * numPoints]);
+    }
 
-    std::ifstream in(inputFile.c_str());
-    char buffer[2048];
-    if(in.good())
+    float sx = options.sx();
+    float sy = options.sy();
+    float sz = options.sz();
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)numPoints; i++)
     {
-        // Data to store the input data
-        float* data = new float[numEntries];
-        in.getline(buffer, 2048);
-        int c = 0;
-        while(in.good() && c <= numPoints)
+        points[3 * i    ] *= sx;
+        points[3 * i + 1] *= sy;
+        points[3 * i + 2] *= sz;
+
+        if(colors)
         {
-            // Read a new line
-            for(int i = 0; i < numEntries; i++)
-            {
-                in >> data[i];
-            }
-
-            // Fill data arrays
-            int posPtr = 3 * c;
-
-            points[posPtr    ] = data[options.x()];
-            points[posPtr + 1] = data[options.y()];
-            points[posPtr + 2] = data[options.z()];
-
-            points[posPtr    ] *= options.sx();
-            points[posPtr + 1] *= options.sy();
-            points[posPtr + 2] *= options.sz();
-
-            if(convert)
-            {
-                colors[posPtr    ] = (unsigned char)data[options.i()];
-                colors[posPtr + 1] = (unsigned char)data[options.i()];
-                colors[posPtr + 2] = (unsigned char)data[options.i()];
-            }
-            else if (readColor)
-            {
-                colors[posPtr    ] = (unsigned char)data[options.r()];
-                colors[posPtr + 1] = (unsigned char)data[options.g()];
-                colors[posPtr + 2] = (unsigned char)data[options.b()];
-            }
-
-            if(readIntensity)
-            {
-                intensities[c] = data[options.i()];
-            }
-            c++;
-            ++progress;
+            colors[3 * i    ] = (unsigned char)intensities[i];
+            colors[3 * i + 1] = (unsigned char)intensities[i];
+            colors[3 * i + 2] = (unsigned char)intensities[i];
         }
-		delete[] data;
-
-        // Create model and save data
-        PointBufferPtr pointBuffer(new PointBuffer );
-        pointBuffer->setPointArray(points, numPoints);
-        pointBuffer->setColorArray(colors, numPoints);
-        pointBuffer->addFloatChannel(intensities, "intensities", numPoints, 1);
-
-        ModelPtr model( new Model(pointBuffer));
-        ModelFactory::saveModel(model, outputFile);
     }
-    else
+
+    if(colors)
     {
-        std::cout << "Unable to open file for output: " << inputFile << std::endl;
+        pointBuffer->setColorArray(colors, numPoints);
     }
 
+    ModelFactory::saveModel(model, outputFile);
+
     std::cout << std::endl;
 
 	return 0;
@@ -78,13 +78,35 @@ int main( int argc, char ** argv )
     // face normals
     std::cout << timestamp << "Computing face normals..." << std::endl;
     auto faceNormals = calcFaceNormals(hem);
-    if(options.getEdgeCollapseNum() > 0)
+    if(options.getTargetFaceCount() > 0)
+    {
+      const size_t targetFaces = options.getTargetFaceCount();
+      std::cout << timestamp << "Reduce mesh to " << targetFaces << " faces" << std::endl;
+      if(options.useQuadricReduction())
+      {
+        quadricMeshReduction(hem, targetFaces, faceNormals);
+      }
+      else if(targetFaces < hem.numFaces())
+      {
+        simpleMeshReduction(hem, (hem.numFaces() - targetFaces) / 2, faceNormals);
+      }
+    }
+    else if(options.getEdgeCollapseNum() > 0)
     {
       double percent = options.getEdgeCollapseNum() > 100 ? 1 : options.getEdgeCollapseNum() / 100.0;
       size_t numCollapse = static_cast<size_t>(percent * hem.numEdges());
       std::cout << timestamp << "Reduce mesh by collapsing " << percent * 100
         << "% of the edges (" << numCollapse << " out of " << hem.numEdges() << ")" << std::endl;
-      simpleMeshReduction(hem, numCollapse, faceNormals);
+      if(options.useQuadricReduction())
+      {
+        // Each collapse removes two faces in the general case
+        const size_t numFaces = hem.numFaces();
+        quadricMeshReduction(hem, numFaces - std::min(numFaces, 2 * numCollapse), faceNormals);
+      }
+      else
+      {
+        simpleMeshReduction(hem, numCollapse, faceNormals);
+      }
     }
 
     std::cout << timestamp << "Adding mesh to file..." << std::endl;
@@ -114,14 +136,14 @@ int main( int argc, char ** argv )
     if(addedAverageAngles) std::cout << timestamp << "successfully added vertex average angles" << std::endl;
     else std::cout << timestamp << "could not add vertex average angles!" << std::endl;
 
-    std::cout << timestamp << "Computing roughness..." << std::endl;
-    auto roughness = calcVertexRoughness(hem, 0.3, vertexNormals);
+    std::cout << timestamp << "Computing roughness and height differences..." << std::endl;
+    DenseVertexMap<float> roughness;
+    DenseVertexMap<float> heightDifferences;
+    calcVertexRoughnessAndHeightDifferences(hem, 0.3, vertexNormals, roughness, heightDifferences);
     bool addedRoughness = hdf5.addDenseAttributeMap<DenseVertexMap<float>>(hem, roughness, "roughness");
     if(addedRoughness) std::cout << timestamp << "successfully added roughness." << std::endl;
     else std::cout << timestamp << "could not add roughness!" << std::endl;
 
-    std::cout << timestamp << "Computing height differences..." << std::endl;
-    auto heightDifferences = calcVertexHeightDifferences(hem, 0.3);
     bool addedHeightDiff = hdf5.addDenseAttributeMap<DenseVertexMap<float>>(hem, heightDifferences, "height_diff");
     if(addedHeightDiff) std::cout << timestamp << "successfully added height differences." << std::endl;
     else std::cout << timestamp << "could not add height differences!" << std::endl;
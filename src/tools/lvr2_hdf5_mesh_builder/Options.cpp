@@ -41,6 +41,8 @@ Options::Options(int argc, char** argv) : m_descr("Supported options")
             ("outputFile,o", value<string>()->default_value("mesh.h5"), "Output file.")
             ("meshName,m", value<string>()->default_value("mesh"), "The name of the mesh to write")
             ("edgeCollapse,e", value<size_t>()->default_value(0), "Edge collapse reduction algorithm, the number of edges to collapse.")
+            ("targetFaces,t", value<size_t>()->default_value(0), "Edge collapse reduction until the mesh has at most this many faces, overrides edgeCollapse.")
+            ("quadric,q", "Use the parallel quadric error simplification for edge collapses.")
             ("3dtk2ros,c", value<bool>()->default_value(false), "Whether the input file should be converted from 3DTK format to the ROS format")
             ;
 
@@ -64,6 +64,8 @@ public:
     string  getMeshName()         const { return m_variables["meshName"].as<string>();}
     bool    getConvert3DTK2ROS()  const { return m_variables["3dtk2ros"].as<bool>();}
     size_t  getEdgeCollapseNum()  const { return m_variables["edgeCollapse"].as<size_t >();}
+    size_t  getTargetFaceCount()  const { return m_variables["targetFaces"].as<size_t >();}
+    bool    useQuadricReduction() const { return m_variables.count("quadric");}
 
 private:
     /// The internally used variable map
@@ -86,6 +88,8 @@ inline ostream& operator<<(ostream& os, const Options &o)
     cout << "##### Output file \t\t: "  << o.getOutputFile() << endl;
     cout << "##### Mesh name \t\t: "  << o.getMeshName() << endl;
     cout << "##### Edge collapse num \t\t: "  << o.getEdgeCollapseNum() << endl;
+    cout << "##### Target faces \t\t: "  << o.getTargetFaceCount() << endl;
+    cout << "##### Quadric reduction \t\t: "  << o.useQuadricReduction() << endl;
     cout << "##### 3DTK2ROS \t\t: "  << o.getConvert3DTK2ROS() << endl;
 	return os;
 }
@@ -55,6 +55,7 @@ using namespace std;
 #include <lvr2/io/Timestamp.hpp>
 #include <lvr2/io/ModelFactory.hpp>
 #include <lvr2/io/IOUtils.hpp>
+#include <lvr2/io/LasIO.hpp>
 
 #ifdef LVR2_USE_PCL
 #include <lvr2/reconstruction/PCLFiltering.hpp>
@@ -169,6 +170,45 @@ void addScanPosition(Eigen::Matrix4d& transform)
     }
 }
 
+/**
+ * @brief   Points read from LAS files are stored relative to an integer
+ *          coordinate base that the LAS writer adds back on output.
+ *
+ * @return  false if the point buffer of the model carries no such base
+ */
+bool getCoordinateBase(ModelPtr model, Eigen::Vector3d& base)
+{
+    const char* names[3] = {"coordinate_base_x", "coordinate_base_y", "coordinate_base_z"};
+    bool found = false;
+    for(int c = 0; c < 3; c++)
+    {
+        intOptional value = model->m_pointCloud->getIntAtomic(names[c]);
+        base[c] = value ? *value : 0.0;
+        found = found || value;
+    }
+    return found;
+}
+
+/**
+ * @brief   Applies a rigid transformation to the point cloud of the model.
+ *          For base-relative points the base is folded into the
+ *          translation, so that base + p' = R * (base + p) + t.
+ */
+void transformRelativePointCloud(ModelPtr model, const Eigen::Matrix4d& transform)
+{
+    Eigen::Vector3d base;
+    if(getCoordinateBase(model, base))
+    {
+        Eigen::Matrix4d relative = transform;
+        relative.block<3, 1>(0, 3) += transform.block<3, 3>(0, 0) * base - base;
+        transformPointCloud(model, relative);
+    }
+    else
+    {
+        transformPointCloud(model, transform);
+    }
+}
+
 
 void processSingleFile(boost::filesystem::path& inFile)
 {
@@ -185,6 +225,14 @@ void processSingleFile(boost::filesystem::path& inFile)
         throw "ERROR: Could not create Model for: ";
     }
 
+    // Axis swaps and scaling would have to be applied to the coordinate
+    // base as well, which the integer base of LAS input can't represent
+    Eigen::Vector3d base;
+    if(getCoordinateBase(model, base) && options->coordinateTransform().transforms())
+    {
+        throw "ERROR: Coordinate transforms are not supported for LAS input: ";
+    }
+
     if(options->getOutputFile() != "")
     {
         char frames[1024];
@@ -211,14 +259,14 @@ void processSingleFile(boost::filesystem::path& inFile)
         {
             std::cout << timestamp << "Getting transformation from dat: " << datPath << std::endl;
             Eigen::Matrix4d transform = getTransformationFromDat(datPath);
-            transformPointCloud(model, transform);
+            transformRelativePointCloud(model, transform);
             addScanPosition(transform);
         }
         else if(boost::filesystem::exists(framesPath))
         {
             std::cout << timestamp << "Getting transformation from frame: " << framesPath << std::endl;
             Eigen::Matrix4d transform = getTransformationFromFrames(framesPath);
-            transformPointCloud(model, transform);
+            transformRelativePointCloud(model, transform);
             addScanPosition(transform);
         }
         else if(boost::filesystem::exists(posePath))
@@ -226,7 +274,7 @@ void processSingleFile(boost::filesystem::path& inFile)
 
             std::cout << timestamp << "Getting transformation from pose: " << posePath << std::endl;
             Eigen::Matrix4d transform = getTransformationFromPose(posePath);
-            transformPointCloud(model, transform);
+            transformRelativePointCloud(model, transform);
             addScanPosition(transform);
         }
 
@@ -346,10 +394,26 @@ void processSingleFile(boost::filesystem::path& inFile)
             }
 
         }
+        else if(options->getOutputFormat() == "LAS")
+        {
+            // All scans are appended to one file, which is finished after the last one
+            static LasPointWriter writer(options->getOutputFile());
+
+            if(writer.write(model->m_pointCloud))
+            {
+                points_written += model->m_pointCloud->numPoints();
+            }
+
+            if(true == lastScan)
+            {
+                writer.close();
+                std::cout << timestamp << "Wrote " << points_written << " points." << std::endl;
+            }
+        }
     }
     else
     {
-        if(options->getOutputFormat() == "")
+        if(options->getOutputFormat() == "" || options->getOutputFormat() == "LAS")
         {
             // Infer format from file extension, convert and write out
             char name[1024];
@@ -376,11 +440,22 @@ void processSingleFile(boost::filesystem::path& inFile)
                 writeFrame(transformed, framesOut);
             }
 
-            ofstream out(name);
             transformAndReducePointCloud(model, getReductionFactor(inFile, options->getTargetSize()), options->coordinateTransform());
-            size_t points_written = writePointsToStream(model, out);
+            size_t points_written = 0;
 
-            out.close();
+            if(options->getOutputFormat() == "LAS")
+            {
+                sprintf(name, "%s/%s.las", options->getOutputDir().c_str(), inFile.stem().c_str());
+                LasPointWriter writer(name);
+                writer.write(model->m_pointCloud);
+                points_written = writer.close();
+            }
+            else
+            {
+                ofstream out(name);
+                points_written = writePointsToStream(model, out);
+                out.close();
+            }
 
             cout << "Wrote " << points_written << " points to file " << name << endl;
          }
@@ -508,7 +583,7 @@ int main(int argc, char** argv) {
     for(boost::filesystem::directory_iterator it(inputDir); it != end; ++it)
     {
         std::string ext =	it->path().extension().string();
-        if(ext == ".3d" || ext == ".ply" || ext == ".txt" )
+        if(ext == ".3d" || ext == ".ply" || ext == ".txt" || ext == ".las" || ext == ".laz")
         {
             v.push_back(it->path());
         }
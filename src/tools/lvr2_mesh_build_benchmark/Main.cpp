@@ -0,0 +1,156 @@
+/**
+ * Benchmark for the construction of HalfEdgeMeshes from mesh buffers.
+ *
+ * Builds the mesh once by inserting all faces one by one with addFace()
+ * and once with the bulk construction used by the MeshBuffer constructor
+ * and addFaces(). Reports the time of both and checks that they create
+ * the same number of vertices, edges and faces.
+ *
+ * Usage: lvr2_mesh_build_benchmark [mesh] [repetitions]
+ *
+ * Without a mesh a triangulated grid with 2M faces is used.
+ */
+
+#include <lvr2/io/ModelFactory.hpp>
+#include <lvr2/io/MeshBuffer.hpp>
+#include <lvr2/io/Timestamp.hpp>
+#include <lvr2/geometry/BaseVector.hpp>
+#include <lvr2/geometry/HalfEdgeMesh.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace lvr2;
+using Vec = BaseVector<float>;
+
+namespace
+{
+
+/// A regular grid of n x n vertices with two triangles per cell
+MeshBufferPtr syntheticMesh(size_t n)
+{
+    floatArr vertices(new float[3 * n * n]);
+    for(size_t y = 0; y < n; y++)
+    {
+        for(size_t x = 0; x < n; x++)
+        {
+            size_t pos = 3 * (y * n + x);
+            vertices[pos]     = x;
+            vertices[pos + 1] = y;
+            vertices[pos + 2] = 0.0f;
+        }
+    }
+
+    size_t numFaces = 2 * (n - 1) * (n - 1);
+    indexArray indices(new unsigned int[3 * numFaces]);
+    size_t pos = 0;
+    for(size_t y = 0; y + 1 < n; y++)
+    {
+        for(size_t x = 0; x + 1 < n; x++)
+        {
+            unsigned int v = y * n + x;
+            indices[pos++] = v;
+            indices[pos++] = v + 1;
+            indices[pos++] = v + n;
+            indices[pos++] = v + 1;
+            indices[pos++] = v + n + 1;
+            indices[pos++] = v + n;
+        }
+    }
+
+    MeshBufferPtr buffer(new MeshBuffer);
+    buffer->setVertices(vertices, n * n);
+    buffer->setFaceIndices(indices, numFaces);
+    return buffer;
+}
+
+void incremental(MeshBufferPtr buffer, HalfEdgeMesh<Vec>& mesh)
+{
+    floatArr vertices = buffer->getVertices();
+    indexArray indices = buffer->getFaceIndices();
+
+    for(size_t i = 0; i < buffer->numVertices(); i++)
+    {
+        mesh.addVertex(Vec(vertices[3 * i], vertices[3 * i + 1], vertices[3 * i + 2]));
+    }
+
+    for(size_t i = 0; i < buffer->numFaces(); i++)
+    {
+        mesh.addFace(
+            VertexHandle(indices[3 * i]),
+            VertexHandle(indices[3 * i + 1]),
+            VertexHandle(indices[3 * i + 2])
+        );
+    }
+}
+
+void report(const char* name, double seconds, const HalfEdgeMesh<Vec>& mesh)
+{
+    std::cout << timestamp << name << ": " << seconds << " s ("
+              << mesh.numFaces() / seconds << " faces/s), "
+              << mesh.numVertices() << " vertices, "
+              << mesh.numEdges() << " edges, "
+              << mesh.numFaces() << " faces" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    MeshBufferPtr buffer;
+    if(argc > 1)
+    {
+        ModelPtr model = ModelFactory::readModel(std::string(argv[1]));
+        if(!model || !model->m_mesh)
+        {
+            std::cout << timestamp << "IO Error: Unable to parse " << argv[1] << std::endl;
+            return 1;
+        }
+        buffer = model->m_mesh;
+    }
+    else
+    {
+        buffer = syntheticMesh(1001);
+    }
+
+    size_t repetitions = argc > 2 ? std::stoul(argv[2]) : 3;
+
+    std::cout << timestamp << "Vertices: " << buffer->numVertices()
+              << ", faces: " << buffer->numFaces() << std::endl;
+
+    double incrementalTime = 0.0;
+    double bulkTime = 0.0;
+    size_t incrementalEdges = 0;
+    size_t bulkEdges = 0;
+
+    for(size_t r = 0; r < repetitions; r++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        HalfEdgeMesh<Vec> a;
+        incremental(buffer, a);
+        auto middle = std::chrono::steady_clock::now();
+        HalfEdgeMesh<Vec> b(buffer);
+        auto end = std::chrono::steady_clock::now();
+
+        double t0 = std::chrono::duration<double>(middle - start).count();
+        double t1 = std::chrono::duration<double>(end - middle).count();
+        incrementalTime += t0;
+        bulkTime += t1;
+        incrementalEdges = a.numEdges();
+        bulkEdges = b.numEdges();
+
+        report("addFace()", t0, a);
+        report("Bulk", t1, b);
+    }
+
+    std::cout << timestamp << "Speedup: " << incrementalTime / bulkTime << std::endl;
+
+    if(incrementalEdges != bulkEdges)
+    {
+        std::cout << timestamp << "Error: the meshes differ." << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
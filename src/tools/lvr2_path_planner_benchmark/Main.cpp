@@ -0,0 +1,210 @@
+/**
+ * Benchmark for shortest path queries on meshes.
+ *
+ * Answers random queries once with Dijkstra() from GeometryAlgorithms and
+ * once with each search of the PathPlanner, first one query after another
+ * and then as a parallel batch with findPaths(). Reports the time of all
+ * variants and checks that they find paths of the same cost.
+ *
+ * Usage: lvr2_path_planner_benchmark [mesh] [queries]
+ *
+ * Without a mesh a triangulated grid with 500K faces is used.
+ */
+
+#include <lvr2/algorithm/PathPlanner.hpp>
+#include <lvr2/io/ModelFactory.hpp>
+#include <lvr2/io/MeshBuffer.hpp>
+#include <lvr2/io/Timestamp.hpp>
+#include <lvr2/geometry/BaseVector.hpp>
+#include <lvr2/geometry/HalfEdgeMesh.hpp>
+#include <lvr2/geometry/Normal.hpp>
+#include <lvr2/algorithm/GeometryAlgorithms.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace lvr2;
+using Vec = BaseVector<float>;
+using Query = std::pair<VertexHandle, VertexHandle>;
+
+namespace
+{
+
+/// A regular grid of n x n vertices with two triangles per cell
+MeshBufferPtr syntheticMesh(size_t n)
+{
+    floatArr vertices(new float[3 * n * n]);
+    for(size_t y = 0; y < n; y++)
+    {
+        for(size_t x = 0; x < n; x++)
+        {
+            size_t pos = 3 * (y * n + x);
+            vertices[pos]     = x;
+            vertices[pos + 1] = y;
+            vertices[pos + 2] = 0.1f * std::sin(0.1f * x) * std::cos(0.1f * y);
+        }
+    }
+
+    size_t numFaces = 2 * (n - 1) * (n - 1);
+    indexArray indices(new unsigned int[3 * numFaces]);
+    size_t pos = 0;
+    for(size_t y = 0; y + 1 < n; y++)
+    {
+        for(size_t x = 0; x + 1 < n; x++)
+        {
+            unsigned int v = y * n + x;
+            indices[pos++] = v;
+            indices[pos++] = v + 1;
+            indices[pos++] = v + n;
+            indices[pos++] = v + 1;
+            indices[pos++] = v + n + 1;
+            indices[pos++] = v + n;
+        }
+    }
+
+    MeshBufferPtr buffer(new MeshBuffer);
+    buffer->setVertices(vertices, n * n);
+    buffer->setFaceIndices(indices, numFaces);
+    return buffer;
+}
+
+/// Relative difference of two path costs, 0 if both paths don't exist
+float costDifference(float a, float b)
+{
+    if(std::isinf(a) || std::isinf(b))
+    {
+        return std::isinf(a) && std::isinf(b) ? 0.0f : 1.0f;
+    }
+    return std::abs(a - b) / std::max(1.0f, std::abs(b));
+}
+
+void report(const char* name, double seconds, size_t numQueries)
+{
+    std::cout << timestamp << name << ": " << seconds << " s ("
+              << numQueries / seconds << " queries/s)" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    MeshBufferPtr buffer;
+    if(argc > 1)
+    {
+        ModelPtr model = ModelFactory::readModel(std::string(argv[1]));
+        if(!model || !model->m_mesh)
+        {
+            std::cout << timestamp << "IO Error: Unable to parse " << argv[1] << std::endl;
+            return 1;
+        }
+        buffer = model->m_mesh;
+    }
+    else
+    {
+        buffer = syntheticMesh(501);
+    }
+
+    size_t numQueries = argc > 2 ? std::stoul(argv[2]) : 100;
+
+    HalfEdgeMesh<Vec> mesh(buffer);
+    DenseEdgeMap<float> edgeCosts = calcVertexDistances(mesh);
+    DenseVertexMap<float> vertexCosts(mesh.nextVertexIndex(), 0.0f);
+
+    std::cout << timestamp << "Vertices: " << mesh.numVertices()
+              << ", edges: " << mesh.numEdges() << std::endl;
+
+    std::vector<VertexHandle> vertices;
+    vertices.reserve(mesh.numVertices());
+    for(auto vH : mesh.vertices())
+    {
+        vertices.push_back(vH);
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> pick(0, vertices.size() - 1);
+    std::vector<Query> queries;
+    queries.reserve(numQueries);
+    for(size_t i = 0; i < numQueries; i++)
+    {
+        VertexHandle start = vertices[pick(rng)];
+        queries.push_back(Query(start, vertices[pick(rng)]));
+    }
+
+    const float inf = std::numeric_limits<float>::infinity();
+
+    // Reference: Dijkstra() allocates and fills its maps for every query
+    std::vector<float> reference(numQueries, inf);
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < numQueries; i++)
+    {
+        std::list<VertexHandle> path;
+        DenseVertexMap<float> distances;
+        DenseVertexMap<VertexHandle> predecessors;
+        DenseVertexMap<bool> seen(mesh.nextVertexIndex(), false);
+        if(Dijkstra(mesh, queries[i].first, queries[i].second, edgeCosts,
+                    path, distances, predecessors, seen, vertexCosts))
+        {
+            reference[i] = distances[queries[i].second];
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    report("Dijkstra()", std::chrono::duration<double>(end - start).count(), numQueries);
+
+    start = std::chrono::steady_clock::now();
+    PathPlanner<Vec> planner(mesh, edgeCosts, vertexCosts);
+    end = std::chrono::steady_clock::now();
+    std::cout << timestamp << "PathPlanner setup: "
+              << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+
+    using Search = PathPlanner<Vec>::Search;
+    const std::pair<const char*, Search> searches[] = {
+        {"PathPlanner Dijkstra", Search::DIJKSTRA},
+        {"PathPlanner A*", Search::ASTAR},
+        {"PathPlanner bidirectional", Search::BIDIRECTIONAL}
+    };
+
+    float maxDifference = 0.0f;
+    for(auto& search : searches)
+    {
+        PathPlanner<Vec>::SearchState state;
+        start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < numQueries; i++)
+        {
+            std::list<VertexHandle> path;
+            float cost = inf;
+            if(planner.findPath(queries[i].first, queries[i].second, path, state, search.second))
+            {
+                cost = state.cost();
+            }
+            maxDifference = std::max(maxDifference, costDifference(cost, reference[i]));
+        }
+        end = std::chrono::steady_clock::now();
+        report(search.first, std::chrono::duration<double>(end - start).count(), numQueries);
+    }
+
+    std::vector<std::list<VertexHandle>> paths;
+    start = std::chrono::steady_clock::now();
+    std::vector<float> costs = planner.findPaths(queries, paths);
+    end = std::chrono::steady_clock::now();
+    report("PathPlanner findPaths()", std::chrono::duration<double>(end - start).count(), numQueries);
+
+    for(size_t i = 0; i < numQueries; i++)
+    {
+        maxDifference = std::max(maxDifference, costDifference(costs[i], reference[i]));
+    }
+
+    std::cout << timestamp << "Largest relative cost difference: " << maxDifference << std::endl;
+
+    if(maxDifference > 1e-4f)
+    {
+        std::cout << timestamp << "Error: the path costs differ." << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,228 @@
+/**
+ * Benchmark for the tangent plane fits used in normal estimation.
+ *
+ * Compares the former least squares height regression (Jacobi SVD), an
+ * iterative Eigen PCA in double precision and the closed form covariance
+ * kernel from PlaneFitting.hpp. Reports the throughput of each solver and
+ * the angular deviation of their normals from the double precision PCA.
+ *
+ * Usage: lvr2_plane_fit_benchmark [pointcloud] [k] [samples]
+ *
+ * Without a point cloud a noisy synthetic surface is used.
+ */
+
+#include <lvr2/io/ModelFactory.hpp>
+#include <lvr2/io/PointBuffer.hpp>
+#include <lvr2/io/Timestamp.hpp>
+#include <lvr2/geometry/BaseVector.hpp>
+#include <lvr2/reconstruction/PlaneFitting.hpp>
+#include <lvr2/reconstruction/SearchTreeFlann.hpp>
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace lvr2;
+using Vec = BaseVector<float>;
+
+namespace
+{
+
+/// Neighborhoods of all samples in separate coordinate arrays
+struct Neighborhoods
+{
+    size_t k;
+    size_t count;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+};
+
+PointBufferPtr syntheticCloud(size_t n)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> uniform(0.0f, 10.0f);
+    std::normal_distribution<float> noise(0.0f, 0.005f);
+
+    floatArr points(new float[3 * n]);
+    for(size_t i = 0; i < n; i++)
+    {
+        float u = uniform(rng);
+        float v = uniform(rng);
+        points[3 * i]     = u;
+        points[3 * i + 1] = v;
+        points[3 * i + 2] = 0.5f * std::sin(u) * std::cos(v) + noise(rng);
+    }
+
+    PointBufferPtr buffer(new PointBuffer);
+    buffer->setPointArray(points, n);
+    return buffer;
+}
+
+/// The plane fit that AdaptiveKSearchSurface::calcPlane used before
+Eigen::Vector3d svdRegression(const float* x, const float* y, const float* z, size_t k)
+{
+    Eigen::VectorXf F(k);
+    Eigen::MatrixXf B(k, 3);
+    for(size_t j = 0; j < k; j++)
+    {
+        F(j)    = y[j];
+        B(j, 0) = 1.0f;
+        B(j, 1) = x[j];
+        B(j, 2) = z[j];
+    }
+
+    Eigen::Vector3f C = B.jacobiSvd(Eigen::ComputeThinU | Eigen::ComputeThinV).solve(F);
+
+    // y = C0 + C1 * x + C2 * z  =>  normal (C1, -1, C2)
+    return Eigen::Vector3d(C(1), -1.0, C(2)).normalized();
+}
+
+/// Reference: iterative eigen decomposition of the covariance in double precision
+Eigen::Vector3d referencePCA(const float* x, const float* y, const float* z, size_t k)
+{
+    Eigen::Vector3d mean(0, 0, 0);
+    for(size_t j = 0; j < k; j++)
+    {
+        mean += Eigen::Vector3d(x[j], y[j], z[j]);
+    }
+    mean /= k;
+
+    Eigen::Matrix3d cov = Eigen::Matrix3d::Zero();
+    for(size_t j = 0; j < k; j++)
+    {
+        Eigen::Vector3d r = Eigen::Vector3d(x[j], y[j], z[j]) - mean;
+        cov += r * r.transpose();
+    }
+
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(cov);
+    return solver.eigenvectors().col(0);
+}
+
+Eigen::Vector3d closedForm(const float* x, const float* y, const float* z, size_t k)
+{
+    Covariance3 c = computeCovariance(x, y, z, k);
+    float n[3];
+    smallestEigenvector(c.cov, n);
+    return Eigen::Vector3d(n[0], n[1], n[2]);
+}
+
+using Solver = std::function<Eigen::Vector3d(const float*, const float*, const float*, size_t)>;
+
+void run(const char* name, const Solver& solver, const Neighborhoods& nb,
+         const std::vector<Eigen::Vector3d>& reference, std::vector<Eigen::Vector3d>& normals)
+{
+    normals.resize(nb.count);
+
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < nb.count; i++)
+    {
+        size_t offset = i * nb.k;
+        normals[i] = solver(&nb.x[offset], &nb.y[offset], &nb.z[offset], nb.k);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    double meanError = 0.0;
+    double maxError = 0.0;
+    if(!reference.empty())
+    {
+        for(size_t i = 0; i < nb.count; i++)
+        {
+            // Normals are not oriented yet, so ignore the sign
+            double dot = std::min(1.0, std::abs(normals[i].dot(reference[i])));
+            double angle = std::acos(dot) * 180.0 / M_PI;
+            meanError += angle;
+            maxError = std::max(maxError, angle);
+        }
+        meanError /= nb.count;
+    }
+
+    std::cout << timestamp << name << ": "
+              << nb.count / seconds << " planes/s, angular error mean "
+              << meanError << " deg, max " << maxError << " deg" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    PointBufferPtr buffer;
+    if(argc > 1)
+    {
+        ModelPtr model = ModelFactory::readModel(std::string(argv[1]));
+        if(!model || !model->m_pointCloud)
+        {
+            std::cout << timestamp << "IO Error: Unable to parse " << argv[1] << std::endl;
+            return 1;
+        }
+        buffer = model->m_pointCloud;
+    }
+    else
+    {
+        buffer = syntheticCloud(1000000);
+    }
+
+    size_t k = argc > 2 ? std::stoul(argv[2]) : 50;
+    size_t samples = argc > 3 ? std::stoul(argv[3]) : 100000;
+
+    size_t numPoints = buffer->numPoints();
+    if(numPoints < k)
+    {
+        std::cout << timestamp << "Point cloud has less than " << k << " points." << std::endl;
+        return 1;
+    }
+    samples = std::min(samples, numPoints);
+
+    std::cout << timestamp << "Points: " << numPoints << ", k: " << k
+              << ", samples: " << samples << std::endl;
+    std::cout << timestamp << "Covariance kernel uses AVX2: "
+              << (covarianceUsesAVX2() ? "yes" : "no") << std::endl;
+
+    // Collect the neighborhoods of evenly spaced sample points up front
+    // so that only the plane fits are timed
+    SearchTreeFlann<Vec> tree(buffer);
+    FloatChannelOptional pts = buffer->getFloatChannel("points");
+
+    std::vector<Vec> queries(samples);
+    size_t step = numPoints / samples;
+    for(size_t i = 0; i < samples; i++)
+    {
+        queries[i] = (*pts)[i * step];
+    }
+
+    std::vector<size_t> indices;
+    std::vector<float> distances;
+    tree.kSearchBatch(queries, k, indices, distances);
+
+    Neighborhoods nb;
+    nb.k = k;
+    nb.count = samples;
+    nb.x.resize(k * samples);
+    nb.y.resize(k * samples);
+    nb.z.resize(k * samples);
+    for(size_t i = 0; i < k * samples; i++)
+    {
+        Vec p = (*pts)[indices[i]];
+        nb.x[i] = p.x;
+        nb.y[i] = p.y;
+        nb.z[i] = p.z;
+    }
+
+    std::vector<Eigen::Vector3d> reference;
+    std::vector<Eigen::Vector3d> normals;
+
+    run("Eigen PCA (double, reference)", referencePCA, nb, reference, normals);
+    reference = normals;
+
+    run("SVD height regression (old)", svdRegression, nb, reference, normals);
+    run("Closed form covariance", closedForm, nb, reference, normals);
+
+    return 0;
+}
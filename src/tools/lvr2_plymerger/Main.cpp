@@ -39,7 +39,10 @@
 
 #include <iostream>
 #include <fstream>
+#include <future>
 #include <tuple>
+#include <vector>
+#include <cstring>
 
 using std::ofstream;
 using std::cout;
@@ -208,70 +211,81 @@ void writePLYHeader(ofstream& outfile, size_t numPoints, bool writeColors, bool
     outfile << "end_header" << endl;
 }
 
-void addToFile(ofstream& out, string filename)
+void addToFile(ofstream& out, string filename, bool writeColors, bool writeNormals)
 {
-    ModelPtr model = ModelFactory::readModel(filename);
-    PointBufferPtr pointBuffer = model->m_pointCloud;
-
-    size_t np, nn, nc;
-    unsigned w_color;
-    np = pointBuffer->numPoints();
-    nc = nn = np;
-
-    floatArr points = pointBuffer->getPointArray();
-    ucharArr colors = pointBuffer->getColorArray(w_color);
-    floatArr normals = pointBuffer->getNormalArray();
+    PointReaderPtr reader = ModelFactory::openPointReader(filename);
+    if(!reader)
+    {
+        cout << timestamp << "Could not read '" << filename << "'." << endl;
+        return;
+    }
 
     // Determine size of single point
-    size_t buffer_size = 3 * sizeof(float);
-
-    if(colors)
+    size_t point_size = 3 * sizeof(float);
+    if(writeColors)
     {
-        buffer_size += w_color * sizeof(unsigned char);
+        point_size += 3 * sizeof(unsigned char);
     }
-
-    if(normals)
+    if(writeNormals)
     {
-        buffer_size += 3 * sizeof(float);
+        point_size += 3 * sizeof(float);
     }
 
-    char* buffer = new char[buffer_size];
-
-    for(size_t i = 0; i < np; i++)
+    // Read the next chunk in the background while the current one is written
+    const size_t chunkSize = 1 << 20;
+    PointBufferPtr chunks[2] = {PointBufferPtr(new PointBuffer), PointBufferPtr(new PointBuffer)};
+    int current = 0;
+    auto readNext = [&reader, &chunks, chunkSize](int c)
     {
-        char* ptr = &buffer[0];
-
-        // Write coordinates to buffer
-        *((float*)ptr) = points[3*i];
-        ptr += sizeof(float);
-        *((float*)ptr) = points[3*i+1];
-        ptr += sizeof(float);
-        *((float*)ptr) = points[3*i+2];
-
-        // Write colors to buffer
-        if(colors)
+        return std::async(std::launch::async, [&reader, &chunks, chunkSize, c]
         {
-            ptr += sizeof(float);
-            *((unsigned char*)ptr) = colors[3 * i];
-            ptr += sizeof(unsigned char);
-            *((unsigned char*)ptr) = colors[3 * i + 1];
-            ptr += sizeof(unsigned char);
-            *((unsigned char*)ptr) = colors[3 * i + 2];
-        }
-
-        if(normals)
+            return reader->readChunk(chunks[c], chunkSize);
+        });
+    };
+
+    std::vector<char> buffer;
+    std::future<size_t> next = readNext(current);
+    size_t np;
+    while((np = next.get()) > 0)
+    {
+        PointBufferPtr chunk = chunks[current];
+        current = 1 - current;
+        next = readNext(current);
+
+        unsigned w_color = 0;
+        floatArr points = chunk->getPointArray();
+        ucharArr colors = chunk->getColorArray(w_color);
+        floatArr normals = chunk->getNormalArray();
+
+        buffer.assign(np * point_size, 0);
+        char* ptr = buffer.data();
+        for(size_t i = 0; i < np; i++)
         {
-            ptr += sizeof(unsigned char);
-            *((float*)ptr) = normals[3*i];
-            ptr += sizeof(float);
-            *((float*)ptr) = normals[3*i+1];
-            ptr += sizeof(float);
-            *((float*)ptr) = normals[3*i+2];
+            // Write coordinates to buffer
+            memcpy(ptr, &points[3 * i], 3 * sizeof(float));
+            ptr += 3 * sizeof(float);
+
+            // Write colors to buffer, missing ones are black
+            if(writeColors)
+            {
+                if(colors)
+                {
+                    memcpy(ptr, &colors[w_color * i], 3 * sizeof(unsigned char));
+                }
+                ptr += 3 * sizeof(unsigned char);
+            }
+
+            if(writeNormals)
+            {
+                if(normals)
+                {
+                    memcpy(ptr, &normals[3 * i], 3 * sizeof(float));
+                }
+                ptr += 3 * sizeof(float);
+            }
         }
-        out.write((const char*)buffer, buffer_size);
+        out.write(buffer.data(), buffer.size());
     }
-
-    delete[] buffer;
 }
 
 /**
@@ -382,7 +396,7 @@ int main(int argc, char** argv)
 
         for(auto chunkIt: filesInChunk)
         {
-            addToFile(out, chunkIt);
+            addToFile(out, chunkIt, mergeColors, mergeNormals);
         }
 
         for(size_t c = 0; c < filesInChunk.size(); c++)
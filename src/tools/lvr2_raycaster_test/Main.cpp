@@ -1,5 +1,8 @@
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <memory>
+#include <random>
 #include <tuple>
 #include <stdlib.h>
 
@@ -347,6 +350,112 @@ void test3(RaycasterBase<PointType, NormalType>& rc, size_t num_rays=984543)
 
 }
 
+/**
+ * @brief Generates a bumpy sphere around the origin, which every ray from
+ *        inside of it hits
+ */
+MeshBufferPtr genSphereMesh(size_t rings, size_t segments, float radius = 10.0)
+{
+    MeshBufferPtr dst_mesh = MeshBufferPtr(new MeshBuffer);
+
+    size_t num_vertices = (rings + 1) * segments;
+    size_t num_faces = 2 * rings * segments;
+    floatArr vertices(new float[num_vertices * 3]);
+    indexArray face_indices(new unsigned int[num_faces * 3]);
+
+    for(size_t i = 0; i <= rings; i++)
+    {
+        float theta = M_PI * i / rings;
+        for(size_t j = 0; j < segments; j++)
+        {
+            float phi = 2 * M_PI * j / segments;
+            float r = radius * (1.0 + 0.05 * std::sin(7 * theta) * std::cos(5 * phi));
+            size_t v = i * segments + j;
+            vertices[v * 3 + 0] = r * std::sin(theta) * std::cos(phi);
+            vertices[v * 3 + 1] = r * std::sin(theta) * std::sin(phi);
+            vertices[v * 3 + 2] = r * std::cos(theta);
+        }
+    }
+
+    size_t f = 0;
+    for(size_t i = 0; i < rings; i++)
+    {
+        for(size_t j = 0; j < segments; j++)
+        {
+            unsigned int v0 = i * segments + j;
+            unsigned int v1 = i * segments + (j + 1) % segments;
+            unsigned int v2 = v0 + segments;
+            unsigned int v3 = v1 + segments;
+            face_indices[f++] = v0; face_indices[f++] = v2; face_indices[f++] = v1;
+            face_indices[f++] = v1; face_indices[f++] = v2; face_indices[f++] = v3;
+        }
+    }
+
+    dst_mesh->setVertices(vertices, num_vertices);
+    dst_mesh->setFaceIndices(face_indices, num_faces);
+
+    return dst_mesh;
+}
+
+/**
+ * @brief Measures the throughput of the raycaster for coherent rays of a
+ *        panorama scan and for incoherent rays with random origins and
+ *        directions
+ */
+void benchmark(RaycasterBase<PointType, NormalType>& rc, std::string name, size_t width = 2048, size_t height = 512)
+{
+    size_t num_rays = width * height;
+
+    // panorama: one origin, rows of neighbouring directions
+    PointType origin = {0.5, -0.3, 0.2};
+    std::vector<NormalType> panorama(num_rays);
+    for(size_t v = 0; v < height; v++)
+    {
+        float theta = M_PI * (v + 0.5) / height;
+        for(size_t u = 0; u < width; u++)
+        {
+            float phi = 2 * M_PI * u / width;
+            panorama[v * width + u] = NormalType(
+                std::sin(theta) * std::cos(phi),
+                std::sin(theta) * std::sin(phi),
+                std::cos(theta));
+        }
+    }
+
+    // random rays from random origins
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dist(-1.0, 1.0);
+    std::vector<PointType> origins(num_rays);
+    std::vector<NormalType> directions(num_rays);
+    for(size_t i = 0; i < num_rays; i++)
+    {
+        origins[i] = PointType(5 * dist(gen), 5 * dist(gen), 5 * dist(gen));
+        directions[i] = NormalType(dist(gen), dist(gen), dist(gen));
+    }
+
+    std::vector<PointType> intersections;
+    std::vector<uint8_t> hits;
+
+    auto report = [&](std::string rays, double seconds)
+    {
+        size_t num_hits = 0;
+        for(auto hit : hits)
+        {
+            num_hits += hit;
+        }
+        std::cout << name << " " << rays << ": " << num_rays / seconds / 1e6 << " Mrays/s ("
+                  << num_hits << " / " << num_rays << " hits)" << std::endl;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    rc.castRays(origin, panorama, intersections, hits);
+    report("coherent", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    start = std::chrono::steady_clock::now();
+    rc.castRays(origins, directions, intersections, hits);
+    report("incoherent", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
+
 int main(int argc, char** argv){
 
     MeshBufferPtr buffer = genMesh();
@@ -364,6 +473,13 @@ int main(int argc, char** argv){
 
     test3(rcGPU, num_rays);
 
+    // throughput on a larger mesh
+    MeshBufferPtr sphere = genSphereMesh(1000, 1000);
+    BVHRaycaster<PointType, NormalType> rcBenchCPU(sphere);
+    CLRaycaster<PointType, NormalType> rcBenchGPU(sphere);
+    benchmark(rcBenchCPU, "CPU");
+    benchmark(rcBenchGPU, "GPU");
+
     ModelPtr model(new Model(buffer));
 
     ModelFactory::saveModel(model, "projection_mesh.ply");
@@ -139,6 +139,10 @@
 #include <iostream>
 #include <memory>
 #include <tuple>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
 #include <stdlib.h>
 
 #include <boost/optional.hpp>
@@ -172,6 +176,7 @@
 #include <lvr2/reconstruction/SearchTreeFlann.hpp>
 #include <lvr2/reconstruction/HashGrid.hpp>
 #include <lvr2/reconstruction/PointsetGrid.hpp>
+#include <lvr2/reconstruction/PointChunker.hpp>
 #include <lvr2/reconstruction/SharpBox.hpp>
 #include <lvr2/io/PointBuffer.hpp>
 #include <lvr2/io/MeshBuffer.hpp>
@@ -211,20 +216,8 @@ using PsSurface = lvr2::PointsetSurface<Vec>;
 
 
 template <typename BaseVecT>
-PointsetSurfacePtr<BaseVecT> loadPointCloud(const reconstruct::Options& options)
+PointsetSurfacePtr<BaseVecT> createSurface(const reconstruct::Options& options, PointBufferPtr buffer)
 {
-    // Create a point loader object
-    ModelPtr model = ModelFactory::readModel(options.getInputFileName());
-
-    // Parse loaded data
-    if (!model)
-    {
-        cout << timestamp << "IO Error: Unable to parse " << options.getInputFileName() << endl;
-        return nullptr;
-    }
-
-    PointBufferPtr buffer = model->m_pointCloud;
-
     // Create a point cloud manager
     string pcm_name = options.getPCM();
     PointsetSurfacePtr<Vec> surface;
@@ -300,16 +293,31 @@ PointsetSurfacePtr<BaseVecT> loadPointCloud(const reconstruct::Options& options)
     return surface;
 }
 
+template <typename BaseVecT>
+PointsetSurfacePtr<BaseVecT> loadPointCloud(const reconstruct::Options& options)
+{
+    // Create a point loader object
+    ModelPtr model = ModelFactory::readModel(options.getInputFileName());
+
+    // Parse loaded data
+    if (!model)
+    {
+        cout << timestamp << "IO Error: Unable to parse " << options.getInputFileName() << endl;
+        return nullptr;
+    }
+
+    return createSurface<BaseVecT>(options, model->m_pointCloud);
+}
+
 std::pair<shared_ptr<GridBase>, unique_ptr<FastReconstructionBase<Vec>>>
     createGridAndReconstruction(
         const reconstruct::Options& options,
-        PointsetSurfacePtr<Vec> surface
+        PointsetSurfacePtr<Vec> surface,
+        const BoundingBox<Vec>& boundingBox,
+        float resolution,
+        bool useVoxelsize
     )
 {
-    // Determine whether to use intersections or voxelsize
-    bool useVoxelsize = options.getIntersections() <= 0;
-    float resolution = useVoxelsize ? options.getVoxelsize() : options.getIntersections();
-
     // Create a point set grid for reconstruction
     string decompositionType = options.getDecomposition();
 
@@ -325,26 +333,27 @@ std::pair<shared_ptr<GridBase>, unique_ptr<FastReconstructionBase<Vec>>>
         auto grid = std::make_shared<PointsetGrid<Vec, FastBox<Vec>>>(
             resolution,
             surface,
-            surface->getBoundingBox(),
+            boundingBox,
             useVoxelsize,
-            options.extrude()
+            options.extrude(),
+            options.parallelGrid()
         );
         grid->calcDistanceValues();
-        auto reconstruction = make_unique<FastReconstruction<Vec, FastBox<Vec>>>(grid);
+        auto reconstruction = make_unique<FastReconstruction<Vec, FastBox<Vec>>>(grid, options.parallelMesh());
         return make_pair(grid, std::move(reconstruction));
     }
     else if(decompositionType == "PMC")
     {
-        BilinearFastBox<Vec>::m_surface = surface;
         auto grid = std::make_shared<PointsetGrid<Vec, BilinearFastBox<Vec>>>(
             resolution,
             surface,
-            surface->getBoundingBox(),
+            boundingBox,
             useVoxelsize,
-            options.extrude()
+            options.extrude(),
+            options.parallelGrid()
         );
         grid->calcDistanceValues();
-        auto reconstruction = make_unique<FastReconstruction<Vec, BilinearFastBox<Vec>>>(grid);
+        auto reconstruction = make_unique<FastReconstruction<Vec, BilinearFastBox<Vec>>>(grid, options.parallelMesh());
         return make_pair(grid, std::move(reconstruction));
     }
     else if(decompositionType == "MT")
@@ -352,32 +361,267 @@ std::pair<shared_ptr<GridBase>, unique_ptr<FastReconstructionBase<Vec>>>
         auto grid = std::make_shared<PointsetGrid<Vec, TetraederBox<Vec>>>(
             resolution,
             surface,
-            surface->getBoundingBox(),
+            boundingBox,
             useVoxelsize,
-            options.extrude()
+            options.extrude(),
+            options.parallelGrid()
         );
         grid->calcDistanceValues();
-        auto reconstruction = make_unique<FastReconstruction<Vec, TetraederBox<Vec>>>(grid);
+        auto reconstruction = make_unique<FastReconstruction<Vec, TetraederBox<Vec>>>(grid, options.parallelMesh());
         return make_pair(grid, std::move(reconstruction));
     }
     else if(decompositionType == "SF")
     {
-        SharpBox<Vec>::m_surface = surface;
         auto grid = std::make_shared<PointsetGrid<Vec, SharpBox<Vec>>>(
             resolution,
             surface,
-            surface->getBoundingBox(),
+            boundingBox,
             useVoxelsize,
-            options.extrude()
+            options.extrude(),
+            options.parallelGrid()
         );
         grid->calcDistanceValues();
-        auto reconstruction = make_unique<FastReconstruction<Vec, SharpBox<Vec>>>(grid);
+        auto reconstruction = make_unique<FastReconstruction<Vec, SharpBox<Vec>>>(grid, options.parallelMesh());
         return make_pair(grid, std::move(reconstruction));
     }
 
     return make_pair(nullptr, nullptr);
 }
 
+/**
+ * @brief Merges the meshes of the chunks of a chunked reconstruction into
+ *        one mesh. The border vertices of a chunk are merged with the
+ *        border vertices of previously added chunks at the same position.
+ */
+class ChunkStitcher
+{
+public:
+    ChunkStitcher(HalfEdgeMesh<Vec>& mesh, float precision)
+        : m_mesh(mesh), m_precision(precision), m_skippedFaces(0)
+    {
+    }
+
+    /**
+     * @brief Adds all faces of the given chunk mesh
+     *
+     * @param chunk         The mesh of a chunk
+     * @param duplicates    Indices of the vertices on the chunk borders
+     */
+    void addChunk(const HalfEdgeMesh<Vec>& chunk, const vector<unsigned int>& duplicates)
+    {
+        vector<bool> isDuplicate(chunk.nextVertexIndex(), false);
+        for(auto index : duplicates)
+        {
+            isDuplicate[index] = true;
+        }
+
+        vector<OptionalVertexHandle> handles(chunk.nextVertexIndex());
+        for(auto vH : chunk.vertices())
+        {
+            Vec pos = chunk.getVertexPosition(vH);
+            handles[vH.idx()] = isDuplicate[vH.idx()] ? getBorderVertex(pos) : m_mesh.addVertex(pos);
+        }
+
+        for(auto fH : chunk.faces())
+        {
+            auto vertices = chunk.getVerticesOfFace(fH);
+            VertexHandle a = handles[vertices[0].idx()].unwrap();
+            VertexHandle b = handles[vertices[1].idx()].unwrap();
+            VertexHandle c = handles[vertices[2].idx()].unwrap();
+
+            // Merging border vertices can degenerate faces or create
+            // non-manifold configurations where the chunks do not match
+            if(a == b || b == c || a == c || !m_mesh.isFaceInsertionValid(a, b, c))
+            {
+                m_skippedFaces++;
+                continue;
+            }
+            m_mesh.addFace(a, b, c);
+        }
+    }
+
+    /**
+     * @brief Returns the number of faces that could not be added
+     */
+    size_t numSkippedFaces() const
+    {
+        return m_skippedFaces;
+    }
+
+private:
+
+    using Key = std::array<int64_t, 3>;
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& k) const
+        {
+            return (k[0] * 73856093) ^ (k[1] * 19349663) ^ (k[2] * 83492791);
+        }
+    };
+
+    /// Returns the border vertex at the given position, creates it if necessary
+    VertexHandle getBorderVertex(const Vec& pos)
+    {
+        Key key = {{
+            (int64_t) std::floor(pos.x / m_precision),
+            (int64_t) std::floor(pos.y / m_precision),
+            (int64_t) std::floor(pos.z / m_precision)
+        }};
+
+        // The matching vertex can lie in a neighboring cell of the hash grid
+        for(int dx = -1; dx <= 1; dx++)
+        {
+            for(int dy = -1; dy <= 1; dy++)
+            {
+                for(int dz = -1; dz <= 1; dz++)
+                {
+                    auto it = m_borderVertices.find({{key[0] + dx, key[1] + dy, key[2] + dz}});
+                    if(it != m_borderVertices.end() &&
+                       m_mesh.getVertexPosition(it->second).distance(pos) < m_precision)
+                    {
+                        return it->second;
+                    }
+                }
+            }
+        }
+
+        VertexHandle vH = m_mesh.addVertex(pos);
+        m_borderVertices.emplace(key, vH);
+        return vH;
+    }
+
+    HalfEdgeMesh<Vec>& m_mesh;
+
+    /// Maximum distance of merged vertices
+    float m_precision;
+
+    /// Border vertices of the added chunks, hashed by their position
+    std::unordered_map<Key, VertexHandle, KeyHash> m_borderVertices;
+
+    size_t m_skippedFaces;
+};
+
+/**
+ * @brief Reconstructs the point cloud in chunks. The points are streamed
+ *        into overlapping chunks on disk that are reconstructed one after
+ *        another (or options.getParallelChunks() at a time). The grids of
+ *        all chunks are aligned, so the chunk meshes can be stitched at
+ *        their borders.
+ *
+ * @return false if the input could not be read
+ */
+bool reconstructChunked(const reconstruct::Options& options, HalfEdgeMesh<Vec>& mesh)
+{
+    float chunkSize = options.getChunkSize();
+    PointChunker chunker(chunkSize, options.getChunkOverlap(), options.getChunkDirectory());
+
+    cout << timestamp << "Partitioning " << options.getInputFileName() << " into chunks" << endl;
+    if(!chunker.addFile(options.getInputFileName()))
+    {
+        cout << timestamp << "IO Error: Unable to parse " << options.getInputFileName() << endl;
+        return false;
+    }
+    chunker.finish();
+
+    BoundingBox<Vec> bb = chunker.getBoundingBox();
+    if(!bb.isValid())
+    {
+        cout << timestamp << "No points found in " << options.getInputFileName() << endl;
+        return false;
+    }
+
+    // The chunk borders have to lie on cell borders of the grid, so the
+    // chunk size has to be a multiple of the voxel size
+    float voxelsize = options.getIntersections() > 0
+                    ? bb.getLongestSide() / options.getIntersections()
+                    : options.getVoxelsize();
+    long cellsPerChunk = std::max(1l, std::lround(chunkSize / voxelsize));
+    voxelsize = chunkSize / cellsPerChunk;
+    cout << timestamp << "Using voxelsize " << voxelsize << " for "
+         << cellsPerChunk << " cells per chunk side" << endl;
+
+    // The grid of each chunk covers the chunk and its overlap. The cell
+    // centers of all grids are at (i + 0.5) * voxelsize.
+    int overlapCells = std::floor(chunker.getOverlap() / voxelsize);
+    Vec gridOffset = Vec(1, 1, 1) * ((overlapCells + 0.5f) * voxelsize);
+
+    // Border vertices of adjacent chunks differ by rounding errors
+    float maxCoord = std::max({
+        fabs(bb.getMin().x), fabs(bb.getMin().y), fabs(bb.getMin().z),
+        fabs(bb.getMax().x), fabs(bb.getMax().y), fabs(bb.getMax().z)
+    });
+    float precision = std::max(0.001f * voxelsize, 16 * std::numeric_limits<float>::epsilon() * maxCoord);
+
+    // A chunk needs enough points for the k-neighborhoods
+    size_t minPoints = std::max({options.getKn(), options.getKi(), options.getKd()}) + 1;
+
+    vector<PointChunker::ChunkIndex> chunks = chunker.chunks();
+    ChunkStitcher stitcher(mesh, precision);
+
+    // Divide the threads between the chunks
+    int parallelChunks = std::min<int>(options.getParallelChunks(), chunks.size());
+    int threadsPerChunk = std::max(1, options.getNumThreads() / std::max(1, parallelChunks));
+    OpenMPConfig::setMaxActiveLevels(2);
+
+    #pragma omp parallel for schedule(dynamic) num_threads(parallelChunks)
+    for(long i = 0; i < (long)chunks.size(); i++)
+    {
+        OpenMPConfig::setNumThreads(threadsPerChunk);
+
+        const PointChunker::ChunkIndex& chunk = chunks[i];
+        if(chunker.numPoints(chunk) < minPoints)
+        {
+            continue;
+        }
+
+        PointBufferPtr buffer = chunker.loadChunk(chunk);
+        PointsetSurfacePtr<Vec> surface = createSurface<Vec>(options, buffer);
+        if(!surface)
+        {
+            continue;
+        }
+
+        BoundingBox<Vec> core = chunker.chunkBoundingBox(chunk);
+        BoundingBox<Vec> gridBB(core.getMin() - gridOffset, core.getMax() + gridOffset);
+
+        shared_ptr<GridBase> grid;
+        unique_ptr<FastReconstructionBase<Vec>> reconstruction;
+        std::tie(grid, reconstruction) = createGridAndReconstruction(options, surface, gridBB, voxelsize, true);
+
+        // The box types share the surface in a static member, so the
+        // surface extraction of the chunks can not run in parallel
+        #pragma omp critical(chunkMesh)
+        {
+            BilinearFastBox<Vec>::m_surface = surface;
+            SharpBox<Vec>::m_surface = surface;
+
+            HalfEdgeMesh<Vec> chunkMesh;
+            vector<unsigned int> duplicates;
+            reconstruction->getMesh(chunkMesh, core, duplicates, precision);
+            stitcher.addChunk(chunkMesh, duplicates);
+
+            cout << timestamp << "Reconstructed chunk (" << chunk[0] << ", " << chunk[1] << ", " << chunk[2]
+                 << ") with " << chunkMesh.numFaces() << " faces" << endl;
+        }
+    }
+
+    OpenMPConfig::setMaxActiveLevels(1);
+    OpenMPConfig::setNumThreads(options.getNumThreads());
+
+    BilinearFastBox<Vec>::m_surface = nullptr;
+    SharpBox<Vec>::m_surface = nullptr;
+
+    if(stitcher.numSkippedFaces())
+    {
+        cout << timestamp << "Skipped " << stitcher.numSkippedFaces() << " faces at chunk borders" << endl;
+    }
+    cout << timestamp << "Stitched mesh has " << mesh.numVertices() << " vertices and "
+         << mesh.numFaces() << " faces" << endl;
+
+    return true;
+}
+
 int main(int argc, char** argv)
 {
     // =======================================================================
@@ -400,39 +644,71 @@ int main(int argc, char** argv)
     // Load (and potentially store) point cloud
     // =======================================================================
     OpenMPConfig::setNumThreads(options.getNumThreads());
+    ModelFactory::m_scanReduction = options.getScanReduction();
 
-    auto surface = loadPointCloud<Vec>(options);
-    if (!surface)
-    {
-        cout << "Failed to create pointcloud. Exiting." << endl;
-        return EXIT_FAILURE;
-    }
+    // Create an empty mesh
+    lvr2::HalfEdgeMesh<Vec> mesh;
+
+    // Not available for the chunked reconstruction, which never loads
+    // the whole point cloud
+    PointsetSurfacePtr<Vec> surface;
 
-    // Save points and normals only
-    if(options.savePointNormals())
+    if(options.getChunkSize() > 0)
     {
-        ModelPtr pn(new Model(surface->pointBuffer()));
-        ModelFactory::saveModel(pn, "pointnormals.ply");
+        // ===================================================================
+        // Reconstruct mesh chunk by chunk
+        // ===================================================================
+        if(!reconstructChunked(options, mesh))
+        {
+            cout << "Failed to reconstruct chunks. Exiting." << endl;
+            return EXIT_FAILURE;
+        }
     }
+    else
+    {
+        surface = loadPointCloud<Vec>(options);
+        if (!surface)
+        {
+            cout << "Failed to create pointcloud. Exiting." << endl;
+            return EXIT_FAILURE;
+        }
 
+        // Save points and normals only
+        if(options.savePointNormals())
+        {
+            ModelPtr pn(new Model(surface->pointBuffer()));
+            ModelFactory::saveModel(pn, "pointnormals.ply");
+        }
 
-    // =======================================================================
-    // Reconstruct mesh from point cloud data
-    // =======================================================================
-    // Create an empty mesh
-    lvr2::HalfEdgeMesh<Vec> mesh;
 
-    shared_ptr<GridBase> grid;
-    unique_ptr<FastReconstructionBase<Vec>> reconstruction;
-    std::tie(grid, reconstruction) = createGridAndReconstruction(options, surface);
+        // ===================================================================
+        // Reconstruct mesh from point cloud data
+        // ===================================================================
+        // Determine whether to use intersections or voxelsize
+        bool useVoxelsize = options.getIntersections() <= 0;
+        float resolution = useVoxelsize ? options.getVoxelsize() : options.getIntersections();
 
-    // Reconstruct mesh
-    reconstruction->getMesh(mesh);
+        shared_ptr<GridBase> grid;
+        unique_ptr<FastReconstructionBase<Vec>> reconstruction;
+        std::tie(grid, reconstruction) = createGridAndReconstruction(
+            options,
+            surface,
+            surface->getBoundingBox(),
+            resolution,
+            useVoxelsize
+        );
 
-    // Save grid to file
-    if(options.saveGrid())
-    {
-        grid->saveGrid("fastgrid.grid");
+        // Reconstruct mesh. The surface is needed by the contour optimization
+        // of the bilinear and sharp feature boxes.
+        BilinearFastBox<Vec>::m_surface = surface;
+        SharpBox<Vec>::m_surface = surface;
+        reconstruction->getMesh(mesh);
+
+        // Save grid to file
+        if(options.saveGrid())
+        {
+            grid->saveGrid("fastgrid.grid");
+        }
     }
 
 
@@ -459,7 +735,8 @@ int main(int argc, char** argv)
 
     // Reduce mesh complexity
     const auto reductionRatio = options.getEdgeCollapseReductionRatio();
-    if (reductionRatio > 0.0)
+    const auto targetFaceCount = options.getTargetFaceCount();
+    if (reductionRatio > 0.0 || targetFaceCount > 0)
     {
         if (reductionRatio > 1.0)
         {
@@ -468,8 +745,30 @@ int main(int argc, char** argv)
 
         // Each edge collapse removes two faces in the general case.
         // TODO: maybe we should calculate this differently...
-        const auto count = static_cast<size_t>((mesh.numFaces() / 2) * reductionRatio);
-        auto collapsedCount = simpleMeshReduction(mesh, count, faceNormals);
+        auto count = static_cast<size_t>((mesh.numFaces() / 2) * reductionRatio);
+        if (targetFaceCount > 0)
+        {
+            count = targetFaceCount < mesh.numFaces()
+                ? (mesh.numFaces() - targetFaceCount) / 2
+                : 0;
+        }
+
+        if (options.useQuadricReduction())
+        {
+            const auto targetFaces = targetFaceCount > 0
+                ? targetFaceCount
+                : mesh.numFaces() - 2 * count;
+            quadricMeshReduction(mesh, targetFaces, faceNormals);
+        }
+        else
+        {
+            simpleMeshReduction(mesh, count, faceNormals);
+        }
+
+        // The collapses leave many unused handles behind. Renumber the mesh
+        // and recalculate the normals for the new face handles.
+        mesh.compact();
+        faceNormals = calcFaceNormals(mesh);
     }
 
     ClusterBiMap<FaceHandle> clusterBiMap;
@@ -505,10 +804,16 @@ int main(int argc, char** argv)
     // Prepare color data for finalizing
     ClusterPainter painter(clusterBiMap);
     auto clusterColors = optional<DenseClusterMap<Rgb8Color>>(painter.simpsons(mesh));
-    auto vertexColors = calcColorFromPointCloud(mesh, surface);
+    optional<DenseVertexMap<Rgb8Color>> vertexColors;
+    if (surface)
+    {
+        vertexColors = calcColorFromPointCloud(mesh, surface);
+    }
 
     // Calc normals for vertices
-    auto vertexNormals = calcVertexNormals(mesh, faceNormals, *surface);
+    auto vertexNormals = surface
+        ? calcVertexNormals(mesh, faceNormals, *surface)
+        : calcVertexNormals(mesh, faceNormals);
 
     // Prepare finalize algorithm
     TextureFinalizer<Vec> finalize(clusterBiMap);
@@ -522,7 +827,7 @@ int main(int argc, char** argv)
 
     // Vertex colors:
     // If vertex colors should be generated from pointcloud:
-    if (options.vertexColorsFromPointcloud())
+    if (options.vertexColorsFromPointcloud() && vertexColors)
     {
         // set vertex color data from pointcloud
         finalize.setVertexColors(*vertexColors);
@@ -533,62 +838,69 @@ int main(int argc, char** argv)
         finalize.setClusterColors(*clusterColors);
     }
 
-    // Materializer for face materials (colors and/or textures)
-    Materializer<Vec> materializer(
-        mesh,
-        clusterBiMap,
-        faceNormals,
-        *surface
-    );
+    // Materials need the point cloud, which is not available after a
+    // chunked reconstruction
+    optional<MaterializerResult<Vec>> matResult;
+    if (surface)
+    {
+        // Materializer for face materials (colors and/or textures)
+        Materializer<Vec> materializer(
+            mesh,
+            clusterBiMap,
+            faceNormals,
+            *surface
+        );
 
-    ImageTexturizer<Vec> img_texter(
-        options.getTexelSize(),
-        options.getTexMinClusterSize(),
-        options.getTexMaxClusterSize()
-    );
+        ImageTexturizer<Vec> img_texter(
+            options.getTexelSize(),
+            options.getTexMinClusterSize(),
+            options.getTexMaxClusterSize()
+        );
 
-    Texturizer<Vec> texturizer(
-        options.getTexelSize(),
-        options.getTexMinClusterSize(),
-        options.getTexMaxClusterSize()
-    );
+        Texturizer<Vec> texturizer(
+            options.getTexelSize(),
+            options.getTexMinClusterSize(),
+            options.getTexMaxClusterSize()
+        );
 
-    // When using textures ...
-    if (options.generateTextures())
-    {
-        if (!options.texturesFromImages())
+        // When using textures ...
+        if (options.generateTextures())
         {
-            materializer.setTexturizer(texturizer);
-        }
-        else
-        {
-            ScanprojectIO project;
-
-            if (options.getProjectDir().empty())
+            if (!options.texturesFromImages())
             {
-                project.parse_project(options.getInputFileName());
+                materializer.setTexturizer(texturizer);
             }
             else
             {
-                project.parse_project(options.getProjectDir());
-            }
+                ScanprojectIO project;
 
-            img_texter.set_project(project.get_project());
+                if (options.getProjectDir().empty())
+                {
+                    project.parse_project(options.getInputFileName());
+                }
+                else
+                {
+                    project.parse_project(options.getProjectDir());
+                }
 
-            materializer.setTexturizer(img_texter);
+                img_texter.set_project(project.get_project());
+
+                materializer.setTexturizer(img_texter);
+            }
         }
-    }
 
-    // Generate materials
-    MaterializerResult<Vec> matResult = materializer.generateMaterials();
+        // Generate materials
+        matResult = materializer.generateMaterials();
+
+        // Add material data to finalize algorithm
+        finalize.setMaterializerResult(*matResult);
+    }
 
-    // Add material data to finalize algorithm
-    finalize.setMaterializerResult(matResult);
     // Run finalize algorithm
     auto buffer = finalize.apply(mesh);
 
     // When using textures ...
-    if (options.generateTextures())
+    if (options.generateTextures() && matResult)
     {
         // Set optioins to save them to disk
         //materializer.saveTextures();
@@ -602,7 +914,7 @@ int main(int argc, char** argv)
     // Create output model and save to file
     auto m = ModelPtr( new Model(buffer));
 
-    if(options.saveOriginalData())
+    if(options.saveOriginalData() && surface)
     {
         m->m_pointCloud = surface->pointBuffer();
 
@@ -615,7 +927,7 @@ int main(int argc, char** argv)
         ModelFactory::saveModel(m, output_filename);
     }
 
-    if (matResult.m_keypoints)
+    if (matResult && matResult->m_keypoints)
     {
         // save materializer keypoints to hdf5 which is not possible with ModelFactory
         //PlutoMapIO map_io("triangle_mesh.h5");
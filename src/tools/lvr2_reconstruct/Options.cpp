@@ -35,6 +35,7 @@
 #include "Options.hpp"
 #include <lvr2/config/lvropenmp.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 
@@ -64,8 +65,15 @@ Options::Options(int argc, char** argv)
         ("outputFile", value< vector<string> >()->multitoken()->default_value(vector<string>{"triangle_mesh.ply", "triangle_mesh.obj"}), "Output file name. Supported formats are ASCII (.pts, .xyz) and .ply")
         ("voxelsize,v", value<float>(&m_voxelsize)->default_value(10), "Voxelsize of grid used for reconstruction.")
         ("noExtrusion", "Do not extend grid. Can be used  to avoid artefacts in dense data sets but. Disabling will possibly create additional holes in sparse data sets.")
+        ("parallelGrid", "Build the reconstruction grid with all threads. Creates the same grid as the default serial construction.")
+        ("parallelMesh", "Extract the marching cubes surface with all threads. Creates the same mesh as the default serial extraction. Supported for MC and PMC decomposition.")
+        ("chunkSize", value<float>()->default_value(0), "Reconstruct the point cloud in cubic chunks of this edge length to limit the memory usage. The points are streamed into temporary chunk files and the chunk meshes are stitched. 0 disables chunking.")
+        ("chunkOverlap", value<float>()->default_value(0), "Distance by which the chunks overlap. Has to be larger than the neighborhoods used for normal estimation and distance evaluation. Defaults to a tenth of the chunk size.")
+        ("parallelChunks", value<int>()->default_value(1), "Number of chunks that are reconstructed at the same time. Each chunk uses threads / parallelChunks threads.")
+        ("chunkDir", value<string>()->default_value(""), "Directory for the temporary chunk files. Defaults to a new directory in the system's temporary path.")
+        ("scanReduction", value<int>()->default_value(1), "Read only every n-th point of each scan if the input is a directory of UOS scans or a scan project.")
         ("intersections,i", value<int>(&m_intersections)->default_value(-1), "Number of intersections used for reconstruction. If other than -1, voxelsize will calculated automatically.")
-        ("pcm,p", value<string>(&m_pcm)->default_value("FLANN"), "Point cloud manager used for point handling and normal estimation. Choose from {STANN, PCL, NABO}.")
+        ("pcm,p", value<string>(&m_pcm)->default_value("FLANN"), "Point cloud manager used for point handling and normal estimation. Choose from {FLANN, NANOFLANN, STANN, PCL, NABO}.")
         ("ransac", "Set this flag for RANSAC based normal estimation.")
         ("decomposition,d", value<string>(&m_pcm)->default_value("PMC"), "Defines the type of decomposition that is used for the voxels (Standard Marching Cubes (MC), Planar Marching Cubes (PMC), Standard Marching Cubes with sharp feature detection (SF) or Tetraeder (MT) decomposition. Choose from {MC, PMC, MT, SF}")
         ("optimizePlanes,o", "Shift all triangle vertices of a cluster onto their shared plane")
@@ -98,6 +106,8 @@ Options::Options(int argc, char** argv)
         ("sft", value<float>(&m_sft)->default_value(0.9), "Sharp feature threshold when using sharp feature decomposition")
         ("sct", value<float>(&m_sct)->default_value(0.7), "Sharp corner threshold when using sharp feature decomposition")
         ("reductionRatio", value<float>(&m_edgeCollapseReductionRatio)->default_value(0.0), "Percentage of faces to remove via edge-collapse (0.0 means no reduction, 1.0 means to remove all faces which can be removed)")
+        ("targetFaces", value<size_t>(&m_targetFaceCount)->default_value(0), "Reduce the mesh via edge-collapse until it has at most this many faces (0 means no reduction, overrides reductionRatio)")
+        ("quadricReduction", "Use the parallel quadric error simplification instead of the serial edge-collapse for reductionRatio and targetFaces")
         ("tp", value<string>(&m_texturePack)->default_value(""), "Path to texture pack")
         ("co", value<string>(&m_statsCoeffs)->default_value(""), "Coefficents file for texture matching based on statistics")
         ("nsc", value<unsigned int>(&m_numStatsColors)->default_value(16), "Number of colors for texture statistics")
@@ -204,6 +214,16 @@ float Options::getEdgeCollapseReductionRatio() const
     return (m_variables["reductionRatio"].as<float>());
 }
 
+size_t Options::getTargetFaceCount() const
+{
+    return (m_variables["targetFaces"].as<size_t>());
+}
+
+bool Options::useQuadricReduction() const
+{
+    return (m_variables.count("quadricReduction"));
+}
+
 int    Options::getDanglingArtifacts() const
 {
     return (m_variables["rda"].as<int> ());
@@ -313,6 +333,42 @@ bool Options::extrude() const
     }
 }
 
+bool Options::parallelGrid() const
+{
+    return m_variables.count("parallelGrid");
+}
+
+bool Options::parallelMesh() const
+{
+    return m_variables.count("parallelMesh");
+}
+
+float Options::getChunkSize() const
+{
+    return m_variables["chunkSize"].as<float>();
+}
+
+float Options::getChunkOverlap() const
+{
+    float overlap = m_variables["chunkOverlap"].as<float>();
+    return overlap > 0 ? overlap : 0.1 * getChunkSize();
+}
+
+int Options::getParallelChunks() const
+{
+    return std::max(1, m_variables["parallelChunks"].as<int>());
+}
+
+int Options::getScanReduction() const
+{
+    return std::max(1, m_variables["scanReduction"].as<int>());
+}
+
+string Options::getChunkDirectory() const
+{
+    return m_variables["chunkDir"].as<string>();
+}
+
 bool Options::colorRegions() const
 {
     return m_variables.count("colorRegions");
@@ -288,11 +288,59 @@ public:
      */
     bool extrude() const;
 
+    /**
+     * @brief   Whether to build the grid in parallel.
+     */
+    bool parallelGrid() const;
+
+    /**
+     * @brief   Whether to extract the mesh from the grid in parallel.
+     */
+    bool parallelMesh() const;
+
+    /**
+     * @brief   Edge length of the chunks for the chunked reconstruction.
+     *          0 if the point cloud is reconstructed at once.
+     */
+    float getChunkSize() const;
+
+    /**
+     * @brief   Overlap of adjacent chunks
+     */
+    float getChunkOverlap() const;
+
+    /**
+     * @brief   Number of chunks that are reconstructed at the same time
+     */
+    int getParallelChunks() const;
+
+    /**
+     * @brief   Directory for the temporary chunk files
+     */
+    string getChunkDirectory() const;
+
+    /**
+     * @brief   Only every n-th point of each scan is read from scan
+     *          directories
+     */
+    int getScanReduction() const;
+
     /**
      * @brief Reduction ratio for mesh reduction via edge collapse
      */
     float getEdgeCollapseReductionRatio() const;
 
+    /**
+     * @brief Number of faces the mesh is reduced to via edge collapse
+     */
+    size_t getTargetFaceCount() const;
+
+    /**
+     * @brief Whether the mesh is reduced with the parallel quadric error
+     *        simplification
+     */
+    bool useQuadricReduction() const;
+
 
     unsigned int getNumStatsColors() const;
 
@@ -407,6 +455,9 @@ private:
     /// Reduction ratio for mesh reduction via edge collapse
     float                           m_edgeCollapseReductionRatio;
 
+    /// Number of faces to reduce the mesh to via edge collapse
+    size_t                          m_targetFaceCount;
+
 
     ///Path to texture pack
     string m_texturePack;
@@ -470,6 +521,24 @@ inline ostream& operator<<(ostream& os, const Options &o)
         cout << "##### Voxelsize \t\t: " << o.getVoxelsize() << endl;
     }
     cout << "##### Number of threads \t: "    << o.getNumThreads()      << endl;
+    if(o.parallelGrid())
+    {
+        cout << "##### Parallel grid \t\t: YES" << endl;
+    }
+    if(o.parallelMesh())
+    {
+        cout << "##### Parallel mesh \t\t: YES" << endl;
+    }
+    if(o.getChunkSize() > 0)
+    {
+        cout << "##### Chunk size \t\t: " << o.getChunkSize() << endl;
+        cout << "##### Chunk overlap \t\t: " << o.getChunkOverlap() << endl;
+        cout << "##### Parallel chunks \t\t: " << o.getParallelChunks() << endl;
+    }
+    if(o.getScanReduction() > 1)
+    {
+        cout << "##### Scan reduction \t\t: " << o.getScanReduction() << endl;
+    }
     cout << "##### Point cloud manager \t: " << o.getPCM()             << endl;
     if(o.useRansac())
     {
@@ -575,6 +644,14 @@ inline ostream& operator<<(ostream& os, const Options &o)
     {
         cout << "##### Edge collapse reduction ratio\t: " << o.getEdgeCollapseReductionRatio() << endl;
     }
+    if(o.getTargetFaceCount() > 0)
+    {
+        cout << "##### Edge collapse target faces\t: " << o.getTargetFaceCount() << endl;
+    }
+    if(o.useQuadricReduction())
+    {
+        cout << "##### Quadric reduction \t\t: ON" << endl;
+    }
 
     if(o.useGPU())
     {